@@ -0,0 +1,147 @@
+#include <XLink/XLink.h>
+#include <XLink/XLinkLog.h>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <thread>
+
+// Stands in for a TCP/IP device: serves links in the device role on the XLink port and
+// answers the device discovery of hosts, so it's found and connected to like a booted
+// device. Streams named on the command line are echoed, sunk or sourced for every link.
+
+constexpr static auto ECHO_MAX_SIZE = 8 * 1024 * 1024;
+
+enum class StreamMode { ECHO, SINK, SOURCE };
+
+struct StreamConfig {
+    std::string name;
+    StreamMode mode;
+    int size;
+};
+
+static void usage(const char* app) {
+    printf("Usage: %s [options]\n"
+           "  --listen ip[:port]  address to serve links on, default 0.0.0.0:11490\n"
+           "  --mxid id           id reported to device searches, default XLINK_TCP_PEER\n"
+           "  --echo name         writes every packet read on stream 'name' back on it\n"
+           "  --sink name         reads and drops every packet of stream 'name'\n"
+           "  --source name:size  writes packets of 'size' bytes on stream 'name' back to back\n"
+           "  --once              exits after the first link was reset\n", app);
+}
+
+static void serveStream(linkId_t linkId, const StreamConfig& config) {
+    // sinks never write, but only opening with a write size doesn't depend on the host
+    // having opened the stream already
+    int writeSize = config.mode == StreamMode::ECHO ? ECHO_MAX_SIZE : config.mode == StreamMode::SOURCE ? config.size : 1;
+    auto s = XLinkOpenStream(linkId, config.name.c_str(), writeSize);
+    if(s == INVALID_STREAM_ID || s == INVALID_STREAM_ID_OUT_OF_MEMORY) {
+        printf("Open stream %s failed\n", config.name.c_str());
+        return;
+    }
+
+    // every loop ends with an error once the host reset the link
+    streamPacketDesc_t* p;
+    switch(config.mode) {
+        case StreamMode::ECHO:
+            while(XLinkReadData(s, &p) == X_LINK_SUCCESS) {
+                XLinkError_t rc = XLinkWriteData(s, p->data, p->length);
+                XLinkReleaseData(s);
+                if(rc != X_LINK_SUCCESS) break;
+            }
+            break;
+        case StreamMode::SINK:
+            while(XLinkReadData(s, &p) == X_LINK_SUCCESS) {
+                XLinkReleaseData(s);
+            }
+            break;
+        case StreamMode::SOURCE: {
+            std::vector<uint8_t> payload(config.size);
+            while(XLinkWriteData(s, payload.data(), (int) payload.size()) == X_LINK_SUCCESS) {
+            }
+            break;
+        }
+    }
+}
+
+int main(int argc, char** argv) {
+
+    std::string listen = "0.0.0.0";
+    std::string mxid = "XLINK_TCP_PEER";
+    std::vector<StreamConfig> streams;
+    bool once = false;
+    for(int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        if(arg == "--listen" && hasValue) {
+            listen = argv[++i];
+        } else if(arg == "--mxid" && hasValue) {
+            mxid = argv[++i];
+        } else if(arg == "--echo" && hasValue) {
+            streams.push_back({argv[++i], StreamMode::ECHO, 0});
+        } else if(arg == "--sink" && hasValue) {
+            streams.push_back({argv[++i], StreamMode::SINK, 0});
+        } else if(arg == "--source" && hasValue) {
+            std::string value = argv[++i];
+            auto colon = value.rfind(':');
+            int size = colon == std::string::npos ? 0 : atoi(value.c_str() + colon + 1);
+            if(size <= 0) {
+                usage(argv[0]);
+                return 1;
+            }
+            streams.push_back({value.substr(0, colon), StreamMode::SOURCE, size});
+        } else if(arg == "--once") {
+            once = true;
+        } else {
+            usage(argv[0]);
+            return 1;
+        }
+    }
+
+    // the link is served until its streams fail
+    if(streams.empty()) {
+        usage(argv[0]);
+        return 1;
+    }
+
+    // Initialize and suppress XLink logs, failing reads at link reset are expected
+    mvLogDefaultLevelSet(MVLOG_LAST);
+    XLinkGlobalHandler_t gHandler = {};
+    if(XLinkInitialize(&gHandler) != X_LINK_SUCCESS) {
+        printf("Couldn't initialize XLink\n");
+        return -1;
+    }
+
+    deviceDesc_t announced = {};
+    announced.protocol = X_LINK_TCP_IP;
+    announced.state = X_LINK_BOOTED;
+    strncpy(announced.mxid, mxid.c_str(), sizeof(announced.mxid) - 1);
+    if(XLinkServerAnnounce(&announced) != X_LINK_SUCCESS) {
+        printf("Couldn't answer device searches, continuing without\n");
+    }
+
+    do {
+        XLinkHandler_t handler = {};
+        handler.devicePath = const_cast<char*>(listen.c_str());
+        handler.protocol = X_LINK_TCP_IP;
+        printf("Waiting for a host on %s\n", listen.c_str());
+        if(XLinkServer(&handler) != X_LINK_SUCCESS) {
+            printf("Serving a link failed\n");
+            return -1;
+        }
+        printf("Host connected\n");
+
+        std::vector<std::thread> threads;
+        for(const auto& config : streams) {
+            threads.emplace_back(serveStream, (linkId_t) handler.linkId, config);
+        }
+        for(auto& thread : threads) {
+            thread.join();
+        }
+        printf("Link closed\n");
+    } while(!once);
+
+    XLinkServerAnnounceStop(X_LINK_TCP_IP);
+    return 0;
+}
@@ -95,6 +95,55 @@ XLinkError_t XLinkSearchForDevices(const deviceDesc_t in_deviceRequirements,
  */
 XLinkError_t XLinkConnect(XLinkHandler_t* handler);
 
+/**
+ * @brief Waits for a host to connect, starts dispatcher and waits for the ping of the host.
+ *        This side of the link acts as the device, e.g. as a peer process on the same machine
+ *        or, with X_LINK_LOOPBACK, as a peer thread of the same process
+ * @param[in,out] handler - XLink communication parameters (endpoint to listen on for the underlying
+ *                layer, e.g. shared memory name for X_LINK_IPC, link name for X_LINK_LOOPBACK
+ *                or "ip:port" for X_LINK_TCP_IP)
+ * @return Status code of the operation: X_LINK_SUCCESS (0) for success
+ */
+XLinkError_t XLinkServer(XLinkHandler_t* handler);
+
+/**
+ * @brief Answers device searches of hosts in the background, so links served with XLinkServer
+ *        are found like a device. Only X_LINK_TCP_IP discovery is supported
+ * @param deviceDesc - protocol to answer the searches of, mxid and state reported to the hosts
+ * @return Status code of the operation: X_LINK_SUCCESS (0) for success
+ */
+XLinkError_t XLinkServerAnnounce(const deviceDesc_t* deviceDesc);
+
+/**
+ * @brief Stops answering device searches started with XLinkServerAnnounce
+ * @param protocol - protocol given to XLinkServerAnnounce
+ * @return Status code of the operation: X_LINK_SUCCESS (0) for success
+ */
+XLinkError_t XLinkServerAnnounceStop(XLinkProtocol_t protocol);
+
+/**
+ * @brief Selects how TCP/IP links connected or served afterwards are implemented
+ * @note Links keep the backend they were created with. X_LINK_TCP_BACKEND_IO_URING serves all
+ *       links from one ring: a receive of every link stays posted into a registered buffer, and
+ *       sends of all links go to the kernel in batches. It needs Linux 5.6 or later and a build
+ *       with XLINK_ENABLE_IO_URING, links fall back to sockets otherwise
+ * @param backend - implementation of later links, X_LINK_TCP_BACKEND_SOCKETS by default
+ * @return Status code of the operation: X_LINK_SUCCESS (0) for success, X_LINK_NOT_IMPLEMENTED
+ *         if io_uring isn't available, sockets stay selected then
+ */
+XLinkError_t XLinkSetTcpBackend(XLinkTcpBackend_t backend);
+
+/**
+ * @brief Sets the size from which writes of TCP/IP links are sent with MSG_ZEROCOPY
+ * @note The write completes once the kernel released the data instead of copying it. Applies to
+ *       links of the sockets backend right away. Sockets whose sends the kernel copied anyway,
+ *       e.g. over loopback, go back to plain sends. Linux 4.14 or later
+ * @param bytes - smallest write sent without copies, XLINK_TCP_ZEROCOPY_THRESHOLD by default, 0 disables
+ * @return Status code of the operation: X_LINK_SUCCESS (0) for success, X_LINK_NOT_IMPLEMENTED
+ *         if the platform has no MSG_ZEROCOPY
+ */
+XLinkError_t XLinkSetTcpZeroCopyThreshold(uint32_t bytes);
+
 /**
  * @brief Puts device into bootloader mode
  * @param deviceDesc - device description structure, obtained from XLinkFind* functions call
@@ -201,6 +250,76 @@ XLinkError_t XLinkProfPrint();
 XLinkError_t XLinkGetGlobalProfilingData(XLinkProf_t* prof);
 XLinkError_t XLinkGetProfilingData(linkId_t id, XLinkProf_t* prof);
 
+/**
+ * @brief Returns the read and write counters of all links since XLinkProfStart
+ * Safe to call while other threads read and write, all fields are from the same instant
+ * @param[out]  counters - Number of calls, bytes and nanoseconds spent of reads and writes
+ * @return Status code of the operation: X_LINK_SUCCESS (0) for success
+ */
+XLinkError_t XLinkGetGlobalProfilingCounters(XLinkProfCounters_t* counters);
+
+/**
+ * @brief Returns the read and write counters of a link since it was connected
+ * Recorded whether profiling was started or not. Safe to call while other threads
+ * read and write, all fields are from the same instant
+ * @param[in]   id - Link Id obtained from XLinkConnect in the handler parameter
+ * @param[out]  counters - Number of calls, bytes and nanoseconds spent of reads and writes
+ * @return Status code of the operation: X_LINK_SUCCESS (0) for success
+ */
+XLinkError_t XLinkGetProfilingCounters(linkId_t id, XLinkProfCounters_t* counters);
+
+/**
+ * @brief Returns the latency distributions of the operations on all streams of a link
+ * Recorded since the link was connected, whether profiling was started or not
+ * @param[in]   id - Link Id obtained from XLinkConnect in the handler parameter
+ * @param[out]  prof - Read wait, write completion and release latencies
+ * @return Status code of the operation: X_LINK_SUCCESS (0) for success
+ */
+XLinkError_t XLinkGetLinkLatencyProfilingData(linkId_t id, XLinkStreamProf_t* prof);
+
+/**
+ * @brief Returns how long the events of a kind spent in each stage of the dispatcher
+ * Recorded since the link was connected, whether profiling was started or not.
+ * Shows whether latency comes from queueing, the transport or waking the caller up
+ * @param[in]   id - Link Id obtained from XLinkConnect in the handler parameter
+ * @param[in]   kind - Kind of the events, local calls or events sent by the remote
+ * @param[out]  prof - Latency distribution of every stage the events passed
+ * @return Status code of the operation: X_LINK_SUCCESS (0) for success
+ */
+XLinkError_t XLinkGetStageProfilingData(linkId_t id, XLinkEventKind_t kind, XLinkStageProf_t* prof);
+
+/**
+ * @brief Returns the time waited for one of the internal locks since XLinkProfStart
+ * @param[in]   lock - Lock of interest
+ * @param[out]  prof - Number of times the lock was taken and the total and maximum wait
+ * @return Status code of the operation: X_LINK_SUCCESS (0) for success
+ */
+XLinkError_t XLinkGetLockProfilingData(XLinkLock_t lock, XLinkLockProf_t* prof);
+
+/**
+ * @brief Starts recording the events of all links into an in-memory ring
+ * @note Records API calls, sends, receives and blocked events with their thread, stream and size.
+ *       The ring is allocated by the first start only and keeps the latest events once full,
+ *       later starts clear it. Timestamps are those of std::chrono::steady_clock
+ * @param[in]   capacity - Number of events kept, 0 for the default of 65536
+ * @return Status code of the operation: X_LINK_SUCCESS (0) for success
+ */
+XLinkError_t XLinkTraceStart(uint32_t capacity);
+
+/**
+ * @brief Stops recording events, the ring is kept for XLinkTraceDump
+ * @return Status code of the operation: X_LINK_SUCCESS (0) for success
+ */
+XLinkError_t XLinkTraceStop(void);
+
+/**
+ * @brief Writes the recorded events as Chrome trace event JSON, which Perfetto opens as well
+ * @note May be called while recording
+ * @param[in]   path - File to write, overwritten if it exists
+ * @return Status code of the operation: X_LINK_SUCCESS (0) for success
+ */
+XLinkError_t XLinkTraceDump(const char* path);
+
 
 // ------------------------------------
 // Device management. End.
@@ -223,6 +342,18 @@ XLinkError_t XLinkGetProfilingData(linkId_t id, XLinkProf_t* prof);
  */
 streamId_t XLinkOpenStream(linkId_t id, const char* name, int stream_write_size);
 
+/**
+ * @brief Opens a stream like XLinkOpenStream and applies per-stream options to it
+ * @note Options which the remote doesn't support are ignored with a warning
+ * @param[in] id - link Id obtained from XLinkConnect in the handler parameter
+ * @param[in] name - stream name
+ * @param[in] stream_write_size - stream buffer size
+ * @param[in] options - stream options, NULL for defaults
+ * @return Link Id: INVALID_STREAM_ID for failure
+ */
+streamId_t XLinkOpenStreamWithOptions(linkId_t id, const char* name, int stream_write_size,
+                                      const XLinkStreamOptions_t* options);
+
 /**
  * @brief Closes stream for any further data transfer
  *        Stream will be deallocated when all pending data has been released
@@ -241,6 +372,19 @@ XLinkError_t XLinkCloseStream(streamId_t const streamId);
  */
 XLinkError_t XLinkWriteData(streamId_t const streamId, const uint8_t* buffer, int size);
 
+/**
+ * @brief Writes part of a file to a remote stream, without copying it through user space on TCP/IP links
+ * @note The data arrives as several packets, each of at most a quarter of the stream's write size.
+ *       Links of other protocols read the file through a buffer. The file offset of fd isn't changed
+ * @param[in] streamId - stream link Id obtained from XLinkOpenStream call
+ * @param[in] fd - file descriptor of a regular file, open for reading
+ * @param[in] offset - position in the file of the first byte to write
+ * @param[in] length - number of bytes to write
+ * @return Status code of the operation: X_LINK_SUCCESS (0) for success, X_LINK_ERROR also if the file
+ *         ends before offset + length
+ */
+XLinkError_t XLinkWriteFromFd(streamId_t const streamId, int fd, uint64_t offset, uint64_t length);
+
 /**
  * @brief Sends a package to initiate the writing of data to a remote stream
  * @warning Actual size of the written data is ALIGN_UP(size, 64)
@@ -271,15 +415,69 @@ XLinkError_t XLinkReadDataWithTimeout(streamId_t const streamId, streamPacketDes
 
 /**
  * @brief Releases specific data from stream
+ * @note Fails if the packet isn't held. Read packets of streams with shared reads may be
+ *       released in any order, see XLinkStreamOptions_t
  * @param[in] streamId – stream link Id obtained from XLinkOpenStream call
  * @param[in] packetId – ID of the package to be released from the stream
  * @return Status code of the operation: X_LINK_SUCCESS (0) for success
  */
 XLinkError_t XLinkReleaseSpecificData(streamId_t streamId, streamPacketDesc_t* packetDesc);
 
+/**
+ * @brief Returns the latency distributions of the operations on a stream
+ * Recorded since the stream was opened, whether profiling was started or not
+ * @param[in]   streamId - Stream link Id obtained from XLinkOpenStream call
+ * @param[out]  prof - Read wait, write completion and release latencies
+ * @return Status code of the operation: X_LINK_SUCCESS (0) for success
+ */
+XLinkError_t XLinkGetStreamProfilingData(streamId_t streamId, XLinkStreamProf_t* prof);
+
+/**
+ * @brief Returns how long the events of a stream spent in each stage of the dispatcher
+ * Events of all kinds are summed up, see XLinkGetStageProfilingData
+ * @param[in]   streamId - Stream link Id obtained from XLinkOpenStream call
+ * @param[out]  prof - Latency distribution of every stage the events passed
+ * @return Status code of the operation: X_LINK_SUCCESS (0) for success
+ */
+XLinkError_t XLinkGetStreamStageProfilingData(streamId_t streamId, XLinkStageProf_t* prof);
+
+/**
+ * @brief Returns how many packets of a stream were dropped unread
+ * @note Only streams keeping the latest packets drop any, see XLinkStreamOptions_t
+ * @param[in]   streamId - Stream link Id obtained from XLinkOpenStream call
+ * @param[out]  dropped - Packets dropped since the stream was opened
+ * @return Status code of the operation: X_LINK_SUCCESS (0) for success
+ */
+XLinkError_t XLinkGetStreamDroppedPackets(streamId_t const streamId, uint64_t* dropped);
+
+/**
+ * @brief Returns the number of a packet among those the stream received
+ * @note Skipped numbers were dropped, see XLinkStreamOptions_t. Only packets read with
+ *       XLinkReadData or XLinkReadDataWithTimeout and not yet released have a number
+ * @param[in]   streamId - Stream link Id obtained from XLinkOpenStream call
+ * @param[in]   packet - Packet read from the stream
+ * @param[out]  sequence - Number of the packet, counted from 0 since the stream was opened
+ * @return Status code of the operation: X_LINK_SUCCESS (0) for success
+ */
+XLinkError_t XLinkGetPacketSequence(streamId_t const streamId, const streamPacketDesc_t* packet, uint32_t* sequence);
+
+/**
+ * @brief Waits until the data of a packet read from a stream with progressive delivery has arrived
+ * @param[in]   streamId – stream link Id obtained from XLinkOpenStream call
+ * @param[in]   packet – packet obtained from one of the XLinkRead calls of this stream
+ * @param[in]   size – number of bytes from the start of the packet to wait for, capped to its length
+ * @param[out]  available – number of bytes from the start of the packet that arrived, can be NULL
+ * @return Status code of the operation: X_LINK_SUCCESS (0) for success, X_LINK_COMMUNICATION_FAIL
+ *         when the link broke off while the data was arriving or went down meanwhile
+ * @note Packets of other streams are complete when read, releasing a packet waits for all its data
+ */
+XLinkError_t XLinkWaitPacketData(streamId_t const streamId, const streamPacketDesc_t* packet,
+                                 uint32_t size, uint32_t* available);
+
 /**
  * @brief Reads data from local stream and moves ownership. Will only have something if it was written to by the remote
  * @note Caller is responsible for deallocating with XLinkDeallocateMoveData(streamPacketDesc_t::data, streamPacketDesc_t::length)
+ * @note On streams with progressive delivery it returns once the whole data has arrived
  * @param[in]   streamId - stream link Id obtained from XLinkOpenStream call
  * @param[out]  packet - structure containing output data buffer and received size
  * @return Status code of the operation: X_LINK_SUCCESS (0) for success
@@ -289,6 +487,7 @@ XLinkError_t XLinkReadMoveData(streamId_t const streamId, streamPacketDesc_t* co
 /**
  * @brief Reads data from local stream and moves ownership. Will only have something if it was written to by the remote
  * @note Caller is responsible for deallocating with XLinkDeallocateMoveData(streamPacketDesc_t::data, streamPacketDesc_t::length)
+ * @note On streams with progressive delivery it returns once the whole data has arrived
  * @param[in]   streamId - stream link Id obtained from XLinkOpenStream call
  * @param[out]  packet - structure containing output data buffer and received size
  * @param[in]   msTimeout – time in milliseconds after which operation times out
@@ -303,9 +502,160 @@ XLinkError_t XLinkReadMoveDataWithTimeout(streamId_t const streamId, streamPacke
  */
 void XLinkDeallocateMoveData(void* const data, const uint32_t length);
 
+/**
+ * @brief Hands the data of a moved packet back to its stream, which receives later packets into it
+ * @note Takes the place of XLinkDeallocateMoveData. The data is deallocated when the stream keeps
+ *       no more buffers, see XLinkStreamOptions_t::recycledBuffers, or was closed meanwhile
+ * @param[in]  streamId - stream the packet was read from
+ * @param[in]  data - streamPacketDesc_t::data pointer
+ * @param[in]  length - streamPacketDesc_t::length
+ */
+void XLinkRecycleMoveData(streamId_t const streamId, void* const data, const uint32_t length);
+
+/**
+ * @brief Writes the payloads of a stream to a file or pipe instead of handing them to readers
+ * @note Payloads are written by the link's reader thread as they arrive, spliced from the socket
+ *       on TCP/IP links. Each is credited back to the remote once written, so the remote's write
+ *       window works as with readers. Packets received before stay to be read. Needs a remote
+ *       which supports release credits. Returns once a payload still being written to the
+ *       previous file is done, which may be closed then
+ * @param[in] streamId - stream link Id obtained from XLinkOpenStream call
+ * @param[in] fd - file descriptor open for writing, -1 hands later packets to readers again
+ * @param[in] options - framing of the payloads, NULL for none
+ * @return Status code of the operation: X_LINK_SUCCESS (0) for success, X_LINK_ERROR also if a payload
+ *         couldn't be written since the previous call, X_LINK_NOT_IMPLEMENTED if the remote or
+ *         platform doesn't support it
+ */
+XLinkError_t XLinkStreamSinkToFd(streamId_t const streamId, int fd, const XLinkSinkOptions_t* options);
+
+/**
+ * @brief Forwards every packet read from one stream to another, e.g. of a different link
+ * @note Packets are forwarded by a thread of the library, which writes the received data as it is
+ *       and releases each packet only once the destination accepted it. A slow destination
+ *       therefore holds back the remote of the source through its write window. Once a write to
+ *       the destination failed, the packets of the source are dropped instead, so its remote isn't
+ *       stalled. The bridge ends when the source is closed or its link goes down, or with
+ *       XLinkUnbridgeStreams. The source mustn't be read meanwhile. The destination write size
+ *       must hold the largest packet, opening it with XLinkStreamOptions_t::postedWrites saves a
+ *       round trip per packet
+ * @param[in] srcStreamId - stream the packets are read from
+ * @param[in] dstStreamId - stream the packets are written to
+ * @param[in] options - options of the bridge, NULL for the defaults
+ * @return Status code of the operation: X_LINK_SUCCESS (0) for success, X_LINK_ERROR if the source
+ *         is bridged already or the bridge couldn't be started
+ */
+XLinkError_t XLinkBridgeStreams(streamId_t const srcStreamId, streamId_t const dstStreamId,
+                                const XLinkBridgeOptions_t* options);
+
+/**
+ * @brief Stops a bridge started with XLinkBridgeStreams
+ * @note Waits until the packet being forwarded was accepted by the destination. Unread packets
+ *       stay in the source, which the application may read again once this returned
+ * @param[in] srcStreamId - source stream of the bridge
+ * @return Status code of the operation: X_LINK_SUCCESS (0) for success, X_LINK_ERROR if the source
+ *         isn't bridged or the bridge is being stopped already
+ */
+XLinkError_t XLinkUnbridgeStreams(streamId_t const srcStreamId);
+
+/**
+ * @brief Publishes the packets of a stream to other processes of this machine, which read them
+ *        with XLinkBrokerOpenStream, so one process owning the link serves many
+ * @note Packets are copied once, by a thread of the library, into shared memory which the readers
+ *       map. All readers access the same copy, a packet is only overwritten once every reader
+ *       released it, so hold packets briefly. Readers falling behind by more than the kept packets
+ *       skip the older ones. Publishing ends when the stream is closed or its link goes down.
+ *       The stream mustn't be read meanwhile. Linux only
+ * @param[in] streamId - stream link Id obtained from XLinkOpenStream call
+ * @param[in] name - name the readers open the stream by, without slashes
+ * @param[in] options - sizes of the shared memory, NULL for the defaults
+ * @return Status code of the operation: X_LINK_SUCCESS (0) for success, X_LINK_DEVICE_ALREADY_IN_USE
+ *         if another live publisher uses the name, X_LINK_NOT_IMPLEMENTED if the platform doesn't
+ *         support it
+ */
+XLinkError_t XLinkBrokerPublish(streamId_t const streamId, const char* name,
+                                const XLinkBrokerOptions_t* options);
+
+/**
+ * @brief Opens a stream published by XLinkBrokerPublish, in this or another process
+ * @note The reader receives the packets published from now on. Its Id is only valid with the
+ *       XLinkBroker functions
+ * @param[in] name - name the stream was published by
+ * @return Reader Id: INVALID_STREAM_ID for failure, also if no stream is published by the name
+ *         or it has XLINK_BROKER_MAX_READERS readers already
+ */
+streamId_t XLinkBrokerOpenStream(const char* name);
+
+/**
+ * @brief Reads the next published packet, without copying it out of the shared memory
+ * @note Blocks until a packet is published. Mirrors XLinkReadData, release the packet with
+ *       XLinkBrokerReleaseData
+ * @param[in]  readerId - reader Id obtained from XLinkBrokerOpenStream call
+ * @param[out] packet - structure containing output data buffer and received size
+ * @param[out] dropped - if not NULL, packets skipped before this one since the reader fell behind
+ * @return Status code of the operation: X_LINK_SUCCESS (0) for success, X_LINK_COMMUNICATION_NOT_OPEN
+ *         once publishing ended and every published packet was read
+ */
+XLinkError_t XLinkBrokerReadData(streamId_t const readerId, streamPacketDesc_t** packet, uint32_t* dropped);
+
+/**
+ * @brief Releases the oldest packet read from a published stream, which may then be overwritten
+ * @param[in] readerId - reader Id obtained from XLinkBrokerOpenStream call
+ * @return Status code of the operation: X_LINK_SUCCESS (0) for success
+ */
+XLinkError_t XLinkBrokerReleaseData(streamId_t const readerId);
+
+/**
+ * @brief Closes a reader of a published stream and releases the packets it holds
+ * @param[in] readerId - reader Id obtained from XLinkBrokerOpenStream call
+ * @return Status code of the operation: X_LINK_SUCCESS (0) for success
+ */
+XLinkError_t XLinkBrokerCloseStream(streamId_t const readerId);
+
+/**
+ * @brief Subscribes to every packet of a stream, which any number of subscribers of this process
+ *        receive without copies
+ * @note The first subscription makes a thread of the library read the stream until it's closed,
+ *       the stream mustn't be read otherwise meanwhile. Subscribers receive the packets arriving
+ *       from now on. A packet is released to the remote once the last subscriber released or
+ *       dropped it, packets arriving without subscribers are released right away
+ * @param[in] streamId - stream link Id obtained from XLinkOpenStream call
+ * @param[in] options - lag limit of the subscriber, NULL for the defaults
+ * @return Subscriber Id: INVALID_STREAM_ID for failure, also with XLINK_FANOUT_MAX_SUBSCRIBERS
+ *         subscribers or XLINK_FANOUT_MAX_STREAMS other streams fanned out already
+ */
+streamId_t XLinkFanOutSubscribe(streamId_t const streamId, const XLinkFanOutOptions_t* options);
+
+/**
+ * @brief Reads the next packet for a subscriber
+ * @note Blocks until a packet arrives. Mirrors XLinkReadData, release the packet with
+ *       XLinkFanOutReleaseData. The packet is shared with the other subscribers, don't modify it
+ * @param[in]  subscriberId - subscriber Id obtained from XLinkFanOutSubscribe call
+ * @param[out] packet - structure containing output data buffer and received size
+ * @param[out] dropped - if not NULL, packets dropped for the subscriber since its previous read
+ * @return Status code of the operation: X_LINK_SUCCESS (0) for success, X_LINK_COMMUNICATION_NOT_OPEN
+ *         once the stream ended and every packet was read
+ */
+XLinkError_t XLinkFanOutReadData(streamId_t const subscriberId, streamPacketDesc_t** packet, uint32_t* dropped);
+
+/**
+ * @brief Releases the oldest packet read by a subscriber
+ * @param[in] subscriberId - subscriber Id obtained from XLinkFanOutSubscribe call
+ * @return Status code of the operation: X_LINK_SUCCESS (0) for success
+ */
+XLinkError_t XLinkFanOutReleaseData(streamId_t const subscriberId);
+
+/**
+ * @brief Ends a subscription and releases the packets the subscriber holds or didn't read
+ * @note A read of the subscriber blocked meanwhile fails with X_LINK_ERROR
+ * @param[in] subscriberId - subscriber Id obtained from XLinkFanOutSubscribe call
+ * @return Status code of the operation: X_LINK_SUCCESS (0) for success
+ */
+XLinkError_t XLinkFanOutUnsubscribe(streamId_t const subscriberId);
+
 /**
  * @brief Releases data from stream - This should be called after the data obtained from
  *  XlinkReadData is processed
+ * @note Packets of streams with shared reads are released with XLinkReleaseSpecificData
  * @param[in] streamId - stream link Id obtained from XLinkOpenStream call
  * @return Status code of the operation: X_LINK_SUCCESS (0) for success
  */
@@ -0,0 +1,218 @@
+// Copyright (C) 2018-2021 Intel Corporation
+// SPDX-License-Identifier: Apache-2.0
+//
+
+///
+/// @file
+///
+/// @brief     Header-only C++ layer over the streams of XLink.h, with packets
+///            which give their buffers back on destruction
+///
+
+#ifndef _XLINK_HPP
+#define _XLINK_HPP
+
+#include <atomic>
+#include <memory>
+#include <string>
+#include <utility>
+
+#include "XLink.h"
+
+namespace xlink {
+
+namespace detail {
+
+// Shared by a stream and its packets, so packets may outlive the stream
+struct StreamState {
+    streamId_t id;
+    uint32_t maxInFlight;
+    std::atomic<uint32_t> inFlight{0};
+
+    StreamState(streamId_t id, uint32_t maxInFlight) : id(id), maxInFlight(maxInFlight) {}
+};
+
+}  // namespace detail
+
+/**
+ * @brief Packet read from a Stream, owning its data
+ * @note Destroying or resetting the packet hands its buffer back to the stream, which receives
+ *       later packets into it. It takes no dispatcher call, the packet was released when read
+ */
+class Packet {
+   public:
+    Packet() = default;
+    Packet(const Packet&) = delete;
+    Packet& operator=(const Packet&) = delete;
+
+    Packet(Packet&& other) noexcept : state(std::move(other.state)), desc(other.desc) {
+        other.desc = streamPacketDesc_t{};
+    }
+
+    Packet& operator=(Packet&& other) noexcept {
+        if(this != &other) {
+            reset();
+            state = std::move(other.state);
+            desc = other.desc;
+            other.desc = streamPacketDesc_t{};
+        }
+        return *this;
+    }
+
+    ~Packet() {
+        reset();
+    }
+
+    uint8_t* data() const {
+        return desc.data;
+    }
+
+    uint32_t size() const {
+        return desc.length;
+    }
+
+    /// Remote clock, see streamPacketDesc_t
+    XLinkTimespec remoteSent() const {
+        return desc.tRemoteSent;
+    }
+
+    /// Local monotonic clock, see streamPacketDesc_t
+    XLinkTimespec received() const {
+        return desc.tReceived;
+    }
+
+    explicit operator bool() const {
+        return desc.data != nullptr;
+    }
+
+    /// Hands the buffer back to the stream now, the packet is empty afterwards
+    void reset() {
+        if(desc.data != nullptr) {
+            XLinkRecycleMoveData(state->id, desc.data, desc.length);
+            state->inFlight.fetch_sub(1, std::memory_order_release);
+        }
+        state.reset();
+        desc = streamPacketDesc_t{};
+    }
+
+   private:
+    friend class Stream;
+
+    Packet(std::shared_ptr<detail::StreamState> state, const streamPacketDesc_t& desc)
+        : state(std::move(state)), desc(desc) {}
+
+    std::shared_ptr<detail::StreamState> state;
+    streamPacketDesc_t desc{};
+};
+
+/**
+ * @brief Stream of a link, closed on destruction
+ * @note At most maxInFlight packets read from the stream exist at a time, the buffers of as
+ *       many packets are kept by the stream, so steady-state reads don't allocate their data
+ */
+class Stream {
+   public:
+    Stream() = default;
+    Stream(const Stream&) = delete;
+    Stream& operator=(const Stream&) = delete;
+    Stream(Stream&& other) noexcept = default;
+
+    Stream& operator=(Stream&& other) noexcept {
+        if(this != &other) {
+            close();
+            state = std::move(other.state);
+        }
+        return *this;
+    }
+
+    ~Stream() {
+        close();
+    }
+
+    /**
+     * @brief Opens a stream like XLinkOpenStreamWithOptions
+     * @param[in] linkId - link Id obtained from XLinkConnect or XLinkServer
+     * @param[in] name - stream name
+     * @param[in] writeSize - stream buffer size on the remote, 0 for reading only
+     * @param[in] maxInFlight - number of packets that may exist at a time, at most XLINK_MAX_RECYCLED_BUFFERS
+     * @param[in] options - stream options, recycledBuffers defaults to maxInFlight
+     * @return Stream which isn't valid on failure
+     */
+    static Stream open(linkId_t linkId,
+                       const std::string& name,
+                       int writeSize,
+                       uint32_t maxInFlight = XLINK_MAX_RECYCLED_BUFFERS,
+                       XLinkStreamOptions_t options = XLinkStreamOptions_t{}) {
+        Stream stream;
+        if(maxInFlight == 0) return stream;
+        if(options.recycledBuffers == 0) options.recycledBuffers = maxInFlight;
+
+        streamId_t id = XLinkOpenStreamWithOptions(linkId, name.c_str(), writeSize, &options);
+        if(id != INVALID_STREAM_ID && id != INVALID_STREAM_ID_OUT_OF_MEMORY) {
+            stream.state = std::make_shared<detail::StreamState>(id, maxInFlight);
+        }
+        return stream;
+    }
+
+    bool valid() const {
+        return state != nullptr;
+    }
+
+    streamId_t id() const {
+        return state ? state->id : INVALID_STREAM_ID;
+    }
+
+    /// Packets read and not destroyed yet
+    uint32_t inFlight() const {
+        return state ? state->inFlight.load(std::memory_order_acquire) : 0;
+    }
+
+    XLinkError_t write(const void* data, int size, unsigned int msTimeout = XLINK_NO_RW_TIMEOUT) {
+        if(!state) return X_LINK_ERROR;
+        if(msTimeout == XLINK_NO_RW_TIMEOUT) {
+            return XLinkWriteData(state->id, static_cast<const uint8_t*>(data), size);
+        }
+        return XLinkWriteDataWithTimeout(state->id, static_cast<const uint8_t*>(data), size, msTimeout);
+    }
+
+    /**
+     * @brief Reads the next packet of the stream
+     * @param[out] packet - replaced by the packet read, empty on failure
+     * @param[in]  msTimeout - time in milliseconds after which the read times out
+     * @return Status code of the operation: X_LINK_SUCCESS (0) for success, X_LINK_OUT_OF_MEMORY
+     *         without waiting when maxInFlight packets exist already
+     */
+    XLinkError_t read(Packet& packet, unsigned int msTimeout = XLINK_NO_RW_TIMEOUT) {
+        packet.reset();
+        if(!state) return X_LINK_ERROR;
+        if(state->inFlight.fetch_add(1, std::memory_order_acquire) >= state->maxInFlight) {
+            state->inFlight.fetch_sub(1, std::memory_order_release);
+            return X_LINK_OUT_OF_MEMORY;
+        }
+
+        streamPacketDesc_t desc{};
+        XLinkError_t rc = msTimeout == XLINK_NO_RW_TIMEOUT ? XLinkReadMoveData(state->id, &desc)
+                                                           : XLinkReadMoveDataWithTimeout(state->id, &desc, msTimeout);
+        if(rc != X_LINK_SUCCESS || desc.data == nullptr) {
+            state->inFlight.fetch_sub(1, std::memory_order_release);
+            return rc != X_LINK_SUCCESS ? rc : X_LINK_ERROR;
+        }
+        packet = Packet(state, desc);
+        return X_LINK_SUCCESS;
+    }
+
+    /// Closes the stream now, packets read from it stay valid
+    XLinkError_t close() {
+        if(!state) return X_LINK_SUCCESS;
+        XLinkError_t rc = XLinkCloseStream(state->id);
+        state.reset();
+        return rc;
+    }
+
+   private:
+    std::shared_ptr<detail::StreamState> state;
+};
+
+}  // namespace xlink
+
+#endif  //_XLINK_HPP
@@ -0,0 +1,36 @@
+// Copyright (C) 2018-2021 Intel Corporation
+// SPDX-License-Identifier: Apache-2.0
+//
+
+///
+/// @file
+///
+/// @brief     Relaxed atomic counters and fences of the profiling data
+///
+
+#ifndef _XLINKATOMIC_H
+#define _XLINKATOMIC_H
+
+#include <stdint.h>
+
+#if defined(_MSC_VER)
+# include <intrin.h>
+# define XLINK_ATOMIC_ADD_U32(ptr, value) _InterlockedExchangeAdd((volatile long*)(ptr), (long)(value))
+# define XLINK_ATOMIC_LOAD_U32(ptr) (*(volatile uint32_t*)(ptr))
+# define XLINK_ATOMIC_ADD_U64(ptr, value) _InterlockedExchangeAdd64((volatile __int64*)(ptr), (__int64)(value))
+# define XLINK_ATOMIC_LOAD_U64(ptr) ((uint64_t)_InterlockedCompareExchange64((volatile __int64*)(ptr), 0, 0))
+# define XLINK_ATOMIC_STORE_U64(ptr, value) _InterlockedExchange64((volatile __int64*)(ptr), (__int64)(value))
+// the interlocked functions are full barriers already
+# define XLINK_ATOMIC_FENCE_ACQUIRE() _ReadWriteBarrier()
+# define XLINK_ATOMIC_FENCE_RELEASE() _ReadWriteBarrier()
+#else
+# define XLINK_ATOMIC_ADD_U32(ptr, value) __atomic_fetch_add((ptr), (value), __ATOMIC_RELAXED)
+# define XLINK_ATOMIC_LOAD_U32(ptr) __atomic_load_n((ptr), __ATOMIC_RELAXED)
+# define XLINK_ATOMIC_ADD_U64(ptr, value) __atomic_fetch_add((ptr), (uint64_t)(value), __ATOMIC_RELAXED)
+# define XLINK_ATOMIC_LOAD_U64(ptr) __atomic_load_n((ptr), __ATOMIC_RELAXED)
+# define XLINK_ATOMIC_STORE_U64(ptr, value) __atomic_store_n((ptr), (uint64_t)(value), __ATOMIC_RELAXED)
+# define XLINK_ATOMIC_FENCE_ACQUIRE() __atomic_thread_fence(__ATOMIC_ACQUIRE)
+# define XLINK_ATOMIC_FENCE_RELEASE() __atomic_thread_fence(__ATOMIC_RELEASE)
+#endif
+
+#endif //_XLINKATOMIC_H
@@ -20,12 +20,24 @@ extern "C"
 typedef int (*getRespFunction) (xLinkEvent_t*,
                 xLinkEvent_t*);
 typedef struct {
+    // Returns 0 once the event is sent, a positive value if a part of it is
+    // still to be sent by another call, which other events may precede
     int (*eventSend) (xLinkEvent_t*);
     int (*eventReceive) (xLinkEvent_t*);
     getRespFunction localGetResponse;
     getRespFunction remoteGetResponse;
     void (*closeLink) (void* fd, int fullClose);
     void (*closeDeviceFd) (xLinkDeviceHandle_t* deviceHandle);
+    // Optional. Sends protocol state deferred by the get response functions
+    // (e.g. batched release credit) which became due. Returns microseconds
+    // until the next deferred state is due, -1 if nothing is deferred
+    int (*flushDeferred) (xLinkDeviceHandle_t* deviceHandle);
+    // Optional. Returns the scheduling class of the event, higher classes are
+    // dispatched first. Events of the same class are dispatched in order
+    int (*eventPriority) (xLinkEvent_t* event);
+    // Optional. Records the stages a remote event passed once it was handled,
+    // local events are recorded by the threads waiting for them
+    void (*eventStages) (xLinkEvent_t* event);
 } DispatcherControlFunctions;
 
 XLinkError_t DispatcherInitialize(DispatcherControlFunctions *controlFunc);
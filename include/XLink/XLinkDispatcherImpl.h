@@ -15,5 +15,17 @@ int dispatcherRemoteEventGetResponse (xLinkEvent_t*,
                         xLinkEvent_t*);
 void dispatcherCloseLink (void* fd, int fullClose);
 void dispatcherCloseDeviceFd (xLinkDeviceHandle_t* deviceHandle);
+int dispatcherFlushDeferred (xLinkDeviceHandle_t* deviceHandle);
+int dispatcherEventPriority (xLinkEvent_t* event);
+void dispatcherEventStages (xLinkEvent_t* event);
+
+// For control functions which hand whole events over in memory instead of
+// through XLinkPlatformWrite/Read, e.g. to measure the dispatcher alone.
+// dispatcherEventPrepareSend does what dispatcherEventSend does short of
+// writing the event. dispatcherEventReceiveFrom does what
+// dispatcherEventReceive does once the header is read, taking the data of a
+// write from the given buffer. Streams with fragmented writes aren't supported
+int dispatcherEventPrepareSend (xLinkEvent_t* event);
+int dispatcherEventReceiveFrom (xLinkEvent_t* event, const void* data);
 
 #endif //_XLINKDISPATCHERIMPL_H
@@ -0,0 +1,77 @@
+// Copyright (C) 2018-2021 Intel Corporation
+// SPDX-License-Identifier: Apache-2.0
+//
+
+///
+/// @file
+///
+/// @brief     Latency histograms of the streams and links
+///
+
+#ifndef _XLINKHISTOGRAM_H
+#define _XLINKHISTOGRAM_H
+
+#include <stdint.h>
+#include "XLinkPublicDefines.h"
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+// Log-linear buckets: every power of two of nanoseconds is split into
+// 2^XLINK_HISTOGRAM_SUB_BITS buckets, so a bucket is at most 12.5% wide.
+// The last bucket holds everything from 2^34 ns (~17 s) on
+#define XLINK_HISTOGRAM_SUB_BITS 3
+#define XLINK_HISTOGRAM_BUCKETS 256
+
+typedef struct {
+    uint32_t counts[XLINK_HISTOGRAM_BUCKETS];
+} XLinkHistogram_t;
+
+typedef enum {
+    XLINK_LATENCY_READ_WAIT,
+    XLINK_LATENCY_WRITE,
+    XLINK_LATENCY_RELEASE,
+    XLINK_LATENCY_COUNT
+} xLinkLatency_t;
+
+typedef struct {
+    XLinkHistogram_t histograms[XLINK_LATENCY_COUNT];
+} xLinkLatencyHistograms_t;
+
+// Monotonic timestamps of an event as it passes through the dispatcher, 0 if it
+// didn't pass a point
+typedef struct {
+    uint64_t enqueueNs;
+    uint64_t dispatchNs;
+    uint64_t unblockNs;
+    uint64_t sendStartNs;
+    uint64_t sendEndNs;
+    uint64_t receiveStartNs;
+    uint64_t receiveEndNs;
+    uint64_t completeNs;
+    uint64_t wakeNs;
+} xLinkEventStamps_t;
+
+typedef struct {
+    XLinkHistogram_t histograms[X_LINK_STAGE_COUNT];
+} xLinkStageHistograms_t;
+
+// Lock-free, may be called from any thread
+void XLinkHistogramRecord(XLinkHistogram_t* histogram, uint64_t ns);
+
+// Percentiles are the upper bounds of the buckets they fall into
+void XLinkHistogramSummarize(const XLinkHistogram_t* histogram, XLinkLatencyProf_t* prof);
+
+void XLinkLatencySummarize(const xLinkLatencyHistograms_t* latency, XLinkStreamProf_t* prof);
+
+// Records the stages an event passed, see XLinkStage_t
+void XLinkStagesRecord(xLinkStageHistograms_t* stages, const xLinkEventStamps_t* stamps);
+void XLinkStagesSummarize(const xLinkStageHistograms_t* stages, XLinkStageProf_t* prof);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif //_XLINKHISTOGRAM_H
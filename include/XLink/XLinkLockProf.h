@@ -0,0 +1,51 @@
+// Copyright (C) 2018-2021 Intel Corporation
+// SPDX-License-Identifier: Apache-2.0
+//
+
+///
+/// @file
+///
+/// @brief     Wait time profiling of the internal locks
+///
+
+#ifndef _XLINKLOCKPROF_H
+#define _XLINKLOCKPROF_H
+
+#include <stdint.h>
+#include "XLinkPublicDefines.h"
+
+# if (defined(_WIN32) || defined(_WIN64))
+#  include "win_pthread.h"
+# else
+#  include <pthread.h>
+# endif
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+// Enabling resets the counters of all locks
+void XLinkLockProfEnable(int enable);
+int XLinkLockProfEnabled(void);
+uint64_t XLinkLockProfNow(void);
+void XLinkLockProfRecord(XLinkLock_t lock, uint64_t waitNs);
+void XLinkLockProfGet(XLinkLock_t lock, XLinkLockProf_t* prof);
+
+// pthread_mutex_lock accounting the time waited for the mutex to the lock, while profiling
+static inline int XLinkProfMutexLock(pthread_mutex_t* mutex, XLinkLock_t lock)
+{
+    if (!XLinkLockProfEnabled()) {
+        return pthread_mutex_lock(mutex);
+    }
+    uint64_t start = XLinkLockProfNow();
+    int rc = pthread_mutex_lock(mutex);
+    XLinkLockProfRecord(lock, XLinkLockProfNow() - start);
+    return rc;
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif //_XLINKLOCKPROF_H
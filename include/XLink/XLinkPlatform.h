@@ -65,7 +65,13 @@ xLinkPlatformErrorCode_t XLinkPlatformBootRemote(const deviceDesc_t* deviceDesc,
 xLinkPlatformErrorCode_t XLinkPlatformBootFirmware(const deviceDesc_t* deviceDesc, const char* firmware, size_t length);
 xLinkPlatformErrorCode_t XLinkPlatformConnect(const char* devPathRead, const char* devPathWrite,
                          XLinkProtocol_t protocol, void** fd);
+xLinkPlatformErrorCode_t XLinkPlatformServer(const char* devPathRead, const char* devPathWrite,
+                         XLinkProtocol_t protocol, void** fd);
+xLinkPlatformErrorCode_t XLinkPlatformServerAnnounce(const deviceDesc_t* deviceDesc);
+xLinkPlatformErrorCode_t XLinkPlatformServerAnnounceStop(XLinkProtocol_t protocol);
 xLinkPlatformErrorCode_t XLinkPlatformBootBootloader(const char* name, XLinkProtocol_t protocol);
+xLinkPlatformErrorCode_t XLinkPlatformSetTcpBackend(XLinkTcpBackend_t backend);
+xLinkPlatformErrorCode_t XLinkPlatformSetTcpZeroCopyThreshold(uint32_t bytes);
 
 UsbSpeed_t get_usb_speed();
 const char* get_mx_serial();
@@ -84,7 +90,19 @@ xLinkPlatformErrorCode_t XLinkPlatformCloseRemote(xLinkDeviceHandle_t* deviceHan
 // ------------------------------------
 
 int XLinkPlatformWrite(xLinkDeviceHandle_t *deviceHandle, void *data, int size);
+// Writes the header and data back to back, in one transfer where the protocol allows it
+int XLinkPlatformWriteMessage(xLinkDeviceHandle_t *deviceHandle, void *header, int headerSize, void *data, int size);
+// Writes size bytes of the file from offset, without copies through user space where the protocol allows it
+int XLinkPlatformWriteFromFd(xLinkDeviceHandle_t *deviceHandle, int fd, uint64_t offset, int size);
+// Reads size bytes into the file, after prefixSize bytes of prefix, without copies through user space
+// where the protocol allows it. Returns X_LINK_PLATFORM_FD_WRITE_FAILED if the data was read but
+// the file didn't take all of it
+int XLinkPlatformReadToFd(xLinkDeviceHandle_t *deviceHandle, int fd, const void *prefix, int prefixSize, int size);
+#define X_LINK_PLATFORM_FD_WRITE_FAILED 1
 int XLinkPlatformRead(xLinkDeviceHandle_t *deviceHandle, void *data, int size);
+// Keeps at most about bytes of data queued for sending in the transport, where the protocol
+// queues ahead of the writer. An event written after a fragment then waits for that much at most
+int XLinkPlatformLimitSendQueue(xLinkDeviceHandle_t *deviceHandle, uint32_t bytes);
 
 void* XLinkPlatformAllocateData(uint32_t size, uint32_t alignment);
 void XLinkPlatformDeallocateData(void *ptr, uint32_t size, uint32_t alignment);
@@ -12,6 +12,7 @@
 
 #include "XLinkStream.h"
 #include "XLinkPublicDefines.h"
+#include "XLinkProfCounters.h"
 
 #if !defined(XLINK_ALIGN_TO_BOUNDARY)
 # if defined(_WIN32) && !defined(__GNUC__)
@@ -32,6 +33,8 @@ extern "C"
 #define MAXIMUM_SEMAPHORES 32
 #endif
 #define __CACHE_LINE_SIZE 64
+// Time the peer of XLinkServer has to ping the link once it connected
+#define XLINK_SERVER_PING_TIMEOUT_SEC 5
 
 typedef int32_t eventId_t;
 
@@ -63,6 +66,10 @@ typedef struct xLinkDesc_t {
     xLinkDeviceHandle_t deviceHandle;
     linkId_t id;
     XLink_sem_t dispatcherClosedSem;
+    // Posted once the peer pinged this link, see XLinkServer
+    XLink_sem_t pingSem;
+    // The dispatcher of the link still runs, the slot can't be reused until it stopped
+    uint32_t dispatcherRunning;
     UsbSpeed_t usbConnSpeed;
     char mxSerialId[XLINK_MAX_MX_ID_SIZE];
 
@@ -70,8 +77,24 @@ typedef struct xLinkDesc_t {
     int hostClosedFD;
     //Deprecated fields. End.
 
-    // profiling
-    XLinkProf_t profilingData;
+    // profiling, since connect
+    xLinkProfAccumulator_t profilingData;
+    // of all streams, since connect. Allocated when the slot is first connected and kept with it,
+    // stages holds X_LINK_EVENT_COUNT of them
+    xLinkLatencyHistograms_t* latency;
+    xLinkStageHistograms_t* stages;
+
+    // Protocol extensions the peer advertised on connect, see XLINK_CAPABILITY_*
+    uint32_t peerCapabilities;
+    // Number of streams holding release credit or write acknowledgements not yet sent to the peer
+    uint32_t pendingCreditStreams;
+
+    // Link accepted by XLinkServer. This side acts as the device and takes stream ids from the peer
+    uint32_t deviceRole;
+
+    // Bytes the transport may queue ahead of the writer, 0 if unlimited. Set to the smallest
+    // fragment size of the streams, see XLinkPlatformLimitSendQueue
+    uint32_t sendQueueLimit;
 
 } xLinkDesc_t;
 
@@ -112,6 +135,10 @@ typedef enum
     IPC_CLOSE_STREAM_RESP,
     XLINK_READ_REL_SPEC_REQ,
     XLINK_READ_REL_SPEC_RESP,
+
+    /*Protocol extensions, only sent to peers which advertise them*/
+    XLINK_CREDIT_REQ, // carries release credit only, has no response
+    XLINK_WRITE_FRAG_REQ, // data of a fragmented XLINK_WRITE_REQ, never dispatched
 } xLinkEventType_t;
 
 typedef enum
@@ -127,9 +154,30 @@ typedef enum
 #endif
 
 #define MAX_EVENTS 64
+// Events passed over this many times are promoted by one scheduling class
+#define XLINK_PRIORITY_AGING_STEP 8
 #define MAX_SCHEDULERS MAX_LINKS
 #define XLINK_MAX_DEVICES MAX_LINKS
 
+// Protocol extensions exchanged in the size field of XLINK_PING_REQ/RESP
+// when the capabilities flag is set. Peers which don't set the flag support none
+#define XLINK_CAPABILITY_RELEASE_CREDIT (1u << 0)
+#define XLINK_CAPABILITY_POSTED_WRITE   (1u << 1)
+#define XLINK_CAPABILITY_FRAGMENTS      (1u << 2)
+
+#define XLINK_LOCAL_CAPABILITIES (XLINK_CAPABILITY_RELEASE_CREDIT | \
+                                  XLINK_CAPABILITY_POSTED_WRITE | \
+                                  XLINK_CAPABILITY_FRAGMENTS)
+
+// Smallest fragment a write is split into, see XLinkStreamOptions_t
+#define XLINK_MIN_FRAGMENT_SIZE 4096
+
+// Progressively delivered packets become visible to readers in steps of this size
+#define XLINK_PROGRESSIVE_CHUNK_SIZE (64 * 1024)
+
+// Posted writes are acknowledged at the latest this long after they arrived
+#define XLINK_POSTED_WRITE_ACK_DELAY_US 1000
+
 typedef struct xLinkEventHeader_t{
     eventId_t           id;
     xLinkEventType_t    type;
@@ -151,14 +199,44 @@ typedef struct xLinkEventHeader_t{
             uint32_t sizeTooBig : 1;
             uint32_t noSuchStream : 1;
             uint32_t moveSemantic : 1;
+            uint32_t capabilities : 1;
+            uint32_t releaseCredit : 1;
+            uint32_t posted : 1;
+            uint32_t fragmented : 1;
         }bitField;
     }flags;
 }xLinkEventHeader_t;
 
+/**
+ * @brief Cumulative release credit and posted write acknowledgement of a stream
+ * @note Travels in the streamName field of the event header when the
+ *       releaseCredit flag is set, so it is never attached to stream creation events
+ */
+typedef struct xLinkReleaseCredit_t {
+    streamId_t streamId;
+    uint32_t size;
+    uint32_t packets;
+    uint32_t writes;
+} xLinkReleaseCredit_t;
+
 typedef struct xLinkEvent_t {
     XLINK_ALIGN_TO_BOUNDARY(64) xLinkEventHeader_t header;
     xLinkDeviceHandle_t deviceHandle;
     void* data;
+    // Fragmented writes only. Data goes out in XLINK_WRITE_FRAG_REQ
+    // events of at most fragmentSize bytes, sentSize bytes are out already
+    uint32_t fragmentSize;
+    uint32_t sentSize;
+    // Writes from a file only, see XLinkWriteFromFd. The data is read from
+    // fileFd at fileOffset when sent, data is NULL
+    int fromFile;
+    int fileFd;
+    uint64_t fileOffset;
+    // Incoming writes only, the data went to the stream's sink and is credited back
+    // to the remote right away
+    int sunk;
+    // Not sent, copied back to the caller along with the result
+    xLinkEventStamps_t stamps;
 }xLinkEvent_t;
 
 #define XLINK_INIT_EVENT(event, in_streamId, in_type, in_size, in_data, in_deviceHandle) do { \
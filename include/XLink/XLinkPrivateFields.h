@@ -24,10 +24,15 @@
 extern XLinkGlobalHandler_t* glHandler; //TODO need to either protect this with semaphor
                                         //or make profiling data per device
 
+// of all links, between XLinkProfStart and XLinkProfStop
+extern xLinkProfAccumulator_t globalProfilingData;
+
 extern xLinkDesc_t availableXLinks[MAX_LINKS];
 extern pthread_mutex_t availableXLinksMutex;
 extern DispatcherControlFunctions controlFunctionTbl;
 extern sem_t  pingSem; //to b used by myriad
+extern pthread_mutex_t progressiveDataMutex;
+extern pthread_cond_t progressiveDataCond;
 
 // ------------------------------------
 // Global fields declaration. End.
@@ -50,6 +55,14 @@ streamDesc_t* getStreamByName(xLinkDesc_t* link, const char* name);
 
 void releaseStream(streamDesc_t* stream);
 
+// Doesn't take the stream, for profiling and options which don't change while the stream is
+// open only. A stream closed meanwhile at worst passes a sample to the next stream opened in its slot
+streamDesc_t* peekStreamById(xLinkDesc_t* link, streamId_t id);
+
+// Makes reads of the stream fail instead of blocking while no packet is available, until
+// cleared again, and wakes up the read blocked meanwhile
+XLinkError_t interruptStreamReads(streamId_t streamId, int interrupt);
+
 // ------------------------------------
 // Helpers declaration. End.
 // ------------------------------------
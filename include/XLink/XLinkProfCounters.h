@@ -0,0 +1,48 @@
+// Copyright (C) 2018-2021 Intel Corporation
+// SPDX-License-Identifier: Apache-2.0
+//
+
+///
+/// @file
+///
+/// @brief     Lock-free read and write counters of the links and of XLink as a whole
+///
+
+#ifndef _XLINKPROFCOUNTERS_H
+#define _XLINKPROFCOUNTERS_H
+
+#include <stdint.h>
+#include "XLinkPublicDefines.h"
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+// Updated with relaxed atomic adds by any number of threads. Every update is bracketed by
+// the started and finished counts, a snapshot is retried until no update overlapped it
+typedef struct {
+    uint64_t started;
+    uint64_t finished;
+    uint64_t reads;
+    uint64_t writes;
+    uint64_t readBytes;
+    uint64_t writeBytes;
+    uint64_t readNs;
+    uint64_t writeNs;
+    uint64_t startNs;
+} xLinkProfAccumulator_t;
+
+void XLinkProfAccumulatorReset(xLinkProfAccumulator_t* accumulator);
+void XLinkProfAccumulatorAddRead(xLinkProfAccumulator_t* accumulator, uint64_t bytes, uint64_t ns);
+void XLinkProfAccumulatorAddWrite(xLinkProfAccumulator_t* accumulator, uint64_t bytes, uint64_t ns);
+void XLinkProfAccumulatorSnapshot(const xLinkProfAccumulator_t* accumulator, XLinkProfCounters_t* counters);
+
+// Fills the read and write fields of the legacy float profiling data
+void XLinkProfCountersToProf(const XLinkProfCounters_t* counters, XLinkProf_t* prof);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif //_XLINKPROFCOUNTERS_H
@@ -26,6 +26,15 @@ extern "C"
 #define XLINK_MAX_STREAMS 32
 #endif
 #define XLINK_MAX_PACKETS_PER_STREAM 64
+#define XLINK_MAX_RECYCLED_BUFFERS 16
+// TCP/IP writes from this size on are sent without copies, see XLinkSetTcpZeroCopyThreshold
+#define XLINK_TCP_ZEROCOPY_THRESHOLD (256 * 1024)
+// Streams published by XLinkBrokerPublish keep at most this many packets, for this many readers
+#define XLINK_BROKER_MAX_SLOTS 64
+#define XLINK_BROKER_MAX_READERS 32
+// Streams fanned out by XLinkFanOutSubscribe at the same time, and their subscribers over all streams
+#define XLINK_FANOUT_MAX_STREAMS 16
+#define XLINK_FANOUT_MAX_SUBSCRIBERS 32
 #define XLINK_NO_RW_TIMEOUT 0xFFFFFFFF
 
 
@@ -63,7 +72,9 @@ typedef enum{
     X_LINK_IPC,
     X_LINK_TCP_IP,
     X_LINK_NMB_OF_PROTOCOLS,
-    X_LINK_ANY_PROTOCOL
+    X_LINK_ANY_PROTOCOL,
+    // Appended so that the values above stay the same for existing binaries
+    X_LINK_LOOPBACK
 } XLinkProtocol_t;
 
 typedef enum{
@@ -141,6 +152,199 @@ typedef struct XLinkProf_t
     float totalBootTime;
 } XLinkProf_t;
 
+/**
+ * @brief Profiling counters with nanosecond precision, read as a consistent snapshot
+ */
+typedef struct XLinkProfCounters_t
+{
+    uint64_t reads;
+    uint64_t writes;
+    uint64_t totalReadBytes;
+    uint64_t totalWriteBytes;
+    uint64_t totalReadNs;
+    uint64_t totalWriteNs;
+    // Time counted over: since the link was connected, or since XLinkProfStart for the global counters
+    uint64_t elapsedNs;
+} XLinkProfCounters_t;
+
+/**
+ * @brief Latency distribution of an operation. Percentiles are exact to 12.5%
+ */
+typedef struct XLinkLatencyProf_t
+{
+    uint64_t count;
+    uint64_t p50Ns;
+    uint64_t p90Ns;
+    uint64_t p99Ns;
+    uint64_t p999Ns;
+    uint64_t maxNs;
+} XLinkLatencyProf_t;
+
+typedef struct XLinkStreamProf_t
+{
+    XLinkLatencyProf_t readWait;        // reads until a packet was available
+    XLinkLatencyProf_t writeCompletion; // writes until they completed
+    XLinkLatencyProf_t release;         // releases of read packets
+} XLinkStreamProf_t;
+
+/**
+ * @brief Stages of the events of the dispatcher, see XLinkGetStageProfilingData
+ */
+typedef enum{
+    X_LINK_STAGE_QUEUE = 0,  // queued until the dispatcher picked the event up
+    X_LINK_STAGE_BLOCKED,    // reads waiting for data, writes waiting for room on the remote
+    X_LINK_STAGE_TRANSPORT,  // sending the event, and receiving the data of remote events
+    X_LINK_STAGE_RESPONSE,   // from then on until completed, e.g. waiting for the remote to respond
+    X_LINK_STAGE_WAKEUP,     // from completion until the calling thread ran again
+    X_LINK_STAGE_COUNT
+} XLinkStage_t;
+
+/**
+ * @brief Kinds of events whose stages are profiled separately
+ */
+typedef enum{
+    X_LINK_EVENT_WRITE = 0,
+    X_LINK_EVENT_READ,
+    X_LINK_EVENT_RELEASE,
+    X_LINK_EVENT_CONTROL,    // opening and closing streams, pings and resets
+    X_LINK_EVENT_REMOTE,     // requests and responses the remote sent
+    X_LINK_EVENT_COUNT
+} XLinkEventKind_t;
+
+typedef struct XLinkStageProf_t
+{
+    XLinkLatencyProf_t stages[X_LINK_STAGE_COUNT];
+} XLinkStageProf_t;
+
+/**
+ * @brief Internal locks whose wait time is profiled, see XLinkGetLockProfilingData
+ */
+typedef enum{
+    X_LINK_LOCK_LINKS = 0,      // table of links, taken by every link and stream lookup
+    X_LINK_LOCK_EVENT_QUEUE,    // event queues of a link's dispatcher, summed over links
+    X_LINK_LOCK_SEMAPHORE_REFS, // reference counts of the XLink semaphores
+    X_LINK_LOCK_DEVICE_FD,      // map of platform device fds, taken by every platform read and write
+    X_LINK_LOCK_COUNT
+} XLinkLock_t;
+
+typedef struct XLinkLockProf_t
+{
+    uint64_t acquisitions;
+    uint64_t totalWaitNs;
+    uint64_t maxWaitNs;
+} XLinkLockProf_t;
+
+/**
+ * @brief Scheduling class of a stream. Pending events of higher classes are
+ *        dispatched first, long waiting events of lower classes get promoted
+ */
+typedef enum{
+    X_LINK_PRIORITY_NORMAL = 0,
+    X_LINK_PRIORITY_HIGH,
+    X_LINK_PRIORITY_CONTROL,
+} XLinkStreamPriority_t;
+
+/**
+ * @brief Implementation of TCP/IP links, see XLinkSetTcpBackend
+ */
+typedef enum{
+    X_LINK_TCP_BACKEND_SOCKETS = 0, // blocking socket calls
+    X_LINK_TCP_BACKEND_IO_URING,    // one io_uring for all links, receives stay posted, Linux only
+} XLinkTcpBackend_t;
+
+/**
+ * @brief Optional per-stream behaviour, see XLinkOpenStreamWithOptions
+ * @note Zero initialized options give the same behaviour as XLinkOpenStream
+ */
+typedef struct XLinkStreamOptions_t
+{
+    /// Accumulates released packets and returns them to the remote as one cumulative
+    /// credit once this many packets were released. 0 disables batching
+    uint32_t releaseBatchPackets;
+    /// Credit is also returned once this many bytes were released. 0 or values larger
+    /// than half of the remote write window are capped to half of the window
+    uint32_t releaseBatchBytes;
+    /// Credit is also returned at the latest this long after the first batched release
+    uint32_t releaseBatchTimeoutUs;
+    /// Nonzero makes writes complete as soon as they are handed to the transport and fit
+    /// the remote buffer, instead of waiting for a response from the remote per packet.
+    /// The remote acknowledges such writes cumulatively, closing the stream waits for it
+    uint32_t postedWrites;
+    /// Scheduling class of the stream events on this side of the link
+    XLinkStreamPriority_t priority;
+    /// Writes larger than this are sent as fragments of at most this size, which
+    /// other traffic of the link is interleaved with. 0 sends writes in one piece
+    uint32_t fragmentSize;
+    /// Nonzero hands incoming packets to readers as soon as their data starts to arrive.
+    /// Wait for the data with XLinkWaitPacketData before accessing it. Local to this side
+    uint32_t progressiveDelivery;
+    /// Keeps the buffers of up to this many released packets, at most XLINK_MAX_RECYCLED_BUFFERS,
+    /// and receives later packets into them instead of allocating. Buffers of moved packets
+    /// are kept when handed back with XLinkRecycleMoveData. Local to this side
+    uint32_t recycledBuffers;
+    /// Nonzero lets many threads read the stream at once, each packet is handed to one of them.
+    /// Read packets stay valid until released with XLinkReleaseSpecificData, in any order.
+    /// XLinkReleaseData only releases moved packets. Local to this side
+    uint32_t sharedReads;
+    /// Keeps at most this many unread packets, the oldest one is dropped when another one
+    /// arrives and credited back to the remote right away, so a slow reader doesn't stall
+    /// the writer. See XLinkGetStreamDroppedPackets. 0 keeps every packet
+    uint32_t keepLatestPackets;
+} XLinkStreamOptions_t;
+
+/**
+ * @brief Options of XLinkStreamSinkToFd
+ * @note Zero initialized options write the payloads back to back
+ */
+typedef struct XLinkSinkOptions_t
+{
+    /// Nonzero precedes every payload with an XLinkSinkRecord_t
+    uint32_t framing;
+} XLinkSinkOptions_t;
+
+/**
+ * @brief Record preceding a payload written by XLinkStreamSinkToFd with framing, in host byte order
+ */
+typedef struct XLinkSinkRecord_t
+{
+    uint64_t length;           /// size of the payload which follows
+    XLinkTimespec tRemoteSent; /// as streamPacketDesc_t::tRemoteSent
+    XLinkTimespec tReceived;   /// as streamPacketDesc_t::tReceived
+} XLinkSinkRecord_t;
+
+/**
+ * @brief Options of XLinkBridgeStreams
+ * @note Zero initialized options leave the destination open
+ */
+typedef struct XLinkBridgeOptions_t
+{
+    /// Nonzero closes the destination stream once the bridge ends
+    uint32_t closeDestination;
+} XLinkBridgeOptions_t;
+
+/**
+ * @brief Options of XLinkBrokerPublish
+ * @note Zero initialized options keep 8 packets of up to 4 MB
+ */
+typedef struct XLinkBrokerOptions_t
+{
+    /// Packets kept for the readers, at most XLINK_BROKER_MAX_SLOTS
+    uint32_t slots;
+    /// Size of the largest packet, larger packets aren't published
+    uint32_t slotSize;
+} XLinkBrokerOptions_t;
+
+/**
+ * @brief Options of XLinkFanOutSubscribe
+ * @note Zero initialized options never drop packets
+ */
+typedef struct XLinkFanOutOptions_t
+{
+    /// Unread packets the subscriber may fall behind by, older ones are dropped for it.
+    /// 0 never drops, a slow subscriber then holds back the others and the remote
+    uint32_t maxLagPackets;
+} XLinkFanOutOptions_t;
+
 typedef struct XLinkGlobalHandler_t
 {
     int profEnable;
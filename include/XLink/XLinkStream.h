@@ -7,6 +7,15 @@
 
 #include "XLinkPublicDefines.h"
 #include "XLinkSemaphore.h"
+#include "XLinkHistogram.h"
+
+/**
+ * @brief Copies of the read packets of a stream with shared reads
+ */
+typedef struct{
+    streamPacketDesc_t packets[XLINK_MAX_PACKETS_PER_STREAM];
+    uint8_t held[XLINK_MAX_PACKETS_PER_STREAM];
+} streamSharedPackets_t;
 
 /**
  * @brief Streams opened to device
@@ -18,6 +27,8 @@ typedef struct{
     uint32_t readSize;  /*No need of read buffer. It's on remote,
     will read it directly to the requested buffer*/
     streamPacketDesc_t packets[XLINK_MAX_PACKETS_PER_STREAM];
+    // Sequence numbers of the packets above, moved along with them, see XLinkGetPacketSequence
+    uint32_t packetSequences[XLINK_MAX_PACKETS_PER_STREAM];
     uint32_t availablePackets;
     uint32_t blockedPackets;
 
@@ -31,6 +42,90 @@ typedef struct{
 
     uint32_t closeStreamInitiated;
 
+    // Release batching, see XLinkStreamOptions_t. Disabled when releaseBatchPackets is 0
+    uint32_t releaseBatchPackets;
+    uint32_t releaseBatchBytes;
+    uint32_t releaseBatchTimeoutUs;
+    // Released locally but not yet credited back to the remote
+    uint32_t pendingReleasePackets;
+    uint32_t pendingReleaseSize;
+    uint64_t pendingCreditDeadlineNs;
+
+    // Writes complete once sent, the remote acknowledges them cumulatively
+    uint32_t postedWrites;
+    // Posted writes sent but not yet acknowledged by the remote
+    uint32_t postedWritesInFlight;
+    // Posted writes received but not yet acknowledged to the remote
+    uint32_t pendingWriteAcks;
+
+    // XLinkStreamPriority_t of the events of this stream
+    uint32_t priority;
+
+    // Writes larger than this are fragmented, 0 if they aren't
+    uint32_t fragmentSize;
+    // A fragmented write is being sent, later writes wait for it
+    uint32_t fragmentedWriteInFlight;
+    // Reassembly of a fragmented write received from the remote, in progress while
+    // fragmentTotalSize isn't 0. Its data goes to fragmentBuffer, to the packet handed out
+    // by progressive delivery or to the sink the write started on, fragmentSinkFd
+    uint8_t* fragmentBuffer;
+    int fragmentSinkFd;
+    uint32_t fragmentSinking;
+    uint32_t fragmentTotalSize;
+    uint32_t fragmentReceivedSize;
+    int32_t fragmentEventId;
+    uint32_t fragmentFlags;
+    XLinkTimespec fragmentSent;
+
+    // Packets are handed out while their data is still arriving, see XLinkWaitPacketData
+    uint32_t progressiveDelivery;
+    // Packet whose data is being received and how much of it arrived, guarded by
+    // progressiveDataMutex. The packet whose transfer last broke off is kept apart
+    // until its buffer starts another packet
+    uint8_t* progressiveData;
+    uint32_t progressiveSize;
+    uint8_t* progressiveFailedData;
+    uint32_t progressiveFailedSize;
+
+    // Buffers of released packets which later packets are received into, see
+    // XLinkStreamOptions_t. recycledSizes are their sizes aligned to the cache line
+    uint32_t recycleLimit;
+    uint32_t recycledCount;
+    uint8_t* recycledBuffers[XLINK_MAX_RECYCLED_BUFFERS];
+    uint32_t recycledSizes[XLINK_MAX_RECYCLED_BUFFERS];
+
+    // Packets are read by many threads, see XLinkStreamOptions_t. Read packets are handed out
+    // as copies in sharedPackets, which stay put while the circular buffer is compacted.
+    // Allocated on the first shared read and kept with the slot, readers may still hold them
+    uint32_t sharedReads;
+    streamSharedPackets_t* sharedPackets;
+
+    // Unread packets beyond this many are dropped, oldest first, see XLinkStreamOptions_t
+    uint32_t keepLatestPackets;
+    uint64_t droppedPackets;
+    // Sequence number of the next received packet
+    uint32_t receivedPackets;
+
+    // Payloads are written to sinkFd instead of becoming packets, see XLinkStreamSinkToFd.
+    // sinkFailed is set once the file didn't take a payload
+    uint32_t sinkActive;
+    int sinkFd;
+    uint32_t sinkFraming;
+    uint32_t sinkFailed;
+    // A payload is written to sinkWritingFd without holding the stream. These and sinkFailed
+    // are guarded by progressiveDataMutex
+    uint32_t sinkWriting;
+    int sinkWritingFd;
+
+    // Reads fail instead of blocking while no packet is available, see interruptStreamReads
+    uint32_t readsInterrupted;
+
+    // Recorded without taking the stream, see xLinkLatency_t. Allocated when the slot is
+    // first opened and kept with it, as recorders may still look at a closed stream
+    xLinkLatencyHistograms_t* latency;
+    // Of all events of the stream, see XLinkStage_t. Kept with the slot as well
+    xLinkStageHistograms_t* stages;
+
     XLink_sem_t sem;
 }streamDesc_t;
 
@@ -39,4 +134,9 @@ XLinkError_t XLinkStreamInitialize(
 
 void XLinkStreamReset(streamDesc_t* stream);
 
+// Buffer pool of the stream, the caller holds the stream
+uint8_t* XLinkStreamAllocateBuffer(streamDesc_t* stream, uint32_t size);
+void XLinkStreamRecycleBuffer(streamDesc_t* stream, uint8_t* buffer, uint32_t size);
+void XLinkStreamFreeRecycled(streamDesc_t* stream);
+
 #endif //_XLINKSTREAM_H
@@ -12,6 +12,7 @@ typedef struct XLinkTimespec {
 } XLinkTimespec;
 
 void getMonotonicTimestamp(XLinkTimespec* ts);
+uint64_t getMonotonicTimestampNs(void);
 
 #ifdef __cplusplus
 }
@@ -0,0 +1,46 @@
+// Copyright (C) 2018-2021 Intel Corporation
+// SPDX-License-Identifier: Apache-2.0
+//
+
+///
+/// @file
+///
+/// @brief     In-memory trace ring of the XLink events, see XLinkTraceStart
+///
+
+#ifndef _XLINKTRACE_H
+#define _XLINKTRACE_H
+
+#include <stdint.h>
+#include <stdio.h>
+#include "XLinkPublicDefines.h"
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+typedef enum {
+    XLINK_TRACE_CALL = 0,  // an API call, from queueing its event until the caller woke up
+    XLINK_TRACE_SEND,      // an event written to the platform
+    XLINK_TRACE_RECEIVE,   // an event read from the platform, from its header on
+    XLINK_TRACE_BLOCK,     // an event waiting for data or room on the remote, instant
+    XLINK_TRACE_UNBLOCK,   // instant
+} xLinkTracePhase_t;
+
+// Recording allocates the ring on the first start only, later starts clear it.
+// A capacity of 0 takes the default
+void XLinkTraceRingStart(uint32_t capacity);
+void XLinkTraceRingStop(void);
+int XLinkTraceEnabled(void);
+// Lock-free, a no-op unless enabled. Instant phases pass startNs == endNs
+void XLinkTraceRecord(xLinkTracePhase_t phase, uint32_t linkId, uint32_t eventType,
+                      uint32_t streamId, uint32_t size, uint64_t startNs, uint64_t endNs);
+// Chrome trace event JSON, which Perfetto opens as well
+int XLinkTraceRingDump(FILE* file);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif //_XLINKTRACE_H
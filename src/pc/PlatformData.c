@@ -2,6 +2,10 @@
 // SPDX-License-Identifier: Apache-2.0
 //
 
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE // splice and F_SETPIPE_SZ
+#endif
+
 #include <stdio.h>
 #include <stdlib.h>
 #include <errno.h>
@@ -14,6 +18,9 @@
 #include "usb_host.h"
 #include "pcie_host.h"
 #include "tcpip_host.h"
+#include "tcpip_uring.h"
+#include "tcpip_zerocopy.h"
+#include "ipc_host.h"
 #include "PlatformDeviceFd.h"
 #include "inttypes.h"
 
@@ -31,12 +38,27 @@
 #pragma comment(lib, "Ws2_32.lib")
 #else
 #include <sys/socket.h>
+#include <netinet/tcp.h>
 #include <arpa/inet.h>
 #include <netdb.h>
 #include <unistd.h>
 #include <signal.h>
 #endif
 
+#if defined(__linux__)
+#include <fcntl.h>
+#include <pthread.h>
+#include <sys/sendfile.h>
+#include <sys/stat.h>
+#endif
+
+// Files are read through a buffer of this size by protocols which can't send from them
+#define FILE_BOUNCE_BUFFER_SIZE (1024 * 1024)
+// Capacity requested for the pipe which TCP/IP data is spliced into files through
+#define SINK_PIPE_SIZE (1024 * 1024)
+// Stack buffer of the copying fallbacks of XLinkPlatformReadToFd
+#define SINK_COPY_CHUNK (16 * 1024)
+
 #ifdef USE_LINK_JTAG
 #include <sys/types.h>
 #include <sys/socket.h>
@@ -63,9 +85,26 @@ extern int usbFdRead;
 
 static int pciePlatformRead(void *f, void *data, int size);
 static int tcpipPlatformRead(void *fd, void *data, int size);
+static int ipcPlatformRead(void *fd, void *data, int size);
 
 static int pciePlatformWrite(void *f, void *data, int size);
 static int tcpipPlatformWrite(void *fd, void *data, int size);
+static int tcpipPlatformWriteMessage(void *fd, void *header, int headerSize, void *data, int size);
+static int tcpipPlatformWriteFromFd(void *fd, int fileFd, uint64_t offset, int size);
+static int tcpipPlatformLimitSendQueue(void *fd, uint32_t bytes);
+static int bouncePlatformWriteFromFd(xLinkDeviceHandle_t *deviceHandle, int fileFd, uint64_t offset, int size);
+static int tcpipPlatformReadToFd(void *fd, int fileFd, const void *prefix, int prefixSize, int size);
+static int bouncePlatformReadToFd(xLinkDeviceHandle_t *deviceHandle, int fileFd, const void *prefix, int prefixSize, int size);
+#if !(defined(_WIN32) || defined(_WIN64))
+static int writeAll(int fd, const void *data, int size);
+#endif
+#if defined(USE_TCP_IP) && defined(__linux__)
+static int* getSinkPipe(void);
+#endif
+#if defined(USE_TCP_IP)
+static int tcpipSocketSend(TCPIP_SOCKET sock, void *data, int size);
+#endif
+static int ipcPlatformWrite(void *fd, void *data, int size);
 
 // ------------------------------------
 // Wrappers declaration. End.
@@ -94,11 +133,65 @@ int XLinkPlatformWrite(xLinkDeviceHandle_t *deviceHandle, void *data, int size)
         case X_LINK_TCP_IP:
             return tcpipPlatformWrite(deviceHandle->xLinkFD, data, size);
 
+        case X_LINK_IPC:
+        case X_LINK_LOOPBACK:
+            return ipcPlatformWrite(deviceHandle->xLinkFD, data, size);
+
         default:
             return X_LINK_PLATFORM_INVALID_PARAMETERS;
     }
 }
 
+int XLinkPlatformWriteMessage(xLinkDeviceHandle_t *deviceHandle, void *header, int headerSize, void *data, int size)
+{
+    if(deviceHandle->protocol == X_LINK_TCP_IP && XLinkIsProtocolInitialized(deviceHandle->protocol)) {
+        return tcpipPlatformWriteMessage(deviceHandle->xLinkFD, header, headerSize, data, size);
+    }
+
+    int rc = XLinkPlatformWrite(deviceHandle, header, headerSize);
+    if(rc < 0 || size == 0) {
+        return rc;
+    }
+    return XLinkPlatformWrite(deviceHandle, data, size);
+}
+
+int XLinkPlatformLimitSendQueue(xLinkDeviceHandle_t *deviceHandle, uint32_t bytes)
+{
+    if(deviceHandle->protocol == X_LINK_TCP_IP && XLinkIsProtocolInitialized(deviceHandle->protocol)) {
+        return tcpipPlatformLimitSendQueue(deviceHandle->xLinkFD, bytes);
+    }
+    // the other protocols hand the data over as it's written
+    return 0;
+}
+
+int XLinkPlatformWriteFromFd(xLinkDeviceHandle_t *deviceHandle, int fd, uint64_t offset, int size)
+{
+    if(!XLinkIsProtocolInitialized(deviceHandle->protocol)) {
+        return X_LINK_PLATFORM_DRIVER_NOT_LOADED+deviceHandle->protocol;
+    }
+
+#if defined(__linux__)
+    if(deviceHandle->protocol == X_LINK_TCP_IP) {
+        return tcpipPlatformWriteFromFd(deviceHandle->xLinkFD, fd, offset, size);
+    }
+#endif
+    return bouncePlatformWriteFromFd(deviceHandle, fd, offset, size);
+}
+
+int XLinkPlatformReadToFd(xLinkDeviceHandle_t *deviceHandle, int fd, const void *prefix, int prefixSize, int size)
+{
+    if(!XLinkIsProtocolInitialized(deviceHandle->protocol)) {
+        return X_LINK_PLATFORM_DRIVER_NOT_LOADED+deviceHandle->protocol;
+    }
+
+#if defined(__linux__)
+    if(deviceHandle->protocol == X_LINK_TCP_IP) {
+        return tcpipPlatformReadToFd(deviceHandle->xLinkFD, fd, prefix, prefixSize, size);
+    }
+#endif
+    return bouncePlatformReadToFd(deviceHandle, fd, prefix, prefixSize, size);
+}
+
 int XLinkPlatformRead(xLinkDeviceHandle_t *deviceHandle, void *data, int size)
 {
     if(!XLinkIsProtocolInitialized(deviceHandle->protocol)) {
@@ -116,6 +209,10 @@ int XLinkPlatformRead(xLinkDeviceHandle_t *deviceHandle, void *data, int size)
         case X_LINK_TCP_IP:
             return tcpipPlatformRead(deviceHandle->xLinkFD, data, size);
 
+        case X_LINK_IPC:
+        case X_LINK_LOOPBACK:
+            return ipcPlatformRead(deviceHandle->xLinkFD, data, size);
+
         default:
             return X_LINK_PLATFORM_INVALID_PARAMETERS;
     }
@@ -274,6 +371,11 @@ static int tcpipPlatformRead(void *fdKey, void *data, int size)
     }
     TCPIP_SOCKET sock = (TCPIP_SOCKET) (uintptr_t) tmpsockfd;
 
+    int uringRc = tcpip_uring_read(sock, data, size);
+    if(uringRc != TCPIP_URING_NOT_ATTACHED) {
+        return uringRc;
+    }
+
     while(nread < size)
     {
         int rc = recv(sock, &((char*)data)[nread], size - nread, 0);
@@ -291,10 +393,70 @@ static int tcpipPlatformRead(void *fdKey, void *data, int size)
 }
 
 static int tcpipPlatformWrite(void *fdKey, void *data, int size)
+{
+    return tcpipPlatformWriteMessage(fdKey, data, size, NULL, 0);
+}
+
+static int tcpipPlatformWriteMessage(void *fdKey, void *header, int headerSize, void *data, int size)
 {
 #if defined(USE_TCP_IP)
+    void* tmpsockfd = NULL;
+    if(getPlatformDeviceFdFromKey(fdKey, &tmpsockfd)){
+        mvLog(MVLOG_FATAL, "Cannot find file descriptor by key: %" PRIxPTR, (uintptr_t) fdKey);
+        return -1;
+    }
+    TCPIP_SOCKET sock = (TCPIP_SOCKET) (uintptr_t) tmpsockfd;
+
+    // one submission for both, sockets send them one after the other
+    int uringRc = tcpip_uring_write(sock, header, headerSize, data, size);
+    if(uringRc != TCPIP_URING_NOT_ATTACHED) {
+        return uringRc;
+    }
+
+    if(tcpipSocketSend(sock, header, headerSize) || tcpipSocketSend(sock, data, size)) {
+        return -1;
+    }
+#endif
+    return 0;
+}
+
+static int tcpipPlatformWriteFromFd(void *fdKey, int fileFd, uint64_t offset, int size)
+{
+#if defined(USE_TCP_IP) && defined(__linux__)
+    void* tmpsockfd = NULL;
+    if(getPlatformDeviceFdFromKey(fdKey, &tmpsockfd)){
+        mvLog(MVLOG_FATAL, "Cannot find file descriptor by key: %" PRIxPTR, (uintptr_t) fdKey);
+        return -1;
+    }
+    TCPIP_SOCKET sock = (TCPIP_SOCKET) (uintptr_t) tmpsockfd;
+
+    // the kernel moves the pages of the file to the socket
+    off_t fileOffset = (off_t) offset;
     int byteCount = 0;
+    while(byteCount < size) {
+        ssize_t rc = sendfile(sock, fileFd, &fileOffset, size - byteCount);
+        if(rc < 0 && errno == EINTR) {
+            continue;
+        }
+        if(rc <= 0) {
+            // the file ended early or the link is gone
+            return -1;
+        }
+        byteCount += (int) rc;
+    }
+    return 0;
+#else
+    (void) fdKey;
+    (void) fileFd;
+    (void) offset;
+    (void) size;
+    return -1;
+#endif
+}
 
+static int tcpipPlatformLimitSendQueue(void *fdKey, uint32_t bytes)
+{
+#if defined(USE_TCP_IP) && defined(TCP_NOTSENT_LOWAT)
     void* tmpsockfd = NULL;
     if(getPlatformDeviceFdFromKey(fdKey, &tmpsockfd)){
         mvLog(MVLOG_FATAL, "Cannot find file descriptor by key: %" PRIxPTR, (uintptr_t) fdKey);
@@ -302,6 +464,251 @@ static int tcpipPlatformWrite(void *fdKey, void *data, int size)
     }
     TCPIP_SOCKET sock = (TCPIP_SOCKET) (uintptr_t) tmpsockfd;
 
+    // the socket buffers grow to megabytes, every event written would wait behind all of it.
+    // Sends block until the data not sent yet is below the limit
+    int limit = (int) bytes;
+    if(setsockopt(sock, IPPROTO_TCP, TCP_NOTSENT_LOWAT, &limit, sizeof(limit)) < 0) {
+        mvLog(MVLOG_WARN, "Limiting the send queue of the socket failed: %s", strerror(errno));
+        return -1;
+    }
+    return 0;
+#else
+    (void) fdKey;
+    (void) bytes;
+    return 0;
+#endif
+}
+
+static int bouncePlatformWriteFromFd(xLinkDeviceHandle_t *deviceHandle, int fileFd, uint64_t offset, int size)
+{
+#if (defined(_WIN32) || defined(_WIN64))
+    (void) deviceHandle;
+    (void) fileFd;
+    (void) offset;
+    (void) size;
+    return X_LINK_PLATFORM_ERROR;
+#else
+    int bufferSize = size < FILE_BOUNCE_BUFFER_SIZE ? size : FILE_BOUNCE_BUFFER_SIZE;
+    uint8_t* buffer = (uint8_t*) malloc(bufferSize > 0 ? bufferSize : 1);
+    if(buffer == NULL) {
+        return X_LINK_PLATFORM_ERROR;
+    }
+
+    int rc = 0;
+    int byteCount = 0;
+    while(byteCount < size && rc >= 0) {
+        int chunk = size - byteCount < bufferSize ? size - byteCount : bufferSize;
+        ssize_t readCount = pread(fileFd, buffer, chunk, (off_t) (offset + byteCount));
+        if(readCount < 0 && errno == EINTR) {
+            continue;
+        }
+        if(readCount <= 0) {
+            rc = -1;
+            break;
+        }
+        rc = XLinkPlatformWrite(deviceHandle, buffer, (int) readCount);
+        byteCount += (int) readCount;
+    }
+    free(buffer);
+    return rc < 0 ? rc : 0;
+#endif
+}
+
+static int tcpipPlatformReadToFd(void *fdKey, int fileFd, const void *prefix, int prefixSize, int size)
+{
+#if defined(USE_TCP_IP) && defined(__linux__)
+    void* tmpsockfd = NULL;
+    if(getPlatformDeviceFdFromKey(fdKey, &tmpsockfd)){
+        mvLog(MVLOG_FATAL, "Cannot find file descriptor by key: %" PRIxPTR, (uintptr_t) fdKey);
+        return -1;
+    }
+    TCPIP_SOCKET sock = (TCPIP_SOCKET) (uintptr_t) tmpsockfd;
+
+    // once the file failed, the rest of the data is still read so the link stays in sync
+    int failed = prefixSize > 0 && writeAll(fileFd, prefix, prefixSize);
+    uint8_t chunk[SINK_COPY_CHUNK];
+    int received = 0;
+
+    // the io_uring backend keeps a receive posted, so its sockets are only read through it
+    while(received < size) {
+        int left = size - received;
+        int n = left < SINK_COPY_CHUNK ? left : SINK_COPY_CHUNK;
+        int rc = tcpip_uring_read(sock, chunk, n);
+        if(rc == TCPIP_URING_NOT_ATTACHED) {
+            break;
+        }
+        if(rc < 0) {
+            return -1;
+        }
+        failed = failed || writeAll(fileFd, chunk, n);
+        received += n;
+    }
+
+    // pipes take the data straight from the socket, other files through a pipe of this thread
+    struct stat fileStat;
+    int direct = fstat(fileFd, &fileStat) == 0 && S_ISFIFO(fileStat.st_mode);
+    int* sinkPipe = direct ? NULL : getSinkPipe();
+
+    while(received < size) {
+        int left = size - received;
+        if(failed || (!direct && sinkPipe == NULL)) {
+            int rc = recv(sock, chunk, left < SINK_COPY_CHUNK ? left : SINK_COPY_CHUNK, 0);
+            if(rc < 0 && errno == EINTR) {
+                continue;
+            }
+            if(rc <= 0) {
+                return -1;
+            }
+            failed = failed || writeAll(fileFd, chunk, rc);
+            received += rc;
+            continue;
+        }
+
+        ssize_t moved = splice(sock, NULL, direct ? fileFd : sinkPipe[1], NULL, left, SPLICE_F_MOVE);
+        if(moved < 0 && errno == EINTR) {
+            continue;
+        }
+        if(moved < 0 && direct && errno != EAGAIN) {
+            // the pipe's reader is gone, nothing was taken from the socket
+            failed = 1;
+            continue;
+        }
+        if(moved <= 0) {
+            return -1;
+        }
+        received += (int) moved;
+
+        while(!direct && moved > 0) {
+            ssize_t out = -1;
+            if(!failed) {
+                out = splice(sinkPipe[0], NULL, fileFd, NULL, moved, SPLICE_F_MOVE);
+                if(out < 0 && errno == EINTR) {
+                    continue;
+                }
+            }
+            if(out <= 0) {
+                // files splice can't write to, e.g. opened with O_APPEND, get the rest copied
+                int rc = read(sinkPipe[0], chunk, moved < SINK_COPY_CHUNK ? moved : SINK_COPY_CHUNK);
+                if(rc <= 0) {
+                    return -1;
+                }
+                failed = failed || writeAll(fileFd, chunk, rc);
+                out = rc;
+            }
+            moved -= out;
+        }
+    }
+    return failed ? X_LINK_PLATFORM_FD_WRITE_FAILED : 0;
+#else
+    (void) fdKey;
+    (void) fileFd;
+    (void) prefix;
+    (void) prefixSize;
+    (void) size;
+    return -1;
+#endif
+}
+
+static int bouncePlatformReadToFd(xLinkDeviceHandle_t *deviceHandle, int fileFd, const void *prefix, int prefixSize, int size)
+{
+#if (defined(_WIN32) || defined(_WIN64))
+    (void) deviceHandle;
+    (void) fileFd;
+    (void) prefix;
+    (void) prefixSize;
+    (void) size;
+    return X_LINK_PLATFORM_ERROR;
+#else
+    int bufferSize = size < FILE_BOUNCE_BUFFER_SIZE ? size : FILE_BOUNCE_BUFFER_SIZE;
+    uint8_t* buffer = (uint8_t*) malloc(bufferSize > 0 ? bufferSize : 1);
+    if(buffer == NULL) {
+        return X_LINK_PLATFORM_ERROR;
+    }
+
+    // once the file failed, the rest of the data is still read so the link stays in sync
+    int failed = prefixSize > 0 && writeAll(fileFd, prefix, prefixSize);
+    int received = 0;
+    while(received < size) {
+        int chunk = size - received < bufferSize ? size - received : bufferSize;
+        int rc = XLinkPlatformRead(deviceHandle, buffer, chunk);
+        if(rc < 0) {
+            free(buffer);
+            return rc;
+        }
+        failed = failed || writeAll(fileFd, buffer, chunk);
+        received += chunk;
+    }
+    free(buffer);
+    return failed ? X_LINK_PLATFORM_FD_WRITE_FAILED : 0;
+#endif
+}
+
+#if !(defined(_WIN32) || defined(_WIN64))
+static int writeAll(int fd, const void *data, int size)
+{
+    int byteCount = 0;
+    while(byteCount < size) {
+        ssize_t rc = write(fd, (const uint8_t*) data + byteCount, size - byteCount);
+        if(rc < 0 && errno == EINTR) {
+            continue;
+        }
+        if(rc <= 0) {
+            mvLog(MVLOG_ERROR, "Writing to file descriptor %d failed (errno %d)", fd, errno);
+            return -1;
+        }
+        byteCount += (int) rc;
+    }
+    return 0;
+}
+#endif
+
+#if defined(USE_TCP_IP) && defined(__linux__)
+static pthread_once_t sinkPipeOnce = PTHREAD_ONCE_INIT;
+static pthread_key_t sinkPipeKey;
+
+static void closeSinkPipe(void *fds)
+{
+    close(((int*) fds)[0]);
+    close(((int*) fds)[1]);
+    free(fds);
+}
+
+static void createSinkPipeKey(void)
+{
+    pthread_key_create(&sinkPipeKey, closeSinkPipe);
+}
+
+// Each link reads on its own thread, which keeps its pipe until it exits
+static int* getSinkPipe(void)
+{
+    pthread_once(&sinkPipeOnce, createSinkPipeKey);
+    int* fds = (int*) pthread_getspecific(sinkPipeKey);
+    if(fds != NULL) {
+        return fds;
+    }
+
+    fds = (int*) malloc(2 * sizeof(int));
+    if(fds == NULL || pipe(fds) != 0) {
+        free(fds);
+        return NULL;
+    }
+    // larger pipes take more of a packet per splice, the default size works too
+    fcntl(fds[1], F_SETPIPE_SZ, SINK_PIPE_SIZE);
+    pthread_setspecific(sinkPipeKey, fds);
+    return fds;
+}
+#endif
+
+#if defined(USE_TCP_IP)
+static int tcpipSocketSend(TCPIP_SOCKET sock, void *data, int size)
+{
+    // large writes skip the copy into the socket buffer
+    int zerocopyRc = tcpip_zerocopy_send(sock, data, size);
+    if(zerocopyRc != TCPIP_ZEROCOPY_NOT_USED) {
+        return zerocopyRc;
+    }
+
+    int byteCount = 0;
     while(byteCount < size)
     {
         // Use send instead of write and ignore SIGPIPE
@@ -323,9 +730,29 @@ static int tcpipPlatformWrite(void *fdKey, void *data, int size)
             byteCount += rc;
         }
     }
-#endif
     return 0;
 }
+#endif
+
+static int ipcPlatformRead(void *fdKey, void *data, int size)
+{
+    void* conn = NULL;
+    if(getPlatformDeviceFdFromKey(fdKey, &conn)){
+        mvLog(MVLOG_FATAL, "Cannot find file descriptor by key: %" PRIxPTR, (uintptr_t) fdKey);
+        return -1;
+    }
+    return ipc_read(conn, data, size);
+}
+
+static int ipcPlatformWrite(void *fdKey, void *data, int size)
+{
+    void* conn = NULL;
+    if(getPlatformDeviceFdFromKey(fdKey, &conn)){
+        mvLog(MVLOG_FATAL, "Cannot find file descriptor by key: %" PRIxPTR, (uintptr_t) fdKey);
+        return -1;
+    }
+    return ipc_write(conn, data, size);
+}
 
 // ------------------------------------
 // Wrappers implementation. End.
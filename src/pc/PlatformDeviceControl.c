@@ -10,6 +10,9 @@
 #include "usb_host.h"
 #include "pcie_host.h"
 #include "tcpip_host.h"
+#include "tcpip_uring.h"
+#include "tcpip_zerocopy.h"
+#include "ipc_host.h"
 #include "XLinkStringUtils.h"
 #include "PlatformDeviceFd.h"
 
@@ -29,6 +32,13 @@ int usbFdRead = -1;
 
 #include "XLinkPublicDefines.h"
 
+#if !(defined(_WIN32) || defined(_WIN64))
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
 #define USB_LINK_SOCKET_PORT 5678
 #define UNUSED __attribute__((unused))
 
@@ -64,6 +74,12 @@ static const int statuswaittimeout = 5;
 
 static int pciePlatformConnect(UNUSED const char *devPathRead, const char *devPathWrite, void **fd);
 static int tcpipPlatformConnect(const char *devPathRead, const char *devPathWrite, void **fd);
+static int ipcPlatformConnect(const char *devPathRead, const char *devPathWrite, void **fd);
+static int loopbackPlatformConnect(const char *devPathRead, const char *devPathWrite, void **fd);
+
+static int tcpipPlatformServer(const char *devPathRead, const char *devPathWrite, void **fd);
+static int ipcPlatformServer(const char *devPathRead, const char *devPathWrite, void **fd);
+static int loopbackPlatformServer(const char *devPathRead, const char *devPathWrite, void **fd);
 
 static xLinkPlatformErrorCode_t usbPlatformBootBootloader(const char *name);
 static int pciePlatformBootBootloader(const char *name);
@@ -71,6 +87,7 @@ static xLinkPlatformErrorCode_t tcpipPlatformBootBootloader(const char *name);
 
 static int pciePlatformClose(void *f);
 static int tcpipPlatformClose(void *fd);
+static int ipcPlatformClose(void *fd);
 
 static int pciePlatformBootFirmware(const deviceDesc_t* deviceDesc, const char* firmware, size_t length);
 static int tcpipPlatformBootFirmware(const deviceDesc_t* deviceDesc, const char* firmware, size_t length);
@@ -92,12 +109,19 @@ xLinkPlatformErrorCode_t XLinkPlatformInit(void* options)
     for(int i = 0; i < X_LINK_NMB_OF_PROTOCOLS; i++) {
         xlinkSetProtocolInitialized(i, 1);
     }
+    xlinkSetProtocolInitialized(X_LINK_LOOPBACK, 1);
 
     // check for failed initialization; LIBUSB_SUCCESS = 0
     if (usbInitialize(options) != 0) {
         xlinkSetProtocolInitialized(X_LINK_USB_VSC, 0);
     }
 
+#if !defined(__linux__)
+    // shared memory rings rely on futexes
+    xlinkSetProtocolInitialized(X_LINK_IPC, 0);
+    xlinkSetProtocolInitialized(X_LINK_LOOPBACK, 0);
+#endif
+
     // TODO(themarpe) - move to tcpip_host
     //tcpipInitialize();
 #if (defined(_WIN32) || defined(_WIN64)) && defined(USE_TCP_IP)
@@ -110,6 +134,32 @@ xLinkPlatformErrorCode_t XLinkPlatformInit(void* options)
 
 xLinkPlatformErrorCode_t XLinkPlatformBootRemote(const deviceDesc_t* deviceDesc, const char* binaryPath)
 {
+#if !(defined(_WIN32) || defined(_WIN64))
+    // the firmware is booted from a mapping of the file, without reading it into the heap first
+    int fd = open(binaryPath, O_RDONLY);
+    if(fd < 0) {
+        mvLog(MVLOG_ERROR, "Cannot open file by path: %s", binaryPath);
+        return -7;
+    }
+
+    struct stat fileStat;
+    if(fstat(fd, &fileStat) != 0 || fileStat.st_size <= 0) {
+        mvLog(MVLOG_ERROR, "cannot get the size of the file %s", binaryPath);
+        close(fd);
+        return -7;
+    }
+    size_t file_size = (size_t) fileStat.st_size;
+    void* image = mmap(NULL, file_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if(image == MAP_FAILED) {
+        mvLog(MVLOG_ERROR, "cannot map the file %s", binaryPath);
+        return -3;
+    }
+
+    xLinkPlatformErrorCode_t rc = XLinkPlatformBootFirmware(deviceDesc, (const char*) image, file_size) ? -1 : 0;
+    munmap(image, file_size);
+    return rc;
+#else
     FILE *file;
     long file_size;
 
@@ -148,6 +198,7 @@ xLinkPlatformErrorCode_t XLinkPlatformBootRemote(const deviceDesc_t* deviceDesc,
 
     free(image_buffer);
     return 0;
+#endif
 }
 
 xLinkPlatformErrorCode_t XLinkPlatformBootFirmware(const deviceDesc_t* deviceDesc, const char* firmware, size_t length) {
@@ -190,6 +241,60 @@ xLinkPlatformErrorCode_t XLinkPlatformConnect(const char* devPathRead, const cha
         case X_LINK_TCP_IP:
             return tcpipPlatformConnect(devPathRead, devPathWrite, fd);
 
+        case X_LINK_IPC:
+            return ipcPlatformConnect(devPathRead, devPathWrite, fd);
+
+        case X_LINK_LOOPBACK:
+            return loopbackPlatformConnect(devPathRead, devPathWrite, fd);
+
+        default:
+            return X_LINK_PLATFORM_INVALID_PARAMETERS;
+    }
+}
+
+xLinkPlatformErrorCode_t XLinkPlatformServer(const char* devPathRead, const char* devPathWrite, XLinkProtocol_t protocol, void** fd)
+{
+    if(!XLinkIsProtocolInitialized(protocol)) {
+        return X_LINK_PLATFORM_DRIVER_NOT_LOADED+protocol;
+    }
+    switch (protocol) {
+        case X_LINK_TCP_IP:
+            return tcpipPlatformServer(devPathRead, devPathWrite, fd);
+
+        case X_LINK_IPC:
+            return ipcPlatformServer(devPathRead, devPathWrite, fd);
+
+        case X_LINK_LOOPBACK:
+            return loopbackPlatformServer(devPathRead, devPathWrite, fd);
+
+        default:
+            return X_LINK_PLATFORM_INVALID_PARAMETERS;
+    }
+}
+
+xLinkPlatformErrorCode_t XLinkPlatformServerAnnounce(const deviceDesc_t* deviceDesc)
+{
+    if(!XLinkIsProtocolInitialized(deviceDesc->protocol)) {
+        return X_LINK_PLATFORM_DRIVER_NOT_LOADED+deviceDesc->protocol;
+    }
+    switch (deviceDesc->protocol) {
+        case X_LINK_TCP_IP:
+            return tcpip_announce_start(deviceDesc->mxid, deviceDesc->state);
+
+        default:
+            return X_LINK_PLATFORM_INVALID_PARAMETERS;
+    }
+}
+
+xLinkPlatformErrorCode_t XLinkPlatformServerAnnounceStop(XLinkProtocol_t protocol)
+{
+    if(!XLinkIsProtocolInitialized(protocol)) {
+        return X_LINK_PLATFORM_DRIVER_NOT_LOADED+protocol;
+    }
+    switch (protocol) {
+        case X_LINK_TCP_IP:
+            return tcpip_announce_stop();
+
         default:
             return X_LINK_PLATFORM_INVALID_PARAMETERS;
     }
@@ -216,6 +321,25 @@ xLinkPlatformErrorCode_t XLinkPlatformBootBootloader(const char* name, XLinkProt
     }
 }
 
+xLinkPlatformErrorCode_t XLinkPlatformSetTcpBackend(XLinkTcpBackend_t backend)
+{
+    if(backend != X_LINK_TCP_BACKEND_SOCKETS && backend != X_LINK_TCP_BACKEND_IO_URING) {
+        return X_LINK_PLATFORM_INVALID_PARAMETERS;
+    }
+    if(tcpip_uring_select(backend)) {
+        return X_LINK_PLATFORM_TCP_IP_DRIVER_NOT_LOADED;
+    }
+    return X_LINK_PLATFORM_SUCCESS;
+}
+
+xLinkPlatformErrorCode_t XLinkPlatformSetTcpZeroCopyThreshold(uint32_t bytes)
+{
+    if(tcpip_zerocopy_set_threshold(bytes)) {
+        return X_LINK_PLATFORM_TCP_IP_DRIVER_NOT_LOADED;
+    }
+    return X_LINK_PLATFORM_SUCCESS;
+}
+
 xLinkPlatformErrorCode_t XLinkPlatformCloseRemote(xLinkDeviceHandle_t* deviceHandle)
 {
     if(deviceHandle->protocol == X_LINK_ANY_PROTOCOL ||
@@ -238,6 +362,10 @@ xLinkPlatformErrorCode_t XLinkPlatformCloseRemote(xLinkDeviceHandle_t* deviceHan
         case X_LINK_TCP_IP:
             return tcpipPlatformClose(deviceHandle->xLinkFD);
 
+        case X_LINK_IPC:
+        case X_LINK_LOOPBACK:
+            return ipcPlatformClose(deviceHandle->xLinkFD);
+
         default:
             return X_LINK_PLATFORM_INVALID_PARAMETERS;
     }
@@ -360,14 +488,164 @@ int tcpipPlatformConnect(const char *devPathRead, const char *devPathWrite, void
         return -1;
     }
 
+    tcpip_zerocopy_enable(sock);
+    tcpip_uring_attach(sock);
+
+    // Store the socket and create a "unique" key instead
+    // (as file descriptors are reused and can cause a clash with lookups between scheduler and link)
+    *fd = createPlatformDeviceFdKey((void*) (uintptr_t) sock);
+
+#endif
+    return 0;
+}
+
+int ipcPlatformConnect(const char *devPathRead, const char *devPathWrite, void **fd)
+{
+    if (!devPathWrite || !fd) {
+        return X_LINK_PLATFORM_INVALID_PARAMETERS;
+    }
+
+    void* conn = NULL;
+    xLinkPlatformErrorCode_t rc = ipc_connect(devPathWrite, &conn);
+    if (rc != X_LINK_PLATFORM_SUCCESS) {
+        return rc;
+    }
+
+    *fd = createPlatformDeviceFdKey(conn);
+    return 0;
+}
+
+int loopbackPlatformConnect(const char *devPathRead, const char *devPathWrite, void **fd)
+{
+    if (!devPathWrite || !fd) {
+        return X_LINK_PLATFORM_INVALID_PARAMETERS;
+    }
+
+    void* conn = NULL;
+    xLinkPlatformErrorCode_t rc = ipc_loopback_connect(devPathWrite, &conn);
+    if (rc != X_LINK_PLATFORM_SUCCESS) {
+        return rc;
+    }
+
+    *fd = createPlatformDeviceFdKey(conn);
+    return 0;
+}
+
+int tcpipPlatformServer(const char *devPathRead, const char *devPathWrite, void **fd)
+{
+#if defined(USE_TCP_IP)
+    if (!devPathWrite || !fd) {
+        return X_LINK_PLATFORM_INVALID_PARAMETERS;
+    }
+
+    // Parse "ip[:port]", port defaults to the one hosts connect to
+    char serv_ip[64] = { 0 };
+    int port = TCPIP_LINK_SOCKET_PORT;
+    if (sscanf(devPathWrite, "%63[^:]:%d", serv_ip, &port) < 1) {
+        return X_LINK_PLATFORM_INVALID_PARAMETERS;
+    }
+
+    struct sockaddr_in serv_addr = { 0 };
+    serv_addr.sin_family = AF_INET;
+    serv_addr.sin_port = htons(port);
+    if (inet_pton(AF_INET, serv_ip, &serv_addr.sin_addr) <= 0) {
+        return X_LINK_PLATFORM_INVALID_PARAMETERS;
+    }
+
+    TCPIP_SOCKET listen_sock = socket(AF_INET, SOCK_STREAM, 0);
+#if (defined(_WIN32) || defined(_WIN64) )
+    if(listen_sock == INVALID_SOCKET)
+    {
+        return TCPIP_HOST_ERROR;
+    }
+#else
+    if(listen_sock < 0)
+    {
+        return TCPIP_HOST_ERROR;
+    }
+#endif
+
+    // Serving the same port again right after a link closed
+    int on = 1;
+    setsockopt(listen_sock, SOL_SOCKET, SO_REUSEADDR, (const char*) &on, sizeof(on));
+
+    if(bind(listen_sock, (struct sockaddr *) &serv_addr, sizeof(serv_addr)) < 0 || listen(listen_sock, 1) < 0)
+    {
+        mvLog(MVLOG_ERROR, "Cannot listen on %s", devPathWrite);
+        tcpip_close_socket(listen_sock);
+        return X_LINK_PLATFORM_ERROR;
+    }
+
+    // One host per link, later hosts are served by later calls
+    TCPIP_SOCKET sock = accept(listen_sock, NULL, NULL);
+    tcpip_close_socket(listen_sock);
+#if (defined(_WIN32) || defined(_WIN64) )
+    if(sock == INVALID_SOCKET)
+    {
+        return X_LINK_PLATFORM_ERROR;
+    }
+#else
+    if(sock < 0)
+    {
+        return X_LINK_PLATFORM_ERROR;
+    }
+#endif
+
+    // Disable sigpipe reception on send
+    #if defined(SO_NOSIGPIPE)
+        setsockopt(sock, SOL_SOCKET, SO_NOSIGPIPE, &on, sizeof(on));
+    #endif
+
+    if(setsockopt(sock, IPPROTO_TCP, TCP_NODELAY, (const char*) &on, sizeof(on)) < 0)
+    {
+        perror("setsockopt TCP_NODELAY");
+        tcpip_close_socket(sock);
+        return X_LINK_PLATFORM_ERROR;
+    }
+
+    tcpip_zerocopy_enable(sock);
+    tcpip_uring_attach(sock);
+
     // Store the socket and create a "unique" key instead
     // (as file descriptors are reused and can cause a clash with lookups between scheduler and link)
     *fd = createPlatformDeviceFdKey((void*) (uintptr_t) sock);
 
+    return 0;
 #endif
+    return X_LINK_PLATFORM_ERROR;
+}
+
+int ipcPlatformServer(const char *devPathRead, const char *devPathWrite, void **fd)
+{
+    if (!devPathWrite || !fd) {
+        return X_LINK_PLATFORM_INVALID_PARAMETERS;
+    }
+
+    void* conn = NULL;
+    xLinkPlatformErrorCode_t rc = ipc_server(devPathWrite, &conn);
+    if (rc != X_LINK_PLATFORM_SUCCESS) {
+        return rc;
+    }
+
+    *fd = createPlatformDeviceFdKey(conn);
     return 0;
 }
 
+int loopbackPlatformServer(const char *devPathRead, const char *devPathWrite, void **fd)
+{
+    if (!devPathWrite || !fd) {
+        return X_LINK_PLATFORM_INVALID_PARAMETERS;
+    }
+
+    void* conn = NULL;
+    xLinkPlatformErrorCode_t rc = ipc_loopback_server(devPathWrite, &conn);
+    if (rc != X_LINK_PLATFORM_SUCCESS) {
+        return rc;
+    }
+
+    *fd = createPlatformDeviceFdKey(conn);
+    return 0;
+}
 
 xLinkPlatformErrorCode_t usbPlatformBootBootloader(const char *name)
 {
@@ -437,6 +715,8 @@ int tcpipPlatformClose(void *fdKey)
     if(sock != -1)
     {
         status = shutdown(sock, SHUT_RDWR);
+        // the shutdown completes reads and writes in progress on the rings
+        tcpip_uring_detach(sock);
         if (status == 0) { status = close(sock); }
     }
 #endif
@@ -453,6 +733,24 @@ int tcpipPlatformClose(void *fdKey)
 }
 
 
+int ipcPlatformClose(void *fdKey)
+{
+    void* conn = NULL;
+    if(getPlatformDeviceFdFromKey(fdKey, &conn)){
+        mvLog(MVLOG_FATAL, "Cannot find file descriptor by key");
+        return -1;
+    }
+
+    // Lookups of the key fail from now on, so no new reads or writes start
+    if(destroyPlatformDeviceFdKey(fdKey)){
+        mvLog(MVLOG_FATAL, "Cannot destroy file descriptor key");
+        return -1;
+    }
+
+    return ipc_close(conn);
+}
+
+
 
 int pciePlatformBootFirmware(const deviceDesc_t* deviceDesc, const char* firmware, size_t length){
     // Temporary open fd to boot device and then close it
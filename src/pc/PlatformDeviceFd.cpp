@@ -1,4 +1,5 @@
 #include "PlatformDeviceFd.h"
+#include "XLinkLockProf.h"
 
 #include <unordered_map>
 #include <atomic>
@@ -9,9 +10,20 @@ static std::mutex mutex;
 static std::unordered_map<std::uintptr_t, void*> map;
 static std::uintptr_t uniqueFdKey{0x55};
 
+// locks the map, accounting the time waited while profiling
+static std::unique_lock<std::mutex> lockMap() {
+    if(!XLinkLockProfEnabled()) {
+        return std::unique_lock<std::mutex>(mutex);
+    }
+    uint64_t start = XLinkLockProfNow();
+    std::unique_lock<std::mutex> lock(mutex);
+    XLinkLockProfRecord(X_LINK_LOCK_DEVICE_FD, XLinkLockProfNow() - start);
+    return lock;
+}
+
 int getPlatformDeviceFdFromKey(void* fdKeyRaw, void** fd){
     if(fd == nullptr) return -1;
-    std::unique_lock<std::mutex> lock(mutex);
+    auto lock = lockMap();
 
     std::uintptr_t fdKey = reinterpret_cast<std::uintptr_t>(fdKeyRaw);
     if(map.count(fdKey) > 0){
@@ -23,7 +35,7 @@ int getPlatformDeviceFdFromKey(void* fdKeyRaw, void** fd){
 }
 
 void* createPlatformDeviceFdKey(void* fd){
-    std::unique_lock<std::mutex> lock(mutex);
+    auto lock = lockMap();
 
     // Get uniqueFdKey
     std::uintptr_t fdKey = uniqueFdKey++;
@@ -32,7 +44,7 @@ void* createPlatformDeviceFdKey(void* fd){
 }
 
 int destroyPlatformDeviceFdKey(void* fdKeyRaw){
-    std::unique_lock<std::mutex> lock(mutex);
+    auto lock = lockMap();
 
     std::uintptr_t fdKey = reinterpret_cast<std::uintptr_t>(fdKeyRaw);
     if(map.count(fdKey) > 0){
@@ -1,16 +1,21 @@
 #include "XLink/XLink.h"
 #include <atomic>
 
-static std::atomic<bool> protocolInitialized[X_LINK_NMB_OF_PROTOCOLS];
+// X_LINK_LOOPBACK comes after X_LINK_NMB_OF_PROTOCOLS and X_LINK_ANY_PROTOCOL
+static std::atomic<bool> protocolInitialized[X_LINK_LOOPBACK + 1];
+
+static bool isProtocol(const XLinkProtocol_t protocol) {
+    return (protocol >= 0 && protocol < X_LINK_NMB_OF_PROTOCOLS) || protocol == X_LINK_LOOPBACK;
+}
 
 extern "C" void xlinkSetProtocolInitialized(const XLinkProtocol_t protocol, int initialized) {
-    if(protocol >= 0 && protocol < X_LINK_NMB_OF_PROTOCOLS) {
+    if(isProtocol(protocol)) {
         protocolInitialized[protocol] = initialized;
     }
 }
 
 int XLinkIsProtocolInitialized(const XLinkProtocol_t protocol) {
-    if(protocol >= 0 && protocol < X_LINK_NMB_OF_PROTOCOLS) {
+    if(isProtocol(protocol)) {
         return protocolInitialized[protocol];
     }
     return 0;
@@ -0,0 +1,627 @@
+// Copyright (C) 2018-2021 Intel Corporation
+// SPDX-License-Identifier: Apache-2.0
+//
+
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE // fix for warning: implicit declaration of function 'pthread_setname_np'
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <errno.h>
+
+#if defined(__linux__)
+#include <fcntl.h>
+#include <pthread.h>
+#include <signal.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <linux/futex.h>
+#endif
+
+#include "XLink.h"
+#include "XLinkErrorUtils.h"
+
+#define MVLOG_UNIT_NAME xLinkBroker
+#include "XLinkLog.h"
+
+#if defined(__linux__)
+
+// Shared memory of a published stream is named with this prefix followed by its name
+#define BROKER_SHM_NAME_PREFIX "/xlink_broker_"
+#define BROKER_MAGIC 0x584c4252
+#define BROKER_VERSION 1
+#define BROKER_DEFAULT_SLOTS 8
+#define BROKER_DEFAULT_SLOT_SIZE (4 * 1024 * 1024)
+// Sleeping sides wake up this often to check whether the other processes are still alive
+#define BROKER_LIVENESS_CHECK_MS 100
+#define BROKER_PAGE_SIZE 4096
+// Sequence number of a slot being written
+#define BROKER_SEQ_NONE UINT64_MAX
+
+typedef struct {
+    uint64_t seq;           // packet in the slot, BROKER_SEQ_NONE while it's written
+    uint32_t length;
+    XLinkTimespec tRemoteSent;
+    XLinkTimespec tReceived;
+} brokerSlot_t;
+
+typedef struct {
+    int32_t pid;            // 0 for a free entry
+    uint64_t heldSlots;     // bit per slot the reader holds the packet of
+} brokerReaderEntry_t;
+
+/**
+ * @brief Shared memory of a published stream, the slot data follows at dataOffset.
+ *        Only the publisher writes packets, a slot is only rewritten once no reader holds it
+ */
+typedef struct {
+    uint32_t magic;            // set once the publisher initialized the rest
+    uint32_t version;
+    int32_t publisherPid;
+    uint32_t closed;           // set once publishing ended
+    uint32_t slots;
+    uint32_t slotSize;
+    uint64_t dataOffset;
+    uint64_t writeSeq;         // sequence number of the next packet published
+    uint32_t dataSeq;          // doorbell of the readers, bumped after a packet was published
+    uint32_t readersWaiting;   // readers sleeping on dataSeq
+    uint32_t releaseSeq;       // doorbell of the publisher, bumped after a reader released a slot
+    uint32_t publisherWaiting; // publisher sleeps on releaseSeq
+    brokerReaderEntry_t readers[XLINK_BROKER_MAX_READERS];
+    brokerSlot_t slot[XLINK_BROKER_MAX_SLOTS];
+} brokerShm_t;
+
+typedef struct {
+    char shmName[XLINK_MAX_NAME_SIZE + sizeof(BROKER_SHM_NAME_PREFIX)];
+    streamId_t streamId;
+    brokerShm_t* shm;
+    size_t size;
+} brokerPublisher_t;
+
+typedef struct {
+    brokerShm_t* shm;
+    size_t size;
+    brokerReaderEntry_t* entry;
+    uint64_t nextSeq;
+    // packets held, released oldest first
+    uint64_t held[XLINK_BROKER_MAX_SLOTS];
+    uint32_t heldFirst;
+    uint32_t heldCount;
+    streamPacketDesc_t packets[XLINK_BROKER_MAX_SLOTS];
+} brokerReader_t;
+
+static pthread_mutex_t readersMutex = PTHREAD_MUTEX_INITIALIZER;
+static brokerReader_t* localReaders[XLINK_BROKER_MAX_READERS];
+
+// ------------------------------------
+// Helpers declaration. Begin.
+// ------------------------------------
+
+static int getShmName(const char* name, char* shmName, size_t size);
+static brokerShm_t* mapShm(const char* shmName, size_t* size);
+static int isPublished(const char* shmName);
+static void* publishRun(void* ctx);
+static void publishPacket(brokerShm_t* shm, const streamPacketDesc_t* packet);
+static void waitSlotReleased(brokerShm_t* shm, uint32_t index);
+static int isSlotHeld(brokerShm_t* shm, uint64_t bit);
+static brokerReaderEntry_t* claimReaderEntry(brokerShm_t* shm);
+static void reapReaders(brokerShm_t* shm);
+static int isProcessGone(int32_t pid);
+static brokerReader_t* getReader(streamId_t readerId);
+static void releaseSlot(brokerShm_t* shm, brokerReaderEntry_t* entry, uint32_t index);
+static uint8_t* slotData(brokerShm_t* shm, uint32_t index);
+static void futexWait(uint32_t* doorbell, uint32_t seq, int timeoutMs);
+static void ringDoorbell(uint32_t* doorbell, uint32_t* waiting);
+
+// ------------------------------------
+// Helpers declaration. End.
+// ------------------------------------
+
+
+
+// ------------------------------------
+// API implementation. Begin.
+// ------------------------------------
+
+XLinkError_t XLinkBrokerPublish(streamId_t const streamId, const char* name,
+                                const XLinkBrokerOptions_t* options)
+{
+    XLINK_RET_ERR_IF(streamId == INVALID_STREAM_ID, X_LINK_ERROR);
+
+    uint32_t slots = options != NULL && options->slots ? options->slots : BROKER_DEFAULT_SLOTS;
+    uint32_t slotSize = options != NULL && options->slotSize ? options->slotSize : BROKER_DEFAULT_SLOT_SIZE;
+    XLINK_RET_ERR_IF(slots > XLINK_BROKER_MAX_SLOTS, X_LINK_ERROR);
+
+    brokerPublisher_t* publisher = (brokerPublisher_t*)calloc(1, sizeof(brokerPublisher_t));
+    XLINK_RET_ERR_IF(publisher == NULL, X_LINK_OUT_OF_MEMORY);
+    if(getShmName(name, publisher->shmName, sizeof(publisher->shmName))) {
+        free(publisher);
+        return X_LINK_ERROR;
+    }
+    if(isPublished(publisher->shmName)) {
+        mvLog(MVLOG_ERROR, "Stream %s is published already", name);
+        free(publisher);
+        return X_LINK_DEVICE_ALREADY_IN_USE;
+    }
+
+    uint64_t dataOffset = (sizeof(brokerShm_t) + BROKER_PAGE_SIZE - 1) & ~(uint64_t)(BROKER_PAGE_SIZE - 1);
+    publisher->size = dataOffset + (uint64_t)slots * slotSize;
+    publisher->streamId = streamId;
+
+    // a segment left behind by a crashed publisher can't be served anymore
+    shm_unlink(publisher->shmName);
+    int shmFd = shm_open(publisher->shmName, O_CREAT | O_EXCL | O_RDWR, 0600);
+    if(shmFd < 0 || ftruncate(shmFd, (off_t)publisher->size) != 0) {
+        mvLog(MVLOG_ERROR, "Cannot create shared memory %s: %s", publisher->shmName, strerror(errno));
+        if(shmFd >= 0) {
+            close(shmFd);
+            shm_unlink(publisher->shmName);
+        }
+        free(publisher);
+        return X_LINK_ERROR;
+    }
+    brokerShm_t* shm = mmap(NULL, publisher->size, PROT_READ | PROT_WRITE, MAP_SHARED, shmFd, 0);
+    close(shmFd);
+    if(shm == MAP_FAILED) {
+        mvLog(MVLOG_ERROR, "Cannot map shared memory %s: %s", publisher->shmName, strerror(errno));
+        shm_unlink(publisher->shmName);
+        free(publisher);
+        return X_LINK_ERROR;
+    }
+
+    // the memory is zero filled, which is no reader and nothing published
+    shm->version = BROKER_VERSION;
+    shm->publisherPid = (int32_t)getpid();
+    shm->slots = slots;
+    shm->slotSize = slotSize;
+    shm->dataOffset = dataOffset;
+    for(uint32_t i = 0; i < slots; i++) {
+        shm->slot[i].seq = BROKER_SEQ_NONE;
+    }
+    __atomic_store_n(&shm->magic, BROKER_MAGIC, __ATOMIC_RELEASE);
+    publisher->shm = shm;
+
+    pthread_t thread;
+    int sc = pthread_create(&thread, NULL, publishRun, publisher);
+    if(sc) {
+        mvLog(MVLOG_ERROR, "Broker thread creation failed with error: %d", sc);
+        shm_unlink(publisher->shmName);
+        munmap(shm, publisher->size);
+        free(publisher);
+        return X_LINK_ERROR;
+    }
+    if(pthread_setname_np(thread, "XLinkBrokerThr") != 0) {
+        perror("Setting name for broker thread failed");
+    }
+    pthread_detach(thread);
+
+    return X_LINK_SUCCESS;
+}
+
+streamId_t XLinkBrokerOpenStream(const char* name)
+{
+    char shmName[XLINK_MAX_NAME_SIZE + sizeof(BROKER_SHM_NAME_PREFIX)];
+    if(getShmName(name, shmName, sizeof(shmName))) {
+        return INVALID_STREAM_ID;
+    }
+
+    brokerReader_t* reader = (brokerReader_t*)calloc(1, sizeof(brokerReader_t));
+    XLINK_RET_ERR_IF(reader == NULL, INVALID_STREAM_ID);
+    reader->shm = mapShm(shmName, &reader->size);
+    // a segment left behind by a crashed publisher isn't published anymore
+    if(reader->shm == NULL || __atomic_load_n(&reader->shm->closed, __ATOMIC_SEQ_CST)
+       || isProcessGone(reader->shm->publisherPid)) {
+        mvLog(MVLOG_DEBUG, "No stream is published as %s", name);
+        if(reader->shm != NULL) {
+            munmap(reader->shm, reader->size);
+        }
+        free(reader);
+        return INVALID_STREAM_ID;
+    }
+
+    reader->entry = claimReaderEntry(reader->shm);
+    if(reader->entry == NULL) {
+        mvLog(MVLOG_ERROR, "Stream %s has the maximum number of readers", name);
+        munmap(reader->shm, reader->size);
+        free(reader);
+        return INVALID_STREAM_ID;
+    }
+    reader->nextSeq = __atomic_load_n(&reader->shm->writeSeq, __ATOMIC_SEQ_CST);
+
+    streamId_t readerId = INVALID_STREAM_ID;
+    pthread_mutex_lock(&readersMutex);
+    for(int i = 0; i < XLINK_BROKER_MAX_READERS; i++) {
+        if(localReaders[i] == NULL) {
+            localReaders[i] = reader;
+            readerId = (streamId_t)i;
+            break;
+        }
+    }
+    pthread_mutex_unlock(&readersMutex);
+
+    if(readerId == INVALID_STREAM_ID) {
+        mvLog(MVLOG_ERROR, "Too many published streams are open");
+        __atomic_store_n(&reader->entry->pid, 0, __ATOMIC_SEQ_CST);
+        munmap(reader->shm, reader->size);
+        free(reader);
+    }
+    return readerId;
+}
+
+XLinkError_t XLinkBrokerReadData(streamId_t const readerId, streamPacketDesc_t** packet, uint32_t* dropped)
+{
+    XLINK_RET_IF(packet == NULL);
+    brokerReader_t* reader = getReader(readerId);
+    XLINK_RET_IF(reader == NULL);
+
+    brokerShm_t* shm = reader->shm;
+    uint32_t skipped = 0;
+    for(;;) {
+        uint64_t writeSeq = __atomic_load_n(&shm->writeSeq, __ATOMIC_SEQ_CST);
+        if(reader->nextSeq < writeSeq) {
+            if(writeSeq - reader->nextSeq > shm->slots) {
+                skipped += (uint32_t)(writeSeq - shm->slots - reader->nextSeq);
+                reader->nextSeq = writeSeq - shm->slots;
+            }
+
+            // Holding the slot before checking its packet pairs with the publisher marking
+            // the slot before checking it's held, one of both sees the other
+            uint32_t index = (uint32_t)(reader->nextSeq % shm->slots);
+            __atomic_or_fetch(&reader->entry->heldSlots, 1ull << index, __ATOMIC_SEQ_CST);
+            if(__atomic_load_n(&shm->slot[index].seq, __ATOMIC_SEQ_CST) != reader->nextSeq) {
+                // the publisher is overwriting it
+                releaseSlot(shm, reader->entry, index);
+                reader->nextSeq++;
+                skipped++;
+                continue;
+            }
+
+            streamPacketDesc_t* desc = &reader->packets[index];
+            desc->data = slotData(shm, index);
+            desc->length = shm->slot[index].length;
+            desc->tRemoteSent = shm->slot[index].tRemoteSent;
+            desc->tReceived = shm->slot[index].tReceived;
+            reader->held[(reader->heldFirst + reader->heldCount) % XLINK_BROKER_MAX_SLOTS] = reader->nextSeq;
+            reader->heldCount++;
+            reader->nextSeq++;
+
+            *packet = desc;
+            if(dropped != NULL) {
+                *dropped = skipped;
+            }
+            return X_LINK_SUCCESS;
+        }
+
+        // Reading the doorbell before the sequence number makes a ring in between not get lost
+        XLinkError_t rc = X_LINK_SUCCESS;
+        __atomic_add_fetch(&shm->readersWaiting, 1, __ATOMIC_SEQ_CST);
+        for(;;) {
+            uint32_t seq = __atomic_load_n(&shm->dataSeq, __ATOMIC_SEQ_CST);
+            if(__atomic_load_n(&shm->writeSeq, __ATOMIC_SEQ_CST) != writeSeq) {
+                break;
+            }
+            if(__atomic_load_n(&shm->closed, __ATOMIC_SEQ_CST) || isProcessGone(shm->publisherPid)) {
+                rc = X_LINK_COMMUNICATION_NOT_OPEN;
+                break;
+            }
+            futexWait(&shm->dataSeq, seq, BROKER_LIVENESS_CHECK_MS);
+        }
+        __atomic_sub_fetch(&shm->readersWaiting, 1, __ATOMIC_SEQ_CST);
+        if(rc != X_LINK_SUCCESS) {
+            return rc;
+        }
+    }
+}
+
+XLinkError_t XLinkBrokerReleaseData(streamId_t const readerId)
+{
+    brokerReader_t* reader = getReader(readerId);
+    XLINK_RET_IF(reader == NULL);
+    XLINK_RET_ERR_IF(reader->heldCount == 0, X_LINK_ERROR);
+
+    uint64_t seq = reader->held[reader->heldFirst];
+    reader->heldFirst = (reader->heldFirst + 1) % XLINK_BROKER_MAX_SLOTS;
+    reader->heldCount--;
+    releaseSlot(reader->shm, reader->entry, (uint32_t)(seq % reader->shm->slots));
+
+    return X_LINK_SUCCESS;
+}
+
+XLinkError_t XLinkBrokerCloseStream(streamId_t const readerId)
+{
+    brokerReader_t* reader = NULL;
+    pthread_mutex_lock(&readersMutex);
+    if(readerId < XLINK_BROKER_MAX_READERS) {
+        reader = localReaders[readerId];
+        localReaders[readerId] = NULL;
+    }
+    pthread_mutex_unlock(&readersMutex);
+    XLINK_RET_IF(reader == NULL);
+
+    brokerShm_t* shm = reader->shm;
+    __atomic_store_n(&reader->entry->heldSlots, 0, __ATOMIC_SEQ_CST);
+    ringDoorbell(&shm->releaseSeq, &shm->publisherWaiting);
+    __atomic_store_n(&reader->entry->pid, 0, __ATOMIC_SEQ_CST);
+    munmap(shm, reader->size);
+    free(reader);
+
+    return X_LINK_SUCCESS;
+}
+
+// ------------------------------------
+// API implementation. End.
+// ------------------------------------
+
+
+
+// ------------------------------------
+// Helpers implementation. Begin.
+// ------------------------------------
+
+int getShmName(const char* name, char* shmName, size_t size)
+{
+    if(name == NULL || name[0] == '\0' || strchr(name, '/') != NULL) {
+        mvLog(MVLOG_ERROR, "Invalid published stream name");
+        return -1;
+    }
+    int len = snprintf(shmName, size, "%s%s", BROKER_SHM_NAME_PREFIX, name);
+    if(len < 0 || (size_t)len >= size) {
+        mvLog(MVLOG_ERROR, "Published stream name %s is too long", name);
+        return -1;
+    }
+    return 0;
+}
+
+brokerShm_t* mapShm(const char* shmName, size_t* size)
+{
+    int shmFd = shm_open(shmName, O_RDWR, 0);
+    if(shmFd < 0) {
+        return NULL;
+    }
+    struct stat shmStat;
+    if(fstat(shmFd, &shmStat) != 0 || shmStat.st_size < (off_t)sizeof(brokerShm_t)) {
+        // the publisher is still setting it up
+        close(shmFd);
+        return NULL;
+    }
+    brokerShm_t* shm = mmap(NULL, (size_t)shmStat.st_size, PROT_READ | PROT_WRITE, MAP_SHARED, shmFd, 0);
+    close(shmFd);
+    if(shm == MAP_FAILED) {
+        mvLog(MVLOG_ERROR, "Cannot map shared memory %s: %s", shmName, strerror(errno));
+        return NULL;
+    }
+    if(__atomic_load_n(&shm->magic, __ATOMIC_ACQUIRE) != BROKER_MAGIC || shm->version != BROKER_VERSION
+       || shm->dataOffset + (uint64_t)shm->slots * shm->slotSize > (uint64_t)shmStat.st_size) {
+        munmap(shm, (size_t)shmStat.st_size);
+        return NULL;
+    }
+    *size = (size_t)shmStat.st_size;
+    return shm;
+}
+
+int isPublished(const char* shmName)
+{
+    size_t size = 0;
+    brokerShm_t* shm = mapShm(shmName, &size);
+    if(shm == NULL) {
+        return 0;
+    }
+    int published = !__atomic_load_n(&shm->closed, __ATOMIC_SEQ_CST) && !isProcessGone(shm->publisherPid);
+    munmap(shm, size);
+    return published;
+}
+
+void* publishRun(void* ctx)
+{
+    brokerPublisher_t* publisher = (brokerPublisher_t*)ctx;
+    brokerShm_t* shm = publisher->shm;
+    streamPacketDesc_t* packet = NULL;
+
+    // the packet is credited back to the remote once it's copied
+    while(XLinkReadData(publisher->streamId, &packet) == X_LINK_SUCCESS) {
+        if(packet->length > shm->slotSize) {
+            mvLog(MVLOG_WARN, "Packet of %u bytes doesn't fit the slots of %s, it isn't published",
+                  packet->length, publisher->shmName);
+        } else {
+            publishPacket(shm, packet);
+        }
+        if(XLinkReleaseData(publisher->streamId) != X_LINK_SUCCESS) {
+            break;
+        }
+    }
+    mvLog(MVLOG_DEBUG, "Publishing %s ended", publisher->shmName);
+
+    // the name may be published again right away, readers keep their mapping until they close
+    shm_unlink(publisher->shmName);
+    __atomic_store_n(&shm->closed, 1, __ATOMIC_SEQ_CST);
+    ringDoorbell(&shm->dataSeq, NULL);
+    munmap(shm, publisher->size);
+    free(publisher);
+    return NULL;
+}
+
+void publishPacket(brokerShm_t* shm, const streamPacketDesc_t* packet)
+{
+    uint64_t seq = __atomic_load_n(&shm->writeSeq, __ATOMIC_RELAXED);
+    uint32_t index = (uint32_t)(seq % shm->slots);
+    brokerSlot_t* slot = &shm->slot[index];
+
+    // readers taking the slot from now on skip it, the ones holding it are waited for
+    __atomic_store_n(&slot->seq, BROKER_SEQ_NONE, __ATOMIC_SEQ_CST);
+    waitSlotReleased(shm, index);
+
+    memcpy(slotData(shm, index), packet->data, packet->length);
+    slot->length = packet->length;
+    slot->tRemoteSent = packet->tRemoteSent;
+    slot->tReceived = packet->tReceived;
+    __atomic_store_n(&slot->seq, seq, __ATOMIC_RELEASE);
+    __atomic_store_n(&shm->writeSeq, seq + 1, __ATOMIC_SEQ_CST);
+    ringDoorbell(&shm->dataSeq, &shm->readersWaiting);
+}
+
+void waitSlotReleased(brokerShm_t* shm, uint32_t index)
+{
+    uint64_t bit = 1ull << index;
+    if(!isSlotHeld(shm, bit)) {
+        return;
+    }
+
+    __atomic_store_n(&shm->publisherWaiting, 1, __ATOMIC_SEQ_CST);
+    for(;;) {
+        uint32_t seq = __atomic_load_n(&shm->releaseSeq, __ATOMIC_SEQ_CST);
+        if(!isSlotHeld(shm, bit)) {
+            break;
+        }
+        // readers which died don't release their slots
+        reapReaders(shm);
+        futexWait(&shm->releaseSeq, seq, BROKER_LIVENESS_CHECK_MS);
+    }
+    __atomic_store_n(&shm->publisherWaiting, 0, __ATOMIC_SEQ_CST);
+}
+
+int isSlotHeld(brokerShm_t* shm, uint64_t bit)
+{
+    for(int i = 0; i < XLINK_BROKER_MAX_READERS; i++) {
+        if(__atomic_load_n(&shm->readers[i].heldSlots, __ATOMIC_SEQ_CST) & bit) {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+brokerReaderEntry_t* claimReaderEntry(brokerShm_t* shm)
+{
+    for(int attempt = 0; attempt < 2; attempt++) {
+        for(int i = 0; i < XLINK_BROKER_MAX_READERS; i++) {
+            int32_t noReader = 0;
+            if(__atomic_compare_exchange_n(&shm->readers[i].pid, &noReader, (int32_t)getpid(), 0,
+                                           __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST)) {
+                return &shm->readers[i];
+            }
+        }
+        // entries of readers which died are free again
+        reapReaders(shm);
+    }
+    return NULL;
+}
+
+void reapReaders(brokerShm_t* shm)
+{
+    for(int i = 0; i < XLINK_BROKER_MAX_READERS; i++) {
+        int32_t pid = __atomic_load_n(&shm->readers[i].pid, __ATOMIC_SEQ_CST);
+        if(pid != 0 && isProcessGone(pid)) {
+            __atomic_store_n(&shm->readers[i].heldSlots, 0, __ATOMIC_SEQ_CST);
+            __atomic_compare_exchange_n(&shm->readers[i].pid, &pid, 0, 0,
+                                        __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST);
+        }
+    }
+}
+
+int isProcessGone(int32_t pid)
+{
+    if(kill(pid, 0) != 0 && errno == ESRCH) {
+        return 1;
+    }
+    // exited children of the publisher stay zombies until they are waited for
+    char path[32];
+    char content[256];
+    snprintf(path, sizeof(path), "/proc/%d/stat", (int)pid);
+    FILE* file = fopen(path, "r");
+    if(file == NULL) {
+        return 0;
+    }
+    size_t len = fread(content, 1, sizeof(content) - 1, file);
+    fclose(file);
+    content[len] = '\0';
+    // the state follows the command name, which may contain parentheses itself
+    const char* state = strrchr(content, ')');
+    return state != NULL && state[1] == ' ' && state[2] == 'Z';
+}
+
+brokerReader_t* getReader(streamId_t readerId)
+{
+    brokerReader_t* reader = NULL;
+    pthread_mutex_lock(&readersMutex);
+    if(readerId < XLINK_BROKER_MAX_READERS) {
+        reader = localReaders[readerId];
+    }
+    pthread_mutex_unlock(&readersMutex);
+    return reader;
+}
+
+void releaseSlot(brokerShm_t* shm, brokerReaderEntry_t* entry, uint32_t index)
+{
+    __atomic_and_fetch(&entry->heldSlots, ~(1ull << index), __ATOMIC_SEQ_CST);
+    ringDoorbell(&shm->releaseSeq, &shm->publisherWaiting);
+}
+
+uint8_t* slotData(brokerShm_t* shm, uint32_t index)
+{
+    return (uint8_t*)shm + shm->dataOffset + (uint64_t)index * shm->slotSize;
+}
+
+void futexWait(uint32_t* doorbell, uint32_t seq, int timeoutMs)
+{
+    struct timespec timeout = {timeoutMs / 1000, (timeoutMs % 1000) * 1000000L};
+    // returns right away if the doorbell rang since seq was read
+    syscall(SYS_futex, doorbell, FUTEX_WAIT, seq, &timeout, NULL, 0);
+}
+
+void ringDoorbell(uint32_t* doorbell, uint32_t* waiting)
+{
+    __atomic_add_fetch(doorbell, 1, __ATOMIC_SEQ_CST);
+    // the syscall is only paid when the other side went to sleep
+    if(waiting == NULL || __atomic_load_n(waiting, __ATOMIC_SEQ_CST)) {
+        syscall(SYS_futex, doorbell, FUTEX_WAKE, INT32_MAX, NULL, NULL, 0);
+    }
+}
+
+// ------------------------------------
+// Helpers implementation. End.
+// ------------------------------------
+
+#else // __linux__
+
+XLinkError_t XLinkBrokerPublish(streamId_t const streamId, const char* name,
+                                const XLinkBrokerOptions_t* options)
+{
+    (void)streamId;
+    (void)name;
+    (void)options;
+    mvLog(MVLOG_ERROR, "Publishing streams is only supported on Linux");
+    return X_LINK_NOT_IMPLEMENTED;
+}
+
+streamId_t XLinkBrokerOpenStream(const char* name)
+{
+    (void)name;
+    return INVALID_STREAM_ID;
+}
+
+XLinkError_t XLinkBrokerReadData(streamId_t const readerId, streamPacketDesc_t** packet, uint32_t* dropped)
+{
+    (void)readerId;
+    (void)packet;
+    (void)dropped;
+    return X_LINK_NOT_IMPLEMENTED;
+}
+
+XLinkError_t XLinkBrokerReleaseData(streamId_t const readerId)
+{
+    (void)readerId;
+    return X_LINK_NOT_IMPLEMENTED;
+}
+
+XLinkError_t XLinkBrokerCloseStream(streamId_t const readerId)
+{
+    (void)readerId;
+    return X_LINK_NOT_IMPLEMENTED;
+}
+
+#endif // __linux__
@@ -0,0 +1,581 @@
+// Copyright (C) 2018-2021 Intel Corporation
+// SPDX-License-Identifier: Apache-2.0
+//
+
+#include "ipc_host.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <errno.h>
+
+#if defined(__linux__)
+#include <fcntl.h>
+#include <pthread.h>
+#include <signal.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <linux/futex.h>
+#endif
+
+#define MVLOG_UNIT_NAME ipc
+#include "XLinkLog.h"
+
+#if defined(__linux__)
+
+#define IPC_MAGIC 0x584c4950
+#define IPC_VERSION 1
+// Polls of the ring before a side sleeps on the doorbell, covers back to back messages
+#define IPC_SPIN_COUNT 2000
+// Sleeping sides wake up this often to check whether the peer process is still alive
+#define IPC_LIVENESS_CHECK_MS 100
+#define IPC_CACHE_LINE 64
+
+/**
+ * @brief Single producer single consumer byte ring, one per direction of a link.
+ *        Each side only writes its own cache line, the doorbells are futex words
+ */
+typedef struct {
+    // written by the producer
+    uint64_t head __attribute__((aligned(IPC_CACHE_LINE)));
+    uint32_t dataSeq;       // doorbell of the consumer, bumped after head moved
+    uint32_t writerWaiting; // producer sleeps on spaceSeq
+
+    // written by the consumer
+    uint64_t tail __attribute__((aligned(IPC_CACHE_LINE)));
+    uint32_t spaceSeq;      // doorbell of the producer, bumped after tail moved
+    uint32_t readerWaiting; // consumer sleeps on dataSeq
+
+    uint8_t data[IPC_RING_SIZE] __attribute__((aligned(IPC_CACHE_LINE)));
+} ipcRing_t;
+
+typedef struct {
+    uint32_t magic;         // set once the server initialized the rest
+    uint32_t version;
+    int32_t serverPid;
+    int32_t clientPid;      // 0 until a client took the link
+    uint32_t connectSeq;    // doorbell of the server waiting for a client
+    uint32_t closed;        // set by the first side closing the link
+    uint32_t localRefs;     // loopback links: connections sharing this one mapping
+    ipcRing_t rings[2];     // client to server, server to client
+} ipcShm_t;
+
+typedef struct {
+    ipcShm_t* shm;
+    ipcRing_t* rx;
+    ipcRing_t* tx;
+    int32_t peerPid;
+    uint32_t closing;       // local close in progress
+    uint32_t users;         // local reads and writes in progress
+} ipcConnection_t;
+
+/**
+ * @brief In-process link waiting for ipc_loopback_connect
+ */
+typedef struct ipcLoopbackListener_t {
+    char name[XLINK_MAX_NAME_SIZE];
+    ipcShm_t* shm;
+    struct ipcLoopbackListener_t* next;
+} ipcLoopbackListener_t;
+
+static pthread_mutex_t loopbackMutex = PTHREAD_MUTEX_INITIALIZER;
+static ipcLoopbackListener_t* loopbackListeners = NULL;
+
+// ------------------------------------
+// Helpers declaration. Begin.
+// ------------------------------------
+
+static int getShmName(const char* name, char* shmName, size_t size);
+static xLinkPlatformErrorCode_t createConnection(ipcShm_t* shm, ipcRing_t* rx, ipcRing_t* tx,
+                                                 int32_t peerPid, void** fd);
+static void initShm(ipcShm_t* shm);
+static int isServed(const char* shmName);
+static void waitForClient(ipcShm_t* shm);
+static void unmapShm(ipcShm_t* shm);
+static void futexWait(uint32_t* doorbell, uint32_t seq, int timeoutMs);
+static void futexWake(uint32_t* doorbell);
+static void ringDoorbell(uint32_t* doorbell, uint32_t* waiting);
+static int isClosed(ipcConnection_t* conn);
+static int isPeerGone(ipcConnection_t* conn);
+static int waitForPeer(ipcConnection_t* conn, uint64_t* index, uint64_t stale,
+                       uint32_t* doorbell, uint32_t* waiting);
+
+// ------------------------------------
+// Helpers declaration. End.
+// ------------------------------------
+
+xLinkPlatformErrorCode_t ipc_server(const char* name, void** fd)
+{
+    char shmName[XLINK_MAX_NAME_SIZE + sizeof(IPC_SHM_NAME_PREFIX)];
+    if (fd == NULL || getShmName(name, shmName, sizeof(shmName))) {
+        return X_LINK_PLATFORM_INVALID_PARAMETERS;
+    }
+
+    int shmFd = shm_open(shmName, O_CREAT | O_EXCL | O_RDWR, 0600);
+    if (shmFd < 0 && errno == EEXIST) {
+        if (isServed(shmName)) {
+            mvLog(MVLOG_ERROR, "IPC link %s is served already", name);
+            return X_LINK_PLATFORM_DEVICE_BUSY;
+        }
+        // a segment left behind by a crashed server can't be served anymore
+        shm_unlink(shmName);
+        shmFd = shm_open(shmName, O_CREAT | O_EXCL | O_RDWR, 0600);
+    }
+    if (shmFd < 0) {
+        mvLog(MVLOG_ERROR, "Cannot create shared memory %s: %s", shmName, strerror(errno));
+        return X_LINK_PLATFORM_ERROR;
+    }
+    if (ftruncate(shmFd, sizeof(ipcShm_t)) != 0) {
+        mvLog(MVLOG_ERROR, "Cannot size shared memory %s: %s", shmName, strerror(errno));
+        close(shmFd);
+        shm_unlink(shmName);
+        return X_LINK_PLATFORM_ERROR;
+    }
+    ipcShm_t* shm = mmap(NULL, sizeof(ipcShm_t), PROT_READ | PROT_WRITE, MAP_SHARED, shmFd, 0);
+    close(shmFd);
+    if (shm == MAP_FAILED) {
+        mvLog(MVLOG_ERROR, "Cannot map shared memory %s: %s", shmName, strerror(errno));
+        shm_unlink(shmName);
+        return X_LINK_PLATFORM_ERROR;
+    }
+
+    initShm(shm);
+
+    mvLog(MVLOG_DEBUG, "Waiting for a peer on %s", shmName);
+    waitForClient(shm);
+
+    // the link is taken, the name can be served again
+    shm_unlink(shmName);
+
+    return createConnection(shm, &shm->rings[0], &shm->rings[1],
+                            __atomic_load_n(&shm->clientPid, __ATOMIC_SEQ_CST), fd);
+}
+
+xLinkPlatformErrorCode_t ipc_connect(const char* name, void** fd)
+{
+    char shmName[XLINK_MAX_NAME_SIZE + sizeof(IPC_SHM_NAME_PREFIX)];
+    if (fd == NULL || getShmName(name, shmName, sizeof(shmName))) {
+        return X_LINK_PLATFORM_INVALID_PARAMETERS;
+    }
+
+    int shmFd = shm_open(shmName, O_RDWR, 0);
+    if (shmFd < 0) {
+        return X_LINK_PLATFORM_DEVICE_NOT_FOUND;
+    }
+    struct stat shmStat;
+    if (fstat(shmFd, &shmStat) != 0 || shmStat.st_size < (off_t)sizeof(ipcShm_t)) {
+        // the server is still setting it up
+        close(shmFd);
+        return X_LINK_PLATFORM_DEVICE_NOT_FOUND;
+    }
+    ipcShm_t* shm = mmap(NULL, sizeof(ipcShm_t), PROT_READ | PROT_WRITE, MAP_SHARED, shmFd, 0);
+    close(shmFd);
+    if (shm == MAP_FAILED) {
+        mvLog(MVLOG_ERROR, "Cannot map shared memory %s: %s", shmName, strerror(errno));
+        return X_LINK_PLATFORM_ERROR;
+    }
+
+    if (__atomic_load_n(&shm->magic, __ATOMIC_ACQUIRE) != IPC_MAGIC || shm->version != IPC_VERSION) {
+        munmap(shm, sizeof(ipcShm_t));
+        return X_LINK_PLATFORM_DEVICE_NOT_FOUND;
+    }
+
+    int32_t noClient = 0;
+    if (!__atomic_compare_exchange_n(&shm->clientPid, &noClient, (int32_t)getpid(), 0,
+                                     __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST)) {
+        munmap(shm, sizeof(ipcShm_t));
+        return X_LINK_PLATFORM_DEVICE_BUSY;
+    }
+    ringDoorbell(&shm->connectSeq, NULL);
+
+    return createConnection(shm, &shm->rings[1], &shm->rings[0], shm->serverPid, fd);
+}
+
+xLinkPlatformErrorCode_t ipc_loopback_server(const char* name, void** fd)
+{
+    if (fd == NULL || name == NULL || strlen(name) >= XLINK_MAX_NAME_SIZE) {
+        return X_LINK_PLATFORM_INVALID_PARAMETERS;
+    }
+
+    ipcLoopbackListener_t* listener = (ipcLoopbackListener_t*)calloc(1, sizeof(ipcLoopbackListener_t));
+    if (listener == NULL) {
+        return X_LINK_PLATFORM_ERROR;
+    }
+    // anonymous memory is zero filled too, both ends of the link share the mapping
+    ipcShm_t* shm = mmap(NULL, sizeof(ipcShm_t), PROT_READ | PROT_WRITE,
+                         MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+    if (shm == MAP_FAILED) {
+        mvLog(MVLOG_ERROR, "Cannot map loopback link memory: %s", strerror(errno));
+        free(listener);
+        return X_LINK_PLATFORM_ERROR;
+    }
+    shm->localRefs = 2;
+    initShm(shm);
+    strcpy(listener->name, name);
+    listener->shm = shm;
+
+    pthread_mutex_lock(&loopbackMutex);
+    for (ipcLoopbackListener_t* it = loopbackListeners; it != NULL; it = it->next) {
+        if (strcmp(it->name, name) == 0) {
+            pthread_mutex_unlock(&loopbackMutex);
+            mvLog(MVLOG_ERROR, "Loopback link %s is already served", name);
+            munmap(shm, sizeof(ipcShm_t));
+            free(listener);
+            return X_LINK_PLATFORM_DEVICE_BUSY;
+        }
+    }
+    listener->next = loopbackListeners;
+    loopbackListeners = listener;
+    pthread_mutex_unlock(&loopbackMutex);
+
+    mvLog(MVLOG_DEBUG, "Waiting for a peer on loopback link %s", name);
+    // the client took the listener off the list
+    waitForClient(shm);
+    free(listener);
+
+    return createConnection(shm, &shm->rings[0], &shm->rings[1], shm->serverPid, fd);
+}
+
+xLinkPlatformErrorCode_t ipc_loopback_connect(const char* name, void** fd)
+{
+    if (fd == NULL || name == NULL) {
+        return X_LINK_PLATFORM_INVALID_PARAMETERS;
+    }
+
+    ipcShm_t* shm = NULL;
+    pthread_mutex_lock(&loopbackMutex);
+    for (ipcLoopbackListener_t** it = &loopbackListeners; *it != NULL; it = &(*it)->next) {
+        if (strcmp((*it)->name, name) == 0) {
+            shm = (*it)->shm;
+            *it = (*it)->next;
+            break;
+        }
+    }
+    pthread_mutex_unlock(&loopbackMutex);
+    if (shm == NULL) {
+        return X_LINK_PLATFORM_DEVICE_NOT_FOUND;
+    }
+
+    __atomic_store_n(&shm->clientPid, shm->serverPid, __ATOMIC_SEQ_CST);
+    ringDoorbell(&shm->connectSeq, NULL);
+
+    return createConnection(shm, &shm->rings[1], &shm->rings[0], shm->serverPid, fd);
+}
+
+int ipc_close(void* fd)
+{
+    ipcConnection_t* conn = (ipcConnection_t*)fd;
+    if (conn == NULL) {
+        return -1;
+    }
+
+    __atomic_store_n(&conn->closing, 1, __ATOMIC_SEQ_CST);
+    __atomic_store_n(&conn->shm->closed, 1, __ATOMIC_SEQ_CST);
+
+    // wake whoever sleeps on the link, on both sides
+    for (int i = 0; i < 2; i++) {
+        ipcRing_t* ring = &conn->shm->rings[i];
+        ringDoorbell(&ring->dataSeq, NULL);
+        ringDoorbell(&ring->spaceSeq, NULL);
+    }
+
+    // local threads may still be inside a read or write
+    while (__atomic_load_n(&conn->users, __ATOMIC_SEQ_CST)) {
+        usleep(1000);
+    }
+
+    unmapShm(conn->shm);
+    free(conn);
+    return 0;
+}
+
+int ipc_write(void* fd, const void* data, int size)
+{
+    ipcConnection_t* conn = (ipcConnection_t*)fd;
+    if (conn == NULL || data == NULL || size < 0) {
+        return -1;
+    }
+
+    __atomic_add_fetch(&conn->users, 1, __ATOMIC_SEQ_CST);
+
+    int rc = 0;
+    ipcRing_t* ring = conn->tx;
+    const uint8_t* src = (const uint8_t*)data;
+    uint64_t head = __atomic_load_n(&ring->head, __ATOMIC_RELAXED);
+    while (size > 0) {
+        if (isClosed(conn)) {
+            rc = -1;
+            break;
+        }
+
+        uint64_t tail = __atomic_load_n(&ring->tail, __ATOMIC_ACQUIRE);
+        uint64_t space = IPC_RING_SIZE - (head - tail);
+        if (space == 0) {
+            if (waitForPeer(conn, &ring->tail, tail, &ring->spaceSeq, &ring->writerWaiting)) {
+                rc = -1;
+                break;
+            }
+            continue;
+        }
+
+        uint32_t chunk = space < (uint64_t)size ? (uint32_t)space : (uint32_t)size;
+        uint32_t offset = (uint32_t)(head % IPC_RING_SIZE);
+        uint32_t first = IPC_RING_SIZE - offset < chunk ? IPC_RING_SIZE - offset : chunk;
+        memcpy(&ring->data[offset], src, first);
+        memcpy(ring->data, src + first, chunk - first);
+
+        head += chunk;
+        __atomic_store_n(&ring->head, head, __ATOMIC_SEQ_CST);
+        ringDoorbell(&ring->dataSeq, &ring->readerWaiting);
+
+        src += chunk;
+        size -= (int)chunk;
+    }
+
+    __atomic_sub_fetch(&conn->users, 1, __ATOMIC_SEQ_CST);
+    return rc;
+}
+
+int ipc_read(void* fd, void* data, int size)
+{
+    ipcConnection_t* conn = (ipcConnection_t*)fd;
+    if (conn == NULL || data == NULL || size < 0) {
+        return -1;
+    }
+
+    __atomic_add_fetch(&conn->users, 1, __ATOMIC_SEQ_CST);
+
+    int rc = 0;
+    ipcRing_t* ring = conn->rx;
+    uint8_t* dst = (uint8_t*)data;
+    uint64_t tail = __atomic_load_n(&ring->tail, __ATOMIC_RELAXED);
+    while (size > 0) {
+        if (__atomic_load_n(&conn->closing, __ATOMIC_SEQ_CST)) {
+            rc = -1;
+            break;
+        }
+
+        uint64_t available = __atomic_load_n(&ring->head, __ATOMIC_ACQUIRE) - tail;
+        if (available == 0) {
+            // data the peer wrote before closing is still delivered
+            if (waitForPeer(conn, &ring->head, tail, &ring->dataSeq, &ring->readerWaiting)) {
+                rc = -1;
+                break;
+            }
+            continue;
+        }
+
+        uint32_t chunk = available < (uint64_t)size ? (uint32_t)available : (uint32_t)size;
+        uint32_t offset = (uint32_t)(tail % IPC_RING_SIZE);
+        uint32_t first = IPC_RING_SIZE - offset < chunk ? IPC_RING_SIZE - offset : chunk;
+        memcpy(dst, &ring->data[offset], first);
+        memcpy(dst + first, ring->data, chunk - first);
+
+        tail += chunk;
+        __atomic_store_n(&ring->tail, tail, __ATOMIC_SEQ_CST);
+        ringDoorbell(&ring->spaceSeq, &ring->writerWaiting);
+
+        dst += chunk;
+        size -= (int)chunk;
+    }
+
+    __atomic_sub_fetch(&conn->users, 1, __ATOMIC_SEQ_CST);
+    return rc;
+}
+
+// ------------------------------------
+// Helpers implementation. Begin.
+// ------------------------------------
+
+int getShmName(const char* name, char* shmName, size_t size)
+{
+    if (name == NULL || name[0] == '\0' || strchr(name, '/') != NULL) {
+        mvLog(MVLOG_ERROR, "Invalid IPC link name");
+        return -1;
+    }
+    int len = snprintf(shmName, size, "%s%s", IPC_SHM_NAME_PREFIX, name);
+    if (len < 0 || (size_t)len >= size) {
+        mvLog(MVLOG_ERROR, "IPC link name %s is too long", name);
+        return -1;
+    }
+    return 0;
+}
+
+xLinkPlatformErrorCode_t createConnection(ipcShm_t* shm, ipcRing_t* rx, ipcRing_t* tx,
+                                          int32_t peerPid, void** fd)
+{
+    ipcConnection_t* conn = (ipcConnection_t*)calloc(1, sizeof(ipcConnection_t));
+    if (conn == NULL) {
+        unmapShm(shm);
+        return X_LINK_PLATFORM_ERROR;
+    }
+    conn->shm = shm;
+    conn->rx = rx;
+    conn->tx = tx;
+    conn->peerPid = peerPid;
+
+    *fd = conn;
+    return X_LINK_PLATFORM_SUCCESS;
+}
+
+void initShm(ipcShm_t* shm)
+{
+    // the memory is zero filled, which is an empty ring pair
+    shm->version = IPC_VERSION;
+    shm->serverPid = (int32_t)getpid();
+    __atomic_store_n(&shm->magic, IPC_MAGIC, __ATOMIC_RELEASE);
+}
+
+int isServed(const char* shmName)
+{
+    int shmFd = shm_open(shmName, O_RDWR, 0);
+    if (shmFd < 0) {
+        return 0;
+    }
+    struct stat shmStat;
+    ipcShm_t* shm = MAP_FAILED;
+    if (fstat(shmFd, &shmStat) == 0 && shmStat.st_size >= (off_t)sizeof(ipcShm_t)) {
+        shm = mmap(NULL, sizeof(ipcShm_t), PROT_READ | PROT_WRITE, MAP_SHARED, shmFd, 0);
+    }
+    close(shmFd);
+    if (shm == MAP_FAILED) {
+        return 0;
+    }
+    int served = __atomic_load_n(&shm->magic, __ATOMIC_ACQUIRE) == IPC_MAGIC &&
+                 !__atomic_load_n(&shm->closed, __ATOMIC_SEQ_CST) &&
+                 !(kill(shm->serverPid, 0) != 0 && errno == ESRCH);
+    munmap(shm, sizeof(ipcShm_t));
+    return served;
+}
+
+void waitForClient(ipcShm_t* shm)
+{
+    for (;;) {
+        uint32_t seq = __atomic_load_n(&shm->connectSeq, __ATOMIC_SEQ_CST);
+        if (__atomic_load_n(&shm->clientPid, __ATOMIC_SEQ_CST) != 0) {
+            break;
+        }
+        futexWait(&shm->connectSeq, seq, -1);
+    }
+}
+
+void unmapShm(ipcShm_t* shm)
+{
+    // the ends of a loopback link unmap once the later one of them is done
+    if (__atomic_load_n(&shm->localRefs, __ATOMIC_SEQ_CST) != 0
+        && __atomic_sub_fetch(&shm->localRefs, 1, __ATOMIC_SEQ_CST) != 0) {
+        return;
+    }
+    munmap(shm, sizeof(ipcShm_t));
+}
+
+void futexWait(uint32_t* doorbell, uint32_t seq, int timeoutMs)
+{
+    struct timespec timeout = {timeoutMs / 1000, (timeoutMs % 1000) * 1000000L};
+    // returns right away if the doorbell rang since seq was read
+    syscall(SYS_futex, doorbell, FUTEX_WAIT, seq, timeoutMs < 0 ? NULL : &timeout, NULL, 0);
+}
+
+void futexWake(uint32_t* doorbell)
+{
+    syscall(SYS_futex, doorbell, FUTEX_WAKE, INT32_MAX, NULL, NULL, 0);
+}
+
+void ringDoorbell(uint32_t* doorbell, uint32_t* waiting)
+{
+    __atomic_add_fetch(doorbell, 1, __ATOMIC_SEQ_CST);
+    // the syscall is only paid when the other side went to sleep
+    if (waiting == NULL || __atomic_load_n(waiting, __ATOMIC_SEQ_CST)) {
+        futexWake(doorbell);
+    }
+}
+
+int isClosed(ipcConnection_t* conn)
+{
+    return __atomic_load_n(&conn->closing, __ATOMIC_SEQ_CST)
+        || __atomic_load_n(&conn->shm->closed, __ATOMIC_SEQ_CST);
+}
+
+int isPeerGone(ipcConnection_t* conn)
+{
+    return isClosed(conn) || (kill(conn->peerPid, 0) != 0 && errno == ESRCH);
+}
+
+int waitForPeer(ipcConnection_t* conn, uint64_t* index, uint64_t stale,
+                uint32_t* doorbell, uint32_t* waiting)
+{
+    for (int i = 0; i < IPC_SPIN_COUNT; i++) {
+        if (__atomic_load_n(index, __ATOMIC_ACQUIRE) != stale) {
+            return 0;
+        }
+    }
+
+    // The peer rings the doorbell after it moved the index and only wakes us when we
+    // wait. Reading the doorbell before the index makes a ring in between not get lost
+    int rc = 0;
+    __atomic_store_n(waiting, 1, __ATOMIC_SEQ_CST);
+    for (;;) {
+        uint32_t seq = __atomic_load_n(doorbell, __ATOMIC_SEQ_CST);
+        if (__atomic_load_n(index, __ATOMIC_SEQ_CST) != stale) {
+            break;
+        }
+        if (isPeerGone(conn)) {
+            rc = -1;
+            break;
+        }
+        futexWait(doorbell, seq, IPC_LIVENESS_CHECK_MS);
+    }
+    __atomic_store_n(waiting, 0, __ATOMIC_SEQ_CST);
+    return rc;
+}
+
+// ------------------------------------
+// Helpers implementation. End.
+// ------------------------------------
+
+#else // __linux__
+
+xLinkPlatformErrorCode_t ipc_server(const char* name, void** fd)
+{
+    mvLog(MVLOG_ERROR, "X_LINK_IPC is only supported on Linux");
+    return X_LINK_PLATFORM_ERROR;
+}
+
+xLinkPlatformErrorCode_t ipc_connect(const char* name, void** fd)
+{
+    mvLog(MVLOG_ERROR, "X_LINK_IPC is only supported on Linux");
+    return X_LINK_PLATFORM_ERROR;
+}
+
+xLinkPlatformErrorCode_t ipc_loopback_server(const char* name, void** fd)
+{
+    mvLog(MVLOG_ERROR, "X_LINK_LOOPBACK is only supported on Linux");
+    return X_LINK_PLATFORM_ERROR;
+}
+
+xLinkPlatformErrorCode_t ipc_loopback_connect(const char* name, void** fd)
+{
+    mvLog(MVLOG_ERROR, "X_LINK_LOOPBACK is only supported on Linux");
+    return X_LINK_PLATFORM_ERROR;
+}
+
+int ipc_close(void* fd)
+{
+    return -1;
+}
+
+int ipc_write(void* fd, const void* data, int size)
+{
+    return -1;
+}
+
+int ipc_read(void* fd, void* data, int size)
+{
+    return -1;
+}
+
+#endif // __linux__
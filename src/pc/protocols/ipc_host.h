@@ -0,0 +1,70 @@
+// Copyright (C) 2018-2021 Intel Corporation
+// SPDX-License-Identifier: Apache-2.0
+//
+
+#ifndef IPC_HOST_H
+#define IPC_HOST_H
+
+#include "XLinkPlatform.h"
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+// ------------------------------------
+//          IPC defines
+// ------------------------------------
+
+// Shared memory object of a link is named with this prefix followed by the device path
+#define IPC_SHM_NAME_PREFIX "/xlink_ipc_"
+// Capacity of each direction of a link
+#define IPC_RING_SIZE (4 * 1024 * 1024)
+
+// ------------------------------------
+//          IPC functions
+// ------------------------------------
+
+/**
+ * @brief       Creates the shared memory of a link and waits until a peer connects to it
+ * @param[in]   name - name of the link, without slashes
+ * @param[out]  fd   - connection of the link
+ */
+xLinkPlatformErrorCode_t ipc_server(const char* name, void** fd);
+
+/**
+ * @brief       Connects to the shared memory of a link created by ipc_server
+ * @param[in]   name - name of the link, without slashes
+ * @param[out]  fd   - connection of the link
+ */
+xLinkPlatformErrorCode_t ipc_connect(const char* name, void** fd);
+
+/**
+ * @brief       Creates an in-process link in private memory and waits until a peer
+ *              of the same process connects to it with ipc_loopback_connect
+ * @param[in]   name - name of the link, unique within the process
+ * @param[out]  fd   - connection of the link
+ */
+xLinkPlatformErrorCode_t ipc_loopback_server(const char* name, void** fd);
+
+/**
+ * @brief       Connects to an in-process link created by ipc_loopback_server
+ * @param[in]   name - name of the link
+ * @param[out]  fd   - connection of the link
+ */
+xLinkPlatformErrorCode_t ipc_loopback_connect(const char* name, void** fd);
+
+/**
+ * @brief Closes the connection, wakes the peer and local threads blocked on it
+ */
+int ipc_close(void* fd);
+
+int ipc_write(void* fd, const void* data, int size);
+
+int ipc_read(void* fd, void* data, int size);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  // IPC_HOST_H
@@ -40,6 +40,9 @@
 #endif
 
 #include <chrono>
+#include <thread>
+#include <mutex>
+#include <atomic>
 
 /* **************************************************************************/
 /*      Private Macro Definitions                                            */
@@ -87,6 +90,23 @@ static XLinkDeviceState_t tcpip_convert_device_state(uint32_t state)
 }
 
 
+static uint32_t tcpip_convert_to_host_state(XLinkDeviceState_t state)
+{
+    if(state == X_LINK_BOOTLOADER)
+    {
+        return TCPIP_HOST_STATE_BOOTLOADER;
+    }
+    else if(state == X_LINK_FLASH_BOOTED)
+    {
+        return TCPIP_HOST_STATE_FLASH_BOOTED;
+    }
+    else
+    {
+        return TCPIP_HOST_STATE_BOOTED;
+    }
+}
+
+
 static tcpipHostError_t tcpip_create_socket(TCPIP_SOCKET* out_sock, bool broadcast, int timeout_ms)
 {
     TCPIP_SOCKET sock = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
@@ -663,3 +683,84 @@ xLinkPlatformErrorCode_t tcpip_boot_bootloader(const char* name){
 
     return X_LINK_PLATFORM_SUCCESS;
 }
+
+
+// Answering thread of the discovery, for processes serving links in the device role
+static std::mutex announce_mutex;
+static std::thread announce_thread;
+static std::atomic<bool> announce_running{false};
+
+xLinkPlatformErrorCode_t tcpip_announce_start(const char* mxid, XLinkDeviceState_t state)
+{
+    if(mxid == NULL){
+        return X_LINK_PLATFORM_INVALID_PARAMETERS;
+    }
+
+    std::lock_guard<std::mutex> lock(announce_mutex);
+    if(announce_thread.joinable()){
+        return X_LINK_PLATFORM_DEVICE_BUSY;
+    }
+
+    // Receive timeout bounds how long stopping takes
+    TCPIP_SOCKET sock;
+    if(tcpip_create_socket(&sock, false, 100) != TCPIP_HOST_SUCCESS){
+        return X_LINK_PLATFORM_ERROR;
+    }
+
+    struct sockaddr_in announce_address = {};
+    announce_address.sin_family = AF_INET;
+    announce_address.sin_port = htons(BROADCAST_UDP_PORT);
+    announce_address.sin_addr.s_addr = htonl(INADDR_ANY);
+    if(bind(sock, (struct sockaddr *)&announce_address, sizeof(announce_address)) < 0)
+    {
+        tcpip_close_socket(sock);
+        return X_LINK_PLATFORM_ERROR;
+    }
+
+    tcpipHostDeviceDiscoveryResp_t response = {};
+    response.command = TCPIP_HOST_CMD_DEVICE_DISCOVER;
+    strncpy(response.mxid, mxid, sizeof(response.mxid) - 1);
+    response.state = tcpip_convert_to_host_state(state);
+
+    announce_running = true;
+    announce_thread = std::thread([sock, response](){
+        while(announce_running){
+            tcpipHostCommand_t command = TCPIP_HOST_CMD_NO_COMMAND;
+            struct sockaddr_in host_addr;
+            #if (defined(_WIN32) || defined(_WIN64) )
+                int len = sizeof(host_addr);
+            #else
+                socklen_t len = sizeof(host_addr);
+            #endif
+
+            int ret = recvfrom(sock, (char *) &command, sizeof(command), 0, (struct sockaddr*) &host_addr, &len);
+            if(ret < (int) sizeof(command)){
+                // timed out, check whether to stop
+                continue;
+            }
+
+            if(command == TCPIP_HOST_CMD_DEVICE_DISCOVER){
+                DEBUG("Answering discovery\n");
+                sendto(sock, reinterpret_cast<const char*>(&response), sizeof(response), 0, (struct sockaddr*) &host_addr, len);
+            } else {
+                // served links aren't rebooted on request
+                DEBUG("Ignoring command %d\n", command);
+            }
+        }
+        tcpip_close_socket(sock);
+    });
+
+    return X_LINK_PLATFORM_SUCCESS;
+}
+
+xLinkPlatformErrorCode_t tcpip_announce_stop(void)
+{
+    std::lock_guard<std::mutex> lock(announce_mutex);
+    if(!announce_thread.joinable()){
+        return X_LINK_PLATFORM_ERROR;
+    }
+
+    announce_running = false;
+    announce_thread.join();
+    return X_LINK_PLATFORM_SUCCESS;
+}
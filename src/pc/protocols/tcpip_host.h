@@ -113,6 +113,22 @@ xLinkPlatformErrorCode_t tcpip_close_search_context(void* ctx);
 */
 xLinkPlatformErrorCode_t tcpip_boot_bootloader(const char* name);
 
+/**
+ * @brief       Starts answering discovery broadcasts of hosts in a background thread
+ *
+ * @param[in]   mxid Id reported to the hosts
+ * @param[in]   state State reported to the hosts
+ * @retval      X_LINK_PLATFORM_DEVICE_BUSY Already answering
+ * @retval      X_LINK_PLATFORM_ERROR Failed to bind the discovery port
+ * @retval      X_LINK_PLATFORM_SUCCESS Answering
+*/
+xLinkPlatformErrorCode_t tcpip_announce_start(const char* mxid, XLinkDeviceState_t state);
+
+/**
+ * @brief       Stops answering discovery broadcasts, waits for the background thread
+*/
+xLinkPlatformErrorCode_t tcpip_announce_stop(void);
+
 
 #ifdef __cplusplus
 }
@@ -0,0 +1,735 @@
+// Copyright (C) 2018-2021 Intel Corporation
+// SPDX-License-Identifier: Apache-2.0
+//
+
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE // fix for warning: implicit declaration of function 'pthread_setname_np'
+#endif
+
+#include "tcpip_uring.h"
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <errno.h>
+
+#if defined(XLINK_HAVE_IO_URING)
+#include <pthread.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
+#include <linux/io_uring.h>
+#endif
+
+#define MVLOG_UNIT_NAME tcpip_uring
+#include "XLinkLog.h"
+
+#if defined(XLINK_HAVE_IO_URING)
+
+// One ring serves all links: a posted receive per socket, the sends in flight and cancels
+#define TCPIP_URING_ENTRIES 256
+// Sockets served at the same time, each has a receive buffer in the registered region
+#define TCPIP_URING_MAX_CONNECTIONS 64
+// Receive buffer of a socket, a receive picks up several small events at once
+#define TCPIP_URING_STAGING_SIZE (64 * 1024)
+// Reads at least this large are received straight into the caller's buffer
+#define TCPIP_URING_DIRECT_SIZE (16 * 1024)
+// Sockets are looked up by their fd, higher fds are left to the socket calls
+#define TCPIP_URING_MAX_FD 4096
+
+typedef enum {
+    TCPIP_URING_RECEIVE = 1,
+    TCPIP_URING_SEND,
+} tcpipOpType_t;
+
+struct tcpipConnection;
+
+// An operation in flight, its completion is delivered to it through user_data
+typedef struct {
+    tcpipOpType_t type;
+    struct tcpipConnection* conn;
+    int fixed;  // received into the registered buffer
+    int res;
+    int done;
+} tcpipOp_t;
+
+typedef struct {
+    int fd;
+    void* sqPtr;
+    size_t sqSize;
+    void* cqPtr;
+    size_t cqSize;
+    struct io_uring_sqe* sqes;
+    size_t sqesSize;
+
+    uint32_t entries;
+    uint32_t* sqHead;
+    uint32_t* sqTail;
+    uint32_t* sqMask;
+    uint32_t* sqArray;
+    uint32_t* cqHead;
+    uint32_t* cqTail;
+    uint32_t* cqMask;
+    struct io_uring_cqe* cqes;
+} tcpipRing_t;
+
+typedef struct tcpipConnection {
+    int sock;
+    int slot;
+    // the reader and the writers wait on cond for completions of their operations
+    pthread_mutex_t lock;
+    pthread_cond_t cond;
+    // writes are sent one after the other, so partial sends stay in order
+    pthread_mutex_t txLock;
+
+    // the posted receive, into the staging buffer or the target of a large read
+    tcpipOp_t rx;
+    int rxPosted;
+    int rxDirect;
+    uint8_t* target;
+    uint32_t targetLeft;
+    uint8_t* staging;
+    uint32_t stagedStart;
+    uint32_t stagedEnd;
+    int failed;
+    int closing;
+
+    // reads and writes in progress, guarded by connectionsLock
+    uint32_t users;
+} tcpipConnection_t;
+
+static pthread_once_t setupOnce = PTHREAD_ONCE_INIT;
+static int supported = 0;
+static XLinkTcpBackend_t selected = X_LINK_TCP_BACKEND_SOCKETS;
+
+static tcpipRing_t ring;
+// guards the submission queue
+static pthread_mutex_t sqLock = PTHREAD_MUTEX_INITIALIZER;
+// a thread submitting for everybody, the others only queue meanwhile
+static int submitting = 0;
+// receive buffers of all sockets, registered with the ring unless the memlock limit didn't allow it
+static uint8_t* stagingPool = NULL;
+static int stagingRegistered = 0;
+
+static pthread_mutex_t connectionsLock = PTHREAD_MUTEX_INITIALIZER;
+static tcpipConnection_t* connections[TCPIP_URING_MAX_FD];
+static tcpipConnection_t* slots[TCPIP_URING_MAX_CONNECTIONS];
+// socket links don't take connectionsLock while no connection is attached
+static uint32_t attachedCount = 0;
+
+// ------------------------------------
+// Helpers declaration. Begin.
+// ------------------------------------
+
+static int ringInit(tcpipRing_t* ring, uint32_t entries);
+static void ringDestroy(tcpipRing_t* ring);
+static int isSupported(const tcpipRing_t* ring);
+static void setup(void);
+static void* completionRun(void* ctx);
+
+// Queues the operation, submitted by the next call of flushSubmissions or the completion thread
+static void queueOp(const struct io_uring_sqe* op);
+// Submits everything queued, together with what other threads queue meanwhile
+static void flushSubmissions(void);
+
+static tcpipConnection_t* acquireConnection(int sock);
+static void releaseConnection(tcpipConnection_t* conn);
+// Posts the receive of the socket unless one is posted. Holds conn->lock, returns 1 if queued
+static int postReceive(tcpipConnection_t* conn);
+static void completeReceive(tcpipConnection_t* conn, int res);
+
+// ------------------------------------
+// Helpers declaration. End.
+// ------------------------------------
+
+int tcpip_uring_select(XLinkTcpBackend_t backend)
+{
+    if (backend == X_LINK_TCP_BACKEND_IO_URING) {
+        pthread_once(&setupOnce, setup);
+        if (!supported) {
+            return -1;
+        }
+    }
+    __atomic_store_n(&selected, backend, __ATOMIC_RELAXED);
+    return 0;
+}
+
+void tcpip_uring_attach(int sock)
+{
+    if (__atomic_load_n(&selected, __ATOMIC_RELAXED) != X_LINK_TCP_BACKEND_IO_URING) {
+        return;
+    }
+    if (sock < 0 || sock >= TCPIP_URING_MAX_FD) {
+        mvLog(MVLOG_WARN, "Socket %d is served by socket calls, io_uring serves fds below %d",
+              sock, TCPIP_URING_MAX_FD);
+        return;
+    }
+
+    tcpipConnection_t* conn = calloc(1, sizeof(*conn));
+    if (conn == NULL) {
+        return;
+    }
+    conn->sock = sock;
+    conn->rx.type = TCPIP_URING_RECEIVE;
+    conn->rx.conn = conn;
+    pthread_mutex_init(&conn->lock, NULL);
+    pthread_cond_init(&conn->cond, NULL);
+    pthread_mutex_init(&conn->txLock, NULL);
+
+    pthread_mutex_lock(&connectionsLock);
+    conn->slot = -1;
+    for (int i = 0; i < TCPIP_URING_MAX_CONNECTIONS; i++) {
+        if (slots[i] == NULL) {
+            conn->slot = i;
+            slots[i] = conn;
+            break;
+        }
+    }
+    if (conn->slot >= 0) {
+        conn->staging = stagingPool + (size_t)conn->slot * TCPIP_URING_STAGING_SIZE;
+        connections[sock] = conn;
+        __atomic_add_fetch(&attachedCount, 1, __ATOMIC_RELAXED);
+    }
+    pthread_mutex_unlock(&connectionsLock);
+
+    if (conn->slot < 0) {
+        mvLog(MVLOG_WARN, "Socket %d is served by socket calls, io_uring serves %d sockets at most",
+              sock, TCPIP_URING_MAX_CONNECTIONS);
+        pthread_mutex_destroy(&conn->lock);
+        pthread_cond_destroy(&conn->cond);
+        pthread_mutex_destroy(&conn->txLock);
+        free(conn);
+        return;
+    }
+
+    // data is picked up from now on, whether a read waits for it or not
+    pthread_mutex_lock(&conn->lock);
+    int queued = postReceive(conn);
+    pthread_mutex_unlock(&conn->lock);
+    if (queued) {
+        flushSubmissions();
+    }
+}
+
+void tcpip_uring_detach(int sock)
+{
+    if (sock < 0 || sock >= TCPIP_URING_MAX_FD) {
+        return;
+    }
+
+    pthread_mutex_lock(&connectionsLock);
+    tcpipConnection_t* conn = connections[sock];
+    connections[sock] = NULL;
+    if (conn) {
+        __atomic_sub_fetch(&attachedCount, 1, __ATOMIC_RELAXED);
+    }
+    pthread_mutex_unlock(&connectionsLock);
+    if (conn == NULL) {
+        return;
+    }
+
+    // the shutdown of the socket completes the posted receive, the cancel makes sure of it
+    pthread_mutex_lock(&conn->lock);
+    conn->closing = 1;
+    int posted = conn->rxPosted;
+    pthread_cond_broadcast(&conn->cond);
+    pthread_mutex_unlock(&conn->lock);
+    if (posted) {
+        struct io_uring_sqe cancel = {0};
+        cancel.opcode = IORING_OP_ASYNC_CANCEL;
+        cancel.fd = -1;
+        cancel.addr = (uintptr_t)&conn->rx;
+        queueOp(&cancel);
+        flushSubmissions();
+    }
+
+    const struct timespec pause = {0, 1000000};
+    while (1) {
+        pthread_mutex_lock(&connectionsLock);
+        uint32_t users = conn->users;
+        pthread_mutex_unlock(&connectionsLock);
+        pthread_mutex_lock(&conn->lock);
+        posted = conn->rxPosted;
+        pthread_mutex_unlock(&conn->lock);
+        if (users == 0 && !posted) {
+            break;
+        }
+        nanosleep(&pause, NULL);
+    }
+
+    pthread_mutex_lock(&connectionsLock);
+    slots[conn->slot] = NULL;
+    pthread_mutex_unlock(&connectionsLock);
+    pthread_mutex_destroy(&conn->lock);
+    pthread_cond_destroy(&conn->cond);
+    pthread_mutex_destroy(&conn->txLock);
+    free(conn);
+}
+
+int tcpip_uring_read(int sock, void* data, int size)
+{
+    tcpipConnection_t* conn = acquireConnection(sock);
+    if (conn == NULL) {
+        return TCPIP_URING_NOT_ATTACHED;
+    }
+
+    int rc = 0;
+    uint8_t* dst = data;
+    uint32_t left = size;
+    pthread_mutex_lock(&conn->lock);
+    while (left > 0) {
+        uint32_t staged = conn->stagedEnd - conn->stagedStart;
+        if (staged > 0) {
+            uint32_t n = staged < left ? staged : left;
+            memcpy(dst, conn->staging + conn->stagedStart, n);
+            conn->stagedStart += n;
+            dst += n;
+            left -= n;
+            continue;
+        }
+        if (conn->failed || conn->closing) {
+            rc = -1;
+            break;
+        }
+
+        // a large rest is received in place once the staged data is taken
+        conn->target = dst;
+        conn->targetLeft = left;
+        if (postReceive(conn)) {
+            pthread_mutex_unlock(&conn->lock);
+            flushSubmissions();
+            pthread_mutex_lock(&conn->lock);
+        }
+        if (conn->stagedEnd == conn->stagedStart && conn->targetLeft == left && !conn->failed && !conn->closing) {
+            pthread_cond_wait(&conn->cond, &conn->lock);
+        }
+        dst = conn->target;
+        left = conn->targetLeft;
+    }
+    conn->target = NULL;
+    conn->targetLeft = 0;
+    // the staging buffer filled up while nobody read
+    int queued = rc == 0 && postReceive(conn);
+    pthread_mutex_unlock(&conn->lock);
+    if (queued) {
+        flushSubmissions();
+    }
+
+    releaseConnection(conn);
+    return rc;
+}
+
+int tcpip_uring_write(int sock, const void* header, int headerSize, const void* data, int size)
+{
+    tcpipConnection_t* conn = acquireConnection(sock);
+    if (conn == NULL) {
+        return TCPIP_URING_NOT_ATTACHED;
+    }
+
+    struct iovec iov[2] = {{(void*)header, headerSize}, {(void*)data, size}};
+    struct msghdr msg = {0};
+    msg.msg_iov = iov;
+    msg.msg_iovlen = size > 0 ? 2 : 1;
+
+    tcpipOp_t send = {0};
+    send.type = TCPIP_URING_SEND;
+    send.conn = conn;
+
+    struct io_uring_sqe op = {0};
+    op.opcode = IORING_OP_SENDMSG;
+    op.fd = conn->sock;
+    op.addr = (uintptr_t)&msg;
+    op.len = 1;
+    op.msg_flags = MSG_NOSIGNAL | MSG_WAITALL;
+    op.user_data = (uintptr_t)&send;
+
+    int rc = 0;
+    pthread_mutex_lock(&conn->txLock);
+    while (msg.msg_iovlen > 0) {
+        send.done = 0;
+        queueOp(&op);
+        flushSubmissions();
+
+        pthread_mutex_lock(&conn->lock);
+        while (!send.done) {
+            pthread_cond_wait(&conn->cond, &conn->lock);
+        }
+        pthread_mutex_unlock(&conn->lock);
+
+        int sent = send.res;
+        if (sent <= 0) {
+            rc = -1;
+            break;
+        }
+        // continues after a partial send
+        while (msg.msg_iovlen > 0 && (size_t)sent >= msg.msg_iov->iov_len) {
+            sent -= msg.msg_iov->iov_len;
+            msg.msg_iov++;
+            msg.msg_iovlen--;
+        }
+        if (msg.msg_iovlen > 0) {
+            msg.msg_iov->iov_base = (uint8_t*)msg.msg_iov->iov_base + sent;
+            msg.msg_iov->iov_len -= sent;
+        }
+    }
+    pthread_mutex_unlock(&conn->txLock);
+
+    releaseConnection(conn);
+    return rc;
+}
+
+// ------------------------------------
+// Helpers implementation. Begin.
+// ------------------------------------
+
+static int ringInit(tcpipRing_t* ring, uint32_t entries)
+{
+    struct io_uring_params params;
+    memset(&params, 0, sizeof(params));
+    memset(ring, 0, sizeof(*ring));
+
+    ring->fd = syscall(__NR_io_uring_setup, entries, &params);
+    if (ring->fd < 0) {
+        return -1;
+    }
+    ring->entries = params.sq_entries;
+
+    ring->sqSize = params.sq_off.array + params.sq_entries * sizeof(uint32_t);
+    ring->cqSize = params.cq_off.cqes + params.cq_entries * sizeof(struct io_uring_cqe);
+    if (params.features & IORING_FEAT_SINGLE_MMAP) {
+        if (ring->cqSize > ring->sqSize) {
+            ring->sqSize = ring->cqSize;
+        }
+        ring->cqSize = ring->sqSize;
+    }
+    ring->sqesSize = params.sq_entries * sizeof(struct io_uring_sqe);
+
+    ring->sqPtr = mmap(NULL, ring->sqSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                       ring->fd, IORING_OFF_SQ_RING);
+    if (ring->sqPtr == MAP_FAILED) {
+        ring->sqPtr = NULL;
+        ringDestroy(ring);
+        return -1;
+    }
+    if (params.features & IORING_FEAT_SINGLE_MMAP) {
+        ring->cqPtr = ring->sqPtr;
+    } else {
+        ring->cqPtr = mmap(NULL, ring->cqSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                           ring->fd, IORING_OFF_CQ_RING);
+        if (ring->cqPtr == MAP_FAILED) {
+            ring->cqPtr = NULL;
+            ringDestroy(ring);
+            return -1;
+        }
+    }
+    ring->sqes = mmap(NULL, ring->sqesSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                      ring->fd, IORING_OFF_SQES);
+    if (ring->sqes == MAP_FAILED) {
+        ring->sqes = NULL;
+        ringDestroy(ring);
+        return -1;
+    }
+
+    uint8_t* sq = ring->sqPtr;
+    uint8_t* cq = ring->cqPtr;
+    ring->sqHead = (uint32_t*)(sq + params.sq_off.head);
+    ring->sqTail = (uint32_t*)(sq + params.sq_off.tail);
+    ring->sqMask = (uint32_t*)(sq + params.sq_off.ring_mask);
+    ring->sqArray = (uint32_t*)(sq + params.sq_off.array);
+    ring->cqHead = (uint32_t*)(cq + params.cq_off.head);
+    ring->cqTail = (uint32_t*)(cq + params.cq_off.tail);
+    ring->cqMask = (uint32_t*)(cq + params.cq_off.ring_mask);
+    ring->cqes = (struct io_uring_cqe*)(cq + params.cq_off.cqes);
+    return 0;
+}
+
+static void ringDestroy(tcpipRing_t* ring)
+{
+    if (ring->sqes) {
+        munmap(ring->sqes, ring->sqesSize);
+    }
+    if (ring->cqPtr && ring->cqPtr != ring->sqPtr) {
+        munmap(ring->cqPtr, ring->cqSize);
+    }
+    if (ring->sqPtr) {
+        munmap(ring->sqPtr, ring->sqSize);
+    }
+    if (ring->fd >= 0) {
+        close(ring->fd);
+    }
+    memset(ring, 0, sizeof(*ring));
+    ring->fd = -1;
+}
+
+static int isSupported(const tcpipRing_t* ring)
+{
+    size_t size = sizeof(struct io_uring_probe) + IORING_OP_LAST * sizeof(struct io_uring_probe_op);
+    struct io_uring_probe* ops = calloc(1, size);
+    if (ops == NULL
+        || syscall(__NR_io_uring_register, ring->fd, IORING_REGISTER_PROBE, ops, IORING_OP_LAST) != 0) {
+        free(ops);
+        return 0;
+    }
+    const int needed[] = {IORING_OP_RECV, IORING_OP_READ_FIXED, IORING_OP_SENDMSG, IORING_OP_ASYNC_CANCEL};
+    int all = 1;
+    for (size_t i = 0; i < sizeof(needed) / sizeof(needed[0]); i++) {
+        if (needed[i] > ops->last_op || !(ops->ops[needed[i]].flags & IO_URING_OP_SUPPORTED)) {
+            all = 0;
+        }
+    }
+    free(ops);
+    return all;
+}
+
+static void setup(void)
+{
+    if (ringInit(&ring, TCPIP_URING_ENTRIES)) {
+        mvLog(MVLOG_DEBUG, "io_uring isn't available, errno %d", errno);
+        return;
+    }
+    if (!isSupported(&ring)) {
+        mvLog(MVLOG_DEBUG, "io_uring lacks the operations of the TCP/IP backend");
+        ringDestroy(&ring);
+        return;
+    }
+
+    stagingPool = malloc((size_t)TCPIP_URING_MAX_CONNECTIONS * TCPIP_URING_STAGING_SIZE);
+    if (stagingPool == NULL) {
+        ringDestroy(&ring);
+        return;
+    }
+    struct iovec pool = {stagingPool, (size_t)TCPIP_URING_MAX_CONNECTIONS * TCPIP_URING_STAGING_SIZE};
+    stagingRegistered = syscall(__NR_io_uring_register, ring.fd, IORING_REGISTER_BUFFERS, &pool, 1) == 0;
+    if (!stagingRegistered) {
+        mvLog(MVLOG_DEBUG, "Registering the receive buffers failed, errno %d", errno);
+    }
+
+    // the ring lives as long as the process, so does the thread completing its operations
+    pthread_t thread;
+    pthread_attr_t attr;
+    pthread_attr_init(&attr);
+    pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_DETACHED);
+    int rc = pthread_create(&thread, &attr, completionRun, NULL);
+    pthread_attr_destroy(&attr);
+    if (rc != 0) {
+        ringDestroy(&ring);
+        free(stagingPool);
+        stagingPool = NULL;
+        return;
+    }
+    if (pthread_setname_np(thread, "XLinkUringThr") != 0) {
+        mvLog(MVLOG_WARN, "Setting the name of the io_uring thread failed");
+    }
+    supported = 1;
+    mvLog(MVLOG_DEBUG, "io_uring serves TCP/IP links when selected");
+}
+
+static void* completionRun(void* ctx)
+{
+    (void)ctx;
+    while (1) {
+        // receives posted by the completions below go out with the wait
+        pthread_mutex_lock(&sqLock);
+        uint32_t pending = *ring.sqTail - __atomic_load_n(ring.sqHead, __ATOMIC_ACQUIRE);
+        pthread_mutex_unlock(&sqLock);
+        if (syscall(__NR_io_uring_enter, ring.fd, pending, 1, IORING_ENTER_GETEVENTS, NULL, 0) < 0
+            && errno != EINTR && errno != EAGAIN && errno != EBUSY) {
+            mvLog(MVLOG_ERROR, "Waiting for io_uring completions failed, errno %d", errno);
+        }
+
+        uint32_t head = *ring.cqHead;
+        while (head != __atomic_load_n(ring.cqTail, __ATOMIC_ACQUIRE)) {
+            const struct io_uring_cqe* cqe = &ring.cqes[head & *ring.cqMask];
+            tcpipOp_t* op = (tcpipOp_t*)(uintptr_t)cqe->user_data;
+            int res = cqe->res;
+            head++;
+            __atomic_store_n(ring.cqHead, head, __ATOMIC_RELEASE);
+
+            // cancels complete without an operation
+            if (op == NULL) {
+                continue;
+            }
+            tcpipConnection_t* conn = op->conn;
+            pthread_mutex_lock(&conn->lock);
+            if (op->type == TCPIP_URING_RECEIVE) {
+                completeReceive(conn, res);
+            } else {
+                op->res = res;
+                op->done = 1;
+            }
+            pthread_cond_broadcast(&conn->cond);
+            pthread_mutex_unlock(&conn->lock);
+        }
+    }
+    return NULL;
+}
+
+static void queueOp(const struct io_uring_sqe* op)
+{
+    pthread_mutex_lock(&sqLock);
+    uint32_t tail = *ring.sqTail;
+    while (tail - __atomic_load_n(ring.sqHead, __ATOMIC_ACQUIRE) >= ring.entries) {
+        // full, the entries queued first go out to make room
+        syscall(__NR_io_uring_enter, ring.fd, ring.entries, 0, 0, NULL, 0);
+    }
+    uint32_t index = tail & *ring.sqMask;
+    ring.sqes[index] = *op;
+    ring.sqArray[index] = index;
+    __atomic_store_n(ring.sqTail, tail + 1, __ATOMIC_RELEASE);
+    pthread_mutex_unlock(&sqLock);
+}
+
+static void flushSubmissions(void)
+{
+    pthread_mutex_lock(&sqLock);
+    if (submitting) {
+        // the submitting thread takes ours along
+        pthread_mutex_unlock(&sqLock);
+        return;
+    }
+    submitting = 1;
+    while (1) {
+        uint32_t pending = *ring.sqTail - __atomic_load_n(ring.sqHead, __ATOMIC_ACQUIRE);
+        if (pending == 0) {
+            break;
+        }
+        pthread_mutex_unlock(&sqLock);
+        int rc = syscall(__NR_io_uring_enter, ring.fd, pending, 0, 0, NULL, 0);
+        pthread_mutex_lock(&sqLock);
+        if (rc < 0 && errno != EINTR) {
+            // left to the next submission, e.g. while completions overflow
+            mvLog(MVLOG_DEBUG, "Submitting to io_uring failed, errno %d", errno);
+            break;
+        }
+    }
+    submitting = 0;
+    pthread_mutex_unlock(&sqLock);
+}
+
+static tcpipConnection_t* acquireConnection(int sock)
+{
+    if (sock < 0 || sock >= TCPIP_URING_MAX_FD || __atomic_load_n(&attachedCount, __ATOMIC_RELAXED) == 0) {
+        return NULL;
+    }
+    pthread_mutex_lock(&connectionsLock);
+    tcpipConnection_t* conn = connections[sock];
+    if (conn) {
+        conn->users++;
+    }
+    pthread_mutex_unlock(&connectionsLock);
+    return conn;
+}
+
+static void releaseConnection(tcpipConnection_t* conn)
+{
+    pthread_mutex_lock(&connectionsLock);
+    conn->users--;
+    pthread_mutex_unlock(&connectionsLock);
+}
+
+static int postReceive(tcpipConnection_t* conn)
+{
+    if (conn->rxPosted || conn->failed || conn->closing) {
+        return 0;
+    }
+    if (conn->stagedStart == conn->stagedEnd) {
+        conn->stagedStart = conn->stagedEnd = 0;
+    }
+
+    struct io_uring_sqe op = {0};
+    op.fd = conn->sock;
+    op.user_data = (uintptr_t)&conn->rx;
+    conn->rxDirect = conn->stagedEnd == 0 && conn->target != NULL && conn->targetLeft >= TCPIP_URING_DIRECT_SIZE;
+    conn->rx.fixed = 0;
+    if (conn->rxDirect) {
+        op.opcode = IORING_OP_RECV;
+        op.addr = (uintptr_t)conn->target;
+        op.len = conn->targetLeft;
+        op.msg_flags = MSG_WAITALL;
+    } else if (conn->target != NULL && conn->stagedEnd != conn->stagedStart
+               && conn->targetLeft >= conn->stagedEnd - conn->stagedStart + TCPIP_URING_DIRECT_SIZE) {
+        // a large read takes the staged data first and then receives its rest in place
+        return 0;
+    } else {
+        if (conn->stagedEnd == TCPIP_URING_STAGING_SIZE) {
+            if (conn->stagedStart == 0) {
+                // full, reads make room
+                return 0;
+            }
+            memmove(conn->staging, conn->staging + conn->stagedStart, conn->stagedEnd - conn->stagedStart);
+            conn->stagedEnd -= conn->stagedStart;
+            conn->stagedStart = 0;
+        }
+        op.addr = (uintptr_t)(conn->staging + conn->stagedEnd);
+        op.len = TCPIP_URING_STAGING_SIZE - conn->stagedEnd;
+        if (__atomic_load_n(&stagingRegistered, __ATOMIC_RELAXED)) {
+            op.opcode = IORING_OP_READ_FIXED;
+            op.buf_index = 0;
+            conn->rx.fixed = 1;
+        } else {
+            op.opcode = IORING_OP_RECV;
+        }
+    }
+    conn->rxPosted = 1;
+    queueOp(&op);
+    return 1;
+}
+
+// Holds conn->lock
+static void completeReceive(tcpipConnection_t* conn, int res)
+{
+    conn->rxPosted = 0;
+    if (conn->rx.fixed && (res == -EINVAL || res == -EOPNOTSUPP)) {
+        // kernels reading sockets only through recv
+        __atomic_store_n(&stagingRegistered, 0, __ATOMIC_RELAXED);
+    } else if (res == -EINTR || res == -EAGAIN) {
+        // posted again below
+    } else if (res <= 0) {
+        // the connection is gone or was shut down
+        conn->failed = 1;
+    } else if (conn->rxDirect) {
+        conn->target += res;
+        conn->targetLeft -= res;
+    } else {
+        conn->stagedEnd += res;
+    }
+    conn->rxDirect = 0;
+    // submitted with the next wait for completions
+    postReceive(conn);
+}
+
+// ------------------------------------
+// Helpers implementation. End.
+// ------------------------------------
+
+#else
+
+int tcpip_uring_select(XLinkTcpBackend_t backend)
+{
+    return backend == X_LINK_TCP_BACKEND_IO_URING ? -1 : 0;
+}
+
+void tcpip_uring_attach(int sock)
+{
+    (void)sock;
+}
+
+void tcpip_uring_detach(int sock)
+{
+    (void)sock;
+}
+
+int tcpip_uring_read(int sock, void* data, int size)
+{
+    return TCPIP_URING_NOT_ATTACHED;
+}
+
+int tcpip_uring_write(int sock, const void* header, int headerSize, const void* data, int size)
+{
+    return TCPIP_URING_NOT_ATTACHED;
+}
+
+#endif // XLINK_HAVE_IO_URING
@@ -0,0 +1,58 @@
+// Copyright (C) 2018-2021 Intel Corporation
+// SPDX-License-Identifier: Apache-2.0
+//
+
+/**
+ * @file    tcpip_uring.h
+ * @brief   io_uring backend of TCP/IP links, see XLinkSetTcpBackend
+*/
+
+#ifndef TCPIP_URING_H
+#define TCPIP_URING_H
+
+#include "XLinkPublicDefines.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Returned by reads and writes of sockets which aren't served by io_uring
+#define TCPIP_URING_NOT_ATTACHED 1
+
+/**
+ * @brief Selects the backend of links connected or served afterwards
+ * @return 0 on success, -1 if io_uring isn't built in or supported by the kernel
+ */
+int tcpip_uring_select(XLinkTcpBackend_t backend);
+
+/**
+ * @brief Serves the socket of a new link by io_uring if it's the selected backend. A receive
+ *        into a registered buffer of the socket stays posted on the shared ring from then on
+ * @note Sockets beyond the buffers of the ring are left to the socket calls
+ */
+void tcpip_uring_attach(int sock);
+
+/**
+ * @brief Stops serving a socket, after shutdown and before close. Waits for reads and
+ *        writes in progress and for the posted receive, which shutdown completes
+ */
+void tcpip_uring_detach(int sock);
+
+/**
+ * @brief Reads exactly size bytes
+ * @return 0 on success, -1 on failure, TCPIP_URING_NOT_ATTACHED
+ */
+int tcpip_uring_read(int sock, void* data, int size);
+
+/**
+ * @brief Writes both buffers back to back in one submission, the second may be empty.
+ *        Sends of all links queued meanwhile go to the kernel together
+ * @return 0 on success, -1 on failure, TCPIP_URING_NOT_ATTACHED
+ */
+int tcpip_uring_write(int sock, const void* header, int headerSize, const void* data, int size);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  // TCPIP_URING_H
@@ -0,0 +1,190 @@
+// Copyright (C) 2018-2021 Intel Corporation
+// SPDX-License-Identifier: Apache-2.0
+//
+
+#include "tcpip_zerocopy.h"
+#include "XLinkPublicDefines.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+
+#if defined(__linux__)
+#include <poll.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <linux/errqueue.h>
+#endif
+
+#define MVLOG_UNIT_NAME tcpip_zerocopy
+#include "XLinkLog.h"
+
+#if defined(__linux__) && defined(SO_ZEROCOPY) && defined(MSG_ZEROCOPY) && defined(SO_EE_ORIGIN_ZEROCOPY)
+
+static uint32_t threshold = XLINK_TCP_ZEROCOPY_THRESHOLD;
+
+// ------------------------------------
+// Helpers declaration. Begin.
+// ------------------------------------
+
+static int isEnabled(int sock);
+static int waitCompletions(int sock, uint32_t pending);
+
+// ------------------------------------
+// Helpers declaration. End.
+// ------------------------------------
+
+
+
+// ------------------------------------
+// API implementation. Begin.
+// ------------------------------------
+
+int tcpip_zerocopy_set_threshold(uint32_t bytes)
+{
+    __atomic_store_n(&threshold, bytes, __ATOMIC_RELAXED);
+    return 0;
+}
+
+void tcpip_zerocopy_enable(int sock)
+{
+    int on = 1;
+    if(setsockopt(sock, SOL_SOCKET, SO_ZEROCOPY, &on, sizeof(on)) < 0) {
+        mvLog(MVLOG_DEBUG, "SO_ZEROCOPY isn't supported (errno %d), sends are copied", errno);
+    }
+}
+
+int tcpip_zerocopy_send(int sock, const void* data, int size)
+{
+    uint32_t minSize = __atomic_load_n(&threshold, __ATOMIC_RELAXED);
+    if(minSize == 0 || size < 0 || (uint32_t)size < minSize || !isEnabled(sock)) {
+        return TCPIP_ZEROCOPY_NOT_USED;
+    }
+
+    // every send call which took data is completed by the kernel separately
+    uint32_t pending = 0;
+    int flags = MSG_NOSIGNAL | MSG_ZEROCOPY;
+    int sent = 0;
+    while(sent < size) {
+        ssize_t rc = send(sock, (const char*)data + sent, size - sent, flags);
+        if(rc < 0 && errno == EINTR) {
+            continue;
+        }
+        if(rc < 0 && errno == ENOBUFS && (flags & MSG_ZEROCOPY)) {
+            // out of option memory for the notifications, the rest is copied
+            flags &= ~MSG_ZEROCOPY;
+            continue;
+        }
+        if(rc <= 0) {
+            return -1;
+        }
+        sent += (int)rc;
+        if(flags & MSG_ZEROCOPY) {
+            pending++;
+        }
+    }
+    return waitCompletions(sock, pending);
+}
+
+// ------------------------------------
+// API implementation. End.
+// ------------------------------------
+
+
+
+// ------------------------------------
+// Helpers implementation. Begin.
+// ------------------------------------
+
+static int isEnabled(int sock)
+{
+    int on = 0;
+    socklen_t len = sizeof(on);
+    return getsockopt(sock, SOL_SOCKET, SO_ZEROCOPY, &on, &len) == 0 && on;
+}
+
+static int waitCompletions(int sock, uint32_t pending)
+{
+    int copied = 0;
+    while(pending > 0) {
+        char control[128];
+        struct msghdr msg;
+        memset(&msg, 0, sizeof(msg));
+        msg.msg_control = control;
+        msg.msg_controllen = sizeof(control);
+
+        if(recvmsg(sock, &msg, MSG_ERRQUEUE | MSG_DONTWAIT) < 0) {
+            if(errno == EINTR) {
+                continue;
+            }
+            if(errno != EAGAIN && errno != EWOULDBLOCK) {
+                return -1;
+            }
+            // notifications and socket errors both raise POLLERR
+            int error = 0;
+            socklen_t len = sizeof(error);
+            if(getsockopt(sock, SOL_SOCKET, SO_ERROR, &error, &len) == 0 && error != 0) {
+                return -1;
+            }
+            struct pollfd pfd = {sock, 0, 0};
+            if(poll(&pfd, 1, -1) < 0 && errno != EINTR) {
+                return -1;
+            }
+            if((pfd.revents & (POLLHUP | POLLNVAL)) && !(pfd.revents & POLLERR)) {
+                return -1;
+            }
+            continue;
+        }
+
+        struct cmsghdr* cmsg;
+        for(cmsg = CMSG_FIRSTHDR(&msg); cmsg != NULL; cmsg = CMSG_NXTHDR(&msg, cmsg)) {
+            if(!((cmsg->cmsg_level == SOL_IP && cmsg->cmsg_type == IP_RECVERR)
+                 || (cmsg->cmsg_level == SOL_IPV6 && cmsg->cmsg_type == IPV6_RECVERR))) {
+                continue;
+            }
+            struct sock_extended_err err;
+            memcpy(&err, CMSG_DATA(cmsg), sizeof(err));
+            if(err.ee_errno != 0 || err.ee_origin != SO_EE_ORIGIN_ZEROCOPY) {
+                continue;
+            }
+            // notifications cover a range of sends, [ee_info, ee_data]
+            uint32_t count = err.ee_data - err.ee_info + 1;
+            pending = count < pending ? pending - count : 0;
+            copied |= (err.ee_code & SO_EE_CODE_ZEROCOPY_COPIED) != 0;
+        }
+    }
+
+    if(copied) {
+        // the kernel copied the data anyway, e.g. over loopback, which costs more than a plain send
+        int off = 0;
+        setsockopt(sock, SOL_SOCKET, SO_ZEROCOPY, &off, sizeof(off));
+        mvLog(MVLOG_DEBUG, "Zero-copy sends were copied, socket %d copies from now on", sock);
+    }
+    return 0;
+}
+
+// ------------------------------------
+// Helpers implementation. End.
+// ------------------------------------
+
+#else
+
+int tcpip_zerocopy_set_threshold(uint32_t bytes)
+{
+    return bytes == 0 ? 0 : -1;
+}
+
+void tcpip_zerocopy_enable(int sock)
+{
+    (void)sock;
+}
+
+int tcpip_zerocopy_send(int sock, const void* data, int size)
+{
+    (void)sock;
+    (void)data;
+    (void)size;
+    return TCPIP_ZEROCOPY_NOT_USED;
+}
+
+#endif
@@ -0,0 +1,46 @@
+// Copyright (C) 2018-2021 Intel Corporation
+// SPDX-License-Identifier: Apache-2.0
+//
+
+/**
+ * @file    tcpip_zerocopy.h
+ * @brief   MSG_ZEROCOPY sends of large TCP/IP writes, see XLinkSetTcpZeroCopyThreshold
+*/
+
+#ifndef TCPIP_ZEROCOPY_H
+#define TCPIP_ZEROCOPY_H
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Returned by sends which are left to the copying socket calls
+#define TCPIP_ZEROCOPY_NOT_USED 1
+
+/**
+ * @brief Sets the size from which writes are sent without copies, 0 disables them
+ * @return 0 on success, -1 if the platform has no MSG_ZEROCOPY
+ */
+int tcpip_zerocopy_set_threshold(uint32_t bytes);
+
+/**
+ * @brief Allows zero-copy sends on the socket of a new link
+ * @note Kernels without SO_ZEROCOPY leave the socket to the copying path
+ */
+void tcpip_zerocopy_enable(int sock);
+
+/**
+ * @brief Sends exactly size bytes without copying them into the socket buffer. Returns
+ *        once the kernel released the pages, so the caller may reuse the data right away
+ * @return 0 on success, -1 on failure, TCPIP_ZEROCOPY_NOT_USED for writes below the
+ *         threshold and sockets without zero-copy
+ */
+int tcpip_zerocopy_send(int sock, const void* data, int size);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  // TCPIP_ZEROCOPY_H
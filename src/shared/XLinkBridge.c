@@ -0,0 +1,221 @@
+// Copyright (C) 2018-2021 Intel Corporation
+// SPDX-License-Identifier: Apache-2.0
+//
+
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE // fix for warning: implicit declaration of function 'pthread_setname_np'
+#endif
+
+#include "stdio.h"
+#include "stdlib.h"
+
+#if (defined(_WIN32) || defined(_WIN64))
+# include "win_pthread.h"
+# include <windows.h>
+#else
+# include <pthread.h>
+# include <unistd.h>
+#endif
+
+#include "XLink.h"
+#include "XLinkErrorUtils.h"
+#include "XLinkPrivateFields.h"
+
+#ifdef MVLOG_UNIT_NAME
+#undef MVLOG_UNIT_NAME
+#define MVLOG_UNIT_NAME xLink
+#endif
+
+#include "XLinkLog.h"
+
+// Number of bridges forwarding at the same time
+#define MAX_BRIDGES 32
+
+typedef struct {
+    int inUse;
+    // set by XLinkUnbridgeStreams, the bridge ends after the packet being forwarded
+    int stopping;
+    streamId_t src;
+    streamId_t dst;
+    XLinkBridgeOptions_t options;
+} bridgeDesc_t;
+
+static pthread_mutex_t bridgesMutex = PTHREAD_MUTEX_INITIALIZER;
+static bridgeDesc_t bridges[MAX_BRIDGES];
+
+// ------------------------------------
+// Helpers declaration. Begin.
+// ------------------------------------
+
+static void* bridgeRun(void* ctx);
+static bridgeDesc_t* reserveBridge(streamId_t src, streamId_t dst);
+static void freeBridge(bridgeDesc_t* bridge);
+static int isBridgeStopping(bridgeDesc_t* bridge);
+
+// ------------------------------------
+// Helpers declaration. End.
+// ------------------------------------
+
+
+
+// ------------------------------------
+// API implementation. Begin.
+// ------------------------------------
+
+XLinkError_t XLinkBridgeStreams(streamId_t const srcStreamId, streamId_t const dstStreamId,
+                                const XLinkBridgeOptions_t* options)
+{
+    XLINK_RET_ERR_IF(srcStreamId == INVALID_STREAM_ID, X_LINK_ERROR);
+    XLINK_RET_ERR_IF(dstStreamId == INVALID_STREAM_ID, X_LINK_ERROR);
+    XLINK_RET_ERR_IF(srcStreamId == dstStreamId, X_LINK_ERROR);
+
+    bridgeDesc_t* bridge = reserveBridge(srcStreamId, dstStreamId);
+    if(bridge == NULL) {
+        mvLog(MVLOG_ERROR, "Stream 0x%x is bridged already or too many bridges are running", srcStreamId);
+        return X_LINK_ERROR;
+    }
+    if(options != NULL) {
+        bridge->options = *options;
+    }
+
+    pthread_t thread;
+    int sc = pthread_create(&thread, NULL, bridgeRun, bridge);
+    if(sc) {
+        mvLog(MVLOG_ERROR, "Bridge thread creation failed with error: %d", sc);
+        freeBridge(bridge);
+        return X_LINK_ERROR;
+    }
+
+#ifndef __APPLE__
+    if(pthread_setname_np(thread, "XLinkBridgeThr") != 0) {
+        perror("Setting name for bridge thread failed");
+    }
+#endif
+
+    pthread_detach(thread);
+    return X_LINK_SUCCESS;
+}
+
+XLinkError_t XLinkUnbridgeStreams(streamId_t const srcStreamId)
+{
+    bridgeDesc_t* bridge = NULL;
+    pthread_mutex_lock(&bridgesMutex);
+    for(int i = 0; i < MAX_BRIDGES; i++) {
+        if(bridges[i].inUse && !bridges[i].stopping && bridges[i].src == srcStreamId) {
+            bridge = &bridges[i];
+            bridge->stopping = 1;
+            break;
+        }
+    }
+    pthread_mutex_unlock(&bridgesMutex);
+    if(bridge == NULL) {
+        mvLog(MVLOG_ERROR, "Stream 0x%x isn't bridged", srcStreamId);
+        return X_LINK_ERROR;
+    }
+
+    // the bridge may be about to block in a read of the source, which then misses the
+    // interruption, so it is repeated until the bridge ended
+    for(;;) {
+        pthread_mutex_lock(&bridgesMutex);
+        int running = bridge->inUse && bridge->stopping && bridge->src == srcStreamId;
+        pthread_mutex_unlock(&bridgesMutex);
+        if(!running) {
+            break;
+        }
+        // fails once the source is gone, which ends the bridge as well
+        interruptStreamReads(srcStreamId, 1);
+#if (defined(_WIN32) || defined(_WIN64))
+        Sleep(1);
+#else
+        usleep(1000);
+#endif
+    }
+    // the source is read by the application again
+    interruptStreamReads(srcStreamId, 0);
+    return X_LINK_SUCCESS;
+}
+
+// ------------------------------------
+// API implementation. End.
+// ------------------------------------
+
+
+
+// ------------------------------------
+// Helpers implementation. Begin.
+// ------------------------------------
+
+static void* bridgeRun(void* ctx)
+{
+    bridgeDesc_t* bridge = (bridgeDesc_t*)ctx;
+    streamPacketDesc_t* packet = NULL;
+
+    // the packet is held until the destination accepted it, so the source window only
+    // reopens as fast as the destination drains
+    int forwarding = 1;
+    while(!isBridgeStopping(bridge) && XLinkReadData(bridge->src, &packet) == X_LINK_SUCCESS) {
+        XLinkError_t rc = X_LINK_SUCCESS;
+        if(forwarding) {
+            rc = XLinkWriteData(bridge->dst, packet->data, (int)packet->length);
+        }
+        if(XLinkReleaseData(bridge->src) != X_LINK_SUCCESS) {
+            break;
+        }
+        if(rc != X_LINK_SUCCESS) {
+            // the source is still read, so its remote isn't stalled by a full window
+            mvLog(MVLOG_WARN, "Writing to stream 0x%x failed, dropping the packets of stream 0x%x",
+                  bridge->dst, bridge->src);
+            forwarding = 0;
+        }
+    }
+    mvLog(MVLOG_DEBUG, "Bridge from stream 0x%x to 0x%x ended", bridge->src, bridge->dst);
+
+    if(bridge->options.closeDestination) {
+        XLinkCloseStream(bridge->dst);
+    }
+    freeBridge(bridge);
+    return NULL;
+}
+
+static bridgeDesc_t* reserveBridge(streamId_t src, streamId_t dst)
+{
+    bridgeDesc_t* bridge = NULL;
+    pthread_mutex_lock(&bridgesMutex);
+    for(int i = 0; i < MAX_BRIDGES; i++) {
+        if(bridges[i].inUse && bridges[i].src == src) {
+            bridge = NULL;
+            break;
+        }
+        if(!bridges[i].inUse && bridge == NULL) {
+            bridge = &bridges[i];
+        }
+    }
+    if(bridge != NULL) {
+        bridge->inUse = 1;
+        bridge->stopping = 0;
+        bridge->src = src;
+        bridge->dst = dst;
+        bridge->options.closeDestination = 0;
+    }
+    pthread_mutex_unlock(&bridgesMutex);
+    return bridge;
+}
+
+static void freeBridge(bridgeDesc_t* bridge)
+{
+    pthread_mutex_lock(&bridgesMutex);
+    bridge->inUse = 0;
+    pthread_mutex_unlock(&bridgesMutex);
+}
+
+static int isBridgeStopping(bridgeDesc_t* bridge)
+{
+    pthread_mutex_lock(&bridgesMutex);
+    int stopping = bridge->stopping;
+    pthread_mutex_unlock(&bridgesMutex);
+    return stopping;
+}
+
+// ------------------------------------
+// Helpers implementation. End.
+// ------------------------------------
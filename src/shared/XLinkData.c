@@ -5,6 +5,7 @@
 #include "string.h"
 #include "stdlib.h"
 #include "time.h"
+#include <sys/stat.h>
 
 #if (defined(_WIN32) || defined(_WIN64))
 #include "win_time.h"
@@ -24,6 +25,13 @@
 
 #include "XLinkLog.h"
 #include "XLinkStringUtils.h"
+#include "XLinkTime.h"
+#include "XLinkTrace.h"
+
+// XLinkWriteFromFd keeps up to this many packets of a file in the write window of a stream
+#define FILE_WRITE_CHUNKS_IN_WINDOW 4
+// and sends packets of at most this size
+#define FILE_WRITE_MAX_CHUNK (8 * 1024 * 1024)
 
 // ------------------------------------
 // Helpers declaration. Begin.
@@ -33,11 +41,19 @@
 static XLinkError_t checkEventHeader(xLinkEventHeader_t header);
 #endif
 
-static float timespec_diff(struct timespec *start, struct timespec *stop);
 static XLinkError_t addEvent(xLinkEvent_t *event, unsigned int timeoutMs);
-static XLinkError_t addEventWithPerf(xLinkEvent_t *event, float* opTime, unsigned int timeoutMs);
-static XLinkError_t addEventWithPerfTimeout(xLinkEvent_t *event, float* opTime, unsigned int msTimeout);
+static XLinkError_t addEventWithPerf(xLinkEvent_t *event, uint64_t* opTimeNs, unsigned int timeoutMs);
+static XLinkError_t addEventWithPerfTimeout(xLinkEvent_t *event, uint64_t* opTimeNs, unsigned int msTimeout);
 static XLinkError_t getLinkByStreamId(streamId_t streamId, xLinkDesc_t** out_link);
+static void applyStreamOptions(xLinkDesc_t* link, streamDesc_t* stream,
+                               const XLinkStreamOptions_t* options);
+static XLinkError_t waitPacketReleasable(xLinkDesc_t* link, streamId_t streamId, const uint8_t* data);
+static int mayHaveProgressiveData(xLinkDesc_t* link, streamId_t streamId);
+
+static void recordRead(xLinkDesc_t* link, const xLinkEvent_t* event, uint32_t size, uint64_t opTimeNs);
+static void recordWrite(xLinkDesc_t* link, const xLinkEvent_t* event, uint32_t size, uint64_t opTimeNs);
+static void recordLatency(xLinkDesc_t* link, streamId_t streamId, xLinkLatency_t latency, uint64_t ns);
+static void recordStages(xLinkDesc_t* link, const xLinkEvent_t* event);
 
 // ------------------------------------
 // Helpers declaration. End.
@@ -101,6 +117,26 @@ streamId_t XLinkOpenStream(linkId_t id, const char* name, int stream_write_size)
     return streamId;
 }
 
+streamId_t XLinkOpenStreamWithOptions(linkId_t id, const char* name, int stream_write_size,
+                                      const XLinkStreamOptions_t* options)
+{
+    streamId_t streamId = XLinkOpenStream(id, name, stream_write_size);
+    if (streamId == INVALID_STREAM_ID || streamId == INVALID_STREAM_ID_OUT_OF_MEMORY
+        || options == NULL) {
+        return streamId;
+    }
+
+    xLinkDesc_t* link = getLinkById(id);
+    XLINK_RET_ERR_IF(link == NULL, INVALID_STREAM_ID);
+    streamDesc_t* stream = getStreamById(link->deviceHandle.xLinkFD, EXTRACT_STREAM_ID(streamId));
+    XLINK_RET_ERR_IF(stream == NULL, INVALID_STREAM_ID);
+
+    applyStreamOptions(link, stream, options);
+    releaseStream(stream);
+
+    return streamId;
+}
+
 // Just like open stream, when closeStream is called
 // on the local size we are resetting the writeSize
 // and on the remote side we are freeing the read buffer
@@ -115,6 +151,7 @@ XLinkError_t XLinkCloseStream(streamId_t const streamId)
         0, NULL, link->deviceHandle);
 
     XLINK_RET_IF(addEvent(&event, XLINK_NO_RW_TIMEOUT));
+    recordStages(link, &event);
     return X_LINK_SUCCESS;
 }
 
@@ -123,7 +160,7 @@ XLinkError_t XLinkWriteData(streamId_t const streamId, const uint8_t* buffer,
 {
     XLINK_RET_IF(buffer == NULL);
 
-    float opTime = 0.0f;
+    uint64_t opTimeNs = 0;
     xLinkDesc_t* link = NULL;
     XLINK_RET_IF(getLinkByStreamId(streamId, &link));
     streamId_t streamIdOnly = EXTRACT_STREAM_ID(streamId);
@@ -132,23 +169,106 @@ XLinkError_t XLinkWriteData(streamId_t const streamId, const uint8_t* buffer,
     XLINK_INIT_EVENT(event, streamIdOnly, XLINK_WRITE_REQ,
         size,(void*)buffer, link->deviceHandle);
 
-    XLINK_RET_IF(addEventWithPerf(&event, &opTime, XLINK_NO_RW_TIMEOUT));
+    XLINK_RET_IF(addEventWithPerf(&event, &opTimeNs, XLINK_NO_RW_TIMEOUT));
 
-    if (glHandler->profEnable) {
-        glHandler->profilingData.totalWriteBytes += size;
-        glHandler->profilingData.totalWriteTime += opTime;
+    recordWrite(link, &event, size, opTimeNs);
+
+    return X_LINK_SUCCESS;
+}
+
+XLinkError_t XLinkWriteFromFd(streamId_t const streamId, int fd, uint64_t offset, uint64_t length)
+{
+    XLINK_RET_IF(fd < 0);
+    // a file ending early would leave the remote waiting for data of a sent request
+    struct stat fileStat;
+    XLINK_RET_IF(fstat(fd, &fileStat) != 0);
+    XLINK_RET_IF(offset > (uint64_t)fileStat.st_size || length > (uint64_t)fileStat.st_size - offset);
+
+    xLinkDesc_t* link = NULL;
+    XLINK_RET_IF(getLinkByStreamId(streamId, &link));
+    streamId_t streamIdOnly = EXTRACT_STREAM_ID(streamId);
+
+    streamDesc_t* stream = getStreamById(link->deviceHandle.xLinkFD, streamIdOnly);
+    XLINK_RET_IF(stream == NULL);
+    uint32_t window = stream->writeSize;
+    releaseStream(stream);
+    XLINK_RET_ERR_IF(window == 0, X_LINK_ERROR);
+
+    // several packets fit the window, the remote reads one while the next is sent
+    uint32_t chunkSize = window / FILE_WRITE_CHUNKS_IN_WINDOW;
+    if (chunkSize == 0) {
+        chunkSize = window;
+    }
+    if (chunkSize > FILE_WRITE_MAX_CHUNK) {
+        chunkSize = FILE_WRITE_MAX_CHUNK;
+    }
+
+    while (length > 0) {
+        uint32_t size = length < chunkSize ? (uint32_t)length : chunkSize;
+        uint64_t opTimeNs = 0;
+        xLinkEvent_t event = {0};
+        XLINK_INIT_EVENT(event, streamIdOnly, XLINK_WRITE_REQ,
+            size, NULL, link->deviceHandle);
+        event.fromFile = 1;
+        event.fileFd = fd;
+        event.fileOffset = offset;
+
+        XLINK_RET_IF(addEventWithPerf(&event, &opTimeNs, XLINK_NO_RW_TIMEOUT));
+        recordWrite(link, &event, size, opTimeNs);
+
+        offset += size;
+        length -= size;
     }
-    link->profilingData.totalWriteBytes += size;
-    link->profilingData.totalWriteTime += size;
 
     return X_LINK_SUCCESS;
 }
 
+XLinkError_t XLinkStreamSinkToFd(streamId_t const streamId, int fd, const XLinkSinkOptions_t* options)
+{
+#if (defined(_WIN32) || defined(_WIN64))
+    (void)streamId;
+    (void)fd;
+    (void)options;
+    return X_LINK_NOT_IMPLEMENTED;
+#else
+    xLinkDesc_t* link = NULL;
+    XLINK_RET_IF(getLinkByStreamId(streamId, &link));
+    if (fd >= 0 && !(link->peerCapabilities & XLINK_CAPABILITY_RELEASE_CREDIT)) {
+        mvLog(MVLOG_WARN, "Remote doesn't support release credit, payloads can't bypass the readers");
+        return X_LINK_NOT_IMPLEMENTED;
+    }
+
+    streamId_t streamIdOnly = EXTRACT_STREAM_ID(streamId);
+    streamDesc_t* stream = getStreamById(link->deviceHandle.xLinkFD, streamIdOnly);
+    XLINK_RET_IF(stream == NULL);
+    const int previousFd = stream->sinkActive ? stream->sinkFd : -1;
+    stream->sinkActive = fd >= 0;
+    stream->sinkFd = fd;
+    stream->sinkFraming = options != NULL && options->framing;
+    releaseStream(stream);
+
+    // later payloads go to the new file, one may still be written to the previous one
+    pthread_mutex_lock(&progressiveDataMutex);
+    while (previousFd >= 0 && previousFd != fd && stream->id == streamIdOnly &&
+           stream->sinkWriting && stream->sinkWritingFd == previousFd) {
+        pthread_cond_wait(&progressiveDataCond, &progressiveDataMutex);
+    }
+    XLinkError_t rc = X_LINK_SUCCESS;
+    if (stream->id == streamIdOnly) {
+        rc = stream->sinkFailed ? X_LINK_ERROR : X_LINK_SUCCESS;
+        stream->sinkFailed = 0;
+    }
+    pthread_mutex_unlock(&progressiveDataMutex);
+
+    return rc;
+#endif
+}
+
 XLinkError_t XLinkReadData(streamId_t const streamId, streamPacketDesc_t** packet)
 {
     XLINK_RET_IF(packet == NULL);
 
-    float opTime = 0.0f;
+    uint64_t opTimeNs = 0;
     xLinkDesc_t* link = NULL;
     XLINK_RET_IF(getLinkByStreamId(streamId, &link));
     streamId_t streamIdOnly = EXTRACT_STREAM_ID(streamId);
@@ -157,19 +277,14 @@ XLinkError_t XLinkReadData(streamId_t const streamId, streamPacketDesc_t** packe
     XLINK_INIT_EVENT(event, streamIdOnly, XLINK_READ_REQ,
         0, NULL, link->deviceHandle);
 
-    XLINK_RET_IF(addEventWithPerf(&event, &opTime, XLINK_NO_RW_TIMEOUT));
+    XLINK_RET_IF(addEventWithPerf(&event, &opTimeNs, XLINK_NO_RW_TIMEOUT));
 
     *packet = (streamPacketDesc_t *)event.data;
     if(*packet == NULL) {
         return X_LINK_ERROR;
     }
 
-    if( glHandler->profEnable) {
-        glHandler->profilingData.totalReadBytes += (*packet)->length;
-        glHandler->profilingData.totalReadTime += opTime;
-    }
-    link->profilingData.totalReadBytes += (*packet)->length;
-    link->profilingData.totalReadTime += opTime;
+    recordRead(link, &event, (*packet)->length, opTimeNs);
 
 
     return X_LINK_SUCCESS;
@@ -180,7 +295,7 @@ XLinkError_t XLinkWriteDataWithTimeout(streamId_t const streamId, const uint8_t*
 {
     XLINK_RET_IF(buffer == NULL);
 
-    float opTime = 0.0f;
+    uint64_t opTimeNs = 0;
     xLinkDesc_t* link = NULL;
     XLINK_RET_IF(getLinkByStreamId(streamId, &link));
     streamId_t streamIdOnly = EXTRACT_STREAM_ID(streamId);
@@ -190,14 +305,9 @@ XLinkError_t XLinkWriteDataWithTimeout(streamId_t const streamId, const uint8_t*
         size,(void*)buffer, link->deviceHandle);
 
     mvLog(MVLOG_WARN,"XLinkWriteDataWithTimeout is not fully supported yet. The XLinkWriteData method is called instead. Desired timeout = %d\n", timeoutMs);
-    XLINK_RET_IF_FAIL(addEventWithPerf(&event, &opTime, timeoutMs));
+    XLINK_RET_IF_FAIL(addEventWithPerf(&event, &opTimeNs, timeoutMs));
 
-    if( glHandler->profEnable) {
-        glHandler->profilingData.totalWriteBytes += size;
-        glHandler->profilingData.totalWriteTime += opTime;
-    }
-    link->profilingData.totalWriteBytes += size;
-    link->profilingData.totalWriteTime += opTime;
+    recordWrite(link, &event, size, opTimeNs);
 
     return X_LINK_SUCCESS;
 }
@@ -206,7 +316,7 @@ XLinkError_t XLinkReadDataWithTimeout(streamId_t streamId, streamPacketDesc_t**
 {
     XLINK_RET_IF(packet == NULL);
 
-    float opTime = 0.0f;
+    uint64_t opTimeNs = 0;
     xLinkDesc_t* link = NULL;
     XLINK_RET_IF(getLinkByStreamId(streamId, &link));
     streamId_t streamIdOnly = EXTRACT_STREAM_ID(streamId);
@@ -215,19 +325,14 @@ XLinkError_t XLinkReadDataWithTimeout(streamId_t streamId, streamPacketDesc_t**
     XLINK_INIT_EVENT(event, streamId, XLINK_READ_REQ,
         0, NULL, link->deviceHandle);
 
-    XLINK_RET_IF_FAIL(addEventWithPerf(&event, &opTime, timeoutMs));
+    XLINK_RET_IF_FAIL(addEventWithPerf(&event, &opTimeNs, timeoutMs));
 
     *packet = (streamPacketDesc_t *)event.data;
     if(*packet == NULL) {
         return X_LINK_ERROR;
     }
 
-    if( glHandler->profEnable) {
-        glHandler->profilingData.totalReadBytes += (*packet)->length;
-        glHandler->profilingData.totalReadTime += opTime;
-    }
-    link->profilingData.totalReadBytes += (*packet)->length;
-    link->profilingData.totalReadTime += opTime;
+    recordRead(link, &event, (*packet)->length, opTimeNs);
 
     return X_LINK_SUCCESS;
 }
@@ -236,7 +341,7 @@ XLinkError_t XLinkReadMoveData(streamId_t const streamId, streamPacketDesc_t* co
 {
     XLINK_RET_IF(packet == NULL);
 
-    float opTime = 0;
+    uint64_t opTimeNs = 0;
     xLinkDesc_t *link = NULL;
     XLINK_RET_IF(getLinkByStreamId(streamId, &link));
     streamId_t streamIdOnly = EXTRACT_STREAM_ID(streamId);
@@ -245,7 +350,7 @@ XLinkError_t XLinkReadMoveData(streamId_t const streamId, streamPacketDesc_t* co
     XLINK_INIT_EVENT(event, streamIdOnly, XLINK_READ_REQ,
                      0, NULL, link->deviceHandle);
     event.header.flags.bitField.moveSemantic = 1;
-    XLINK_RET_IF(addEventWithPerf(&event, &opTime, XLINK_NO_RW_TIMEOUT));
+    XLINK_RET_IF(addEventWithPerf(&event, &opTimeNs, XLINK_NO_RW_TIMEOUT));
 
     if (!event.data)
     {
@@ -257,16 +362,17 @@ XLinkError_t XLinkReadMoveData(streamId_t const streamId, streamPacketDesc_t* co
     // done within this same XLink module so the same C runtime is used
     free(event.data);
 
-    if (glHandler->profEnable)
-    {
-        glHandler->profilingData.totalReadBytes += packet->length;
-        glHandler->profilingData.totalReadTime += opTime;
-    }
-    link->profilingData.totalReadBytes += packet->length;
-    link->profilingData.totalReadTime += opTime;
-
+    recordRead(link, &event, packet->length, opTimeNs);
 
-    const XLinkError_t retVal = XLinkReleaseData(streamId);
+    // the stream loses track of moved buffers, so their data has to be complete
+    XLinkError_t dataRc = X_LINK_SUCCESS;
+    if (mayHaveProgressiveData(link, streamIdOnly)) {
+        dataRc = XLinkWaitPacketData(streamId, packet, packet->length, NULL);
+    }
+    XLinkError_t retVal = XLinkReleaseData(streamId);
+    if (retVal == X_LINK_SUCCESS) {
+        retVal = dataRc;
+    }
     if (retVal != X_LINK_SUCCESS) {
         // severe error; deallocate here as the caller might forget to dealloc on errors; or be less able to manage
         XLinkPlatformDeallocateData(packet->data, ALIGN_UP_INT32((int32_t)packet->length, __CACHE_LINE_SIZE), __CACHE_LINE_SIZE);
@@ -280,7 +386,7 @@ XLinkError_t XLinkReadMoveDataWithTimeout(streamId_t const streamId, streamPacke
 {
     XLINK_RET_IF(packet == NULL);
 
-    float opTime = 0;
+    uint64_t opTimeNs = 0;
     xLinkDesc_t *link = NULL;
     XLINK_RET_IF(getLinkByStreamId(streamId, &link));
     streamId_t streamIdOnly = EXTRACT_STREAM_ID(streamId);
@@ -290,7 +396,7 @@ XLinkError_t XLinkReadMoveDataWithTimeout(streamId_t const streamId, streamPacke
                      0, NULL, link->deviceHandle);
     event.header.flags.bitField.moveSemantic = 1;
 
-    const XLinkError_t rc = addEventWithPerfTimeout(&event, &opTime, msTimeout);
+    const XLinkError_t rc = addEventWithPerfTimeout(&event, &opTimeNs, msTimeout);
     if(rc == X_LINK_TIMEOUT) return rc;
     else XLINK_RET_IF(rc);
 
@@ -304,15 +410,17 @@ XLinkError_t XLinkReadMoveDataWithTimeout(streamId_t const streamId, streamPacke
     // done within this same XLink module so the same C runtime is used
     free(event.data);
 
-    if (glHandler->profEnable)
-    {
-        glHandler->profilingData.totalReadBytes += packet->length;
-        glHandler->profilingData.totalReadTime += opTime;
-    }
-    link->profilingData.totalReadBytes += packet->length;
-    link->profilingData.totalReadTime += opTime;
+    recordRead(link, &event, packet->length, opTimeNs);
 
-    const XLinkError_t retVal = XLinkReleaseData(streamId);
+    // the stream loses track of moved buffers, so their data has to be complete
+    XLinkError_t dataRc = X_LINK_SUCCESS;
+    if (mayHaveProgressiveData(link, streamIdOnly)) {
+        dataRc = XLinkWaitPacketData(streamId, packet, packet->length, NULL);
+    }
+    XLinkError_t retVal = XLinkReleaseData(streamId);
+    if (retVal == X_LINK_SUCCESS) {
+        retVal = dataRc;
+    }
     if (retVal != X_LINK_SUCCESS) {
         // severe error; deallocate here as the caller might forget to dealloc on errors; or be less able to manage
         XLinkPlatformDeallocateData(packet->data, ALIGN_UP_INT32((int32_t)packet->length, __CACHE_LINE_SIZE), __CACHE_LINE_SIZE);
@@ -326,11 +434,31 @@ void XLinkDeallocateMoveData(void* const data, const uint32_t length) {
     XLinkPlatformDeallocateData(data, ALIGN_UP_INT32((int32_t)length, __CACHE_LINE_SIZE), __CACHE_LINE_SIZE);
 }
 
+void XLinkRecycleMoveData(streamId_t const streamId, void* const data, const uint32_t length)
+{
+    xLinkDesc_t* link = NULL;
+    streamDesc_t* stream = NULL;
+    if (getLinkByStreamId(streamId, &link) == X_LINK_SUCCESS) {
+        stream = getStreamById(link->deviceHandle.xLinkFD, EXTRACT_STREAM_ID(streamId));
+    }
+    if (stream == NULL) {
+        // the stream was closed meanwhile
+        XLinkDeallocateMoveData(data, length);
+        return;
+    }
+    XLinkStreamRecycleBuffer(stream, data, length);
+    releaseStream(stream);
+}
+
 XLinkError_t XLinkReleaseData(streamId_t const streamId)
 {
     xLinkDesc_t* link = NULL;
     XLINK_RET_IF(getLinkByStreamId(streamId, &link));
     streamId_t streamIdOnly = EXTRACT_STREAM_ID(streamId);
+    uint64_t start = getMonotonicTimestampNs();
+
+    // packet still being received must not be freed under the receiving thread
+    XLINK_RET_IF(waitPacketReleasable(link, streamIdOnly, NULL));
 
     xLinkEvent_t event = {0};
     XLINK_INIT_EVENT(event, streamIdOnly, XLINK_READ_REL_REQ,
@@ -338,6 +466,9 @@ XLinkError_t XLinkReleaseData(streamId_t const streamId)
 
     XLINK_RET_IF(addEvent(&event, XLINK_NO_RW_TIMEOUT));
 
+    recordLatency(link, streamIdOnly, XLINK_LATENCY_RELEASE, getMonotonicTimestampNs() - start);
+    recordStages(link, &event);
+
     return X_LINK_SUCCESS;
 }
 
@@ -346,6 +477,9 @@ XLinkError_t XLinkReleaseSpecificData(streamId_t streamId, streamPacketDesc_t* p
     xLinkDesc_t* link = NULL;
     XLINK_RET_IF(getLinkByStreamId(streamId, &link));
     streamId = EXTRACT_STREAM_ID(streamId);
+    uint64_t start = getMonotonicTimestampNs();
+
+    XLINK_RET_IF(waitPacketReleasable(link, streamId, packetDesc->data));
 
     xLinkEvent_t event = {0};
     XLINK_INIT_EVENT(event, streamId, XLINK_READ_REL_SPEC_REQ,
@@ -353,9 +487,130 @@ XLinkError_t XLinkReleaseSpecificData(streamId_t streamId, streamPacketDesc_t* p
 
     XLINK_RET_IF(addEvent(&event, XLINK_NO_RW_TIMEOUT));
 
+    recordLatency(link, streamId, XLINK_LATENCY_RELEASE, getMonotonicTimestampNs() - start);
+    recordStages(link, &event);
+
+    return X_LINK_SUCCESS;
+}
+
+XLinkError_t XLinkGetStreamProfilingData(streamId_t const streamId, XLinkStreamProf_t* prof)
+{
+    XLINK_RET_IF(prof == NULL);
+
+    xLinkDesc_t* link = NULL;
+    XLINK_RET_IF(getLinkByStreamId(streamId, &link));
+    streamId_t streamIdOnly = EXTRACT_STREAM_ID(streamId);
+
+    streamDesc_t* stream = getStreamById(link->deviceHandle.xLinkFD, streamIdOnly);
+    XLINK_RET_IF(stream == NULL);
+    XLinkLatencySummarize(stream->latency, prof);
+    releaseStream(stream);
+
     return X_LINK_SUCCESS;
 }
 
+XLinkError_t XLinkGetStreamDroppedPackets(streamId_t const streamId, uint64_t* dropped)
+{
+    XLINK_RET_IF(dropped == NULL);
+
+    xLinkDesc_t* link = NULL;
+    XLINK_RET_IF(getLinkByStreamId(streamId, &link));
+    streamId_t streamIdOnly = EXTRACT_STREAM_ID(streamId);
+
+    streamDesc_t* stream = getStreamById(link->deviceHandle.xLinkFD, streamIdOnly);
+    XLINK_RET_IF(stream == NULL);
+    *dropped = stream->droppedPackets;
+    releaseStream(stream);
+
+    return X_LINK_SUCCESS;
+}
+
+XLinkError_t XLinkGetPacketSequence(streamId_t const streamId, const streamPacketDesc_t* packet, uint32_t* sequence)
+{
+    XLINK_RET_IF(packet == NULL);
+    XLINK_RET_IF(sequence == NULL);
+
+    xLinkDesc_t* link = NULL;
+    XLINK_RET_IF(getLinkByStreamId(streamId, &link));
+    streamId_t streamIdOnly = EXTRACT_STREAM_ID(streamId);
+
+    streamDesc_t* stream = getStreamById(link->deviceHandle.xLinkFD, streamIdOnly);
+    XLINK_RET_IF(stream == NULL);
+    // read packets stay between the first one and the first unread one until released,
+    // shared reads hand out copies with the same data
+    XLinkError_t rc = X_LINK_ERROR;
+    uint32_t i = stream->firstPacket;
+    while (i != stream->firstPacketUnused) {
+        if (stream->packets[i].data == packet->data) {
+            *sequence = stream->packetSequences[i];
+            rc = X_LINK_SUCCESS;
+            break;
+        }
+        CIRCULAR_INCREMENT(i, XLINK_MAX_PACKETS_PER_STREAM);
+    }
+    releaseStream(stream);
+
+    return rc;
+}
+
+XLinkError_t XLinkGetStreamStageProfilingData(streamId_t const streamId, XLinkStageProf_t* prof)
+{
+    XLINK_RET_IF(prof == NULL);
+
+    xLinkDesc_t* link = NULL;
+    XLINK_RET_IF(getLinkByStreamId(streamId, &link));
+    streamId_t streamIdOnly = EXTRACT_STREAM_ID(streamId);
+
+    streamDesc_t* stream = getStreamById(link->deviceHandle.xLinkFD, streamIdOnly);
+    XLINK_RET_IF(stream == NULL);
+    XLinkStagesSummarize(stream->stages, prof);
+    releaseStream(stream);
+
+    return X_LINK_SUCCESS;
+}
+
+XLinkError_t XLinkWaitPacketData(streamId_t const streamId, const streamPacketDesc_t* packet,
+                                 uint32_t size, uint32_t* available)
+{
+    XLINK_RET_IF(packet == NULL);
+
+    xLinkDesc_t* link = NULL;
+    XLINK_RET_IF(getLinkByStreamId(streamId, &link));
+    streamId_t streamIdOnly = EXTRACT_STREAM_ID(streamId);
+
+    streamDesc_t* stream = getStreamById(link->deviceHandle.xLinkFD, streamIdOnly);
+    XLINK_RET_IF(stream == NULL);
+    releaseStream(stream);
+
+    if (size > packet->length) {
+        size = packet->length;
+    }
+
+    // only the packet currently being received can be incomplete
+    XLinkError_t rc = X_LINK_SUCCESS;
+    uint32_t arrived = packet->length;
+    pthread_mutex_lock(&progressiveDataMutex);
+    while (stream->progressiveData == packet->data && stream->progressiveSize < size) {
+        pthread_cond_wait(&progressiveDataCond, &progressiveDataMutex);
+    }
+    if (stream->id != streamIdOnly) {
+        // the link went down meanwhile, its packets are gone
+        arrived = 0;
+        rc = X_LINK_COMMUNICATION_FAIL;
+    } else if (stream->progressiveData == packet->data) {
+        arrived = stream->progressiveSize;
+    } else if (stream->progressiveFailedData == packet->data && packet->data != NULL) {
+        arrived = stream->progressiveFailedSize;
+        rc = X_LINK_COMMUNICATION_FAIL;
+    }
+    pthread_mutex_unlock(&progressiveDataMutex);
+
+    if (available) {
+        *available = arrived;
+    }
+    return rc;
+}
+
 XLinkError_t XLinkGetFillLevel(streamId_t const streamId, int isRemote, int* fillLevel)
 {
     xLinkDesc_t* link = NULL;
@@ -404,19 +659,6 @@ XLinkError_t checkEventHeader(xLinkEventHeader_t header) {
     }
 }
 
-float timespec_diff(struct timespec *start, struct timespec *stop)
-{
-    if ((stop->tv_nsec - start->tv_nsec) < 0) {
-        start->tv_sec = stop->tv_sec - start->tv_sec - 1;
-        start->tv_nsec = stop->tv_nsec - start->tv_nsec + 1000000000;
-    } else {
-        start->tv_sec = stop->tv_sec - start->tv_sec;
-        start->tv_nsec = stop->tv_nsec - start->tv_nsec;
-    }
-
-    return start->tv_nsec/ 1000000000.0f + start->tv_sec;
-}
-
 XLinkError_t addEvent(xLinkEvent_t *event, unsigned int timeoutMs)
 {
     ASSERT_XLINK(event);
@@ -459,6 +701,7 @@ XLinkError_t addEvent(xLinkEvent_t *event, unsigned int timeoutMs)
             return X_LINK_TIMEOUT;
         }
     }
+    event->stamps.wakeNs = getMonotonicTimestampNs();
 
     XLINK_RET_ERR_IF(
         event->header.flags.bitField.ack != 1,
@@ -467,17 +710,15 @@ XLinkError_t addEvent(xLinkEvent_t *event, unsigned int timeoutMs)
     return X_LINK_SUCCESS;
 }
 
-XLinkError_t addEventWithPerf(xLinkEvent_t *event, float* opTime, unsigned int timeoutMs)
+XLinkError_t addEventWithPerf(xLinkEvent_t *event, uint64_t* opTimeNs, unsigned int timeoutMs)
 {
-    ASSERT_XLINK(opTime);
+    ASSERT_XLINK(opTimeNs);
 
-    struct timespec start, end;
-    clock_gettime(CLOCK_REALTIME, &start);
+    uint64_t start = getMonotonicTimestampNs();
 
     XLINK_RET_IF_FAIL(addEvent(event, timeoutMs));
 
-    clock_gettime(CLOCK_REALTIME, &end);
-    *opTime = timespec_diff(&start, &end);
+    *opTimeNs = getMonotonicTimestampNs() - start;
 
     return X_LINK_SUCCESS;
 }
@@ -496,6 +737,7 @@ XLinkError_t addEventTimeout(xLinkEvent_t *event, struct timespec abstime)
     if (DispatcherWaitEventCompleteTimeout(&event->deviceHandle, abstime)) {
         return X_LINK_TIMEOUT;
     }
+    event->stamps.wakeNs = getMonotonicTimestampNs();
 
     XLINK_RET_ERR_IF(
         event->header.flags.bitField.ack != 1,
@@ -504,11 +746,12 @@ XLinkError_t addEventTimeout(xLinkEvent_t *event, struct timespec abstime)
     return X_LINK_SUCCESS;
 }
 
-XLinkError_t addEventWithPerfTimeout(xLinkEvent_t *event, float* opTime, unsigned int msTimeout)
+XLinkError_t addEventWithPerfTimeout(xLinkEvent_t *event, uint64_t* opTimeNs, unsigned int msTimeout)
 {
-    ASSERT_XLINK(opTime);
+    ASSERT_XLINK(opTimeNs);
 
-    struct timespec start, end;
+    uint64_t startNs = getMonotonicTimestampNs();
+    struct timespec start;
     clock_gettime(CLOCK_REALTIME, &start);
 
     struct timespec absTimeout = start;
@@ -522,8 +765,7 @@ XLinkError_t addEventWithPerfTimeout(xLinkEvent_t *event, float* opTime, unsigne
     int rc = addEventTimeout(event, absTimeout);
     if(rc != X_LINK_SUCCESS) return rc;
 
-    clock_gettime(CLOCK_REALTIME, &end);
-    *opTime = timespec_diff(&start, &end);
+    *opTimeNs = getMonotonicTimestampNs() - startNs;
 
     return X_LINK_SUCCESS;
 }
@@ -540,6 +782,167 @@ static XLinkError_t getLinkByStreamId(streamId_t streamId, xLinkDesc_t** out_lin
 
     return X_LINK_SUCCESS;
 }
+
+static void applyStreamOptions(xLinkDesc_t* link, streamDesc_t* stream,
+                               const XLinkStreamOptions_t* options)
+{
+    if (options->releaseBatchPackets) {
+        if (link->peerCapabilities & XLINK_CAPABILITY_RELEASE_CREDIT) {
+            stream->releaseBatchPackets = options->releaseBatchPackets;
+            stream->releaseBatchBytes = options->releaseBatchBytes;
+            stream->releaseBatchTimeoutUs = options->releaseBatchTimeoutUs;
+        } else {
+            mvLog(MVLOG_WARN, "Remote doesn't support release credit, batching of \"%s\" stream is ignored",
+                  stream->name);
+        }
+    }
+
+    if (options->postedWrites) {
+        if (link->peerCapabilities & XLINK_CAPABILITY_POSTED_WRITE) {
+            stream->postedWrites = 1;
+        } else {
+            mvLog(MVLOG_WARN, "Remote doesn't support posted writes, \"%s\" stream uses acknowledged writes",
+                  stream->name);
+        }
+    }
+
+    if (options->fragmentSize) {
+        if (link->peerCapabilities & XLINK_CAPABILITY_FRAGMENTS) {
+            stream->fragmentSize = options->fragmentSize < XLINK_MIN_FRAGMENT_SIZE ?
+                                   XLINK_MIN_FRAGMENT_SIZE : options->fragmentSize;
+            // fragments only bound the wait of other events if the transport doesn't queue far ahead
+            if (link->sendQueueLimit == 0 || stream->fragmentSize < link->sendQueueLimit) {
+                link->sendQueueLimit = stream->fragmentSize;
+                XLinkPlatformLimitSendQueue(&link->deviceHandle, link->sendQueueLimit);
+            }
+        } else {
+            mvLog(MVLOG_WARN, "Remote doesn't support fragments, writes of \"%s\" stream are sent in one piece",
+                  stream->name);
+        }
+    }
+
+    // the remote sends the data the same way, it's only handed out earlier on this side
+    stream->progressiveDelivery = options->progressiveDelivery != 0;
+    stream->sharedReads = options->sharedReads != 0;
+
+    if (options->keepLatestPackets) {
+        // dropped packets are credited without a release from this side
+        if (link->peerCapabilities & XLINK_CAPABILITY_RELEASE_CREDIT) {
+            stream->keepLatestPackets = options->keepLatestPackets;
+        } else {
+            mvLog(MVLOG_WARN, "Remote doesn't support release credit, \"%s\" stream keeps every packet",
+                  stream->name);
+        }
+    }
+
+    stream->recycleLimit = options->recycledBuffers;
+    if (stream->recycleLimit > XLINK_MAX_RECYCLED_BUFFERS) {
+        mvLog(MVLOG_WARN, "\"%s\" stream keeps at most %d recycled buffers", stream->name, XLINK_MAX_RECYCLED_BUFFERS);
+        stream->recycleLimit = XLINK_MAX_RECYCLED_BUFFERS;
+    }
+
+    // scheduling is local to each side of the link, so the remote needn't support it
+    stream->priority = options->priority;
+    if (stream->priority > X_LINK_PRIORITY_CONTROL) {
+        mvLog(MVLOG_WARN, "Unknown priority %u of \"%s\" stream, using X_LINK_PRIORITY_CONTROL",
+              options->priority, stream->name);
+        stream->priority = X_LINK_PRIORITY_CONTROL;
+    }
+}
+
+static XLinkError_t waitPacketReleasable(xLinkDesc_t* link, streamId_t streamId, const uint8_t* data)
+{
+    if (!mayHaveProgressiveData(link, streamId)) {
+        return X_LINK_SUCCESS;
+    }
+    streamDesc_t* stream = getStreamById(link->deviceHandle.xLinkFD, streamId);
+    XLINK_RET_IF(stream == NULL);
+    if (!stream->progressiveDelivery) {
+        releaseStream(stream);
+        return X_LINK_SUCCESS;
+    }
+    if (data == NULL && stream->blockedPackets) {
+        // XLinkReleaseData releases the oldest packet handed out
+        data = stream->packets[stream->firstPacket].data;
+    }
+    releaseStream(stream);
+
+    pthread_mutex_lock(&progressiveDataMutex);
+    while (data != NULL && stream->progressiveData == data) {
+        pthread_cond_wait(&progressiveDataCond, &progressiveDataMutex);
+    }
+    pthread_mutex_unlock(&progressiveDataMutex);
+
+    return X_LINK_SUCCESS;
+}
+
+// Doesn't take the stream, its options don't change while it can be read from. A stream
+// closed meanwhile is left to the callers to fail on
+static int mayHaveProgressiveData(xLinkDesc_t* link, streamId_t streamId)
+{
+    streamDesc_t* stream = peekStreamById(link, streamId);
+    return stream == NULL || stream->progressiveDelivery;
+}
+
+static void recordRead(xLinkDesc_t* link, const xLinkEvent_t* event, uint32_t size, uint64_t opTimeNs)
+{
+    if (glHandler->profEnable) {
+        XLinkProfAccumulatorAddRead(&globalProfilingData, size, opTimeNs);
+    }
+    XLinkProfAccumulatorAddRead(&link->profilingData, size, opTimeNs);
+
+    recordLatency(link, event->header.streamId, XLINK_LATENCY_READ_WAIT, opTimeNs);
+    recordStages(link, event);
+}
+
+static void recordWrite(xLinkDesc_t* link, const xLinkEvent_t* event, uint32_t size, uint64_t opTimeNs)
+{
+    if (glHandler->profEnable) {
+        XLinkProfAccumulatorAddWrite(&globalProfilingData, size, opTimeNs);
+    }
+    XLinkProfAccumulatorAddWrite(&link->profilingData, size, opTimeNs);
+
+    recordLatency(link, event->header.streamId, XLINK_LATENCY_WRITE, opTimeNs);
+    recordStages(link, event);
+}
+
+static void recordLatency(xLinkDesc_t* link, streamId_t streamId, xLinkLatency_t latency, uint64_t ns)
+{
+    XLinkHistogramRecord(&link->latency->histograms[latency], ns);
+    streamDesc_t* stream = peekStreamById(link, streamId);
+    if (stream && stream->latency) {
+        XLinkHistogramRecord(&stream->latency->histograms[latency], ns);
+    }
+}
+
+static void recordStages(xLinkDesc_t* link, const xLinkEvent_t* event)
+{
+    XLinkEventKind_t kind;
+    switch (event->header.type) {
+        case XLINK_WRITE_REQ:
+            kind = X_LINK_EVENT_WRITE;
+            break;
+        case XLINK_READ_REQ:
+            kind = X_LINK_EVENT_READ;
+            break;
+        case XLINK_READ_REL_REQ:
+        case XLINK_READ_REL_SPEC_REQ:
+            kind = X_LINK_EVENT_RELEASE;
+            break;
+        default:
+            kind = X_LINK_EVENT_CONTROL;
+            break;
+    }
+    XLinkStagesRecord(&link->stages[kind], &event->stamps);
+    streamDesc_t* stream = peekStreamById(link, event->header.streamId);
+    if (stream && stream->stages) {
+        XLinkStagesRecord(stream->stages, &event->stamps);
+    }
+
+    XLinkTraceRecord(XLINK_TRACE_CALL, link->id, event->header.type, event->header.streamId,
+                     event->header.size, event->stamps.enqueueNs, event->stamps.wakeNs);
+}
+
 // ------------------------------------
 // Helpers declaration. End.
 // ------------------------------------
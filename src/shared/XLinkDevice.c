@@ -14,6 +14,8 @@
 #include "XLinkPlatform.h"
 #include "XLinkPrivateFields.h"
 #include "XLinkDispatcherImpl.h"
+#include "XLinkLockProf.h"
+#include "XLinkTrace.h"
 
 #ifdef MVLOG_UNIT_NAME
 #undef MVLOG_UNIT_NAME
@@ -35,11 +37,15 @@
 XLinkGlobalHandler_t* glHandler; //TODO need to either protect this with semaphor
                                  //or make profiling data per device
 
+xLinkProfAccumulator_t globalProfilingData;
+
 xLinkDesc_t availableXLinks[MAX_LINKS];
 pthread_mutex_t availableXLinksMutex = PTHREAD_MUTEX_INITIALIZER;
 sem_t  pingSem; //to b used by myriad
 DispatcherControlFunctions controlFunctionTbl;
 linkId_t nextUniqueLinkId = 0; //incremental number, doesn't get decremented.
+pthread_mutex_t progressiveDataMutex = PTHREAD_MUTEX_INITIALIZER;
+pthread_cond_t progressiveDataCond = PTHREAD_COND_INITIALIZER;
 
 // ------------------------------------
 // Global fields. End.
@@ -56,6 +62,7 @@ static uint32_t init_once = 0;
 static linkId_t getNextAvailableLinkUniqueId();
 static xLinkDesc_t* getNextAvailableLink();
 static void freeGivenLink(xLinkDesc_t* link);
+static void printStages(linkId_t id);
 
 #ifndef __DEVICE__
 
@@ -106,6 +113,7 @@ XLinkError_t XLinkInitialize(XLinkGlobalHandler_t* globalHandler)
     //Using deprecated fields. End.
 
     memset((void*)globalHandler, 0, sizeof(XLinkGlobalHandler_t));
+    XLinkProfAccumulatorReset(&globalProfilingData);
 
     //Using deprecated fields. Begin.
     globalHandler->loglevel = loglevel;
@@ -118,6 +126,9 @@ XLinkError_t XLinkInitialize(XLinkGlobalHandler_t* globalHandler)
     controlFunctionTbl.remoteGetResponse = &dispatcherRemoteEventGetResponse;
     controlFunctionTbl.closeLink         = &dispatcherCloseLink;
     controlFunctionTbl.closeDeviceFd     = &dispatcherCloseDeviceFd;
+    controlFunctionTbl.flushDeferred     = &dispatcherFlushDeferred;
+    controlFunctionTbl.eventPriority     = &dispatcherEventPriority;
+    controlFunctionTbl.eventStages       = &dispatcherEventStages;
 
     if (DispatcherInitialize(&controlFunctionTbl)) {
         mvLog(MVLOG_ERROR, "Condition failed: DispatcherInitialize(&controlFunctionTbl)");
@@ -254,6 +265,11 @@ XLinkError_t XLinkConnect(XLinkHandler_t* handler)
         return parsePlatformError(connectStatus);
     }
 
+    // filled in from the ping response
+    link->peerCapabilities = 0;
+    link->pendingCreditStreams = 0;
+    link->deviceRole = 0;
+
     XLINK_RET_ERR_IF(
         DispatcherStart(&link->deviceHandle) != X_LINK_SUCCESS, X_LINK_TIMEOUT);
 
@@ -282,6 +298,89 @@ XLinkError_t XLinkConnect(XLinkHandler_t* handler)
     return X_LINK_SUCCESS;
 }
 
+//Called only from app - per peer
+XLinkError_t XLinkServer(XLinkHandler_t* handler)
+{
+    XLINK_RET_IF(handler == NULL);
+    XLINK_RET_IF(handler->devicePath == NULL);
+
+    xLinkDesc_t* link = getNextAvailableLink();
+    XLINK_RET_IF(link == NULL);
+    mvLog(MVLOG_DEBUG,"%s() endpoint %s protocol %d\n", __func__, handler->devicePath, handler->protocol);
+
+    link->deviceHandle.protocol = handler->protocol;
+    int serverStatus = XLinkPlatformServer(handler->devicePath2, handler->devicePath,
+                                           link->deviceHandle.protocol, &link->deviceHandle.xLinkFD);
+
+    if (serverStatus < 0) {
+        freeGivenLink(link);
+        return parsePlatformError(serverStatus);
+    }
+
+    // filled in from the ping of the host
+    link->peerCapabilities = 0;
+    link->pendingCreditStreams = 0;
+    link->deviceRole = 1;
+
+    if (DispatcherStart(&link->deviceHandle) != X_LINK_SUCCESS) {
+        XLinkPlatformCloseRemote(&link->deviceHandle);
+        freeGivenLink(link);
+        return X_LINK_TIMEOUT;
+    }
+
+    // the host pings right after it connected
+    struct timespec absTimeout;
+    clock_gettime(CLOCK_REALTIME, &absTimeout);
+    absTimeout.tv_sec += XLINK_SERVER_PING_TIMEOUT_SEC;
+    if (XLink_sem_timedwait(&link->pingSem, &absTimeout)) {
+        mvLog(MVLOG_ERROR, "Peer connected to %s didn't ping the link", handler->devicePath);
+        // the dispatcher frees the link once the device link is closed
+        DispatcherDeviceFdDown(&link->deviceHandle);
+        while(((XLink_sem_wait(&link->dispatcherClosedSem) == -1) && errno == EINTR))
+            continue;
+        return X_LINK_TIMEOUT;
+    }
+
+    link->peerState = XLINK_UP;
+    link->usbConnSpeed = X_LINK_USB_SPEED_UNKNOWN;
+    mv_strcpy(link->mxSerialId, XLINK_MAX_MX_ID_SIZE, "UNKNOWN");
+
+    link->hostClosedFD = 0;
+    handler->linkId = link->id;
+    return X_LINK_SUCCESS;
+}
+
+XLinkError_t XLinkServerAnnounce(const deviceDesc_t* deviceDesc)
+{
+    XLINK_RET_IF(deviceDesc == NULL);
+    return parsePlatformError(XLinkPlatformServerAnnounce(deviceDesc));
+}
+
+XLinkError_t XLinkServerAnnounceStop(XLinkProtocol_t protocol)
+{
+    return parsePlatformError(XLinkPlatformServerAnnounceStop(protocol));
+}
+
+XLinkError_t XLinkSetTcpBackend(XLinkTcpBackend_t backend)
+{
+    xLinkPlatformErrorCode_t rc = XLinkPlatformSetTcpBackend(backend);
+    if (rc == X_LINK_PLATFORM_TCP_IP_DRIVER_NOT_LOADED) {
+        mvLog(MVLOG_WARN, "io_uring isn't available, TCP/IP links keep using sockets");
+        return X_LINK_NOT_IMPLEMENTED;
+    }
+    return parsePlatformError(rc);
+}
+
+XLinkError_t XLinkSetTcpZeroCopyThreshold(uint32_t bytes)
+{
+    xLinkPlatformErrorCode_t rc = XLinkPlatformSetTcpZeroCopyThreshold(bytes);
+    if (rc == X_LINK_PLATFORM_TCP_IP_DRIVER_NOT_LOADED) {
+        mvLog(MVLOG_WARN, "MSG_ZEROCOPY isn't available, TCP/IP writes keep being copied");
+        return X_LINK_NOT_IMPLEMENTED;
+    }
+    return parsePlatformError(rc);
+}
+
 
 //Called only from app - per device
 XLinkError_t XLinkBootBootloader(const deviceDesc_t* deviceDesc)
@@ -434,13 +533,10 @@ XLinkError_t XLinkResetAll()
 XLinkError_t XLinkProfStart()
 {
     XLINK_RET_IF(glHandler == NULL);
+    XLinkProfAccumulatorReset(&globalProfilingData);
+    memset(&glHandler->profilingData, 0, sizeof(glHandler->profilingData));
     glHandler->profEnable = 1;
-    glHandler->profilingData.totalReadBytes = 0;
-    glHandler->profilingData.totalWriteBytes = 0;
-    glHandler->profilingData.totalWriteTime = 0;
-    glHandler->profilingData.totalReadTime = 0;
-    glHandler->profilingData.totalBootCount = 0;
-    glHandler->profilingData.totalBootTime = 0;
+    XLinkLockProfEnable(1);
 
     return X_LINK_SUCCESS;
 }
@@ -449,26 +545,31 @@ XLinkError_t XLinkProfStop()
 {
     XLINK_RET_IF(glHandler == NULL);
     glHandler->profEnable = 0;
-    return X_LINK_SUCCESS;
+    XLinkLockProfEnable(0);
+
+    // for those reading the handler directly
+    return XLinkGetGlobalProfilingData(&glHandler->profilingData);
 }
 
 XLinkError_t XLinkProfPrint()
 {
     XLINK_RET_IF(glHandler == NULL);
+    XLinkProfCounters_t counters;
+    XLinkProfAccumulatorSnapshot(&globalProfilingData, &counters);
     printf("XLink profiling results:\n");
-    if (glHandler->profilingData.totalWriteTime)
+    if (counters.totalWriteNs)
     {
         printf("Average write speed: %f MB/Sec\n",
-               glHandler->profilingData.totalWriteBytes /
-               glHandler->profilingData.totalWriteTime /
+               counters.totalWriteBytes * 1000000000.0 /
+               counters.totalWriteNs /
                1024.0 /
                1024.0 );
     }
-    if (glHandler->profilingData.totalReadTime)
+    if (counters.totalReadNs)
     {
         printf("Average read speed: %f MB/Sec\n",
-               glHandler->profilingData.totalReadBytes /
-               glHandler->profilingData.totalReadTime /
+               counters.totalReadBytes * 1000000000.0 /
+               counters.totalReadNs /
                1024.0 /
                1024.0);
     }
@@ -478,6 +579,13 @@ XLinkError_t XLinkProfPrint()
                glHandler->profilingData.totalBootTime /
                glHandler->profilingData.totalBootCount);
     }
+
+    for (int i = 0; i < MAX_LINKS; i++) {
+        linkId_t id = availableXLinks[i].id;
+        if (id != INVALID_LINK_ID) {
+            printStages(id);
+        }
+    }
     return X_LINK_SUCCESS;
 }
 
@@ -485,8 +593,21 @@ XLinkError_t XLinkGetGlobalProfilingData(XLinkProf_t* prof)
 {
     XLINK_RET_IF(prof == NULL);
     XLINK_RET_IF(glHandler == NULL);
-    // TODO(themarpe) - thread safe readout
-    *prof = glHandler->profilingData;
+
+    XLinkProfCounters_t counters;
+    XLinkProfAccumulatorSnapshot(&globalProfilingData, &counters);
+    prof->totalBootCount = glHandler->profilingData.totalBootCount;
+    prof->totalBootTime = glHandler->profilingData.totalBootTime;
+    XLinkProfCountersToProf(&counters, prof);
+    return X_LINK_SUCCESS;
+}
+
+XLinkError_t XLinkGetGlobalProfilingCounters(XLinkProfCounters_t* counters)
+{
+    XLINK_RET_IF(counters == NULL);
+    XLINK_RET_IF(glHandler == NULL);
+
+    XLinkProfAccumulatorSnapshot(&globalProfilingData, counters);
     return X_LINK_SUCCESS;
 }
 
@@ -496,8 +617,79 @@ XLinkError_t XLinkGetProfilingData(linkId_t id, XLinkProf_t* prof)
     xLinkDesc_t* link = getLinkById(id);
     XLINK_RET_IF(link == NULL);
 
-    // TODO(themarpe) - thread safe readout
-    *prof = link->profilingData;
+    XLinkProfCounters_t counters;
+    XLinkProfAccumulatorSnapshot(&link->profilingData, &counters);
+    memset(prof, 0, sizeof(*prof));
+    XLinkProfCountersToProf(&counters, prof);
+    return X_LINK_SUCCESS;
+}
+
+XLinkError_t XLinkGetProfilingCounters(linkId_t id, XLinkProfCounters_t* counters)
+{
+    XLINK_RET_IF(counters == NULL);
+    xLinkDesc_t* link = getLinkById(id);
+    XLINK_RET_IF(link == NULL);
+
+    XLinkProfAccumulatorSnapshot(&link->profilingData, counters);
+    return X_LINK_SUCCESS;
+}
+
+XLinkError_t XLinkGetLinkLatencyProfilingData(linkId_t id, XLinkStreamProf_t* prof)
+{
+    XLINK_RET_IF(prof == NULL);
+    xLinkDesc_t* link = getLinkById(id);
+    XLINK_RET_IF(link == NULL);
+
+    XLinkLatencySummarize(link->latency, prof);
+    return X_LINK_SUCCESS;
+}
+
+XLinkError_t XLinkGetStageProfilingData(linkId_t id, XLinkEventKind_t kind, XLinkStageProf_t* prof)
+{
+    XLINK_RET_IF(prof == NULL);
+    XLINK_RET_IF(kind < 0 || kind >= X_LINK_EVENT_COUNT);
+    xLinkDesc_t* link = getLinkById(id);
+    XLINK_RET_IF(link == NULL);
+
+    XLinkStagesSummarize(&link->stages[kind], prof);
+    return X_LINK_SUCCESS;
+}
+
+XLinkError_t XLinkGetLockProfilingData(XLinkLock_t lock, XLinkLockProf_t* prof)
+{
+    XLINK_RET_IF(prof == NULL);
+    XLINK_RET_IF(lock < 0 || lock >= X_LINK_LOCK_COUNT);
+
+    XLinkLockProfGet(lock, prof);
+    return X_LINK_SUCCESS;
+}
+
+XLinkError_t XLinkTraceStart(uint32_t capacity)
+{
+    XLinkTraceRingStart(capacity);
+    return X_LINK_SUCCESS;
+}
+
+XLinkError_t XLinkTraceStop(void)
+{
+    XLinkTraceRingStop();
+    return X_LINK_SUCCESS;
+}
+
+XLinkError_t XLinkTraceDump(const char* path)
+{
+    XLINK_RET_IF(path == NULL);
+
+    FILE* file = fopen(path, "w");
+    if (file == NULL) {
+        mvLog(MVLOG_ERROR, "Can't open %s for the trace", path);
+        return X_LINK_ERROR;
+    }
+    int rc = XLinkTraceRingDump(file);
+    if (fclose(file) || rc) {
+        mvLog(MVLOG_ERROR, "Writing the trace to %s failed", path);
+        return X_LINK_ERROR;
+    }
     return X_LINK_SUCCESS;
 }
 
@@ -555,7 +747,7 @@ static linkId_t getNextAvailableLinkUniqueId()
 
 static xLinkDesc_t* getNextAvailableLink() {
 
-    XLINK_RET_ERR_IF(pthread_mutex_lock(&availableXLinksMutex) != 0, NULL);
+    XLINK_RET_ERR_IF(XLinkProfMutexLock(&availableXLinksMutex, X_LINK_LOCK_LINKS) != 0, NULL);
 
     linkId_t id = getNextAvailableLinkUniqueId();
     if(id == INVALID_LINK_ID){
@@ -565,7 +757,8 @@ static xLinkDesc_t* getNextAvailableLink() {
 
     int i;
     for (i = 0; i < MAX_LINKS; i++) {
-        if (availableXLinks[i].id == INVALID_LINK_ID) {
+        // the dispatcher of a closed link may still use its slot
+        if (availableXLinks[i].id == INVALID_LINK_ID && !availableXLinks[i].dispatcherRunning) {
             break;
         }
     }
@@ -583,8 +776,31 @@ static xLinkDesc_t* getNextAvailableLink() {
         XLINK_RET_ERR_IF(pthread_mutex_unlock(&availableXLinksMutex) != 0, NULL);
         return NULL;
     }
+    if (XLink_sem_init(&link->pingSem, 0 ,0)) {
+        mvLog(MVLOG_ERROR, "Cannot initialize semaphore\n");
+        XLink_sem_destroy(&link->dispatcherClosedSem);
+        XLINK_RET_ERR_IF(pthread_mutex_unlock(&availableXLinksMutex) != 0, NULL);
+        return NULL;
+    }
+
+    if (link->latency == NULL) {
+        link->latency = calloc(1, sizeof(*link->latency));
+    }
+    if (link->stages == NULL) {
+        link->stages = calloc(X_LINK_EVENT_COUNT, sizeof(*link->stages));
+    }
+    if (link->latency == NULL || link->stages == NULL) {
+        mvLog(MVLOG_ERROR, "Cannot allocate the histograms of the link\n");
+        XLink_sem_destroy(&link->dispatcherClosedSem);
+        XLink_sem_destroy(&link->pingSem);
+        XLINK_RET_ERR_IF(pthread_mutex_unlock(&availableXLinksMutex) != 0, NULL);
+        return NULL;
+    }
 
     link->id = id;
+    XLinkProfAccumulatorReset(&link->profilingData);
+    memset(link->latency, 0, sizeof(*link->latency));
+    memset(link->stages, 0, X_LINK_EVENT_COUNT * sizeof(*link->stages));
     XLINK_RET_ERR_IF(pthread_mutex_unlock(&availableXLinksMutex) != 0, NULL);
 
     return link;
@@ -592,7 +808,7 @@ static xLinkDesc_t* getNextAvailableLink() {
 
 static void freeGivenLink(xLinkDesc_t* link) {
 
-    if(pthread_mutex_lock(&availableXLinksMutex) != 0){
+    if(XLinkProfMutexLock(&availableXLinksMutex, X_LINK_LOCK_LINKS) != 0){
         mvLog(MVLOG_ERROR, "Cannot lock mutex\n");
         return;
     }
@@ -601,11 +817,38 @@ static void freeGivenLink(xLinkDesc_t* link) {
     if (XLink_sem_destroy(&link->dispatcherClosedSem)) {
         mvLog(MVLOG_ERROR, "Cannot destroy semaphore\n");
     }
+    if (XLink_sem_destroy(&link->pingSem)) {
+        mvLog(MVLOG_ERROR, "Cannot destroy semaphore\n");
+    }
 
     pthread_mutex_unlock(&availableXLinksMutex);
 
 }
 
+static void printStages(linkId_t id)
+{
+    static const char* kinds[X_LINK_EVENT_COUNT] = {"write", "read", "release", "control", "remote"};
+
+    printf("Link %d event stages, p50 / p99 us:\n", (int)id);
+    printf("%10s %10s %17s %17s %17s %17s %17s\n", "event", "count",
+           "queue", "blocked", "transport", "response", "wakeup");
+    for (int kind = 0; kind < X_LINK_EVENT_COUNT; kind++) {
+        XLinkStageProf_t prof;
+        if (XLinkGetStageProfilingData(id, (XLinkEventKind_t)kind, &prof) != X_LINK_SUCCESS) {
+            return;
+        }
+        // every event passes the queue
+        if (prof.stages[X_LINK_STAGE_QUEUE].count == 0) {
+            continue;
+        }
+        printf("%10s %10llu", kinds[kind], (unsigned long long)prof.stages[X_LINK_STAGE_QUEUE].count);
+        for (int stage = 0; stage < X_LINK_STAGE_COUNT; stage++) {
+            printf(" %8.1f/%-8.1f", prof.stages[stage].p50Ns / 1000.0, prof.stages[stage].p99Ns / 1000.0);
+        }
+        printf("\n");
+    }
+}
+
 #ifndef __DEVICE__
 
 static XLinkError_t parsePlatformError(xLinkPlatformErrorCode_t rc) {
@@ -675,6 +918,7 @@ const char* XLinkProtocolToStr(XLinkProtocol_t val) {
         case X_LINK_TCP_IP: return "X_LINK_TCP_IP";
         case X_LINK_NMB_OF_PROTOCOLS: return "X_LINK_NMB_OF_PROTOCOLS";
         case X_LINK_ANY_PROTOCOL: return "X_LINK_ANY_PROTOCOL";
+        case X_LINK_LOOPBACK: return "X_LINK_LOOPBACK";
         default:
             return "INVALID_ENUM_VALUE";
             break;
@@ -23,6 +23,7 @@
 #if (defined(_WIN32) || defined(_WIN64))
 # include "win_pthread.h"
 # include "win_semaphore.h"
+# include "win_time.h"
 #else
 # include <pthread.h>
 # include <unistd.h>
@@ -37,6 +38,9 @@
 #include "XLinkPrivateFields.h"
 #include "XLink.h"
 #include "XLinkErrorUtils.h"
+#include "XLinkLockProf.h"
+#include "XLinkTime.h"
+#include "XLinkTrace.h"
 
 #define MVLOG_UNIT_NAME xLink
 #include "XLinkLog.h"
@@ -60,6 +64,14 @@ typedef struct xLinkEventPriv_t {
     xLinkEventOrigin_t origin;
     XLink_sem_t* sem;
     void* data;
+    // scheduling class given by eventPriority and number of times the event
+    // was passed over in favour of another one, see effectivePriority
+    uint32_t priority;
+    uint32_t skipped;
+    // order of the events within a class
+    uint32_t seq;
+    // eventSend has sent only a part of the event, the rest is to follow
+    uint32_t partiallySent;
 } xLinkEventPriv_t;
 
 typedef struct {
@@ -71,7 +83,6 @@ typedef struct{
     xLinkEventPriv_t* end;
     xLinkEventPriv_t* base;
 
-    xLinkEventPriv_t* curProc;
     xLinkEventPriv_t* cur;
     XLINK_ALIGN_TO_BOUNDARY(64) xLinkEventPriv_t q[MAX_EVENTS];
 
@@ -84,6 +95,7 @@ typedef struct {
     int schedulerId;
 
     int queueProcPriority;
+    uint32_t nextEventSeq;
 
     pthread_mutex_t queueMutex;
 
@@ -99,6 +111,13 @@ typedef struct {
 
     uint32_t dispatcherLinkDown;
     uint32_t dispatcherDeviceFdDown;
+
+    // of the events traced, see XLinkTraceStart
+    linkId_t linkId;
+
+    // The scheduler and link slots stay taken until the thread stopped
+    xLinkDesc_t* link;
+    uint32_t threadRunning;
 } xLinkSchedulerState_t;
 
 
@@ -147,6 +166,7 @@ static void* eventSchedulerRun(void* ctx);
 #endif
 
 static int isEventTypeRequest(xLinkEventPriv_t* event);
+static xLinkEventType_t getRequestType(xLinkEventType_t responseType);
 static void postAndMarkEventServed(xLinkEventPriv_t *event);
 static int createUniqueID();
 static int findAvailableScheduler();
@@ -160,19 +180,28 @@ static inline xLinkEventPriv_t* getNextElementWithState(xLinkEventPriv_t* base,
 
 static xLinkEventPriv_t* searchForReadyEvent(xLinkSchedulerState_t* curr);
 
+static uint32_t effectivePriority(xLinkEventPriv_t* event);
+static int isQueueElemPreferred(xLinkEventPriv_t* event, xLinkEventPriv_t* other);
 static xLinkEventPriv_t* getNextQueueElemToProc(eventQueueHandler_t *q );
+static void ageQueueElems(eventQueueHandler_t *q, xLinkEventPriv_t* chosen);
 static xLinkEvent_t* addNextQueueElemToProc(xLinkSchedulerState_t* curr,
                                             eventQueueHandler_t *q, xLinkEvent_t* event,
-                                            XLink_sem_t* sem, xLinkEventOrigin_t o);
+                                            XLink_sem_t* sem, xLinkEventOrigin_t o,
+                                            uint32_t priority);
 
-static xLinkEventPriv_t* dispatcherGetNextEvent(xLinkSchedulerState_t* curr);
+static int dispatcherWaitNotification(xLinkSchedulerState_t* curr);
+static xLinkEventPriv_t* dispatcherGetNextEvent(xLinkSchedulerState_t* curr, int flushDeferred);
 
 static int dispatcherClean(xLinkSchedulerState_t* curr);
 static int dispatcherReset(xLinkSchedulerState_t* curr);
 static int dispatcherDeviceFdDown(xLinkSchedulerState_t* curr);
 
 static void dispatcherFreeEvents(eventQueueHandler_t *queue, xLinkEventState_t state);
+static void traceEvent(xLinkSchedulerState_t* curr, xLinkTracePhase_t phase,
+                       const xLinkEvent_t* event, uint64_t startNs);
 
+static XLinkError_t dispatcherSendEvent(xLinkSchedulerState_t* curr, xLinkEventPriv_t* event,
+                                        xLinkEvent_t* toSend);
 static XLinkError_t sendEvents(xLinkSchedulerState_t* curr);
 
 // ------------------------------------
@@ -241,14 +270,15 @@ XLinkError_t DispatcherStart(xLinkDeviceHandle_t *deviceHandle)
 
     schedulerState[idx].deviceHandle = *deviceHandle;
     schedulerState[idx].schedulerId = idx;
+    xLinkDesc_t* link = getLink(deviceHandle->xLinkFD);
+    schedulerState[idx].linkId = link ? link->id : INVALID_LINK_ID;
+    schedulerState[idx].link = link;
 
     schedulerState[idx].lQueue.cur = schedulerState[idx].lQueue.q;
-    schedulerState[idx].lQueue.curProc = schedulerState[idx].lQueue.q;
     schedulerState[idx].lQueue.base = schedulerState[idx].lQueue.q;
     schedulerState[idx].lQueue.end = &schedulerState[idx].lQueue.q[MAX_EVENTS];
 
     schedulerState[idx].rQueue.cur = schedulerState[idx].rQueue.q;
-    schedulerState[idx].rQueue.curProc = schedulerState[idx].rQueue.q;
     schedulerState[idx].rQueue.base = schedulerState[idx].rQueue.q;
     schedulerState[idx].rQueue.end = &schedulerState[idx].rQueue.q[MAX_EVENTS];
 
@@ -305,12 +335,20 @@ XLinkError_t DispatcherStart(xLinkDeviceHandle_t *deviceHandle)
     while(((sem_wait(&addSchedulerSem) == -1) && errno == EINTR))
         continue;
     mvLog(MVLOG_DEBUG,"%s() starting a new thread - schedulerId %d \n", __func__, idx);
+    schedulerState[idx].threadRunning = 1;
+    if (link) {
+        link->dispatcherRunning = 1;
+    }
     int sc = pthread_create(&schedulerState[idx].xLinkThreadId,
                             &attr,
                             eventSchedulerRun,
                             (void*)&schedulerState[idx].schedulerId);
     if (sc) {
         mvLog(MVLOG_ERROR,"Thread creation failed with error: %d", sc);
+        schedulerState[idx].threadRunning = 0;
+        if (link) {
+            link->dispatcherRunning = 0;
+        }
         if (pthread_attr_destroy(&attr) != 0) {
             perror("Thread attr destroy failed\n");
         }
@@ -373,6 +411,11 @@ xLinkEvent_t* DispatcherAddEvent(xLinkEventOrigin_t origin, xLinkEvent_t *event)
         return NULL;
     }
 
+    uint32_t priority = 0;
+    if (glControlFunc->eventPriority) {
+        priority = (uint32_t)glControlFunc->eventPriority(event);
+    }
+
     XLink_sem_t *sem = NULL;
     xLinkEvent_t* ev;
     if (origin == EVENT_LOCAL) {
@@ -392,9 +435,9 @@ xLinkEvent_t* DispatcherAddEvent(xLinkEventOrigin_t origin, xLinkEvent_t *event)
         const uint32_t tmpMoveSem = event->header.flags.bitField.moveSemantic;
         event->header.flags.raw = 0;
         event->header.flags.bitField.moveSemantic = tmpMoveSem;
-        ev = addNextQueueElemToProc(curr, &curr->lQueue, event, sem, origin);
+        ev = addNextQueueElemToProc(curr, &curr->lQueue, event, sem, origin, priority);
     } else {
-        ev = addNextQueueElemToProc(curr, &curr->rQueue, event, NULL, origin);
+        ev = addNextQueueElemToProc(curr, &curr->rQueue, event, NULL, origin, priority);
     }
     if (XLink_sem_post(&curr->addEventSem)) {
         mvLog(MVLOG_ERROR,"can't post semaphore\n");
@@ -516,6 +559,8 @@ char* TypeToStr(int type)
         case XLINK_PING_RESP:  return "XLINK_PING_RESP";
         case XLINK_RESET_RESP: return "XLINK_RESET_RESP";
         case XLINK_RESP_LAST:  return "XLINK_RESP_LAST";
+        case XLINK_CREDIT_REQ: return "XLINK_CREDIT_REQ";
+        case XLINK_WRITE_FRAG_REQ: return "XLINK_WRITE_FRAG_REQ";
         default:
             break;
     }
@@ -529,32 +574,36 @@ int DispatcherUnblockEvent(eventId_t id, xLinkEventType_t type, streamId_t strea
 
     mvLog(MVLOG_DEBUG,"unblock\n");
     xLinkEventPriv_t* blockedEvent;
+    xLinkEventPriv_t* oldestEvent = NULL;
 
-    XLINK_RET_ERR_IF(pthread_mutex_lock(&(curr->queueMutex)) != 0, 1);
+    XLINK_RET_ERR_IF(XLinkProfMutexLock(&(curr->queueMutex), X_LINK_LOCK_EVENT_QUEUE) != 0, 1);
     for (blockedEvent = curr->lQueue.q;
          blockedEvent < curr->lQueue.q + MAX_EVENTS;
          blockedEvent++)
     {
+        // the oldest one, so blocked events of a stream keep their order
         if (blockedEvent->isServed == EVENT_BLOCKED &&
             ((blockedEvent->packet.header.id == id || id == -1)
              && blockedEvent->packet.header.type == type
-             && blockedEvent->packet.header.streamId == stream))
+             && blockedEvent->packet.header.streamId == stream)
+            && (oldestEvent == NULL || (int32_t)(blockedEvent->seq - oldestEvent->seq) < 0))
         {
-            mvLog(MVLOG_DEBUG,"unblocked**************** %d %s\n",
-                  (int)blockedEvent->packet.header.id,
-                  TypeToStr((int)blockedEvent->packet.header.type));
-            blockedEvent->isServed = EVENT_READY;
-            if (XLink_sem_post(&curr->notifyDispatcherSem)){
-                mvLog(MVLOG_ERROR, "can't post semaphore\n");
-            }
-            XLINK_RET_ERR_IF(pthread_mutex_unlock(&(curr->queueMutex)) != 0, 1);
-            return 1;
-        } else {
-            mvLog(MVLOG_DEBUG,"%d %s\n",
-                  (int)blockedEvent->packet.header.id,
-                  TypeToStr((int)blockedEvent->packet.header.type));
+            oldestEvent = blockedEvent;
         }
     }
+    if (oldestEvent) {
+        mvLog(MVLOG_DEBUG,"unblocked**************** %d %s\n",
+              (int)oldestEvent->packet.header.id,
+              TypeToStr((int)oldestEvent->packet.header.type));
+        oldestEvent->isServed = EVENT_READY;
+        oldestEvent->packet.stamps.unblockNs = getMonotonicTimestampNs();
+        traceEvent(curr, XLINK_TRACE_UNBLOCK, &oldestEvent->packet, 0);
+        if (XLink_sem_post(&curr->notifyDispatcherSem)){
+            mvLog(MVLOG_ERROR, "can't post semaphore\n");
+        }
+        XLINK_RET_ERR_IF(pthread_mutex_unlock(&(curr->queueMutex)) != 0, 1);
+        return 1;
+    }
     XLINK_RET_ERR_IF(pthread_mutex_unlock(&(curr->queueMutex)) != 0, 1);
     return 0;
 }
@@ -565,7 +614,7 @@ int DispatcherServeEvent(eventId_t id, xLinkEventType_t type, streamId_t stream,
     ASSERT_XLINK(curr != NULL);
 
     xLinkEventPriv_t* event;
-    XLINK_RET_ERR_IF(pthread_mutex_lock(&(curr->queueMutex)) != 0, 1);
+    XLINK_RET_ERR_IF(XLinkProfMutexLock(&(curr->queueMutex), X_LINK_LOCK_EVENT_QUEUE) != 0, 1);
     for (event = curr->lQueue.q;
          event < curr->lQueue.q + MAX_EVENTS;
          event++)
@@ -693,14 +742,20 @@ static void* eventReader(void* ctx)
     mvLog(MVLOG_INFO,"eventReader thread started");
 
     while (!curr->resetXLink) {
+        memset(&event.stamps, 0, sizeof(event.stamps));
         int sc = glControlFunc->eventReceive(&event);
+        event.stamps.receiveEndNs = getMonotonicTimestampNs();
+        if (sc == 0) {
+            traceEvent(curr, XLINK_TRACE_RECEIVE, &event,
+                       event.stamps.receiveStartNs ? event.stamps.receiveStartNs : event.stamps.receiveEndNs);
+        }
 
         mvLog(MVLOG_DEBUG,"Reading %s (scheduler %d, fd %p, event id %d, event stream_id %u, event size %u)\n",
               TypeToStr(event.header.type), curr->schedulerId, event.deviceHandle.xLinkFD, event.header.id, event.header.streamId, event.header.size);
         
         if (sc) {
             mvLog(MVLOG_DEBUG,"Failed to receive event (err %d)", sc);
-            XLINK_RET_ERR_IF(pthread_mutex_lock(&(curr->queueMutex)) != 0, NULL);
+            XLINK_RET_ERR_IF(XLinkProfMutexLock(&(curr->queueMutex), X_LINK_LOCK_EVENT_QUEUE) != 0, NULL);
             dispatcherFreeEvents(&curr->lQueue, EVENT_PENDING);
             dispatcherFreeEvents(&curr->lQueue, EVENT_BLOCKED);
             XLINK_RET_ERR_IF(pthread_mutex_unlock(&(curr->queueMutex)) != 0, NULL);
@@ -805,16 +860,38 @@ static void* eventSchedulerRun(void* ctx)
         mvLog(MVLOG_INFO,"Scheduler thread stopped");
     }
 
+    // nothing touches the slots anymore, the next connection may take them
+    if (curr->link) {
+        XLINK_RET_ERR_IF(XLinkProfMutexLock(&availableXLinksMutex, X_LINK_LOCK_LINKS) != 0, NULL);
+        curr->link->dispatcherRunning = 0;
+        XLINK_RET_ERR_IF(pthread_mutex_unlock(&availableXLinksMutex) != 0, NULL);
+    }
+    XLINK_RET_ERR_IF(pthread_mutex_lock(&num_schedulers_mutex) != 0, NULL);
+    curr->threadRunning = 0;
+    XLINK_RET_ERR_IF(pthread_mutex_unlock(&num_schedulers_mutex) != 0, NULL);
+
     return NULL;
 }
 
 static int isEventTypeRequest(xLinkEventPriv_t* event)
 {
-    return event->packet.header.type < XLINK_REQUEST_LAST;
+    return event->packet.header.type < XLINK_REQUEST_LAST
+        || event->packet.header.type == XLINK_READ_REL_SPEC_REQ
+        || event->packet.header.type == XLINK_CREDIT_REQ;
+}
+
+static xLinkEventType_t getRequestType(xLinkEventType_t responseType)
+{
+    // added after the IPC events, out of the request / response order
+    if (responseType == XLINK_READ_REL_SPEC_RESP) {
+        return XLINK_READ_REL_SPEC_REQ;
+    }
+    return (xLinkEventType_t)(responseType - XLINK_REQUEST_LAST - 1);
 }
 
 static void postAndMarkEventServed(xLinkEventPriv_t *event)
 {
+    event->packet.stamps.completeNs = getMonotonicTimestampNs();
     if (event->retEv){
         // the xLinkEventPriv_t slot pointed by "event" will be
         // re-cycled as soon as we mark it as EVENT_SERVED,
@@ -848,10 +925,13 @@ static int createUniqueID()
 int findAvailableScheduler()
 {
     int i;
+    XLINK_RET_ERR_IF(pthread_mutex_lock(&num_schedulers_mutex) != 0, -1);
     for (i = 0; i < MAX_SCHEDULERS; i++)
-        if (schedulerState[i].schedulerId == -1)
-            return i;
-    return -1;
+        // the thread of a cleaned scheduler may still run
+        if (schedulerState[i].schedulerId == -1 && !schedulerState[i].threadRunning)
+            break;
+    XLINK_RET_ERR_IF(pthread_mutex_unlock(&num_schedulers_mutex) != 0, -1);
+    return i < MAX_SCHEDULERS ? i : -1;
 }
 
 static xLinkSchedulerState_t* findCorrespondingScheduler(void* xLinkFD)
@@ -884,6 +964,7 @@ static int dispatcherRequestServe(xLinkEventPriv_t * event, xLinkSchedulerState_
     xLinkEventHeader_t *header = &event->packet.header;
     if (header->flags.bitField.block){ //block is requested
         event->isServed = EVENT_BLOCKED;
+        traceEvent(curr, XLINK_TRACE_BLOCK, &event->packet, 0);
     } else if(header->flags.bitField.localServe == 1 ||
               (header->flags.bitField.ack == 0
                && header->flags.bitField.nack == 1)){ //this event is served locally, or it is failed
@@ -911,7 +992,7 @@ static int dispatcherResponseServe(xLinkEventPriv_t * event, xLinkSchedulerState
 
         if (curr->lQueue.q[i].isServed == EVENT_PENDING &&
             header->id == evHeader->id &&
-            header->type == evHeader->type - XLINK_REQUEST_LAST -1)
+            header->type == getRequestType(evHeader->type))
         {
             mvLog(MVLOG_DEBUG,"----------------------ISserved %s\n",
                   TypeToStr(header->type));
@@ -960,8 +1041,15 @@ static xLinkEventPriv_t* searchForReadyEvent(xLinkSchedulerState_t* curr)
 {
     XLINK_RET_ERR_IF(curr == NULL, NULL);
     xLinkEventPriv_t* ev = NULL;
+    xLinkEventPriv_t* tmp;
 
-    ev = getNextElementWithState(curr->lQueue.base, curr->lQueue.end, curr->lQueue.base, EVENT_READY);
+    // the oldest one, so unblocked events of a stream keep their order
+    for (tmp = curr->lQueue.base; tmp < curr->lQueue.end; tmp++) {
+        if (tmp->isServed == EVENT_READY &&
+            (ev == NULL || (int32_t)(tmp->seq - ev->seq) < 0)) {
+            ev = tmp;
+        }
+    }
     if(ev){
         mvLog(MVLOG_DEBUG,"ready %s %d \n",
               TypeToStr((int)ev->packet.header.type),
@@ -970,26 +1058,59 @@ static xLinkEventPriv_t* searchForReadyEvent(xLinkSchedulerState_t* curr)
     return ev;
 }
 
+static uint32_t effectivePriority(xLinkEventPriv_t* event)
+{
+    // every XLINK_PRIORITY_AGING_STEP events dispatched ahead of it promote
+    // the event by one class, so lower classes are delayed but never starved
+    return event->priority + event->skipped / XLINK_PRIORITY_AGING_STEP;
+}
+
+static int isQueueElemPreferred(xLinkEventPriv_t* event, xLinkEventPriv_t* other)
+{
+    const uint32_t priority = effectivePriority(event);
+    const uint32_t otherPriority = effectivePriority(other);
+    if (priority != otherPriority) {
+        return priority > otherPriority;
+    }
+    // older first, the sequence may wrap around
+    return (int32_t)(event->seq - other->seq) < 0;
+}
+
 static xLinkEventPriv_t* getNextQueueElemToProc(eventQueueHandler_t *q ){
     xLinkEventPriv_t* event = NULL;
-    if (q->cur != q->curProc) {
-        event = getNextElementWithState(q->base, q->end, q->curProc, EVENT_ALLOCATED);
-        q->curProc = event;
-        CIRCULAR_INCREMENT_BASE(q->curProc, q->end, q->base);
+    xLinkEventPriv_t* tmp;
+    for (tmp = q->base; tmp < q->end; tmp++) {
+        if (tmp->isServed == EVENT_ALLOCATED &&
+            (event == NULL || isQueueElemPreferred(tmp, event))) {
+            event = tmp;
+        }
     }
     return event;
 }
 
+static void ageQueueElems(eventQueueHandler_t *q, xLinkEventPriv_t* chosen)
+{
+    // older events of a stream are passed over at least as often as newer ones
+    // of the same stream, so aging keeps the order of events within a stream
+    xLinkEventPriv_t* tmp;
+    for (tmp = q->base; tmp < q->end; tmp++) {
+        if (tmp != chosen && tmp->isServed == EVENT_ALLOCATED) {
+            tmp->skipped++;
+        }
+    }
+}
+
 /**
  * @brief Add event to Queue
  * @note It called from dispatcherAddEvent
  */
 static xLinkEvent_t* addNextQueueElemToProc(xLinkSchedulerState_t* curr,
                                             eventQueueHandler_t *q, xLinkEvent_t* event,
-                                            XLink_sem_t* sem, xLinkEventOrigin_t o)
+                                            XLink_sem_t* sem, xLinkEventOrigin_t o,
+                                            uint32_t priority)
 {
     xLinkEvent_t* ev;
-    XLINK_RET_ERR_IF(pthread_mutex_lock(&(curr->queueMutex)) != 0, NULL);
+    XLINK_RET_ERR_IF(XLinkProfMutexLock(&(curr->queueMutex), X_LINK_LOCK_EVENT_QUEUE) != 0, NULL);
     xLinkEventPriv_t* eventP = getNextElementWithState(q->base, q->end, q->cur, EVENT_SERVED);
     if (eventP == NULL) {
         mvLog(MVLOG_ERROR, "getNextElementWithState returned NULL");
@@ -1001,7 +1122,15 @@ static xLinkEvent_t* addNextQueueElemToProc(xLinkSchedulerState_t* curr,
 
     eventP->sem = sem;
     eventP->packet = *event;
+    if (o == EVENT_LOCAL) {
+        memset(&eventP->packet.stamps, 0, sizeof(eventP->packet.stamps));
+    }
+    eventP->packet.stamps.enqueueNs = getMonotonicTimestampNs();
     eventP->origin = o;
+    eventP->priority = priority;
+    eventP->skipped = 0;
+    eventP->seq = curr->nextEventSeq++;
+    eventP->partiallySent = 0;
     if (o == EVENT_LOCAL) {
         // XLink API caller provided buffer for return the final result to
         eventP->retEv = event;
@@ -1015,35 +1144,80 @@ static xLinkEvent_t* addNextQueueElemToProc(xLinkSchedulerState_t* curr,
     return ev;
 }
 
-static xLinkEventPriv_t* dispatcherGetNextEvent(xLinkSchedulerState_t* curr)
+static int dispatcherWaitNotification(xLinkSchedulerState_t* curr)
+{
+    int rc;
+    while (1) {
+        int timeoutUs = -1;
+        if (glControlFunc->flushDeferred) {
+            timeoutUs = glControlFunc->flushDeferred(&curr->deviceHandle);
+        }
+        if (timeoutUs < 0) {
+            while(((rc = XLink_sem_wait(&curr->notifyDispatcherSem)) == -1) && errno == EINTR)
+                continue;
+            return rc;
+        }
+
+        // wake up when the earliest deferred item is due, unless an event comes first
+        struct timespec abstime;
+        clock_gettime(CLOCK_REALTIME, &abstime);
+        abstime.tv_sec += timeoutUs / 1000000;
+        abstime.tv_nsec += (long)(timeoutUs % 1000000) * 1000;
+        if (abstime.tv_nsec >= 1000000000) {
+            abstime.tv_sec++;
+            abstime.tv_nsec -= 1000000000;
+        }
+        while(((rc = XLink_sem_timedwait(&curr->notifyDispatcherSem, &abstime)) == -1) && errno == EINTR)
+            continue;
+        if (rc == 0 || errno != ETIMEDOUT) {
+            return rc;
+        }
+    }
+}
+
+static xLinkEventPriv_t* dispatcherGetNextEvent(xLinkSchedulerState_t* curr, int flushDeferred)
 {
     XLINK_RET_ERR_IF(curr == NULL, NULL);
 
     int rc;
-    while(((rc = XLink_sem_wait(&curr->notifyDispatcherSem)) == -1) && errno == EINTR)
-        continue;
+    if (flushDeferred) {
+        rc = dispatcherWaitNotification(curr);
+    } else {
+        while(((rc = XLink_sem_wait(&curr->notifyDispatcherSem)) == -1) && errno == EINTR)
+            continue;
+    }
     if (rc) {
         mvLog(MVLOG_ERROR,"can't post semaphore\n");
     }
 
     xLinkEventPriv_t* event = NULL;
-    XLINK_RET_ERR_IF(pthread_mutex_lock(&(curr->queueMutex)) != 0, NULL);
-    event = searchForReadyEvent(curr);
-    if (event) {
-        XLINK_RET_ERR_IF(pthread_mutex_unlock(&(curr->queueMutex)) != 0, NULL);
-        return event;
-    }
+    XLINK_RET_ERR_IF(XLinkProfMutexLock(&(curr->queueMutex), X_LINK_LOCK_EVENT_QUEUE) != 0, NULL);
+    xLinkEventPriv_t* readyEvent = searchForReadyEvent(curr);
 
     eventQueueHandler_t* hPriorityQueue = curr->queueProcPriority ? &curr->lQueue : &curr->rQueue;
     eventQueueHandler_t* lPriorityQueue = curr->queueProcPriority ? &curr->rQueue : &curr->lQueue;
-    curr->queueProcPriority = curr->queueProcPriority ? 0 : 1;
 
+    // the queues alternate between events of the same class
     event = getNextQueueElemToProc(hPriorityQueue);
-    if (event) {
+    xLinkEventPriv_t* lEvent = getNextQueueElemToProc(lPriorityQueue);
+    if (event == NULL || (lEvent && effectivePriority(lEvent) > effectivePriority(event))) {
+        event = lEvent;
+    }
+    // unblocked events go first, unless an event of a higher class is pending. Events of a
+    // stream share their class, so they keep their order
+    if (readyEvent && (event == NULL || event->priority <= readyEvent->priority)) {
         XLINK_RET_ERR_IF(pthread_mutex_unlock(&(curr->queueMutex)) != 0, NULL);
-        return event;
+        return readyEvent;
+    }
+    curr->queueProcPriority = curr->queueProcPriority ? 0 : 1;
+    if (event) {
+        ageQueueElems(&curr->lQueue, event);
+        ageQueueElems(&curr->rQueue, event);
+        // the rest of partially sent events is picked up again
+        if (event->packet.stamps.dispatchNs == 0) {
+            event->packet.stamps.dispatchNs = getMonotonicTimestampNs();
+        }
     }
-    event = getNextQueueElemToProc(lPriorityQueue);
 
     XLINK_RET_ERR_IF(pthread_mutex_unlock(&(curr->queueMutex)) != 0, NULL);
     return event;
@@ -1066,18 +1240,18 @@ static int dispatcherClean(xLinkSchedulerState_t* curr)
     if (XLink_sem_post(&curr->notifyDispatcherSem)) {
         mvLog(MVLOG_ERROR,"can't post semaphore\n"); //to allow us to get a NULL event
     }
-    xLinkEventPriv_t* event = dispatcherGetNextEvent(curr);
+    xLinkEventPriv_t* event = dispatcherGetNextEvent(curr, 0);
     while (event != NULL) {
         mvLog(MVLOG_INFO, "dropped event is %s, status %d\n",
               TypeToStr(event->packet.header.type), event->isServed);
 
-        XLINK_RET_ERR_IF(pthread_mutex_lock(&(curr->queueMutex)) != 0, 1);
+        XLINK_RET_ERR_IF(XLinkProfMutexLock(&(curr->queueMutex), X_LINK_LOCK_EVENT_QUEUE) != 0, 1);
         postAndMarkEventServed(event);
         XLINK_RET_ERR_IF(pthread_mutex_unlock(&(curr->queueMutex)) != 0, 1);
-        event = dispatcherGetNextEvent(curr);
+        event = dispatcherGetNextEvent(curr, 0);
     }
 
-    XLINK_RET_ERR_IF(pthread_mutex_lock(&(curr->queueMutex)) != 0, 1);
+    XLINK_RET_ERR_IF(XLinkProfMutexLock(&(curr->queueMutex), X_LINK_LOCK_EVENT_QUEUE) != 0, 1);
 
     dispatcherFreeEvents(&curr->lQueue, EVENT_PENDING);
     dispatcherFreeEvents(&curr->lQueue, EVENT_BLOCKED);
@@ -1177,7 +1351,7 @@ static XLinkError_t sendEvents(xLinkSchedulerState_t* curr) {
     xLinkEventPriv_t response;
 
     while (!curr->resetXLink) {
-        event = dispatcherGetNextEvent(curr);
+        event = dispatcherGetNextEvent(curr, 1);
         if(event == NULL) {
             mvLog(MVLOG_ERROR,"Dispatcher received NULL event!");
 #ifndef __DEVICE__
@@ -1197,7 +1371,7 @@ static XLinkError_t sendEvents(xLinkSchedulerState_t* curr) {
             event->packet.header.flags.bitField.nack = 1;
             event->packet.header.flags.bitField.ack = 0;
 
-            XLINK_RET_ERR_IF(pthread_mutex_lock(&(curr->queueMutex)) != 0, X_LINK_ERROR);
+            XLINK_RET_ERR_IF(XLinkProfMutexLock(&(curr->queueMutex), X_LINK_LOCK_EVENT_QUEUE) != 0, X_LINK_ERROR);
             if (event->origin == EVENT_LOCAL){
                 dispatcherRequestServe(event, curr);
             } else {
@@ -1208,6 +1382,12 @@ static XLinkError_t sendEvents(xLinkSchedulerState_t* curr) {
             continue;
         }
 
+        if (event->partiallySent) {
+            // the request has been handled already, only the rest of it is to be sent
+            XLINK_RET_IF_FAIL(dispatcherSendEvent(curr, event, &event->packet));
+            continue;
+        }
+
         getRespFunction getResp;
         xLinkEvent_t* toSend;
         if (event->origin == EVENT_LOCAL){
@@ -1221,7 +1401,7 @@ static XLinkError_t sendEvents(xLinkSchedulerState_t* curr) {
         res = getResp(&event->packet, &response.packet);
 
         if (isEventTypeRequest(event)) {
-            XLINK_RET_ERR_IF(pthread_mutex_lock(&(curr->queueMutex)) != 0, X_LINK_ERROR);
+            XLINK_RET_ERR_IF(XLinkProfMutexLock(&(curr->queueMutex), X_LINK_LOCK_EVENT_QUEUE) != 0, X_LINK_ERROR);
             if (event->origin == EVENT_LOCAL) { //we need to do this for locals only
                 if(dispatcherRequestServe(event, curr)) {
                     mvLog(MVLOG_ERROR, "Failed to serve local event. "
@@ -1249,20 +1429,12 @@ static XLinkError_t sendEvents(xLinkSchedulerState_t* curr) {
                 }
 #endif // __DEVICE__
                 XLINK_RET_ERR_IF(pthread_mutex_unlock(&(curr->queueMutex)) != 0, X_LINK_ERROR);
-                if (glControlFunc->eventSend(toSend) != 0) {
-                    // Error out
-                    curr->resetXLink = 1;
-                    XLINK_RET_ERR_IF(pthread_mutex_lock(&(curr->queueMutex)) != 0, X_LINK_ERROR);
-                    dispatcherFreeEvents(&curr->lQueue, EVENT_PENDING);
-                    dispatcherFreeEvents(&curr->lQueue, EVENT_BLOCKED);
-                    XLINK_RET_ERR_IF(pthread_mutex_unlock(&(curr->queueMutex)) != 0, X_LINK_ERROR);
-                    mvLog(MVLOG_ERROR, "Event sending failed");
-                }
+                XLINK_RET_IF_FAIL(dispatcherSendEvent(curr, event, toSend));
             } else {
                 XLINK_RET_ERR_IF(pthread_mutex_unlock(&(curr->queueMutex)) != 0, X_LINK_ERROR);
             }
         } else {
-            XLINK_RET_ERR_IF(pthread_mutex_lock(&(curr->queueMutex)) != 0, X_LINK_ERROR);
+            XLINK_RET_ERR_IF(XLinkProfMutexLock(&(curr->queueMutex), X_LINK_LOCK_EVENT_QUEUE) != 0, X_LINK_ERROR);
             if (event->origin == EVENT_REMOTE){ // match remote response with the local request
                 dispatcherResponseServe(event, curr);
             }
@@ -1270,9 +1442,74 @@ static XLinkError_t sendEvents(xLinkSchedulerState_t* curr) {
         }
 
         if (event->origin == EVENT_REMOTE){
+            if (glControlFunc->eventStages) {
+                event->packet.stamps.completeNs = getMonotonicTimestampNs();
+                glControlFunc->eventStages(&event->packet);
+            }
             event->isServed = EVENT_SERVED;
+            if (event->packet.header.type == XLINK_RESET_REQ) {
+                // The reader may flag the reset only after this loop went back
+                // to wait for the next event, which then never comes
+                curr->resetXLink = 1;
+            }
+        }
+    }
+
+    return X_LINK_SUCCESS;
+}
+
+static XLinkError_t dispatcherSendEvent(xLinkSchedulerState_t* curr, xLinkEventPriv_t* event,
+                                        xLinkEvent_t* toSend)
+{
+    xLinkEventStamps_t* stamps = &event->packet.stamps;
+    const uint64_t startNs = getMonotonicTimestampNs();
+    if (stamps->sendStartNs == 0) {
+        stamps->sendStartNs = startNs;
+    }
+    int rc = glControlFunc->eventSend(toSend);
+    stamps->sendEndNs = getMonotonicTimestampNs();
+    traceEvent(curr, XLINK_TRACE_SEND, toSend, startNs);
+    if (rc < 0) {
+        // Error out
+        curr->resetXLink = 1;
+        XLINK_RET_ERR_IF(XLinkProfMutexLock(&(curr->queueMutex), X_LINK_LOCK_EVENT_QUEUE) != 0, X_LINK_ERROR);
+        dispatcherFreeEvents(&curr->lQueue, EVENT_PENDING);
+        dispatcherFreeEvents(&curr->lQueue, EVENT_BLOCKED);
+        if (event->partiallySent && event->isServed == EVENT_ALLOCATED) {
+            // a write broken off between its fragments isn't in the queue states freed above,
+            // left allocated it would be picked up again when the dispatcher is cleaned
+            event->partiallySent = 0;
+            event->packet.header.flags.bitField.ack = 0;
+            event->packet.header.flags.bitField.nack = 1;
+            postAndMarkEventServed(event);
         }
+        XLINK_RET_ERR_IF(pthread_mutex_unlock(&(curr->queueMutex)) != 0, X_LINK_ERROR);
+        mvLog(MVLOG_ERROR, "Event sending failed");
+        return X_LINK_SUCCESS;
+    }
+    if (event->origin != EVENT_LOCAL) {
+        return X_LINK_SUCCESS;
+    }
+
+    XLINK_RET_ERR_IF(XLinkProfMutexLock(&(curr->queueMutex), X_LINK_LOCK_EVENT_QUEUE) != 0, X_LINK_ERROR);
+    if (rc > 0) {
+        // queue the rest behind the events waiting meanwhile
+        event->isServed = EVENT_ALLOCATED;
+        event->partiallySent = 1;
+        event->skipped = 0;
+        event->seq = curr->nextEventSeq++;
+        if (XLink_sem_post(&curr->notifyDispatcherSem)) {
+            mvLog(MVLOG_ERROR, "can't post semaphore\n");
+        }
+    } else if (toSend->header.flags.bitField.posted) {
+        // posted writes don't wait for the response of the remote
+        event->partiallySent = 0;
+        postAndMarkEventServed(event);
+    } else if (event->partiallySent) {
+        event->partiallySent = 0;
+        event->isServed = EVENT_PENDING;
     }
+    XLINK_RET_ERR_IF(pthread_mutex_unlock(&(curr->queueMutex)) != 0, X_LINK_ERROR);
 
     return X_LINK_SUCCESS;
 }
@@ -1290,6 +1527,18 @@ static void dispatcherFreeEvents(eventQueueHandler_t *queue, xLinkEventState_t s
     }
 }
 
+static void traceEvent(xLinkSchedulerState_t* curr, xLinkTracePhase_t phase,
+                       const xLinkEvent_t* event, uint64_t startNs)
+{
+    if (!XLinkTraceEnabled()) {
+        return;
+    }
+    // instant when no start is given
+    const uint64_t endNs = getMonotonicTimestampNs();
+    XLinkTraceRecord(phase, curr->linkId, event->header.type, event->header.streamId,
+                     event->header.size, startNs ? startNs : endNs, endNs);
+}
+
 
 // ------------------------------------
 // Helpers implementation. End.
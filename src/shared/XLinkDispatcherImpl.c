@@ -31,9 +31,39 @@ static streamPacketDesc_t* movePacketFromStream(streamDesc_t *stream);
 static streamPacketDesc_t* getPacketFromStream(streamDesc_t* stream);
 static int releasePacketFromStream(streamDesc_t* stream, uint32_t* releasedSize);
 static int releaseSpecificPacketFromStream(streamDesc_t* stream, uint32_t* releasedSize, uint8_t* data);
+// read packets of streams with shared reads, see XLinkStreamOptions_t
+static streamPacketDesc_t* sharePacket(streamDesc_t* stream, const streamPacketDesc_t* packet);
+static void unsharePacket(streamDesc_t* stream, const uint8_t* data);
 static int addNewPacketToStream(streamDesc_t* stream, void* buffer, uint32_t size, XLinkTimespec trsend, XLinkTimespec treceive);
-
-static int handleIncomingEvent(xLinkEvent_t* event, XLinkTimespec treceive);
+// drops the oldest unread packets of streams keeping only the latest ones, see XLinkStreamOptions_t
+static void dropOldestPackets(void* fd, streamId_t streamId);
+static int dropPacketFromStream(streamDesc_t* stream, uint32_t* droppedSize);
+
+static int handleIncomingEvent(xLinkEvent_t* event, XLinkTimespec treceive, const void* data);
+static int handleProgressiveData(xLinkEvent_t* event, streamDesc_t* stream,
+                                 XLinkTimespec trsend, XLinkTimespec treceive);
+// releases the stream, record is written ahead of the data if framing is on
+static int handleSinkData(xLinkEvent_t* event, streamDesc_t* stream, int fd,
+                          const XLinkSinkRecord_t* record, uint32_t size);
+
+// fragmented writes, see XLinkStreamOptions_t
+static int isEventFragment(xLinkEvent_t* event);
+static int writeEventData(xLinkEvent_t* event, uint32_t offset, uint32_t size);
+static int sendNextFragment(xLinkEvent_t* event);
+static int handleIncomingFragment(xLinkEvent_t* event, XLinkTimespec treceive);
+
+static int isDeviceRole(void* fd);
+static void recordPeerCapabilities(xLinkEvent_t* event);
+
+// release credit batching and posted write acknowledgement, see XLinkStreamOptions_t
+static int hasPendingCredit(streamDesc_t* stream);
+static void scheduleCredit(xLinkDesc_t* link, streamDesc_t* stream, int wasPending,
+                           uint32_t delayUs, int dueNow);
+static void deferReleaseCredit(void* fd, streamDesc_t* stream, uint32_t releasedSize);
+static void deferWriteAck(void* fd, streamId_t streamId);
+static int takeReleaseCredit(xLinkDesc_t* link, streamDesc_t* slot, xLinkEvent_t* event);
+static void attachReleaseCredit(xLinkEvent_t* event);
+static void applyReleaseCredit(xLinkEvent_t* event);
 
 // ------------------------------------
 // Helpers declaration. End.
@@ -48,14 +78,23 @@ static int handleIncomingEvent(xLinkEvent_t* event, XLinkTimespec treceive);
 //adds a new event with parameters and returns event id
 int dispatcherEventSend(xLinkEvent_t *event)
 {
-    mvLog(MVLOG_DEBUG, "Send event: %s, size %d, streamId %ld.\n",
-        TypeToStr(event->header.type), event->header.size, event->header.streamId);
+    if (event->header.flags.bitField.fragmented && event->sentSize) {
+        // the request went out already, continue with its data
+        return sendNextFragment(event);
+    }
+
+    dispatcherEventPrepareSend(event);
+    if (event->header.type == XLINK_WRITE_REQ && !event->header.flags.bitField.fragmented && !event->fromFile) {
+        // the data goes out with its header, in one transfer where the platform allows it
+        int rc = XLinkPlatformWriteMessage(&event->deviceHandle, &event->header, sizeof(event->header),
+                                           event->data, event->header.size);
+        if(rc < 0) {
+            mvLog(MVLOG_ERROR,"Write failed %d\n", rc);
+            return rc;
+        }
+        return 0;
+    }
 
-    XLinkTimespec stime;
-    getMonotonicTimestamp(&stime);
-    event->header.tsecLsb = (uint32_t)stime.tv_sec;
-    event->header.tsecMsb = (uint32_t)(stime.tv_sec >> 32);
-    event->header.tnsec = (uint32_t)stime.tv_nsec;
     int rc = XLinkPlatformWrite(&event->deviceHandle,
         &event->header, sizeof(event->header));
 
@@ -65,8 +104,10 @@ int dispatcherEventSend(xLinkEvent_t *event)
     }
 
     if (event->header.type == XLINK_WRITE_REQ) {
-        rc = XLinkPlatformWrite(&event->deviceHandle,
-            event->data, event->header.size);
+        if (event->header.flags.bitField.fragmented) {
+            return sendNextFragment(event);
+        }
+        rc = writeEventData(event, 0, event->header.size);
         if(rc < 0) {
             mvLog(MVLOG_ERROR,"Write failed %d\n", rc);
             return rc;
@@ -83,6 +124,17 @@ int dispatcherEventReceive(xLinkEvent_t* event){
     XLinkTimespec treceive;
     getMonotonicTimestamp(&treceive);
 
+    // fragments are reassembled here, only the completed write gets dispatched
+    while (rc >= 0 && isEventFragment(event)) {
+        int sc = handleIncomingFragment(event, treceive);
+        if (sc <= 0) {
+            return sc;
+        }
+        rc = XLinkPlatformRead(&event->deviceHandle,
+            &event->header, sizeof(event->header));
+        getMonotonicTimestamp(&treceive);
+    }
+
     // mvLog(MVLOG_DEBUG,"Incoming event %p: %s %d %p prevEvent: %s %d %p\n",
     //       event,
     //       TypeToStr(event->header.type),
@@ -105,7 +157,32 @@ int dispatcherEventReceive(xLinkEvent_t* event){
     // }
     // prevEvent = *event;
 
-    return handleIncomingEvent(event, treceive);
+    return handleIncomingEvent(event, treceive, NULL);
+}
+
+int dispatcherEventPrepareSend(xLinkEvent_t* event)
+{
+    mvLog(MVLOG_DEBUG, "Send event: %s, size %d, streamId %ld.\n",
+        TypeToStr(event->header.type), event->header.size, event->header.streamId);
+
+    // pending release credit rides along any outbound event for free
+    attachReleaseCredit(event);
+
+    XLinkTimespec stime;
+    getMonotonicTimestamp(&stime);
+    event->header.tsecLsb = (uint32_t)stime.tv_sec;
+    event->header.tsecMsb = (uint32_t)(stime.tv_sec >> 32);
+    event->header.tnsec = (uint32_t)stime.tv_nsec;
+    return 0;
+}
+
+int dispatcherEventReceiveFrom(xLinkEvent_t* event, const void* data)
+{
+    XLinkTimespec treceive;
+    getMonotonicTimestamp(&treceive);
+
+    ASSERT_XLINK(event->header.type != XLINK_WRITE_REQ || data != NULL);
+    return handleIncomingEvent(event, treceive, data);
 }
 
 //this function should be called only for local requests
@@ -139,7 +216,12 @@ int dispatcherLocalEventGetResponse(xLinkEvent_t* event, xLinkEvent_t* response)
             XLINK_EVENT_ACKNOWLEDGE(event);
             event->header.flags.bitField.localServe = 0;
 
-            if(!isStreamSpaceEnoughFor(stream, event->header.size)){
+            if (stream->fragmentedWriteInFlight) {
+                // the remote reassembles one write per stream at a time
+                mvLog(MVLOG_DEBUG,"stream '%s' is sending fragments (event %d)\n", stream->name, event->header.id);
+                event->header.flags.bitField.block = 1;
+                event->header.flags.bitField.localServe = 1;
+            }else if(!isStreamSpaceEnoughFor(stream, event->header.size)){
                 mvLog(MVLOG_DEBUG,"local NACK RTS. stream '%s' is full (event %d)\n", stream->name, event->header.id);
                 event->header.flags.bitField.block = 1;
                 event->header.flags.bitField.localServe = 1;
@@ -149,6 +231,17 @@ int dispatcherLocalEventGetResponse(xLinkEvent_t* event, xLinkEvent_t* response)
                 event->header.flags.bitField.block = 0;
                 stream->remoteFillLevel += event->header.size;
                 stream->remoteFillPacketLevel++;
+                if (stream->postedWrites) {
+                    // served by the dispatcher as soon as it is sent
+                    event->header.flags.bitField.posted = 1;
+                    stream->postedWritesInFlight++;
+                }
+                if (stream->fragmentSize && event->header.size > stream->fragmentSize) {
+                    event->header.flags.bitField.fragmented = 1;
+                    event->fragmentSize = stream->fragmentSize;
+                    event->sentSize = 0;
+                    stream->fragmentedWriteInFlight = 1;
+                }
                 mvLog(MVLOG_DEBUG,"S%d: Got local write of %ld , remote fill level %ld out of %ld %ld\n",
                       event->header.streamId, event->header.size, stream->remoteFillLevel, stream->writeSize, stream->readSize);
             }
@@ -178,6 +271,12 @@ int dispatcherLocalEventGetResponse(xLinkEvent_t* event, xLinkEvent_t* response)
                 XLINK_EVENT_ACKNOWLEDGE(event);
                 event->header.flags.bitField.block = 0;
             }
+            else if (stream->readsInterrupted ||
+                     (stream->availablePackets && stream->sharedReads && stream->sharedPackets == NULL)) {
+                // or the shared packets couldn't be allocated
+                XLINK_EVENT_NOT_ACKNOWLEDGE(event);
+                event->header.flags.bitField.block = 0;
+            }
             else{
                 event->header.flags.bitField.block = 1;
                 // TODO: easy to implement non-blocking read here, just return nack
@@ -190,10 +289,24 @@ int dispatcherLocalEventGetResponse(xLinkEvent_t* event, xLinkEvent_t* response)
         {
             stream = getStreamById(event->deviceHandle.xLinkFD, event->header.streamId);
             ASSERT_XLINK(stream);
-            XLINK_EVENT_ACKNOWLEDGE(event);
             uint32_t releasedSize = 0;
-            releasePacketFromStream(stream, &releasedSize);
+            if (stream->sharedReads) {
+                // the oldest packet may be held by another reader, moved ones aren't held
+                if (releaseSpecificPacketFromStream(stream, &releasedSize, NULL)) {
+                    XLINK_SET_EVENT_FAILED_AND_SERVE(event);
+                    releaseStream(stream);
+                    break;
+                }
+            } else {
+                releasePacketFromStream(stream, &releasedSize);
+            }
+            XLINK_EVENT_ACKNOWLEDGE(event);
             event->header.size = releasedSize;
+            if (stream->releaseBatchPackets) {
+                // the remote gets the credit later, together with other releases
+                deferReleaseCredit(event->deviceHandle.xLinkFD, stream, releasedSize);
+                event->header.flags.bitField.localServe = 1;
+            }
             releaseStream(stream);
             break;
         }
@@ -202,27 +315,36 @@ int dispatcherLocalEventGetResponse(xLinkEvent_t* event, xLinkEvent_t* response)
             uint8_t* data = (uint8_t*)event->data;
             stream = getStreamById(event->deviceHandle.xLinkFD, event->header.streamId);
             ASSERT_XLINK(stream);
-            XLINK_EVENT_ACKNOWLEDGE(event);
             uint32_t releasedSize = 0;
-            releaseSpecificPacketFromStream(stream, &releasedSize, data);
+            if (releaseSpecificPacketFromStream(stream, &releasedSize, data)) {
+                // nothing is credited to the remote for it
+                XLINK_SET_EVENT_FAILED_AND_SERVE(event);
+                releaseStream(stream);
+                break;
+            }
+            XLINK_EVENT_ACKNOWLEDGE(event);
             event->header.size = releasedSize;
+            if (stream->releaseBatchPackets) {
+                deferReleaseCredit(event->deviceHandle.xLinkFD, stream, releasedSize);
+                event->header.flags.bitField.localServe = 1;
+            }
             releaseStream(stream);
             break;
         }
         case XLINK_CREATE_STREAM_REQ:
         {
             XLINK_EVENT_ACKNOWLEDGE(event);
-#ifndef __DEVICE__
-            event->header.streamId = XLinkAddOrUpdateStream(event->deviceHandle.xLinkFD,
-                                                            event->header.streamName,
-                                                            event->header.size, 0,
-                                                            INVALID_STREAM_ID);
-            mvLog(MVLOG_DEBUG, "XLINK_CREATE_STREAM_REQ - stream has been just opened with id %ld\n",
-                  event->header.streamId);
-#else
-            mvLog(MVLOG_DEBUG, "XLINK_CREATE_STREAM_REQ - do nothing. Stream will be "
-                  "opened with forced id accordingly to response from the host\n");
-#endif
+            if (!isDeviceRole(event->deviceHandle.xLinkFD)) {
+                event->header.streamId = XLinkAddOrUpdateStream(event->deviceHandle.xLinkFD,
+                                                                event->header.streamName,
+                                                                event->header.size, 0,
+                                                                INVALID_STREAM_ID);
+                mvLog(MVLOG_DEBUG, "XLINK_CREATE_STREAM_REQ - stream has been just opened with id %ld\n",
+                      event->header.streamId);
+            } else {
+                mvLog(MVLOG_DEBUG, "XLINK_CREATE_STREAM_REQ - do nothing. Stream will be "
+                      "opened with forced id accordingly to response from the host\n");
+            }
             break;
         }
         case XLINK_CLOSE_STREAM_REQ:
@@ -231,7 +353,7 @@ int dispatcherLocalEventGetResponse(xLinkEvent_t* event, xLinkEvent_t* response)
 
             ASSERT_XLINK(stream);
             XLINK_EVENT_ACKNOWLEDGE(event);
-            if (stream->remoteFillLevel != 0){
+            if (stream->remoteFillLevel != 0 || stream->postedWritesInFlight != 0){
                 stream->closeStreamInitiated = 1;
                 event->header.flags.bitField.block = 1;
                 event->header.flags.bitField.localServe = 1;
@@ -251,7 +373,9 @@ int dispatcherLocalEventGetResponse(xLinkEvent_t* event, xLinkEvent_t* response)
         case XLINK_PING_REQ:
         {
             XLINK_EVENT_ACKNOWLEDGE(event);
-            mvLog(MVLOG_DEBUG,"XLINK_PING_REQ - do nothing\n");
+            // advertise protocol extensions, peers unaware of them ignore the flag
+            event->header.flags.bitField.capabilities = 1;
+            event->header.size = XLINK_LOCAL_CAPABILITIES;
             break;
         }
         case XLINK_WRITE_RESP:
@@ -287,6 +411,10 @@ int dispatcherRemoteEventGetResponse(xLinkEvent_t* event, xLinkEvent_t* response
     response->header.tnsec = event->header.tnsec;
     mvLog(MVLOG_DEBUG, "%s\n",TypeToStr(event->header.type));
 
+    if (event->header.flags.bitField.releaseCredit) {
+        applyReleaseCredit(event);
+    }
+
     switch (event->header.type)
     {
         case XLINK_WRITE_REQ:
@@ -298,6 +426,16 @@ int dispatcherRemoteEventGetResponse(xLinkEvent_t* event, xLinkEvent_t* response
                 response->deviceHandle = event->deviceHandle;
                 XLINK_EVENT_ACKNOWLEDGE(response);
 
+                if (event->sunk) {
+                    // no packet to read, the credit rides along the response
+                    streamDesc_t* stream = getStreamById(event->deviceHandle.xLinkFD, event->header.streamId);
+                    if (stream) {
+                        deferReleaseCredit(event->deviceHandle.xLinkFD, stream, event->header.size);
+                        releaseStream(stream);
+                    }
+                }
+                dropOldestPackets(event->deviceHandle.xLinkFD, event->header.streamId);
+
                 // we got some data. We should unblock a blocked read
                 int xxx = DispatcherUnblockEvent(-1,
                                                 XLINK_READ_REQ,
@@ -306,6 +444,12 @@ int dispatcherRemoteEventGetResponse(xLinkEvent_t* event, xLinkEvent_t* response
                 (void) xxx;
                 mvLog(MVLOG_DEBUG,"unblocked from stream %d %d\n",
                     (int)response->header.streamId, (int)xxx);
+
+                if (event->header.flags.bitField.posted) {
+                    // acknowledged later, together with other posted writes
+                    deferWriteAck(event->deviceHandle.xLinkFD, event->header.streamId);
+                    event->header.flags.bitField.localServe = 1;
+                }
             }
             break;
         case XLINK_READ_REQ:
@@ -369,17 +513,11 @@ int dispatcherRemoteEventGetResponse(xLinkEvent_t* event, xLinkEvent_t* response
             XLINK_EVENT_ACKNOWLEDGE(response);
             response->header.type = XLINK_CREATE_STREAM_RESP;
             //write size from remote means read size for this peer
-#ifdef __DEVICE__
             response->header.streamId = XLinkAddOrUpdateStream(event->deviceHandle.xLinkFD,
                                                                event->header.streamName,
                                                                0, event->header.size,
-                                                               event->header.streamId);
-#else
-            response->header.streamId = XLinkAddOrUpdateStream(event->deviceHandle.xLinkFD,
-                                                               event->header.streamName,
-                                                               0, event->header.size,
-                                                               INVALID_STREAM_ID);
-#endif
+                                                               isDeviceRole(event->deviceHandle.xLinkFD) ?
+                                                               event->header.streamId : INVALID_STREAM_ID);
             if (response->header.streamId == INVALID_STREAM_ID) {
                 response->header.flags.bitField.ack = 0;
                 response->header.flags.bitField.sizeTooBig = 1;
@@ -415,6 +553,8 @@ int dispatcherRemoteEventGetResponse(xLinkEvent_t* event, xLinkEvent_t* response
                         stream->readSize = 0;
                         stream->closeStreamInitiated = 0;
                     }
+                    // nothing is received anymore
+                    XLinkStreamFreeRecycled(stream);
 
                     if (!stream->writeSize) {
                         stream->id = INVALID_STREAM_ID;
@@ -440,7 +580,19 @@ int dispatcherRemoteEventGetResponse(xLinkEvent_t* event, xLinkEvent_t* response
             response->header.type = XLINK_PING_RESP;
             XLINK_EVENT_ACKNOWLEDGE(response);
             response->deviceHandle = event->deviceHandle;
+            recordPeerCapabilities(event);
+            response->header.flags.bitField.capabilities = 1;
+            response->header.size = XLINK_LOCAL_CAPABILITIES;
+#ifdef __DEVICE__
             sem_post(&pingSem);
+#else
+            {
+                xLinkDesc_t* link = getLink(event->deviceHandle.xLinkFD);
+                if (link == NULL || XLink_sem_post(&link->pingSem)) {
+                    mvLog(MVLOG_DEBUG, "can't post pingSem\n");
+                }
+            }
+#endif
             break;
         case XLINK_RESET_REQ:
             mvLog(MVLOG_DEBUG,"reset request - received! Sending ACK *****\n");
@@ -460,17 +612,17 @@ int dispatcherRemoteEventGetResponse(xLinkEvent_t* event, xLinkEvent_t* response
         case XLINK_CREATE_STREAM_RESP:
         {
             // write_size from the response the size of the buffer from the remote
-#ifdef __DEVICE__
-            response->header.streamId = XLinkAddOrUpdateStream(event->deviceHandle.xLinkFD,
-                                                               event->header.streamName,
-                                                               event->header.size, 0,
-                                                               event->header.streamId);
-            XLINK_RET_IF(response->header.streamId
-                == INVALID_STREAM_ID);
-            mvLog(MVLOG_DEBUG, "XLINK_CREATE_STREAM_REQ - stream has been just opened "
-                  "with forced id=%ld accordingly to response from the host\n",
-                  response->header.streamId);
-#endif
+            if (isDeviceRole(event->deviceHandle.xLinkFD)) {
+                response->header.streamId = XLinkAddOrUpdateStream(event->deviceHandle.xLinkFD,
+                                                                   event->header.streamName,
+                                                                   event->header.size, 0,
+                                                                   event->header.streamId);
+                XLINK_RET_IF(response->header.streamId
+                    == INVALID_STREAM_ID);
+                mvLog(MVLOG_DEBUG, "XLINK_CREATE_STREAM_REQ - stream has been just opened "
+                      "with forced id=%ld accordingly to response from the host\n",
+                      response->header.streamId);
+            }
             response->deviceHandle = event->deviceHandle;
             break;
         }
@@ -494,9 +646,14 @@ int dispatcherRemoteEventGetResponse(xLinkEvent_t* event, xLinkEvent_t* response
             break;
         }
         case XLINK_PING_RESP:
+            recordPeerCapabilities(event);
             break;
         case XLINK_RESET_RESP:
             break;
+        case XLINK_CREDIT_REQ:
+            // credit has been applied above, there is nothing to respond
+            event->header.flags.bitField.localServe = 1;
+            break;
         default:
         {
             mvLog(MVLOG_ERROR,
@@ -535,6 +692,10 @@ void dispatcherCloseLink(void* fd, int fullClose)
     link->deviceHandle.xLinkFD = NULL;
     link->peerState = XLINK_NOT_INIT;
     link->nextUniqueStreamId = 0;
+    link->peerCapabilities = 0;
+    link->pendingCreditStreams = 0;
+    link->deviceRole = 0;
+    link->sendQueueLimit = 0;
 
     for (int index = 0; index < XLINK_MAX_STREAMS; index++) {
         streamDesc_t* stream = &link->availableStreams[index];
@@ -543,17 +704,31 @@ void dispatcherCloseLink(void* fd, int fullClose)
         // * use move semantic, this prevents the memset(0) from causing leak/crash
         // * make new xlink-specific semaphore and wait on it during xlink lookup, create, etc.
 
+        // nothing reads the stream anymore, no copies needed
+        stream->sharedReads = 0;
         while (getPacketFromStream(stream) || stream->blockedPackets) {
             releasePacketFromStream(stream, NULL);
         }
+        if (stream->fragmentBuffer) {
+            XLinkPlatformDeallocateData(stream->fragmentBuffer,
+                ALIGN_UP(stream->fragmentTotalSize, __CACHE_LINE_SIZE), __CACHE_LINE_SIZE);
+        }
 
-        // XLink reset stream
+        // XLink reset stream, XLinkWaitPacketData may be looking at it
+        pthread_mutex_lock(&progressiveDataMutex);
         XLinkStreamReset(stream);
+        pthread_mutex_unlock(&progressiveDataMutex);
     }
+    pthread_mutex_lock(&progressiveDataMutex);
+    pthread_cond_broadcast(&progressiveDataCond);
+    pthread_mutex_unlock(&progressiveDataMutex);
 
     if(XLink_sem_destroy(&link->dispatcherClosedSem)) {
         mvLog(MVLOG_DEBUG, "Cannot destroy dispatcherClosedSem\n");
     }
+    if(XLink_sem_destroy(&link->pingSem)) {
+        mvLog(MVLOG_DEBUG, "Cannot destroy pingSem\n");
+    }
 }
 
 void dispatcherCloseDeviceFd(xLinkDeviceHandle_t* deviceHandle)
@@ -561,6 +736,84 @@ void dispatcherCloseDeviceFd(xLinkDeviceHandle_t* deviceHandle)
     XLinkPlatformCloseRemote(deviceHandle);
 }
 
+int dispatcherFlushDeferred(xLinkDeviceHandle_t* deviceHandle)
+{
+    xLinkDesc_t* link = getLink(deviceHandle->xLinkFD);
+    if (link == NULL || link->pendingCreditStreams == 0) {
+        return -1;
+    }
+
+    const uint64_t now = getMonotonicTimestampNs();
+    uint64_t nextDeadline = UINT64_MAX;
+    uint32_t pendingStreams = 0;
+    for (int index = 0; index < XLINK_MAX_STREAMS; index++) {
+        streamDesc_t* slot = &link->availableStreams[index];
+        // pending credit is only changed by the scheduler thread, which is the caller
+        if (slot->id == INVALID_STREAM_ID || !hasPendingCredit(slot)) {
+            continue;
+        }
+        if (slot->pendingCreditDeadlineNs > now) {
+            pendingStreams++;
+            if (slot->pendingCreditDeadlineNs < nextDeadline) {
+                nextDeadline = slot->pendingCreditDeadlineNs;
+            }
+            continue;
+        }
+
+        xLinkEvent_t event = {0};
+        XLINK_INIT_EVENT(event, slot->id, XLINK_CREDIT_REQ, 0, NULL, *deviceHandle);
+        if (takeReleaseCredit(link, slot, &event) && dispatcherEventSend(&event)) {
+            mvLog(MVLOG_ERROR, "Failed to send release credit of stream %u\n", event.header.streamId);
+        }
+    }
+    // streams closed with credit still pending are dropped from the count here
+    link->pendingCreditStreams = pendingStreams;
+
+    if (nextDeadline == UINT64_MAX) {
+        return -1;
+    }
+    return (int)((nextDeadline - now + 999) / 1000);
+}
+
+int dispatcherEventPriority(xLinkEvent_t* event)
+{
+    switch (event->header.type) {
+        case XLINK_CREATE_STREAM_REQ:
+        case XLINK_CREATE_STREAM_RESP:
+        case XLINK_PING_REQ:
+        case XLINK_PING_RESP:
+        case XLINK_RESET_REQ:
+        case XLINK_RESET_RESP:
+        case XLINK_CREDIT_REQ:
+            // not bound to an open stream
+            return X_LINK_PRIORITY_NORMAL;
+        default:
+            break;
+    }
+
+    streamDesc_t* stream = getStreamById(event->deviceHandle.xLinkFD, event->header.streamId);
+    if (stream == NULL) {
+        return X_LINK_PRIORITY_NORMAL;
+    }
+    const int priority = (int)stream->priority;
+    releaseStream(stream);
+
+    return priority;
+}
+
+void dispatcherEventStages(xLinkEvent_t* event)
+{
+    xLinkDesc_t* link = getLink(event->deviceHandle.xLinkFD);
+    if (link == NULL) {
+        return;
+    }
+    XLinkStagesRecord(&link->stages[X_LINK_EVENT_REMOTE], &event->stamps);
+    streamDesc_t* stream = peekStreamById(link, event->header.streamId);
+    if (stream && stream->stages) {
+        XLinkStagesRecord(stream->stages, &event->stamps);
+    }
+}
+
 // ------------------------------------
 // XLinkDispatcherImpl.h implementation. End.
 // ------------------------------------
@@ -589,6 +842,13 @@ streamPacketDesc_t* getPacketFromStream(streamDesc_t* stream)
     if (stream->availablePackets)
     {
         ret = &stream->packets[stream->firstPacketUnused];
+        if (stream->sharedReads) {
+            // the circular buffer is compacted under other readers
+            ret = sharePacket(stream, ret);
+            if (ret == NULL) {
+                return NULL;
+            }
+        }
         stream->availablePackets--;
         CIRCULAR_INCREMENT(stream->firstPacketUnused,
                            XLINK_MAX_PACKETS_PER_STREAM);
@@ -597,8 +857,8 @@ streamPacketDesc_t* getPacketFromStream(streamDesc_t* stream)
     return ret;
 }
 
-// TODO add multithread access to the same stream; not currently supported
-// due to issues like the order of get/move and release of packets
+// Many threads may read the same stream only if it has shared reads, otherwise
+// packets are released in the order they were read
 streamPacketDesc_t* movePacketFromStream(streamDesc_t* stream)
 {
     streamPacketDesc_t *ret = NULL;
@@ -640,8 +900,7 @@ int releasePacketFromStream(streamDesc_t* stream, uint32_t* releasedSize)
     mvLog(MVLOG_DEBUG, "S%d: Got release of %ld , current local fill level is %ld out of %ld %ld\n",
           stream->id, currPack->length, stream->localFillLevel, stream->readSize, stream->writeSize);
 
-    XLinkPlatformDeallocateData(currPack->data,
-                                ALIGN_UP_INT32((int32_t) currPack->length, __CACHE_LINE_SIZE), __CACHE_LINE_SIZE);
+    XLinkStreamRecycleBuffer(stream, currPack->data, currPack->length);
 
     CIRCULAR_INCREMENT(stream->firstPacket, XLINK_MAX_PACKETS_PER_STREAM);
     stream->blockedPackets--;
@@ -654,7 +913,7 @@ int releasePacketFromStream(streamDesc_t* stream, uint32_t* releasedSize)
 int releaseSpecificPacketFromStream(streamDesc_t* stream, uint32_t* releasedSize, uint8_t* data) {
     if (stream->blockedPackets == 0) {
         mvLog(MVLOG_ERROR,"There is no packet to release\n");
-        return 0; // ignore this, although this is a big problem on application side
+        return -1;
     }
 
     uint32_t packetId = stream->firstPacket;
@@ -666,7 +925,10 @@ int releaseSpecificPacketFromStream(streamDesc_t* stream, uint32_t* releasedSize
         }
         CIRCULAR_INCREMENT(packetId, XLINK_MAX_PACKETS_PER_STREAM);
     } while (packetId != stream->firstPacketUnused);
-    ASSERT_XLINK(found);
+    if (!found) {
+        mvLog(MVLOG_ERROR, "S%d: Released packet %p isn't held\n", stream->id, data);
+        return -1;
+    }
 
     streamPacketDesc_t* currPack = &stream->packets[packetId];
     if (currPack->length == 0) {
@@ -677,12 +939,14 @@ int releaseSpecificPacketFromStream(streamDesc_t* stream, uint32_t* releasedSize
 
   mvLog(MVLOG_DEBUG, "S%d: Got release of %ld , current local fill level is %ld out of %ld %ld\n",
           stream->id, currPack->length, stream->localFillLevel, stream->readSize, stream->writeSize);
-    XLinkPlatformDeallocateData(currPack->data,
-                                ALIGN_UP_INT32((int32_t) currPack->length, __CACHE_LINE_SIZE), __CACHE_LINE_SIZE);
+    XLinkStreamRecycleBuffer(stream, currPack->data, currPack->length);
     stream->blockedPackets--;
     if (releasedSize) {
         *releasedSize = currPack->length;
     }
+    if (stream->sharedReads && data != NULL) {
+        unsharePacket(stream, data);
+    }
 
     if (packetId != stream->firstPacket) {
         uint32_t currIndex = packetId;
@@ -690,6 +954,7 @@ int releaseSpecificPacketFromStream(streamDesc_t* stream, uint32_t* releasedSize
         CIRCULAR_INCREMENT(nextIndex, XLINK_MAX_PACKETS_PER_STREAM);
         while (currIndex != stream->firstPacketFree) {
             stream->packets[currIndex] = stream->packets[nextIndex];
+            stream->packetSequences[currIndex] = stream->packetSequences[nextIndex];
             currIndex = nextIndex;
             CIRCULAR_INCREMENT(nextIndex, XLINK_MAX_PACKETS_PER_STREAM);
         }
@@ -703,6 +968,82 @@ int releaseSpecificPacketFromStream(streamDesc_t* stream, uint32_t* releasedSize
     return 0;
 }
 
+streamPacketDesc_t* sharePacket(streamDesc_t* stream, const streamPacketDesc_t* packet)
+{
+    if (stream->sharedPackets == NULL) {
+        stream->sharedPackets = calloc(1, sizeof(*stream->sharedPackets));
+        if (stream->sharedPackets == NULL) {
+            mvLog(MVLOG_ERROR, "Cannot allocate the shared packets of stream %d\n", stream->id);
+            return NULL;
+        }
+    }
+    streamSharedPackets_t* shared = stream->sharedPackets;
+    // there are as many copies as packets in the circular buffer, one is always free
+    uint32_t i = 0;
+    while (shared->held[i]) {
+        i++;
+    }
+    shared->packets[i] = *packet;
+    shared->held[i] = 1;
+    return &shared->packets[i];
+}
+
+void unsharePacket(streamDesc_t* stream, const uint8_t* data)
+{
+    streamSharedPackets_t* shared = stream->sharedPackets;
+    if (shared == NULL) {
+        return;
+    }
+    for (uint32_t i = 0; i < XLINK_MAX_PACKETS_PER_STREAM; i++) {
+        if (shared->held[i] && shared->packets[i].data == data) {
+            shared->held[i] = 0;
+            return;
+        }
+    }
+}
+
+void dropOldestPackets(void* fd, streamId_t streamId)
+{
+    streamDesc_t* stream = getStreamById(fd, streamId);
+    if (stream == NULL) {
+        return;
+    }
+    uint32_t droppedSize = 0;
+    while (stream->keepLatestPackets && stream->availablePackets > stream->keepLatestPackets &&
+           dropPacketFromStream(stream, &droppedSize) == 0) {
+        // the remote gets the credit as if the packet was read and released
+        deferReleaseCredit(fd, stream, droppedSize);
+    }
+    releaseStream(stream);
+}
+
+int dropPacketFromStream(streamDesc_t* stream, uint32_t* droppedSize)
+{
+    if (stream->availablePackets == 0) {
+        return -1;
+    }
+    streamPacketDesc_t* oldest = &stream->packets[stream->firstPacketUnused];
+    stream->localFillLevel -= oldest->length;
+    *droppedSize = oldest->length;
+    XLinkStreamRecycleBuffer(stream, oldest->data, oldest->length);
+    stream->droppedPackets++;
+    mvLog(MVLOG_DEBUG, "S%d: Dropped packet %u of %u bytes\n", stream->id, stream->packetSequences[stream->firstPacketUnused], oldest->length);
+
+    // unread packets move up, those handed out to readers stay where they are
+    uint32_t currIndex = stream->firstPacketUnused;
+    uint32_t nextIndex = currIndex;
+    CIRCULAR_INCREMENT(nextIndex, XLINK_MAX_PACKETS_PER_STREAM);
+    while (nextIndex != stream->firstPacketFree) {
+        stream->packets[currIndex] = stream->packets[nextIndex];
+        stream->packetSequences[currIndex] = stream->packetSequences[nextIndex];
+        currIndex = nextIndex;
+        CIRCULAR_INCREMENT(nextIndex, XLINK_MAX_PACKETS_PER_STREAM);
+    }
+    CIRCULAR_DECREMENT(stream->firstPacketFree, (XLINK_MAX_PACKETS_PER_STREAM - 1));
+    stream->availablePackets--;
+    return 0;
+}
+
 int addNewPacketToStream(streamDesc_t* stream, void* buffer, uint32_t size, XLinkTimespec trsend, XLinkTimespec treceive) {
     if (stream->availablePackets + stream->blockedPackets < XLINK_MAX_PACKETS_PER_STREAM)
     {
@@ -710,6 +1051,7 @@ int addNewPacketToStream(streamDesc_t* stream, void* buffer, uint32_t size, XLin
         stream->packets[stream->firstPacketFree].length = size;
         stream->packets[stream->firstPacketFree].tRemoteSent = trsend;
         stream->packets[stream->firstPacketFree].tReceived = treceive;
+        stream->packetSequences[stream->firstPacketFree] = stream->receivedPackets++;
         CIRCULAR_INCREMENT(stream->firstPacketFree, XLINK_MAX_PACKETS_PER_STREAM);
         stream->availablePackets++;
         return 0;
@@ -717,14 +1059,18 @@ int addNewPacketToStream(streamDesc_t* stream, void* buffer, uint32_t size, XLin
     return -1;
 }
 
-int handleIncomingEvent(xLinkEvent_t* event, XLinkTimespec treceive) {
+int handleIncomingEvent(xLinkEvent_t* event, XLinkTimespec treceive, const void* data) {
     //this function will be dependent whether this is a client or a Remote
     //specific actions to this peer
     mvLog(MVLOG_DEBUG, "%s, size %u, streamId %u.\n", TypeToStr(event->header.type), event->header.size, event->header.streamId);
+    event->stamps.receiveStartNs = treceive.tv_sec * 1000000000ULL + treceive.tv_nsec;
 
-    ASSERT_XLINK(event->header.type >= XLINK_WRITE_REQ
-               && event->header.type != XLINK_REQUEST_LAST
-               && event->header.type < XLINK_RESP_LAST);
+    ASSERT_XLINK((event->header.type >= XLINK_WRITE_REQ
+                && event->header.type != XLINK_REQUEST_LAST
+                && event->header.type < XLINK_RESP_LAST)
+               || event->header.type == XLINK_READ_REL_SPEC_REQ
+               || event->header.type == XLINK_READ_REL_SPEC_RESP
+               || event->header.type == XLINK_CREDIT_REQ);
 
     // Then read the data buffer, which is contained only in the XLINK_WRITE_REQ event
     if(event->header.type != XLINK_WRITE_REQ) {
@@ -735,19 +1081,39 @@ int handleIncomingEvent(xLinkEvent_t* event, XLinkTimespec treceive) {
     streamDesc_t* stream = getStreamById(event->deviceHandle.xLinkFD, event->header.streamId);
     ASSERT_XLINK(stream);
 
+    uint64_t tsec = event->header.tsecLsb | ((uint64_t)event->header.tsecMsb << 32);
+    if (stream->sinkActive && data == NULL) {
+        XLinkSinkRecord_t record;
+        record.length = event->header.size;
+        record.tRemoteSent = (XLinkTimespec){tsec, event->header.tnsec};
+        record.tReceived = treceive;
+        if (handleSinkData(event, stream, stream->sinkFd, &record, event->header.size)) {
+            return -1;
+        }
+        event->sunk = 1;
+        return 0;
+    }
+
     stream->localFillLevel += event->header.size;
     mvLog(MVLOG_DEBUG,"S%u: Got write of %u, current local fill level is %u out of %u %u\n",
           event->header.streamId, event->header.size, stream->localFillLevel, stream->readSize, stream->writeSize);
 
-    void* buffer = XLinkPlatformAllocateData(ALIGN_UP(event->header.size, __CACHE_LINE_SIZE), __CACHE_LINE_SIZE);
+    void* buffer = XLinkStreamAllocateBuffer(stream, event->header.size);
     XLINK_OUT_WITH_LOG_IF(buffer == NULL,
         mvLog(MVLOG_FATAL,"out of memory to receive data of size = %zu\n", event->header.size));
 
-    const int sc = XLinkPlatformRead(&event->deviceHandle, buffer, event->header.size);
-    XLINK_OUT_WITH_LOG_IF(sc < 0, mvLog(MVLOG_ERROR,"%s() Read failed %d\n", __func__, sc));
-
     event->data = buffer;
-    uint64_t tsec = event->header.tsecLsb | ((uint64_t)event->header.tsecMsb << 32);
+    if (data != NULL) {
+        // handed over in memory, there is nothing to deliver progressively
+        memcpy(buffer, data, event->header.size);
+    } else if (stream->progressiveDelivery) {
+        // hands the packet out before its data, the stream is released while reading it
+        return handleProgressiveData(event, stream, (XLinkTimespec){tsec, event->header.tnsec}, treceive);
+    } else {
+        const int sc = XLinkPlatformRead(&event->deviceHandle, buffer, event->header.size);
+        XLINK_OUT_WITH_LOG_IF(sc < 0, mvLog(MVLOG_ERROR,"%s() Read failed %d\n", __func__, sc));
+    }
+
     XLINK_OUT_WITH_LOG_IF(addNewPacketToStream(stream, buffer, event->header.size, (XLinkTimespec){tsec, event->header.tnsec}, treceive),
         mvLog(MVLOG_WARN,"No more place in stream. release packet\n"));
     rc = 0;
@@ -766,6 +1132,487 @@ XLINK_OUT:
     return rc;
 }
 
+int handleSinkData(xLinkEvent_t* event, streamDesc_t* stream, int fd,
+                   const XLinkSinkRecord_t* record, uint32_t size)
+{
+    const int prefixSize = record != NULL && stream->sinkFraming ? (int)sizeof(*record) : 0;
+    const streamId_t streamId = stream->id;
+
+    // the file may be slow, the stream is released meanwhile. XLinkStreamSinkToFd waits
+    // for the transfer before the file can be closed
+    pthread_mutex_lock(&progressiveDataMutex);
+    stream->sinkWriting = fd >= 0;
+    stream->sinkWritingFd = fd;
+    pthread_mutex_unlock(&progressiveDataMutex);
+    releaseStream(stream);
+
+    int sc = XLinkPlatformReadToFd(&event->deviceHandle, fd, record, prefixSize, size);
+
+    pthread_mutex_lock(&progressiveDataMutex);
+    if (stream->id == streamId) {
+        stream->sinkWriting = 0;
+        if (sc == X_LINK_PLATFORM_FD_WRITE_FAILED) {
+            stream->sinkFailed = 1;
+        }
+    }
+    pthread_cond_broadcast(&progressiveDataCond);
+    pthread_mutex_unlock(&progressiveDataMutex);
+
+    if (sc == X_LINK_PLATFORM_FD_WRITE_FAILED) {
+        mvLog(MVLOG_ERROR, "Payload of %u bytes of stream %u wasn't written to its sink\n", size, streamId);
+    }
+
+    if (sc < 0) {
+        mvLog(MVLOG_ERROR,"%s() Read failed %d\n", __func__, sc);
+        XLINK_EVENT_NOT_ACKNOWLEDGE(event);
+        return -1;
+    }
+    return 0;
+}
+
+int handleProgressiveData(xLinkEvent_t* event, streamDesc_t* stream, XLinkTimespec trsend, XLinkTimespec treceive)
+{
+    uint8_t* buffer = event->data;
+    const uint32_t size = event->header.size;
+
+    if (addNewPacketToStream(stream, buffer, size, trsend, treceive)) {
+        mvLog(MVLOG_WARN,"No more place in stream. release packet\n");
+        releaseStream(stream);
+        XLinkPlatformDeallocateData(buffer, ALIGN_UP(size, __CACHE_LINE_SIZE), __CACHE_LINE_SIZE);
+        XLINK_EVENT_NOT_ACKNOWLEDGE(event);
+        return -1;
+    }
+
+    pthread_mutex_lock(&progressiveDataMutex);
+    stream->progressiveData = buffer;
+    stream->progressiveSize = 0;
+    if (stream->progressiveFailedData == buffer) {
+        // the broken packet was released and its buffer recycled
+        stream->progressiveFailedData = NULL;
+    }
+    pthread_mutex_unlock(&progressiveDataMutex);
+    releaseStream(stream);
+
+    // readers can take the packet right away and wait for its data with XLinkWaitPacketData
+    DispatcherUnblockEvent(-1, XLINK_READ_REQ, event->header.streamId,
+                           event->deviceHandle.xLinkFD);
+
+    int rc = 0;
+    uint32_t received = 0;
+    while (received < size) {
+        uint32_t chunk = size - received;
+        if (chunk > XLINK_PROGRESSIVE_CHUNK_SIZE) {
+            chunk = XLINK_PROGRESSIVE_CHUNK_SIZE;
+        }
+        const int sc = XLinkPlatformRead(&event->deviceHandle, buffer + received, chunk);
+        if (sc < 0) {
+            mvLog(MVLOG_ERROR,"%s() Read failed %d\n", __func__, sc);
+            rc = -1;
+            break;
+        }
+        received += chunk;
+
+        pthread_mutex_lock(&progressiveDataMutex);
+        stream->progressiveSize = received;
+        pthread_cond_broadcast(&progressiveDataCond);
+        pthread_mutex_unlock(&progressiveDataMutex);
+    }
+
+    // the packet is complete (or never will be), it may be released from now on
+    pthread_mutex_lock(&progressiveDataMutex);
+    stream->progressiveData = NULL;
+    if (rc != 0) {
+        stream->progressiveFailedData = buffer;
+        stream->progressiveFailedSize = received;
+    }
+    pthread_cond_broadcast(&progressiveDataCond);
+    pthread_mutex_unlock(&progressiveDataMutex);
+
+    if (rc != 0) {
+        // the buffer belongs to the stream already, it is freed with the packet
+        XLINK_EVENT_NOT_ACKNOWLEDGE(event);
+    }
+    return rc;
+}
+
+int isDeviceRole(void* fd)
+{
+#ifdef __DEVICE__
+    (void)fd;
+    return 1;
+#else
+    xLinkDesc_t* link = getLink(fd);
+    return link != NULL && link->deviceRole;
+#endif
+}
+
+void recordPeerCapabilities(xLinkEvent_t* event)
+{
+    xLinkDesc_t* link = getLink(event->deviceHandle.xLinkFD);
+    if (link == NULL) {
+        return;
+    }
+
+    // size of the ping carries no meaning unless the capabilities flag is set
+    link->peerCapabilities = event->header.flags.bitField.capabilities ?
+                             event->header.size & XLINK_LOCAL_CAPABILITIES : 0;
+    mvLog(MVLOG_DEBUG, "Peer capabilities 0x%x\n", link->peerCapabilities);
+}
+
+int hasPendingCredit(streamDesc_t* stream)
+{
+    return stream->pendingReleasePackets != 0 || stream->pendingWriteAcks != 0;
+}
+
+void scheduleCredit(xLinkDesc_t* link, streamDesc_t* stream, int wasPending,
+                    uint32_t delayUs, int dueNow)
+{
+    if (!wasPending) {
+        link->pendingCreditStreams++;
+        stream->pendingCreditDeadlineNs = getMonotonicTimestampNs() + (uint64_t)delayUs * 1000;
+    }
+    if (dueNow) {
+        // due right away, sent by the scheduler before it waits for the next event
+        stream->pendingCreditDeadlineNs = 0;
+    }
+}
+
+void deferReleaseCredit(void* fd, streamDesc_t* stream, uint32_t releasedSize)
+{
+    xLinkDesc_t* link = getLink(fd);
+    if (link == NULL) {
+        return;
+    }
+
+    const int wasPending = hasPendingCredit(stream);
+    stream->pendingReleasePackets++;
+    stream->pendingReleaseSize += releasedSize;
+
+    // The remote stalls once it has XLINK_MAX_PACKETS_PER_STREAM packets or its whole
+    // write window (our readSize) in flight, so never hold back more than half of either
+    uint32_t maxPackets = stream->releaseBatchPackets;
+    if (maxPackets > XLINK_MAX_PACKETS_PER_STREAM / 2) {
+        maxPackets = XLINK_MAX_PACKETS_PER_STREAM / 2;
+    }
+    uint32_t maxSize = stream->readSize / 2;
+    if (stream->releaseBatchBytes && stream->releaseBatchBytes < maxSize) {
+        maxSize = stream->releaseBatchBytes;
+    }
+
+    scheduleCredit(link, stream, wasPending, stream->releaseBatchTimeoutUs,
+                   stream->pendingReleasePackets >= maxPackets || stream->pendingReleaseSize >= maxSize);
+}
+
+void deferWriteAck(void* fd, streamId_t streamId)
+{
+    xLinkDesc_t* link = getLink(fd);
+    streamDesc_t* stream = getStreamById(fd, streamId);
+    if (link == NULL || stream == NULL) {
+        return;
+    }
+
+    const int wasPending = hasPendingCredit(stream);
+    stream->pendingWriteAcks++;
+    // the remote doesn't wait for the acknowledgement, so only the delay bounds it
+    scheduleCredit(link, stream, wasPending, XLINK_POSTED_WRITE_ACK_DELAY_US,
+                   stream->pendingWriteAcks >= XLINK_MAX_PACKETS_PER_STREAM / 2);
+    releaseStream(stream);
+}
+
+int takeReleaseCredit(xLinkDesc_t* link, streamDesc_t* slot, xLinkEvent_t* event)
+{
+    if (slot->id == INVALID_STREAM_ID || !hasPendingCredit(slot)) {
+        return 0;
+    }
+
+    streamDesc_t* stream = getStreamById(link->deviceHandle.xLinkFD, slot->id);
+    if (stream == NULL) {
+        return 0;
+    }
+
+    xLinkReleaseCredit_t credit;
+    credit.streamId = stream->id;
+    credit.size = stream->pendingReleaseSize;
+    credit.packets = stream->pendingReleasePackets;
+    credit.writes = stream->pendingWriteAcks;
+    stream->pendingReleaseSize = 0;
+    stream->pendingReleasePackets = 0;
+    stream->pendingWriteAcks = 0;
+    if (link->pendingCreditStreams) {
+        link->pendingCreditStreams--;
+    }
+    releaseStream(stream);
+
+    memcpy(event->header.streamName, &credit, sizeof(credit));
+    event->header.flags.bitField.releaseCredit = 1;
+    return 1;
+}
+
+void attachReleaseCredit(xLinkEvent_t* event)
+{
+    // a fragmented write is dispatched by the remote only once its data is complete
+    if (event->header.flags.bitField.releaseCredit ||
+        event->header.flags.bitField.fragmented ||
+        event->header.type == XLINK_CREATE_STREAM_REQ ||
+        event->header.type == XLINK_CREATE_STREAM_RESP) {
+        return;
+    }
+
+    xLinkDesc_t* link = getLink(event->deviceHandle.xLinkFD);
+    if (link == NULL || link->pendingCreditStreams == 0) {
+        return;
+    }
+
+    for (int index = 0; index < XLINK_MAX_STREAMS; index++) {
+        if (takeReleaseCredit(link, &link->availableStreams[index], event)) {
+            return;
+        }
+    }
+}
+
+int isEventFragment(xLinkEvent_t* event)
+{
+    return event->header.type == XLINK_WRITE_FRAG_REQ ||
+           (event->header.type == XLINK_WRITE_REQ && event->header.flags.bitField.fragmented);
+}
+
+int writeEventData(xLinkEvent_t* event, uint32_t offset, uint32_t size)
+{
+    if (event->fromFile) {
+        return XLinkPlatformWriteFromFd(&event->deviceHandle, event->fileFd,
+                                        event->fileOffset + offset, (int)size);
+    }
+    return XLinkPlatformWrite(&event->deviceHandle, (uint8_t*)event->data + offset, (int)size);
+}
+
+int sendNextFragment(xLinkEvent_t* event)
+{
+    uint32_t size = event->header.size - event->sentSize;
+    if (size > event->fragmentSize) {
+        size = event->fragmentSize;
+    }
+
+    xLinkEventHeader_t header = event->header;
+    header.type = XLINK_WRITE_FRAG_REQ;
+    header.size = size;
+    header.flags.raw = 0;
+
+    int rc = XLinkPlatformWrite(&event->deviceHandle, &header, sizeof(header));
+    if(rc < 0) {
+        mvLog(MVLOG_ERROR,"Write failed (header) (err %d) | event %s\n", rc, TypeToStr(header.type));
+        return rc;
+    }
+    rc = writeEventData(event, event->sentSize, size);
+    if(rc < 0) {
+        mvLog(MVLOG_ERROR,"Write failed %d\n", rc);
+        return rc;
+    }
+
+    event->sentSize += size;
+    if (event->sentSize < event->header.size) {
+        return 1;
+    }
+
+    streamDesc_t* stream = getStreamById(event->deviceHandle.xLinkFD, event->header.streamId);
+    if (stream) {
+        stream->fragmentedWriteInFlight = 0;
+        releaseStream(stream);
+    }
+    // all writes waiting for it, they are reevaluated oldest first
+    for (int index = 0; index < MAX_EVENTS; index++) {
+        if (!DispatcherUnblockEvent(-1, XLINK_WRITE_REQ, event->header.streamId,
+                                    event->deviceHandle.xLinkFD)) {
+            break;
+        }
+    }
+    return 0;
+}
+
+int handleIncomingFragment(xLinkEvent_t* event, XLinkTimespec treceive)
+{
+    mvLog(MVLOG_DEBUG, "%s, size %u, streamId %u.\n", TypeToStr(event->header.type), event->header.size, event->header.streamId);
+
+    int rc = -1;
+    streamDesc_t* stream = getStreamById(event->deviceHandle.xLinkFD, event->header.streamId);
+    ASSERT_XLINK(stream);
+
+    if (event->header.type == XLINK_WRITE_REQ) {
+        // the data follows in fragments, keep what is needed to dispatch the write
+        XLINK_OUT_WITH_LOG_IF(stream->fragmentTotalSize != 0,
+            mvLog(MVLOG_ERROR,"Stream %u is already reassembling a write\n", event->header.streamId));
+        stream->fragmentReceivedSize = 0;
+        stream->fragmentEventId = event->header.id;
+        stream->fragmentFlags = event->header.flags.raw;
+        stream->fragmentSent.tv_sec = event->header.tsecLsb | ((uint64_t)event->header.tsecMsb << 32);
+        stream->fragmentSent.tv_nsec = event->header.tnsec;
+
+        // the data goes where the data of a write in one piece would go, see handleIncomingEvent
+        int handedOut = 0;
+        if (stream->sinkActive) {
+            stream->fragmentSinking = 1;
+            stream->fragmentSinkFd = stream->sinkFd;
+        } else {
+            uint8_t* buffer = XLinkStreamAllocateBuffer(stream, event->header.size);
+            XLINK_OUT_WITH_LOG_IF(buffer == NULL,
+                mvLog(MVLOG_FATAL,"out of memory to receive data of size = %zu\n", event->header.size));
+            if (stream->progressiveDelivery) {
+                if (addNewPacketToStream(stream, buffer, event->header.size, stream->fragmentSent, treceive)) {
+                    XLinkPlatformDeallocateData(buffer, ALIGN_UP(event->header.size, __CACHE_LINE_SIZE), __CACHE_LINE_SIZE);
+                    XLINK_OUT_WITH_LOG_IF(1, mvLog(MVLOG_WARN,"No more place in stream. release packet\n"));
+                }
+                pthread_mutex_lock(&progressiveDataMutex);
+                stream->progressiveData = buffer;
+                stream->progressiveSize = 0;
+                if (stream->progressiveFailedData == buffer) {
+                    stream->progressiveFailedData = NULL;
+                }
+                pthread_mutex_unlock(&progressiveDataMutex);
+                handedOut = 1;
+            } else {
+                stream->fragmentBuffer = buffer;
+            }
+            stream->localFillLevel += event->header.size;
+        }
+        stream->fragmentTotalSize = event->header.size;
+        releaseStream(stream);
+
+        if (handedOut) {
+            // readers take the packet right away and wait for its data with XLinkWaitPacketData
+            DispatcherUnblockEvent(-1, XLINK_READ_REQ, event->header.streamId,
+                                   event->deviceHandle.xLinkFD);
+        }
+        return 1;
+    }
+
+    XLINK_OUT_WITH_LOG_IF(stream->fragmentTotalSize == 0 ||
+                          event->header.size > stream->fragmentTotalSize - stream->fragmentReceivedSize,
+        mvLog(MVLOG_ERROR,"Unexpected fragment of %u bytes for stream %u\n", event->header.size, event->header.streamId));
+
+    const uint32_t offset = stream->fragmentReceivedSize;
+    const uint32_t size = event->header.size;
+    if (stream->fragmentSinking) {
+        XLinkSinkRecord_t record;
+        record.length = stream->fragmentTotalSize;
+        record.tRemoteSent = stream->fragmentSent;
+        record.tReceived = treceive;
+        // a sink replaced meanwhile gets nothing more of the write, the rest is dropped
+        const int fd = stream->sinkActive && stream->sinkFd == stream->fragmentSinkFd ? stream->fragmentSinkFd : -1;
+        if (fd < 0) {
+            pthread_mutex_lock(&progressiveDataMutex);
+            stream->sinkFailed = 1;
+            pthread_mutex_unlock(&progressiveDataMutex);
+        }
+        const int sinkRc = handleSinkData(event, stream, fd, offset == 0 ? &record : NULL, size);
+        stream = getStreamById(event->deviceHandle.xLinkFD, event->header.streamId);
+        ASSERT_XLINK(stream);
+        XLINK_OUT_IF(sinkRc);
+    } else if (stream->fragmentBuffer != NULL) {
+        const int sc = XLinkPlatformRead(&event->deviceHandle, stream->fragmentBuffer + offset, size);
+        XLINK_OUT_WITH_LOG_IF(sc < 0, mvLog(MVLOG_ERROR,"%s() Read failed %d\n", __func__, sc));
+    } else {
+        // the packet is handed out, readers waiting for its data need the stream meanwhile
+        uint8_t* data = stream->progressiveData;
+        releaseStream(stream);
+        const int sc = XLinkPlatformRead(&event->deviceHandle, data + offset, size);
+        stream = getStreamById(event->deviceHandle.xLinkFD, event->header.streamId);
+        ASSERT_XLINK(stream);
+        XLINK_OUT_WITH_LOG_IF(sc < 0, mvLog(MVLOG_ERROR,"%s() Read failed %d\n", __func__, sc));
+
+        pthread_mutex_lock(&progressiveDataMutex);
+        stream->progressiveSize = offset + size;
+        pthread_cond_broadcast(&progressiveDataCond);
+        pthread_mutex_unlock(&progressiveDataMutex);
+    }
+    stream->fragmentReceivedSize += size;
+
+    if (stream->fragmentReceivedSize < stream->fragmentTotalSize) {
+        releaseStream(stream);
+        return 1;
+    }
+
+    // complete, dispatch it as the write it was sent as
+    event->header.type = XLINK_WRITE_REQ;
+    event->header.id = stream->fragmentEventId;
+    event->header.size = stream->fragmentTotalSize;
+    event->header.flags.raw = stream->fragmentFlags;
+    if (stream->fragmentSinking) {
+        event->sunk = 1;
+    } else if (stream->fragmentBuffer != NULL) {
+        XLINK_OUT_WITH_LOG_IF(addNewPacketToStream(stream, stream->fragmentBuffer, event->header.size,
+                                                   stream->fragmentSent, treceive),
+            mvLog(MVLOG_WARN,"No more place in stream. release packet\n"));
+        event->data = stream->fragmentBuffer;
+        stream->fragmentBuffer = NULL;
+    } else {
+        // the packet is complete, it may be released from now on
+        pthread_mutex_lock(&progressiveDataMutex);
+        event->data = stream->progressiveData;
+        stream->progressiveData = NULL;
+        pthread_cond_broadcast(&progressiveDataCond);
+        pthread_mutex_unlock(&progressiveDataMutex);
+    }
+    stream->fragmentSinking = 0;
+    stream->fragmentTotalSize = 0;
+    rc = 0;
+
+XLINK_OUT:
+    if(rc != 0) {
+        if(stream->fragmentBuffer != NULL) {
+            XLinkPlatformDeallocateData(stream->fragmentBuffer,
+                ALIGN_UP(stream->fragmentTotalSize, __CACHE_LINE_SIZE), __CACHE_LINE_SIZE);
+            stream->fragmentBuffer = NULL;
+        } else if (stream->fragmentTotalSize != 0 && !stream->fragmentSinking) {
+            // the packet handed out never completes, the buffer is freed with it
+            pthread_mutex_lock(&progressiveDataMutex);
+            stream->progressiveFailedData = stream->progressiveData;
+            stream->progressiveFailedSize = stream->fragmentReceivedSize;
+            stream->progressiveData = NULL;
+            pthread_cond_broadcast(&progressiveDataCond);
+            pthread_mutex_unlock(&progressiveDataMutex);
+        }
+        stream->fragmentSinking = 0;
+        stream->fragmentTotalSize = 0;
+        XLINK_EVENT_NOT_ACKNOWLEDGE(event);
+    }
+    releaseStream(stream);
+
+    return rc;
+}
+
+void applyReleaseCredit(xLinkEvent_t* event)
+{
+    xLinkReleaseCredit_t credit;
+    memcpy(&credit, event->header.streamName, sizeof(credit));
+
+    streamDesc_t* stream = getStreamById(event->deviceHandle.xLinkFD, credit.streamId);
+    if (!stream) {
+        mvLog(MVLOG_DEBUG, "Release credit for already closed stream %u\n", credit.streamId);
+        return;
+    }
+    stream->remoteFillLevel -= credit.size;
+    stream->remoteFillPacketLevel -= credit.packets;
+    stream->postedWritesInFlight -= credit.writes;
+
+    mvLog(MVLOG_DEBUG,"S%d: Got remote release credit of %u packets, %u bytes, %u posted writes, "
+          "remote fill level %u out of %u\n", credit.streamId, credit.packets, credit.size,
+          credit.writes, stream->remoteFillLevel, stream->writeSize);
+    const int unblockClose = stream->closeStreamInitiated && stream->localFillLevel == 0;
+    releaseStream(stream);
+
+    // a batch may make room for many writes, they are reevaluated oldest first
+    for (int index = 0; index < MAX_EVENTS; index++) {
+        if (!DispatcherUnblockEvent(-1, XLINK_WRITE_REQ, credit.streamId,
+                                    event->deviceHandle.xLinkFD)) {
+            break;
+        }
+    }
+    if (unblockClose) {
+        mvLog(MVLOG_DEBUG,"%s() Unblock close STREAM\n", __func__);
+        DispatcherUnblockEvent(-1, XLINK_CLOSE_STREAM_REQ, credit.streamId,
+                               event->deviceHandle.xLinkFD);
+    }
+}
+
 // ------------------------------------
 // Helpers implementation. Begin.
 // ------------------------------------
@@ -0,0 +1,432 @@
+// Copyright (C) 2018-2021 Intel Corporation
+// SPDX-License-Identifier: Apache-2.0
+//
+
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE // fix for warning: implicit declaration of function 'pthread_setname_np'
+#endif
+
+#include "stdio.h"
+#include "stdlib.h"
+
+#if (defined(_WIN32) || defined(_WIN64))
+# include "win_pthread.h"
+#else
+# include <pthread.h>
+#endif
+
+#include "XLink.h"
+#include "XLinkErrorUtils.h"
+
+#ifdef MVLOG_UNIT_NAME
+#undef MVLOG_UNIT_NAME
+#define MVLOG_UNIT_NAME xLink
+#endif
+
+#include "XLinkLog.h"
+
+// A stream holds at most this many packets, so does its fan-out
+#define FANOUT_PACKETS XLINK_MAX_PACKETS_PER_STREAM
+
+typedef struct fanOutSubscriber_t fanOutSubscriber_t;
+
+/**
+ * @brief Packets of a stream read by the library and shared by its subscribers.
+ *        Packets from tail to head are held in the stream, refs counts who didn't let go yet
+ */
+typedef struct {
+    streamId_t streamId;
+    pthread_mutex_t mutex;
+    pthread_cond_t cond;        // broadcast once a packet arrived or the stream ended
+    streamPacketDesc_t* packets[FANOUT_PACKETS];
+    uint32_t refs[FANOUT_PACKETS];
+    uint64_t head;              // sequence number of the next packet read from the stream
+    uint64_t tail;              // oldest packet not released to the stream yet
+    fanOutSubscriber_t* subscribers[XLINK_FANOUT_MAX_SUBSCRIBERS];
+    int ended;
+    uint32_t users;             // subscribers and the reading thread, guarded by fanOutsMutex
+} fanOut_t;
+
+struct fanOutSubscriber_t {
+    fanOut_t* fanOut;
+    uint32_t maxLag;
+    uint64_t next;              // sequence number of the next packet to read
+    // packets read and not released yet, oldest first
+    uint64_t held[FANOUT_PACKETS];
+    uint32_t heldFirst;
+    uint32_t heldCount;
+    uint32_t dropped;           // since the previous read
+    int closing;                // unsubscribed, calls in progress fail
+    uint32_t users;             // the subscription and calls in progress, guarded by fanOutsMutex
+};
+
+static pthread_mutex_t fanOutsMutex = PTHREAD_MUTEX_INITIALIZER;
+// a stream with subscribers has one fan-out
+static fanOut_t* fanOuts[XLINK_FANOUT_MAX_STREAMS];
+static fanOutSubscriber_t* subscribers[XLINK_FANOUT_MAX_SUBSCRIBERS];
+
+// ------------------------------------
+// Helpers declaration. Begin.
+// ------------------------------------
+
+static fanOut_t* getFanOut(streamId_t streamId);
+static void putFanOut(fanOut_t* fanOut);
+static void* fanOutRun(void* ctx);
+static void dropLaggedPackets(fanOut_t* fanOut, fanOutSubscriber_t* subscriber);
+static void dropReference(fanOut_t* fanOut, uint64_t seq);
+static uint32_t collectReleasable(fanOut_t* fanOut);
+static void releaseToStream(streamId_t streamId, uint32_t count);
+static fanOutSubscriber_t* getSubscriber(streamId_t subscriberId);
+static void putSubscriber(fanOutSubscriber_t* subscriber);
+
+// ------------------------------------
+// Helpers declaration. End.
+// ------------------------------------
+
+
+
+// ------------------------------------
+// API implementation. Begin.
+// ------------------------------------
+
+streamId_t XLinkFanOutSubscribe(streamId_t const streamId, const XLinkFanOutOptions_t* options)
+{
+    XLINK_RET_ERR_IF(streamId == INVALID_STREAM_ID, INVALID_STREAM_ID);
+
+    fanOutSubscriber_t* subscriber = (fanOutSubscriber_t*)calloc(1, sizeof(fanOutSubscriber_t));
+    XLINK_RET_ERR_IF(subscriber == NULL, INVALID_STREAM_ID);
+    subscriber->maxLag = options != NULL ? options->maxLagPackets : 0;
+    // the subscription
+    subscriber->users = 1;
+
+    streamId_t subscriberId = INVALID_STREAM_ID;
+    pthread_mutex_lock(&fanOutsMutex);
+    for(int i = 0; i < XLINK_FANOUT_MAX_SUBSCRIBERS; i++) {
+        if(subscribers[i] == NULL) {
+            subscriberId = (streamId_t)i;
+            break;
+        }
+    }
+    fanOut_t* fanOut = subscriberId != INVALID_STREAM_ID ? getFanOut(streamId) : NULL;
+    if(fanOut != NULL) {
+        subscriber->fanOut = fanOut;
+        subscribers[subscriberId] = subscriber;
+
+        pthread_mutex_lock(&fanOut->mutex);
+        subscriber->next = fanOut->head;
+        for(int i = 0; i < XLINK_FANOUT_MAX_SUBSCRIBERS; i++) {
+            if(fanOut->subscribers[i] == NULL) {
+                fanOut->subscribers[i] = subscriber;
+                break;
+            }
+        }
+        pthread_mutex_unlock(&fanOut->mutex);
+    }
+    pthread_mutex_unlock(&fanOutsMutex);
+
+    if(fanOut == NULL) {
+        mvLog(MVLOG_ERROR, "Stream 0x%x can't be subscribed to", streamId);
+        free(subscriber);
+        return INVALID_STREAM_ID;
+    }
+    return subscriberId;
+}
+
+XLinkError_t XLinkFanOutReadData(streamId_t const subscriberId, streamPacketDesc_t** packet, uint32_t* dropped)
+{
+    XLINK_RET_IF(packet == NULL);
+    fanOutSubscriber_t* subscriber = getSubscriber(subscriberId);
+    XLINK_RET_IF(subscriber == NULL);
+
+    fanOut_t* fanOut = subscriber->fanOut;
+    pthread_mutex_lock(&fanOut->mutex);
+    while(subscriber->next >= fanOut->head && !fanOut->ended && !subscriber->closing) {
+        pthread_cond_wait(&fanOut->cond, &fanOut->mutex);
+    }
+    if(subscriber->closing || subscriber->next >= fanOut->head) {
+        XLinkError_t rc = subscriber->closing ? X_LINK_ERROR : X_LINK_COMMUNICATION_NOT_OPEN;
+        pthread_mutex_unlock(&fanOut->mutex);
+        putSubscriber(subscriber);
+        return rc;
+    }
+
+    uint64_t seq = subscriber->next++;
+    subscriber->held[(subscriber->heldFirst + subscriber->heldCount) % FANOUT_PACKETS] = seq;
+    subscriber->heldCount++;
+    *packet = fanOut->packets[seq % FANOUT_PACKETS];
+    if(dropped != NULL) {
+        *dropped = subscriber->dropped;
+    }
+    subscriber->dropped = 0;
+    pthread_mutex_unlock(&fanOut->mutex);
+
+    putSubscriber(subscriber);
+    return X_LINK_SUCCESS;
+}
+
+XLinkError_t XLinkFanOutReleaseData(streamId_t const subscriberId)
+{
+    fanOutSubscriber_t* subscriber = getSubscriber(subscriberId);
+    XLINK_RET_IF(subscriber == NULL);
+
+    fanOut_t* fanOut = subscriber->fanOut;
+    pthread_mutex_lock(&fanOut->mutex);
+    if(subscriber->closing || subscriber->heldCount == 0) {
+        pthread_mutex_unlock(&fanOut->mutex);
+        putSubscriber(subscriber);
+        mvLog(MVLOG_ERROR, "Subscriber %u holds no packet", subscriberId);
+        return X_LINK_ERROR;
+    }
+    uint64_t seq = subscriber->held[subscriber->heldFirst];
+    subscriber->heldFirst = (subscriber->heldFirst + 1) % FANOUT_PACKETS;
+    subscriber->heldCount--;
+    dropReference(fanOut, seq);
+    uint32_t releasable = collectReleasable(fanOut);
+    // once the stream ended, there is nothing to release
+    int ended = fanOut->ended;
+    pthread_mutex_unlock(&fanOut->mutex);
+
+    if(!ended) {
+        releaseToStream(fanOut->streamId, releasable);
+    }
+    putSubscriber(subscriber);
+    return X_LINK_SUCCESS;
+}
+
+XLinkError_t XLinkFanOutUnsubscribe(streamId_t const subscriberId)
+{
+    pthread_mutex_lock(&fanOutsMutex);
+    fanOutSubscriber_t* subscriber = NULL;
+    if(subscriberId < XLINK_FANOUT_MAX_SUBSCRIBERS) {
+        subscriber = subscribers[subscriberId];
+        subscribers[subscriberId] = NULL;
+    }
+    if(subscriber == NULL) {
+        pthread_mutex_unlock(&fanOutsMutex);
+        return X_LINK_ERROR;
+    }
+
+    fanOut_t* fanOut = subscriber->fanOut;
+    streamId_t streamId = fanOut->streamId;
+    pthread_mutex_lock(&fanOut->mutex);
+    for(int i = 0; i < XLINK_FANOUT_MAX_SUBSCRIBERS; i++) {
+        if(fanOut->subscribers[i] == subscriber) {
+            fanOut->subscribers[i] = NULL;
+        }
+    }
+    for(uint32_t i = 0; i < subscriber->heldCount; i++) {
+        dropReference(fanOut, subscriber->held[(subscriber->heldFirst + i) % FANOUT_PACKETS]);
+    }
+    for(uint64_t seq = subscriber->next; seq < fanOut->head; seq++) {
+        dropReference(fanOut, seq);
+    }
+    uint32_t releasable = collectReleasable(fanOut);
+    int ended = fanOut->ended;
+    // wakes up a read of the subscriber, which fails then
+    subscriber->closing = 1;
+    pthread_cond_broadcast(&fanOut->cond);
+    pthread_mutex_unlock(&fanOut->mutex);
+    pthread_mutex_unlock(&fanOutsMutex);
+
+    // once the stream ended, there is nothing to release
+    if(!ended) {
+        releaseToStream(streamId, releasable);
+    }
+    putSubscriber(subscriber);
+    return X_LINK_SUCCESS;
+}
+
+// ------------------------------------
+// API implementation. End.
+// ------------------------------------
+
+
+
+// ------------------------------------
+// Helpers implementation. Begin.
+// ------------------------------------
+
+// Returns the fan-out of the stream, starting it on the first subscription. Holds fanOutsMutex
+static fanOut_t* getFanOut(streamId_t streamId)
+{
+    int freeIndex = -1;
+    for(int i = 0; i < XLINK_FANOUT_MAX_STREAMS; i++) {
+        if(fanOuts[i] != NULL && fanOuts[i]->streamId == streamId) {
+            fanOuts[i]->users++;
+            return fanOuts[i];
+        }
+        if(fanOuts[i] == NULL && freeIndex < 0) {
+            freeIndex = i;
+        }
+    }
+    if(freeIndex < 0) {
+        return NULL;
+    }
+
+    fanOut_t* fanOut = (fanOut_t*)calloc(1, sizeof(fanOut_t));
+    if(fanOut == NULL) {
+        return NULL;
+    }
+    fanOut->streamId = streamId;
+    if(pthread_mutex_init(&fanOut->mutex, NULL) != 0) {
+        free(fanOut);
+        return NULL;
+    }
+    if(pthread_cond_init(&fanOut->cond, NULL) != 0) {
+        pthread_mutex_destroy(&fanOut->mutex);
+        free(fanOut);
+        return NULL;
+    }
+    // the subscriber and the reading thread
+    fanOut->users = 2;
+
+    pthread_t thread;
+    int sc = pthread_create(&thread, NULL, fanOutRun, fanOut);
+    if(sc) {
+        mvLog(MVLOG_ERROR, "Fan-out thread creation failed with error: %d", sc);
+        pthread_cond_destroy(&fanOut->cond);
+        pthread_mutex_destroy(&fanOut->mutex);
+        free(fanOut);
+        return NULL;
+    }
+#ifndef __APPLE__
+    if(pthread_setname_np(thread, "XLinkFanOutThr") != 0) {
+        perror("Setting name for fan-out thread failed");
+    }
+#endif
+    pthread_detach(thread);
+
+    fanOuts[freeIndex] = fanOut;
+    return fanOut;
+}
+
+// Holds fanOutsMutex
+static void putFanOut(fanOut_t* fanOut)
+{
+    if(--fanOut->users > 0) {
+        return;
+    }
+    pthread_cond_destroy(&fanOut->cond);
+    pthread_mutex_destroy(&fanOut->mutex);
+    free(fanOut);
+}
+
+static void* fanOutRun(void* ctx)
+{
+    fanOut_t* fanOut = (fanOut_t*)ctx;
+    streamPacketDesc_t* packet = NULL;
+
+    // the packets stay in the stream, which holds back the remote until every subscriber let go
+    while(XLinkReadData(fanOut->streamId, &packet) == X_LINK_SUCCESS) {
+        pthread_mutex_lock(&fanOut->mutex);
+        uint32_t index = (uint32_t)(fanOut->head % FANOUT_PACKETS);
+        fanOut->packets[index] = packet;
+        fanOut->refs[index] = 0;
+        for(int i = 0; i < XLINK_FANOUT_MAX_SUBSCRIBERS; i++) {
+            if(fanOut->subscribers[i] != NULL) {
+                fanOut->refs[index]++;
+            }
+        }
+        fanOut->head++;
+        for(int i = 0; i < XLINK_FANOUT_MAX_SUBSCRIBERS; i++) {
+            if(fanOut->subscribers[i] != NULL) {
+                dropLaggedPackets(fanOut, fanOut->subscribers[i]);
+            }
+        }
+        // without subscribers the packet is released right away
+        uint32_t releasable = collectReleasable(fanOut);
+        pthread_cond_broadcast(&fanOut->cond);
+        pthread_mutex_unlock(&fanOut->mutex);
+
+        releaseToStream(fanOut->streamId, releasable);
+    }
+    mvLog(MVLOG_DEBUG, "Fan-out of stream 0x%x ended", fanOut->streamId);
+
+    pthread_mutex_lock(&fanOutsMutex);
+    for(int i = 0; i < XLINK_FANOUT_MAX_STREAMS; i++) {
+        if(fanOuts[i] == fanOut) {
+            fanOuts[i] = NULL;
+        }
+    }
+    pthread_mutex_lock(&fanOut->mutex);
+    fanOut->ended = 1;
+    pthread_cond_broadcast(&fanOut->cond);
+    pthread_mutex_unlock(&fanOut->mutex);
+    putFanOut(fanOut);
+    pthread_mutex_unlock(&fanOutsMutex);
+    return NULL;
+}
+
+// Holds fanOut->mutex
+static void dropLaggedPackets(fanOut_t* fanOut, fanOutSubscriber_t* subscriber)
+{
+    if(subscriber->maxLag == 0) {
+        return;
+    }
+    while(fanOut->head - subscriber->next > subscriber->maxLag) {
+        dropReference(fanOut, subscriber->next);
+        subscriber->next++;
+        subscriber->dropped++;
+    }
+}
+
+// Holds fanOut->mutex
+static void dropReference(fanOut_t* fanOut, uint64_t seq)
+{
+    if(fanOut->refs[seq % FANOUT_PACKETS] > 0) {
+        fanOut->refs[seq % FANOUT_PACKETS]--;
+    }
+}
+
+// Returns how many of the oldest packets nobody refers to anymore. Holds fanOut->mutex
+static uint32_t collectReleasable(fanOut_t* fanOut)
+{
+    // XLinkReleaseData releases the oldest packet of the stream, so they are released in order
+    uint32_t releasable = 0;
+    while(fanOut->tail < fanOut->head && fanOut->refs[fanOut->tail % FANOUT_PACKETS] == 0) {
+        fanOut->tail++;
+        releasable++;
+    }
+    return releasable;
+}
+
+static void releaseToStream(streamId_t streamId, uint32_t count)
+{
+    for(uint32_t i = 0; i < count; i++) {
+        if(XLinkReleaseData(streamId) != X_LINK_SUCCESS) {
+            break;
+        }
+    }
+}
+
+// Takes a reference on the subscriber, which XLinkFanOutUnsubscribe doesn't free meanwhile
+static fanOutSubscriber_t* getSubscriber(streamId_t subscriberId)
+{
+    fanOutSubscriber_t* subscriber = NULL;
+    pthread_mutex_lock(&fanOutsMutex);
+    if(subscriberId < XLINK_FANOUT_MAX_SUBSCRIBERS) {
+        subscriber = subscribers[subscriberId];
+    }
+    if(subscriber != NULL) {
+        subscriber->users++;
+    }
+    pthread_mutex_unlock(&fanOutsMutex);
+    return subscriber;
+}
+
+// The last reference frees the subscriber, and its reference on the fan-out
+static void putSubscriber(fanOutSubscriber_t* subscriber)
+{
+    pthread_mutex_lock(&fanOutsMutex);
+    if(--subscriber->users > 0) {
+        pthread_mutex_unlock(&fanOutsMutex);
+        return;
+    }
+    putFanOut(subscriber->fanOut);
+    pthread_mutex_unlock(&fanOutsMutex);
+    free(subscriber);
+}
+
+// ------------------------------------
+// Helpers implementation. End.
+// ------------------------------------
@@ -0,0 +1,169 @@
+// Copyright (C) 2018-2021 Intel Corporation
+// SPDX-License-Identifier: Apache-2.0
+//
+
+#include <string.h>
+
+#include "XLinkHistogram.h"
+#include "XLinkAtomic.h"
+
+#define SUB_BUCKETS (1u << XLINK_HISTOGRAM_SUB_BITS)
+#define MAX_MSB (XLINK_HISTOGRAM_BUCKETS / SUB_BUCKETS + XLINK_HISTOGRAM_SUB_BITS - 2)
+
+// ------------------------------------
+// Helpers declaration. Begin.
+// ------------------------------------
+
+static uint32_t getMsb(uint64_t value);
+static uint32_t getBucket(uint64_t ns);
+static uint64_t getBucketUpperBound(uint32_t bucket);
+static uint64_t getPercentile(const uint32_t* counts, uint64_t total, double percentile);
+static void recordInterval(XLinkHistogram_t* histogram, uint64_t startNs, uint64_t endNs);
+
+// ------------------------------------
+// Helpers declaration. End.
+// ------------------------------------
+
+void XLinkHistogramRecord(XLinkHistogram_t* histogram, uint64_t ns)
+{
+    XLINK_ATOMIC_ADD_U32(&histogram->counts[getBucket(ns)], 1);
+}
+
+void XLinkHistogramSummarize(const XLinkHistogram_t* histogram, XLinkLatencyProf_t* prof)
+{
+    uint32_t counts[XLINK_HISTOGRAM_BUCKETS];
+    uint64_t total = 0;
+    uint32_t highest = 0;
+    for (uint32_t bucket = 0; bucket < XLINK_HISTOGRAM_BUCKETS; bucket++) {
+        counts[bucket] = XLINK_ATOMIC_LOAD_U32(&histogram->counts[bucket]);
+        total += counts[bucket];
+        if (counts[bucket]) {
+            highest = bucket;
+        }
+    }
+
+    memset(prof, 0, sizeof(*prof));
+    prof->count = total;
+    if (total == 0) {
+        return;
+    }
+    prof->p50Ns = getPercentile(counts, total, 0.5);
+    prof->p90Ns = getPercentile(counts, total, 0.9);
+    prof->p99Ns = getPercentile(counts, total, 0.99);
+    prof->p999Ns = getPercentile(counts, total, 0.999);
+    prof->maxNs = getBucketUpperBound(highest);
+}
+
+void XLinkLatencySummarize(const xLinkLatencyHistograms_t* latency, XLinkStreamProf_t* prof)
+{
+    XLinkHistogramSummarize(&latency->histograms[XLINK_LATENCY_READ_WAIT], &prof->readWait);
+    XLinkHistogramSummarize(&latency->histograms[XLINK_LATENCY_WRITE], &prof->writeCompletion);
+    XLinkHistogramSummarize(&latency->histograms[XLINK_LATENCY_RELEASE], &prof->release);
+}
+
+void XLinkStagesRecord(xLinkStageHistograms_t* stages, const xLinkEventStamps_t* stamps)
+{
+    recordInterval(&stages->histograms[X_LINK_STAGE_QUEUE], stamps->enqueueNs, stamps->dispatchNs);
+    recordInterval(&stages->histograms[X_LINK_STAGE_BLOCKED], stamps->dispatchNs, stamps->unblockNs);
+    recordInterval(&stages->histograms[X_LINK_STAGE_WAKEUP], stamps->completeNs, stamps->wakeNs);
+
+    uint64_t sendNs = stamps->sendEndNs ? stamps->sendEndNs - stamps->sendStartNs : 0;
+    if (stamps->receiveEndNs) {
+        // Remote events: their data is received before they're queued, the
+        // response is sent while they're handled
+        if (stamps->receiveStartNs) {
+            XLinkHistogramRecord(&stages->histograms[X_LINK_STAGE_TRANSPORT],
+                                 stamps->receiveEndNs - stamps->receiveStartNs + sendNs);
+        }
+        if (stamps->dispatchNs && stamps->completeNs >= stamps->dispatchNs + sendNs) {
+            XLinkHistogramRecord(&stages->histograms[X_LINK_STAGE_RESPONSE],
+                                 stamps->completeNs - stamps->dispatchNs - sendNs);
+        }
+        return;
+    }
+
+    recordInterval(&stages->histograms[X_LINK_STAGE_TRANSPORT], stamps->sendStartNs, stamps->sendEndNs);
+    uint64_t handledNs = stamps->dispatchNs;
+    if (stamps->unblockNs > handledNs) {
+        handledNs = stamps->unblockNs;
+    }
+    if (stamps->sendEndNs > handledNs) {
+        handledNs = stamps->sendEndNs;
+    }
+    recordInterval(&stages->histograms[X_LINK_STAGE_RESPONSE], handledNs, stamps->completeNs);
+}
+
+void XLinkStagesSummarize(const xLinkStageHistograms_t* stages, XLinkStageProf_t* prof)
+{
+    for (int stage = 0; stage < X_LINK_STAGE_COUNT; stage++) {
+        XLinkHistogramSummarize(&stages->histograms[stage], &prof->stages[stage]);
+    }
+}
+
+// ------------------------------------
+// Helpers implementation. Begin.
+// ------------------------------------
+
+uint32_t getMsb(uint64_t value)
+{
+#if defined(__GNUC__) || defined(__clang__)
+    return 63 - __builtin_clzll(value);
+#else
+    uint32_t msb = 0;
+    while (value >>= 1) {
+        msb++;
+    }
+    return msb;
+#endif
+}
+
+uint32_t getBucket(uint64_t ns)
+{
+    if (ns < SUB_BUCKETS) {
+        return (uint32_t)ns;
+    }
+    uint32_t msb = getMsb(ns);
+    if (msb > MAX_MSB) {
+        return XLINK_HISTOGRAM_BUCKETS - 1;
+    }
+    uint32_t sub = (uint32_t)(ns >> (msb - XLINK_HISTOGRAM_SUB_BITS)) & (SUB_BUCKETS - 1);
+    return (msb - XLINK_HISTOGRAM_SUB_BITS + 1) * SUB_BUCKETS + sub;
+}
+
+uint64_t getBucketUpperBound(uint32_t bucket)
+{
+    if (bucket < SUB_BUCKETS) {
+        return bucket;
+    }
+    uint32_t msb = bucket / SUB_BUCKETS + XLINK_HISTOGRAM_SUB_BITS - 1;
+    uint64_t sub = bucket % SUB_BUCKETS;
+    return ((SUB_BUCKETS + sub + 1) << (msb - XLINK_HISTOGRAM_SUB_BITS)) - 1;
+}
+
+uint64_t getPercentile(const uint32_t* counts, uint64_t total, double percentile)
+{
+    uint64_t rank = (uint64_t)(percentile * total);
+    if (rank >= total) {
+        rank = total - 1;
+    }
+    uint64_t seen = 0;
+    for (uint32_t bucket = 0; bucket < XLINK_HISTOGRAM_BUCKETS; bucket++) {
+        seen += counts[bucket];
+        if (seen > rank) {
+            return getBucketUpperBound(bucket);
+        }
+    }
+    return getBucketUpperBound(XLINK_HISTOGRAM_BUCKETS - 1);
+}
+
+void recordInterval(XLinkHistogram_t* histogram, uint64_t startNs, uint64_t endNs)
+{
+    // stages an event didn't pass aren't recorded
+    if (startNs && endNs >= startNs) {
+        XLinkHistogramRecord(histogram, endNs - startNs);
+    }
+}
+
+// ------------------------------------
+// Helpers implementation. End.
+// ------------------------------------
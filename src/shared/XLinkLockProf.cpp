@@ -0,0 +1,54 @@
+#include <atomic>
+#include <chrono>
+
+#include "XLinkLockProf.h"
+
+namespace {
+
+struct LockCounters {
+    std::atomic<uint64_t> acquisitions{0};
+    std::atomic<uint64_t> totalWaitNs{0};
+    std::atomic<uint64_t> maxWaitNs{0};
+};
+
+std::atomic<bool> enabled{false};
+LockCounters counters[X_LINK_LOCK_COUNT];
+
+} // namespace
+
+void XLinkLockProfEnable(int enable) {
+    if(enable) {
+        for(auto& lock : counters) {
+            lock.acquisitions = 0;
+            lock.totalWaitNs = 0;
+            lock.maxWaitNs = 0;
+        }
+    }
+    enabled = enable != 0;
+}
+
+int XLinkLockProfEnabled(void) {
+    return enabled.load(std::memory_order_relaxed);
+}
+
+uint64_t XLinkLockProfNow(void) {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+void XLinkLockProfRecord(XLinkLock_t lock, uint64_t waitNs) {
+    if(lock < 0 || lock >= X_LINK_LOCK_COUNT) return;
+    auto& counter = counters[lock];
+    counter.acquisitions.fetch_add(1, std::memory_order_relaxed);
+    counter.totalWaitNs.fetch_add(waitNs, std::memory_order_relaxed);
+    uint64_t max = counter.maxWaitNs.load(std::memory_order_relaxed);
+    while(waitNs > max && !counter.maxWaitNs.compare_exchange_weak(max, waitNs, std::memory_order_relaxed)) {
+    }
+}
+
+void XLinkLockProfGet(XLinkLock_t lock, XLinkLockProf_t* prof) {
+    auto& counter = counters[lock];
+    prof->acquisitions = counter.acquisitions;
+    prof->totalWaitNs = counter.totalWaitNs;
+    prof->maxWaitNs = counter.maxWaitNs;
+}
@@ -10,6 +10,7 @@
 #include "XLinkPrivateFields.h"
 #include "XLinkPrivateDefines.h"
 #include "XLinkErrorUtils.h"
+#include "XLinkLockProf.h"
 
 #ifdef MVLOG_UNIT_NAME
 #undef MVLOG_UNIT_NAME
@@ -20,7 +21,7 @@
 
 xLinkDesc_t* getLinkById(linkId_t id)
 {
-    XLINK_RET_ERR_IF(pthread_mutex_lock(&availableXLinksMutex) != 0, NULL);
+    XLINK_RET_ERR_IF(XLinkProfMutexLock(&availableXLinksMutex, X_LINK_LOCK_LINKS) != 0, NULL);
 
     int i;
     for (i = 0; i < MAX_LINKS; i++) {
@@ -37,7 +38,7 @@ xLinkDesc_t* getLinkById(linkId_t id)
 xLinkDesc_t* getLink(void* fd)
 {
 
-    XLINK_RET_ERR_IF(pthread_mutex_lock(&availableXLinksMutex) != 0, NULL);
+    XLINK_RET_ERR_IF(XLinkProfMutexLock(&availableXLinksMutex, X_LINK_LOCK_LINKS) != 0, NULL);
 
     int i;
     for (i = 0; i < MAX_LINKS; i++) {
@@ -115,6 +116,38 @@ void releaseStream(streamDesc_t* stream)
     }
 }
 
+streamDesc_t* peekStreamById(xLinkDesc_t* link, streamId_t id)
+{
+    for (int i = 0; i < XLINK_MAX_STREAMS; i++) {
+        if (link->availableStreams[i].id == id) {
+            return &link->availableStreams[i];
+        }
+    }
+    return NULL;
+}
+
+XLinkError_t interruptStreamReads(streamId_t streamId, int interrupt)
+{
+    // callers retry until the stream is gone, so that isn't logged
+    xLinkDesc_t* link = getLinkById(EXTRACT_LINK_ID(streamId));
+    if (link == NULL || getXLinkState(link) != XLINK_UP) {
+        return X_LINK_COMMUNICATION_NOT_OPEN;
+    }
+    streamId_t streamIdOnly = EXTRACT_STREAM_ID(streamId);
+
+    streamDesc_t* stream = getStreamById(link->deviceHandle.xLinkFD, streamIdOnly);
+    if (stream == NULL) {
+        return X_LINK_ERROR;
+    }
+    stream->readsInterrupted = interrupt ? 1 : 0;
+    releaseStream(stream);
+
+    if (interrupt) {
+        DispatcherUnblockEvent(-1, XLINK_READ_REQ, streamIdOnly, link->deviceHandle.xLinkFD);
+    }
+    return X_LINK_SUCCESS;
+}
+
 xLinkState_t getXLinkState(xLinkDesc_t* link)
 {
     XLINK_RET_ERR_IF(link == NULL, XLINK_NOT_INIT);
@@ -0,0 +1,97 @@
+// Copyright (C) 2018-2021 Intel Corporation
+// SPDX-License-Identifier: Apache-2.0
+//
+
+#include "XLinkProfCounters.h"
+#include "XLinkAtomic.h"
+#include "XLinkTime.h"
+
+// ------------------------------------
+// Helpers declaration. Begin.
+// ------------------------------------
+
+static void beginUpdate(xLinkProfAccumulator_t* accumulator);
+static void endUpdate(xLinkProfAccumulator_t* accumulator);
+
+// ------------------------------------
+// Helpers declaration. End.
+// ------------------------------------
+
+void XLinkProfAccumulatorReset(xLinkProfAccumulator_t* accumulator)
+{
+    beginUpdate(accumulator);
+    XLINK_ATOMIC_STORE_U64(&accumulator->reads, 0);
+    XLINK_ATOMIC_STORE_U64(&accumulator->writes, 0);
+    XLINK_ATOMIC_STORE_U64(&accumulator->readBytes, 0);
+    XLINK_ATOMIC_STORE_U64(&accumulator->writeBytes, 0);
+    XLINK_ATOMIC_STORE_U64(&accumulator->readNs, 0);
+    XLINK_ATOMIC_STORE_U64(&accumulator->writeNs, 0);
+    XLINK_ATOMIC_STORE_U64(&accumulator->startNs, getMonotonicTimestampNs());
+    endUpdate(accumulator);
+}
+
+void XLinkProfAccumulatorAddRead(xLinkProfAccumulator_t* accumulator, uint64_t bytes, uint64_t ns)
+{
+    beginUpdate(accumulator);
+    XLINK_ATOMIC_ADD_U64(&accumulator->reads, 1);
+    XLINK_ATOMIC_ADD_U64(&accumulator->readBytes, bytes);
+    XLINK_ATOMIC_ADD_U64(&accumulator->readNs, ns);
+    endUpdate(accumulator);
+}
+
+void XLinkProfAccumulatorAddWrite(xLinkProfAccumulator_t* accumulator, uint64_t bytes, uint64_t ns)
+{
+    beginUpdate(accumulator);
+    XLINK_ATOMIC_ADD_U64(&accumulator->writes, 1);
+    XLINK_ATOMIC_ADD_U64(&accumulator->writeBytes, bytes);
+    XLINK_ATOMIC_ADD_U64(&accumulator->writeNs, ns);
+    endUpdate(accumulator);
+}
+
+void XLinkProfAccumulatorSnapshot(const xLinkProfAccumulator_t* accumulator, XLinkProfCounters_t* counters)
+{
+    // Consistent once every update started before the end of the reads had finished
+    // before their beginning. Updates take a few ns, so a retry or two at most is typical
+    uint64_t finished, started;
+    do {
+        finished = XLINK_ATOMIC_LOAD_U64(&accumulator->finished);
+        XLINK_ATOMIC_FENCE_ACQUIRE();
+        counters->reads = XLINK_ATOMIC_LOAD_U64(&accumulator->reads);
+        counters->writes = XLINK_ATOMIC_LOAD_U64(&accumulator->writes);
+        counters->totalReadBytes = XLINK_ATOMIC_LOAD_U64(&accumulator->readBytes);
+        counters->totalWriteBytes = XLINK_ATOMIC_LOAD_U64(&accumulator->writeBytes);
+        counters->totalReadNs = XLINK_ATOMIC_LOAD_U64(&accumulator->readNs);
+        counters->totalWriteNs = XLINK_ATOMIC_LOAD_U64(&accumulator->writeNs);
+        counters->elapsedNs = getMonotonicTimestampNs() - XLINK_ATOMIC_LOAD_U64(&accumulator->startNs);
+        XLINK_ATOMIC_FENCE_ACQUIRE();
+        started = XLINK_ATOMIC_LOAD_U64(&accumulator->started);
+    } while (started != finished);
+}
+
+void XLinkProfCountersToProf(const XLinkProfCounters_t* counters, XLinkProf_t* prof)
+{
+    prof->totalReadBytes = counters->totalReadBytes;
+    prof->totalWriteBytes = counters->totalWriteBytes;
+    prof->totalReadTime = (float)(counters->totalReadNs / 1000000000.0);
+    prof->totalWriteTime = (float)(counters->totalWriteNs / 1000000000.0);
+}
+
+// ------------------------------------
+// Helpers implementation. Begin.
+// ------------------------------------
+
+static void beginUpdate(xLinkProfAccumulator_t* accumulator)
+{
+    XLINK_ATOMIC_ADD_U64(&accumulator->started, 1);
+    XLINK_ATOMIC_FENCE_RELEASE();
+}
+
+static void endUpdate(xLinkProfAccumulator_t* accumulator)
+{
+    XLINK_ATOMIC_FENCE_RELEASE();
+    XLINK_ATOMIC_ADD_U64(&accumulator->finished, 1);
+}
+
+// ------------------------------------
+// Helpers implementation. End.
+// ------------------------------------
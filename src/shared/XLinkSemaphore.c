@@ -5,6 +5,7 @@
 #include <errno.h>
 #include "XLinkSemaphore.h"
 #include "XLinkErrorUtils.h"
+#include "XLinkLockProf.h"
 #include "XLinkLog.h"
 
 static pthread_mutex_t ref_mutex = PTHREAD_MUTEX_INITIALIZER;
@@ -12,7 +13,7 @@ static pthread_cond_t ref_cond = PTHREAD_COND_INITIALIZER;
 
 int XLink_sem_inc(XLink_sem_t* sem)
 {
-    XLINK_RET_IF_FAIL(pthread_mutex_lock(&ref_mutex));
+    XLINK_RET_IF_FAIL(XLinkProfMutexLock(&ref_mutex, X_LINK_LOCK_SEMAPHORE_REFS));
     if (sem->refs < 0) {
         // Semaphore has been already destroyed
         XLINK_RET_IF_FAIL(pthread_mutex_unlock(&ref_mutex));
@@ -27,7 +28,7 @@ int XLink_sem_inc(XLink_sem_t* sem)
 
 int XLink_sem_dec(XLink_sem_t* sem)
 {
-    XLINK_RET_IF_FAIL(pthread_mutex_lock(&ref_mutex));
+    XLINK_RET_IF_FAIL(XLinkProfMutexLock(&ref_mutex, X_LINK_LOCK_SEMAPHORE_REFS));
     if (sem->refs < 1) {
         // Can't decrement reference count if there are no waiters
         // or semaphore has been already destroyed
@@ -48,7 +49,7 @@ int XLink_sem_init(XLink_sem_t* sem, int pshared, unsigned int value)
     XLINK_RET_ERR_IF(sem == NULL, -1);
 
     XLINK_RET_IF_FAIL(sem_init(&sem->psem, pshared, value));
-    XLINK_RET_IF_FAIL(pthread_mutex_lock(&ref_mutex));
+    XLINK_RET_IF_FAIL(XLinkProfMutexLock(&ref_mutex, X_LINK_LOCK_SEMAPHORE_REFS));
     sem->refs = 0;
     XLINK_RET_IF_FAIL(pthread_mutex_unlock(&ref_mutex));
 
@@ -59,7 +60,7 @@ int XLink_sem_destroy(XLink_sem_t* sem)
 {
     XLINK_RET_ERR_IF(sem == NULL, -1);
 
-    XLINK_RET_IF_FAIL(pthread_mutex_lock(&ref_mutex));
+    XLINK_RET_IF_FAIL(XLinkProfMutexLock(&ref_mutex, X_LINK_LOCK_SEMAPHORE_REFS));
     if (sem->refs < 0) {
         // Semaphore has been already destroyed
         XLINK_RET_IF_FAIL(pthread_mutex_unlock(&ref_mutex));
@@ -131,7 +132,7 @@ int XLink_sem_set_refs(XLink_sem_t* sem, int refs)
     XLINK_RET_ERR_IF(sem == NULL, -1);
     XLINK_RET_ERR_IF(refs < -1, -1);
 
-    XLINK_RET_IF_FAIL(pthread_mutex_lock(&ref_mutex));
+    XLINK_RET_IF_FAIL(XLinkProfMutexLock(&ref_mutex, X_LINK_LOCK_SEMAPHORE_REFS));
     sem->refs = refs;
     int ret = pthread_cond_broadcast(&ref_cond);
     XLINK_RET_IF_FAIL(pthread_mutex_unlock(&ref_mutex));
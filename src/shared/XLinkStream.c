@@ -2,10 +2,14 @@
 // SPDX-License-Identifier: Apache-2.0
 //
 
+#include <stdlib.h>
 #include <string.h>
 
 #include "XLinkStream.h"
 #include "XLinkErrorUtils.h"
+#include "XLinkMacros.h"
+#include "XLinkPlatform.h"
+#include "XLinkPrivateDefines.h"
 
 #ifdef MVLOG_UNIT_NAME
 #undef MVLOG_UNIT_NAME
@@ -20,7 +24,29 @@ XLinkError_t XLinkStreamInitialize(
     mvLog(MVLOG_DEBUG, "name: %s, id: %ld\n", name, id);
     ASSERT_XLINK(stream);
 
+    xLinkLatencyHistograms_t* latency = stream->latency;
+    xLinkStageHistograms_t* stages = stream->stages;
+    if (latency == NULL) {
+        latency = calloc(1, sizeof(*latency));
+    } else {
+        memset(latency, 0, sizeof(*latency));
+    }
+    if (stages == NULL) {
+        stages = calloc(1, sizeof(*stages));
+    } else {
+        memset(stages, 0, sizeof(*stages));
+    }
+
+    streamSharedPackets_t* sharedPackets = stream->sharedPackets;
     memset(stream, 0, sizeof(*stream));
+    stream->latency = latency;
+    stream->stages = stages;
+    stream->sharedPackets = sharedPackets;
+    if (latency == NULL || stages == NULL) {
+        mvLog(MVLOG_ERROR, "Cannot allocate the histograms of the stream\n");
+        stream->id = INVALID_STREAM_ID;
+        return X_LINK_ERROR;
+    }
 
     if (XLink_sem_init(&stream->sem, 0, 0)) {
         mvLog(MVLOG_ERROR, "Cannot initialize semaphore\n");
@@ -42,9 +68,58 @@ void XLinkStreamReset(streamDesc_t* stream) {
     if(XLink_sem_destroy(&stream->sem)) {
         mvLog(MVLOG_DEBUG, "Cannot destroy semaphore\n");
     }
+    XLinkStreamFreeRecycled(stream);
 
     // sets all stream fields, including the packets circular buffer to NULL
     // with no check to see if something is open, packet is "blocked", etc.
+    // The histograms and the shared packets stay with the slot
+    xLinkLatencyHistograms_t* latency = stream->latency;
+    xLinkStageHistograms_t* stages = stream->stages;
+    streamSharedPackets_t* sharedPackets = stream->sharedPackets;
+    if (sharedPackets) {
+        memset(sharedPackets->held, 0, sizeof(sharedPackets->held));
+    }
     memset(stream, 0, sizeof(*stream));
     stream->id = INVALID_STREAM_ID;
+    stream->latency = latency;
+    stream->stages = stages;
+    stream->sharedPackets = sharedPackets;
+}
+
+uint8_t* XLinkStreamAllocateBuffer(streamDesc_t* stream, uint32_t size) {
+    const uint32_t alignedSize = ALIGN_UP(size, __CACHE_LINE_SIZE);
+    // the most recently recycled buffer which is large enough
+    for(uint32_t i = stream->recycledCount; i > 0; i--) {
+        if(stream->recycledSizes[i - 1] >= alignedSize) {
+            uint8_t* buffer = stream->recycledBuffers[i - 1];
+            stream->recycledCount--;
+            stream->recycledBuffers[i - 1] = stream->recycledBuffers[stream->recycledCount];
+            stream->recycledSizes[i - 1] = stream->recycledSizes[stream->recycledCount];
+            return buffer;
+        }
+    }
+    return XLinkPlatformAllocateData(alignedSize, __CACHE_LINE_SIZE);
+}
+
+void XLinkStreamRecycleBuffer(streamDesc_t* stream, uint8_t* buffer, uint32_t size) {
+    if(buffer == NULL) {
+        return;
+    }
+    const uint32_t alignedSize = ALIGN_UP(size, __CACHE_LINE_SIZE);
+    if(stream->recycledCount < stream->recycleLimit) {
+        // a larger buffer is only known by the size of its last packet
+        stream->recycledBuffers[stream->recycledCount] = buffer;
+        stream->recycledSizes[stream->recycledCount] = alignedSize;
+        stream->recycledCount++;
+        return;
+    }
+    XLinkPlatformDeallocateData(buffer, alignedSize, __CACHE_LINE_SIZE);
+}
+
+void XLinkStreamFreeRecycled(streamDesc_t* stream) {
+    for(uint32_t i = 0; i < stream->recycledCount; i++) {
+        XLinkPlatformDeallocateData(stream->recycledBuffers[i], stream->recycledSizes[i], __CACHE_LINE_SIZE);
+    }
+    stream->recycledCount = 0;
+    stream->recycleLimit = 0;
 }
@@ -7,4 +7,9 @@ void getMonotonicTimestamp(XLinkTimespec* ts) {
     auto epoch = now.time_since_epoch();
     ts->tv_sec = std::chrono::duration_cast<std::chrono::seconds>(epoch).count();
     ts->tv_nsec = std::chrono::duration_cast<std::chrono::nanoseconds>(epoch).count() % 1000000000;
+}
+
+uint64_t getMonotonicTimestampNs(void) {
+    auto epoch = std::chrono::steady_clock::now().time_since_epoch();
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(epoch).count();
 }
\ No newline at end of file
@@ -0,0 +1,186 @@
+#include <atomic>
+#include <mutex>
+#include <cstring>
+
+#if (defined(_WIN32) || defined(_WIN64))
+#include <windows.h>
+#else
+#include <pthread.h>
+#include <unistd.h>
+#endif
+#if defined(__linux__)
+#include <sys/syscall.h>
+#endif
+
+#include "XLinkTrace.h"
+extern "C" {
+#include "XLinkDispatcher.h"
+}
+
+namespace {
+
+constexpr uint32_t DEFAULT_CAPACITY = 64 * 1024;
+constexpr uint32_t MAX_THREADS = 256;
+constexpr uint32_t THREAD_NAME_SIZE = 16;
+
+// Every field is atomic, the dump may run while the entry is overwritten. seq is the
+// index of the entry plus one once written, 0 while being written
+struct Entry {
+    std::atomic<uint64_t> seq{0};
+    std::atomic<uint64_t> startNs{0};
+    std::atomic<uint64_t> endNs{0};
+    // thread id, event type, phase and link id
+    std::atomic<uint64_t> origin{0};
+    // stream id and size
+    std::atomic<uint64_t> payload{0};
+};
+
+struct ThreadName {
+    std::atomic<uint32_t> tid{0};
+    char name[THREAD_NAME_SIZE];
+};
+
+std::mutex controlMutex;
+std::atomic<bool> enabled{false};
+std::atomic<Entry*> ring{nullptr};
+std::atomic<uint32_t> capacity{0};
+std::atomic<uint64_t> head{0};
+ThreadName threadNames[MAX_THREADS];
+std::atomic<uint32_t> threadCount{0};
+
+const char* phaseNames[] = {"call", "send", "receive", "block", "unblock"};
+
+uint32_t getProcessId() {
+#if (defined(_WIN32) || defined(_WIN64))
+    return (uint32_t)GetCurrentProcessId();
+#else
+    return (uint32_t)getpid();
+#endif
+}
+
+uint32_t getOsThreadId() {
+#if (defined(_WIN32) || defined(_WIN64))
+    return (uint32_t)GetCurrentThreadId();
+#elif defined(__linux__)
+    return (uint32_t)syscall(SYS_gettid);
+#elif defined(__APPLE__)
+    uint64_t tid = 0;
+    pthread_threadid_np(NULL, &tid);
+    return (uint32_t)tid;
+#else
+    static std::atomic<uint32_t> next{1};
+    return next++;
+#endif
+}
+
+// Thread ids of the OS, so the trace lines up with others of the process.
+// Names are taken the first time a thread records, XLink names its threads on creation
+uint32_t currentThreadId() {
+    static thread_local uint32_t tid = 0;
+    if(tid == 0) {
+        tid = getOsThreadId();
+        uint32_t index = threadCount.fetch_add(1);
+        if(index < MAX_THREADS) {
+            ThreadName& entry = threadNames[index];
+            memset(entry.name, 0, sizeof(entry.name));
+#if defined(__linux__) || defined(__APPLE__)
+            pthread_getname_np(pthread_self(), entry.name, sizeof(entry.name));
+#endif
+            entry.tid.store(tid, std::memory_order_release);
+        }
+    }
+    return tid;
+}
+
+} // namespace
+
+void XLinkTraceRingStart(uint32_t requested) {
+    std::lock_guard<std::mutex> lock(controlMutex);
+    Entry* entries = ring.load();
+    if(entries == nullptr) {
+        // never freed, calls in flight may still be recording
+        uint32_t size = requested ? requested : DEFAULT_CAPACITY;
+        entries = new Entry[size];
+        capacity = size;
+        ring.store(entries, std::memory_order_release);
+    } else {
+        for(uint32_t i = 0; i < capacity; i++) {
+            entries[i].seq.store(0, std::memory_order_relaxed);
+        }
+    }
+    head = 0;
+    enabled.store(true, std::memory_order_release);
+}
+
+void XLinkTraceRingStop(void) {
+    enabled = false;
+}
+
+int XLinkTraceEnabled(void) {
+    return enabled.load(std::memory_order_relaxed);
+}
+
+void XLinkTraceRecord(xLinkTracePhase_t phase, uint32_t linkId, uint32_t eventType,
+                      uint32_t streamId, uint32_t size, uint64_t startNs, uint64_t endNs) {
+    if(!enabled.load(std::memory_order_acquire)) return;
+    Entry* entries = ring.load(std::memory_order_acquire);
+    uint64_t index = head.fetch_add(1, std::memory_order_relaxed);
+    Entry& entry = entries[index % capacity.load(std::memory_order_relaxed)];
+
+    entry.seq.store(0, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    entry.startNs.store(startNs, std::memory_order_relaxed);
+    entry.endNs.store(endNs, std::memory_order_relaxed);
+    entry.origin.store((uint64_t)currentThreadId() << 32 | (uint64_t)(eventType & 0xFFFF) << 16
+                       | (uint64_t)(phase & 0xFF) << 8 | (linkId & 0xFF), std::memory_order_relaxed);
+    entry.payload.store((uint64_t)streamId << 32 | size, std::memory_order_relaxed);
+    entry.seq.store(index + 1, std::memory_order_release);
+}
+
+int XLinkTraceRingDump(FILE* file) {
+    std::lock_guard<std::mutex> lock(controlMutex);
+    const uint32_t pid = getProcessId();
+    Entry* entries = ring.load(std::memory_order_acquire);
+    const uint64_t size = capacity;
+    const uint64_t end = head;
+
+    fprintf(file, "{\"displayTimeUnit\": \"ns\", \"traceEvents\": [\n");
+    const char* separator = "";
+    uint32_t threads = threadCount < MAX_THREADS ? threadCount.load() : MAX_THREADS;
+    for(uint32_t i = 0; i < threads; i++) {
+        uint32_t tid = threadNames[i].tid.load(std::memory_order_acquire);
+        if(tid == 0 || threadNames[i].name[0] == '\0') continue;
+        fprintf(file, "%s{\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": %u, \"tid\": %u, \"args\": {\"name\": \"%.*s\"}}",
+                separator, pid, tid, (int)THREAD_NAME_SIZE, threadNames[i].name);
+        separator = ",\n";
+    }
+
+    for(uint64_t index = end > size ? end - size : 0; entries && index < end; index++) {
+        Entry& entry = entries[index % size];
+        uint64_t seq = entry.seq.load(std::memory_order_acquire);
+        if(seq != index + 1) continue;
+        uint64_t startNs = entry.startNs.load(std::memory_order_relaxed);
+        uint64_t endNs = entry.endNs.load(std::memory_order_relaxed);
+        uint64_t origin = entry.origin.load(std::memory_order_relaxed);
+        uint64_t payload = entry.payload.load(std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_acquire);
+        // overwritten meanwhile
+        if(entry.seq.load(std::memory_order_relaxed) != seq) continue;
+
+        uint32_t phase = (origin >> 8) & 0xFF;
+        if(phase > XLINK_TRACE_UNBLOCK) continue;
+        const char* type = TypeToStr((int)((origin >> 16) & 0xFFFF));
+        fprintf(file, "%s{\"name\": \"%s\", \"cat\": \"%s\", \"ts\": %.3f, ", separator, type, phaseNames[phase],
+                startNs / 1000.0);
+        if(phase == XLINK_TRACE_BLOCK || phase == XLINK_TRACE_UNBLOCK) {
+            fprintf(file, "\"ph\": \"i\", \"s\": \"t\", ");
+        } else {
+            fprintf(file, "\"ph\": \"X\", \"dur\": %.3f, ", (endNs - startNs) / 1000.0);
+        }
+        fprintf(file, "\"pid\": %u, \"tid\": %u, \"args\": {\"link\": %u, \"stream\": %u, \"size\": %u}}", pid,
+                (uint32_t)(origin >> 32), (uint32_t)(origin & 0xFF), (uint32_t)(payload >> 32), (uint32_t)payload);
+        separator = ",\n";
+    }
+    fprintf(file, "\n]}\n");
+    return ferror(file) ? -1 : 0;
+}
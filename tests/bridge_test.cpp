@@ -0,0 +1,166 @@
+#include <XLink/XLink.h>
+#include <XLink/XLinkLog.h>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <thread>
+#include <atomic>
+#include "test_common.hpp"
+
+// The following test needs no device: the device side of each link is served by a thread of
+// the same process. The host bridges a stream of an in-process link, whose peer writes many
+// times its write window, to a stream of a TCP loopback link, whose peer reads the packets and
+// checks they arrive whole and in order. That peer stops reading for a while, which must stall
+// the writer on the other link, since packets are only credited once forwarded. Once the bridge
+// is stopped the host reads the source itself. Bridged again to a closed stream, the source must
+// be drained, so its writer isn't stalled.
+
+constexpr static auto SOURCE_PATH = "bridge_test";
+constexpr static auto DESTINATION_PATH = "127.0.0.1:11600";
+constexpr static auto STREAM_NAME = "bridged";
+constexpr static auto WINDOW = 256 * 1024;
+constexpr static auto NUM_PACKETS = 200;
+constexpr static auto STALL_MS = 300;
+// written after the bridge was stopped, one read by the host and many more than the window dropped
+constexpr static auto NUM_DROPPED = 20;
+constexpr static TestPackets PACKETS = {NUM_PACKETS + 1 + NUM_DROPPED, WINDOW / 2, false};
+
+static void runWriter(std::atomic<bool>& ok, std::atomic<int>& written) {
+    XLinkHandler_t handler = {};
+    if(!serveLink(SOURCE_PATH, X_LINK_LOOPBACK, handler)) {
+        ok = false;
+        return;
+    }
+    auto s = XLinkOpenStream(handler.linkId, STREAM_NAME, WINDOW);
+    std::vector<uint8_t> payload(WINDOW);
+    for(int i = 0; i < NUM_PACKETS && ok && s != INVALID_STREAM_ID; i++) {
+        ok = PACKETS.write(s, i, payload);
+        written++;
+    }
+    // the host sends a packet once it stopped the bridge, and once it bridged the stream again
+    for(int i = NUM_PACKETS; i < PACKETS.count && ok; i++) {
+        if((i == NUM_PACKETS || i == NUM_PACKETS + 1) && !waitForHost(s)) {
+            ok = false;
+            break;
+        }
+        ok = PACKETS.write(s, i, payload);
+        written++;
+    }
+    streamPacketDesc_t* p;
+    // returns an error once the host reset the link
+    XLinkReadData(s, &p);
+}
+
+static void runReader(std::atomic<bool>& ok, std::atomic<bool>& done, std::atomic<int>& written, int& stalledAt) {
+    XLinkHandler_t handler = {};
+    if(!serveLink(DESTINATION_PATH, X_LINK_TCP_IP, handler)) {
+        ok = false;
+        done = true;
+        return;
+    }
+    auto s = XLinkOpenStream(handler.linkId, STREAM_NAME, 1);
+    streamPacketDesc_t* p;
+    for(int i = 0; i < NUM_PACKETS && s != INVALID_STREAM_ID; i++) {
+        if(XLinkReadData(s, &p) != X_LINK_SUCCESS) {
+            printf("Peer: reading packet %d failed\n", i);
+            ok = false;
+            break;
+        }
+        if(!PACKETS.matches(i, p->data, p->length)) {
+            printf("Peer: packet %d differs\n", i);
+            ok = false;
+        }
+        XLinkReleaseData(s);
+        if(i == 0) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(STALL_MS));
+            stalledAt = written;
+        }
+    }
+    done = true;
+    // returns an error once the host reset the link
+    XLinkReadData(s, &p);
+}
+
+int main() {
+    // failing reads of the peers at the reset are expected
+    mvLogDefaultLevelSet(MVLOG_FATAL);
+    XLinkGlobalHandler_t gHandler = {};
+    XLinkInitialize(&gHandler);
+
+    std::atomic<bool> writerOk{true}, readerOk{true}, readerDone{false};
+    std::atomic<int> written{0};
+    int stalledAt = 0;
+    std::thread writer(runWriter, std::ref(writerOk), std::ref(written));
+    std::thread reader(runReader, std::ref(readerOk), std::ref(readerDone), std::ref(written), std::ref(stalledAt));
+
+    XLinkHandler_t source = {}, destination = {};
+    bool ok = connectLink(SOURCE_PATH, X_LINK_LOOPBACK, source);
+    ok = connectLink(DESTINATION_PATH, X_LINK_TCP_IP, destination) && ok;
+
+    XLinkStreamOptions_t streamOptions = {};
+    streamOptions.postedWrites = 1;
+    auto src = ok ? XLinkOpenStream(source.linkId, STREAM_NAME, 64) : INVALID_STREAM_ID;
+    auto dst = ok ? XLinkOpenStreamWithOptions(destination.linkId, STREAM_NAME, WINDOW, &streamOptions) : INVALID_STREAM_ID;
+    if(src == INVALID_STREAM_ID || dst == INVALID_STREAM_ID || XLinkBridgeStreams(src, dst, nullptr) != X_LINK_SUCCESS) {
+        printf("Bridging the streams failed\n");
+        ok = false;
+    }
+    if(ok && XLinkBridgeStreams(src, dst, nullptr) == X_LINK_SUCCESS) {
+        printf("Bridging a stream twice wasn't refused\n");
+        ok = false;
+    }
+
+    for(int i = 0; i < 1000 && ok && !readerDone; i++) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    if(!readerDone) {
+        printf("Peer didn't receive everything\n");
+        ok = false;
+    } else if(stalledAt >= NUM_PACKETS) {
+        printf("Writer wasn't held back by the stalled reader\n");
+        ok = false;
+    }
+
+    // the bridge is waiting for the next packet and stops right away, the source is read here then
+    uint8_t go = 1;
+    streamPacketDesc_t* p;
+    if(ok && (XLinkUnbridgeStreams(src) != X_LINK_SUCCESS || XLinkUnbridgeStreams(src) == X_LINK_SUCCESS)) {
+        printf("Stopping the bridge failed\n");
+        ok = false;
+    }
+    if(ok && (XLinkWriteData(src, &go, 1) != X_LINK_SUCCESS || XLinkReadData(src, &p) != X_LINK_SUCCESS
+              || !PACKETS.matches(NUM_PACKETS, p->data, p->length) || XLinkReleaseData(src) != X_LINK_SUCCESS)) {
+        printf("Reading the source after the bridge stopped failed\n");
+        ok = false;
+    }
+
+    // writes to the closed stream fail, the writer mustn't be held back by its window
+    auto closed = ok ? XLinkOpenStream(destination.linkId, "closed", WINDOW) : INVALID_STREAM_ID;
+    if(closed == INVALID_STREAM_ID || XLinkCloseStream(closed) != X_LINK_SUCCESS
+       || XLinkBridgeStreams(src, closed, nullptr) != X_LINK_SUCCESS || XLinkWriteData(src, &go, 1) != X_LINK_SUCCESS) {
+        printf("Bridging to a closed stream failed\n");
+        ok = false;
+    }
+    for(int i = 0; i < 1000 && ok && written < PACKETS.count; i++) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    if(ok && written != PACKETS.count) {
+        printf("Writer stalled after %d packets, the source wasn't drained\n", (int) written);
+        ok = false;
+    }
+    if(ok && XLinkUnbridgeStreams(src) != X_LINK_SUCCESS) {
+        printf("Stopping the draining bridge failed\n");
+        ok = false;
+    }
+
+    XLinkResetRemote(source.linkId);
+    XLinkResetRemote(destination.linkId);
+    writer.join();
+    reader.join();
+
+    ok = ok && writerOk && readerOk;
+    printf("%s\n", ok ? "Success" : "Failed");
+    return ok ? 0 : -1;
+}
@@ -0,0 +1,209 @@
+#include <XLink/XLink.h>
+#include <XLink/XLinkLog.h>
+#include <unistd.h>
+#include <sys/wait.h>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <thread>
+#include <atomic>
+#include "test_common.hpp"
+
+// The following test needs no device: the device side of the link is served by a thread of
+// the same process. The host publishes a stream of the link with XLinkBrokerPublish, which
+// child processes and threads of the host read. Every reader must receive the packets whole
+// and in order, skipped packets are reported. A packet isn't overwritten while a reader holds
+// it, and a child exiting without releasing its packet mustn't stall the others.
+
+constexpr static auto LINK_NAME = "broker_test_link";
+constexpr static auto PUBLISHED_NAME = "broker_test";
+constexpr static auto STREAM_NAME = "published";
+constexpr static auto WINDOW = 256 * 1024;
+constexpr static auto NUM_PACKETS = 500;
+constexpr static auto NUM_CHILDREN = 2;
+constexpr static auto HOLD_MS = 200;
+constexpr static TestPackets PACKETS = {NUM_PACKETS, WINDOW / 2, true};
+
+static streamId_t openPublished() {
+    for(int i = 0; i < 500; i++) {
+        auto reader = XLinkBrokerOpenStream(PUBLISHED_NAME);
+        if(reader != INVALID_STREAM_ID) return reader;
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    return INVALID_STREAM_ID;
+}
+
+// reads until the last packet, every packet is either received or reported as dropped
+static bool readAll(streamId_t reader, const char* who, int expected) {
+    int index = -1;
+    while(index != NUM_PACKETS - 1) {
+        streamPacketDesc_t* p;
+        uint32_t dropped = 0;
+        if(XLinkBrokerReadData(reader, &p, &dropped) != X_LINK_SUCCESS) {
+            printf("%s: reading failed after packet %d\n", who, index);
+            return false;
+        }
+        if(!PACKETS.isIntact(p, index) || index != expected + (int) dropped) {
+            printf("%s: packet %d is wrong, expected %d with %u dropped\n", who, index, expected, dropped);
+            return false;
+        }
+        expected = index + 1;
+        XLinkBrokerReleaseData(reader);
+    }
+    return true;
+}
+
+static int runChild(int ready, bool crash) {
+    auto reader = openPublished();
+    if(reader == INVALID_STREAM_ID) {
+        printf("Child: opening the stream failed\n");
+        return 1;
+    }
+    char attached = 1;
+    if(write(ready, &attached, 1) != 1) return 1;
+    if(crash) {
+        // exits holding the packet
+        streamPacketDesc_t* p;
+        uint32_t dropped;
+        int index;
+        return XLinkBrokerReadData(reader, &p, &dropped) == X_LINK_SUCCESS && PACKETS.isIntact(p, index) ? 0 : 1;
+    }
+    return readAll(reader, "Child", 0) ? 0 : 1;
+}
+
+static void runPeer(std::atomic<bool>& ok, std::atomic<bool>& done) {
+    XLinkHandler_t handler = {};
+    if(!serveLink(LINK_NAME, X_LINK_LOOPBACK, handler)) {
+        ok = false;
+        return;
+    }
+    auto s = XLinkOpenStream(handler.linkId, STREAM_NAME, WINDOW);
+    // the host sends a packet once its readers are attached
+    if(!waitForHost(s)) {
+        ok = false;
+        return;
+    }
+    std::vector<uint8_t> payload(WINDOW);
+    for(int i = 0; i < NUM_PACKETS && ok; i++) {
+        ok = PACKETS.write(s, i, payload);
+    }
+    done = true;
+    streamPacketDesc_t* p;
+    // returns an error once the host reset the link
+    XLinkReadData(s, &p);
+}
+
+int main() {
+    // failing reads of the peer at the reset are expected
+    mvLogDefaultLevelSet(MVLOG_FATAL);
+
+    // the children only map the published stream, they're forked before any thread runs
+    int ready[2];
+    if(pipe(ready) != 0) return -1;
+    std::vector<pid_t> children;
+    for(int i = 0; i <= NUM_CHILDREN; i++) {
+        pid_t pid = fork();
+        if(pid == 0) {
+            close(ready[0]);
+            int rc = runChild(ready[1], i == NUM_CHILDREN);
+            fflush(stdout);
+            _exit(rc);
+        }
+        children.push_back(pid);
+    }
+    close(ready[1]);
+
+    XLinkGlobalHandler_t gHandler = {};
+    XLinkInitialize(&gHandler);
+    std::atomic<bool> peerOk{true}, peerDone{false};
+    std::thread peer(runPeer, std::ref(peerOk), std::ref(peerDone));
+
+    XLinkHandler_t handler = {};
+    bool ok = connectLink(LINK_NAME, X_LINK_LOOPBACK, handler);
+
+    auto s = ok ? XLinkOpenStream(handler.linkId, STREAM_NAME, 64) : INVALID_STREAM_ID;
+    XLinkBrokerOptions_t options = {};
+    options.slots = 8;
+    options.slotSize = WINDOW;
+    if(s == INVALID_STREAM_ID || XLinkBrokerPublish(s, PUBLISHED_NAME, &options) != X_LINK_SUCCESS) {
+        printf("Publishing the stream failed\n");
+        ok = false;
+    }
+    if(ok && XLinkBrokerPublish(s, PUBLISHED_NAME, &options) != X_LINK_DEVICE_ALREADY_IN_USE) {
+        printf("Publishing a name twice wasn't refused\n");
+        ok = false;
+    }
+    auto first = ok ? openPublished() : INVALID_STREAM_ID;
+    auto second = ok ? openPublished() : INVALID_STREAM_ID;
+    char attached;
+    for(int i = 0; i <= NUM_CHILDREN && ok; i++) {
+        ok = read(ready[0], &attached, 1) == 1;
+    }
+    uint8_t go = 1;
+    if(!ok || first == INVALID_STREAM_ID || second == INVALID_STREAM_ID || XLinkWriteData(s, &go, 1) != X_LINK_SUCCESS) {
+        printf("Attaching the readers failed\n");
+        ok = false;
+    }
+
+    // the first packet stays while it's held
+    streamPacketDesc_t *p1 = nullptr, *p2 = nullptr;
+    uint32_t dropped;
+    int index = -1;
+    if(ok && (XLinkBrokerReadData(first, &p1, &dropped) != X_LINK_SUCCESS
+              || XLinkBrokerReadData(second, &p2, &dropped) != X_LINK_SUCCESS)) {
+        printf("Reading the first packet failed\n");
+        ok = false;
+    }
+    if(ok) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(HOLD_MS));
+        if(!PACKETS.isIntact(p1, index) || index != 0 || !PACKETS.isIntact(p2, index) || index != 0) {
+            printf("Held packet was overwritten\n");
+            ok = false;
+        }
+        XLinkBrokerReleaseData(first);
+        XLinkBrokerReleaseData(second);
+    }
+
+    std::atomic<bool> readersOk{ok};
+    if(ok) {
+        std::thread other([&] { readersOk = readAll(second, "Thread", 1) && readersOk; });
+        readersOk = readAll(first, "Thread", 1) && readersOk;
+        other.join();
+    }
+    ok = ok && readersOk;
+    for(pid_t child : children) {
+        int status = 0;
+        if(waitpid(child, &status, 0) != child || !WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+            printf("Child %d failed\n", (int) child);
+            ok = false;
+        }
+    }
+
+    // the last write completes once the peer heard back, which may be after it was read
+    for(int i = 0; i < 1000 && ok && !peerDone; i++) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+
+    // publishing ends with the link, a reader waiting for packets is told
+    auto last = ok ? XLinkBrokerOpenStream(PUBLISHED_NAME) : INVALID_STREAM_ID;
+    XLinkResetRemote(handler.linkId);
+    streamPacketDesc_t* p;
+    if(ok && (last == INVALID_STREAM_ID || XLinkBrokerReadData(last, &p, &dropped) != X_LINK_COMMUNICATION_NOT_OPEN)) {
+        printf("Reader wasn't told publishing ended\n");
+        ok = false;
+    }
+    if(ok && XLinkBrokerOpenStream(PUBLISHED_NAME) != INVALID_STREAM_ID) {
+        printf("Opening an ended stream wasn't refused\n");
+        ok = false;
+    }
+    for(auto reader : {first, second, last}) {
+        if(reader != INVALID_STREAM_ID) XLinkBrokerCloseStream(reader);
+    }
+    peer.join();
+
+    ok = ok && peerOk;
+    printf("%s\n", ok ? "Success" : "Failed");
+    return ok ? 0 : -1;
+}
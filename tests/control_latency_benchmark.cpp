@@ -0,0 +1,122 @@
+#include <XLink/XLink.h>
+#include <cstdio>
+#include <chrono>
+#include <thread>
+#include <atomic>
+#include <vector>
+#include <algorithm>
+#include <string>
+
+// The following is an Server side (host) benchmark that measures the latency of small
+// control messages written while a bulk stream keeps the link saturated with 50MB writes.
+// Rounds are run with the control stream in the normal and in the control priority class,
+// and with the bulk writes sent in one piece and fragmented.
+
+// Use the following code on Client side (device) to test
+// ...
+//    for(int round = 0; round < 3; round++){
+//        std::string suffix = std::to_string(round);
+//        auto bulk = XLinkOpenStream(0, ("bulk_" + suffix).c_str(), 64 * 1024 * 1024);
+//        auto config = XLinkOpenStream(0, ("config_" + suffix).c_str(), 1024);
+//        assert(bulk != INVALID_STREAM_ID && config != INVALID_STREAM_ID);
+//        std::thread bulkReader([bulk](){
+//            streamPacketDesc_t* p;
+//            while(XLinkReadData(bulk, &p) == X_LINK_SUCCESS) XLinkReleaseData(bulk);
+//        });
+//        streamPacketDesc_t* p;
+//        for(int i = 0; i < NUM_MESSAGES; i++){
+//            XLinkReadData(config, &p);
+//            XLinkReleaseData(config);
+//        }
+//        XLinkCloseStream(bulk);
+//        bulkReader.join();
+//    }
+// ...
+
+constexpr static auto NUM_MESSAGES = 1000;
+constexpr static auto BULK_SIZE = 50 * 1024 * 1024;
+
+static void runRound(linkId_t linkId, int round, XLinkStreamPriority_t priority, uint32_t fragmentSize) {
+    std::string suffix = std::to_string(round);
+
+    XLinkStreamOptions_t bulkOptions = {};
+    bulkOptions.fragmentSize = fragmentSize;
+    XLinkStreamOptions_t configOptions = {};
+    configOptions.priority = priority;
+    auto bulk = XLinkOpenStreamWithOptions(linkId, ("bulk_" + suffix).c_str(), 64 * 1024 * 1024, &bulkOptions);
+    auto config = XLinkOpenStreamWithOptions(linkId, ("config_" + suffix).c_str(), 1024, &configOptions);
+    if(bulk == INVALID_STREAM_ID || config == INVALID_STREAM_ID) {
+        printf("Open stream failed...\n");
+        return;
+    }
+
+    // writers keep the dispatcher queue filled with bulk writes
+    std::atomic<bool> running{true};
+    std::vector<uint8_t> payload(BULK_SIZE);
+    std::vector<std::thread> writers;
+    for(int i = 0; i < 2; i++) {
+        writers.emplace_back([&](){
+            while(running) {
+                if(XLinkWriteData(bulk, payload.data(), (int)payload.size()) != X_LINK_SUCCESS) break;
+            }
+        });
+    }
+
+    std::vector<double> latencies;
+    uint8_t message[64] = {0};
+    for(int i = 0; i < NUM_MESSAGES; i++) {
+        auto start = std::chrono::steady_clock::now();
+        if(XLinkWriteData(config, message, sizeof(message)) != X_LINK_SUCCESS) {
+            printf("Control write failed\n");
+            break;
+        }
+        std::chrono::duration<double, std::micro> latency = std::chrono::steady_clock::now() - start;
+        latencies.push_back(latency.count());
+    }
+
+    running = false;
+    for(auto& writer : writers) {
+        writer.join();
+    }
+    XLinkCloseStream(config);
+    XLinkCloseStream(bulk);
+
+    if(latencies.empty()) {
+        return;
+    }
+    std::sort(latencies.begin(), latencies.end());
+    printf("%s control stream, %s bulk writes - p50: %.0f us, p99: %.0f us, max: %.0f us\n",
+           priority == X_LINK_PRIORITY_NORMAL ? "normal" : "control",
+           fragmentSize ? "fragmented" : "whole",
+           latencies[latencies.size() / 2], latencies[latencies.size() * 99 / 100], latencies.back());
+}
+
+int main() {
+
+    XLinkGlobalHandler_t gHandler;
+    XLinkInitialize(&gHandler);
+
+    // Search for booted device
+    deviceDesc_t deviceDesc, inDeviceDesc;
+    inDeviceDesc.protocol = X_LINK_ANY_PROTOCOL;
+    inDeviceDesc.state = X_LINK_BOOTED;
+    if(X_LINK_SUCCESS != XLinkFindFirstSuitableDevice(inDeviceDesc, &deviceDesc)){
+        printf("Didn't find a device\n");
+        return -1;
+    }
+
+    printf("Device name: %s\n", deviceDesc.name);
+
+    XLinkHandler_t handler;
+    handler.devicePath = deviceDesc.name;
+    handler.protocol = deviceDesc.protocol;
+    XLinkConnect(&handler);
+
+    runRound(handler.linkId, 0, X_LINK_PRIORITY_NORMAL, 0);
+    runRound(handler.linkId, 1, X_LINK_PRIORITY_CONTROL, 0);
+    runRound(handler.linkId, 2, X_LINK_PRIORITY_CONTROL, 64 * 1024);
+
+    XLinkResetRemote(handler.linkId);
+
+    return 0;
+}
@@ -0,0 +1,271 @@
+#include <XLink/XLink.h>
+#include <XLink/XLinkLog.h>
+extern "C" {
+#include <XLink/XLinkDispatcher.h>
+#include <XLink/XLinkDispatcherImpl.h>
+}
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <chrono>
+#include <thread>
+#include <vector>
+#include <deque>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <algorithm>
+
+// The following benchmark measures the dispatcher alone. Both sides of a link live in this
+// process and the control functions hand events over through in-memory mailboxes instead of
+// writing and reading them over the platform, so DispatcherAddEvent, the scheduler, the
+// get response functions and handleIncomingEvent are all that's measured. The loopback
+// protocol only provides the two link fds, nothing is sent over it.
+// Every API thread writes a window of packets on its stream, reads and releases them on the
+// other side of the link, then opens and closes a stream. It reports ns per call for each.
+//
+// Usage: dispatcher_benchmark [--threads max] [--count packets per thread]
+
+constexpr static auto LINK_NAME = "dispatcher_benchmark";
+constexpr static auto PACKET_SIZE = 64;
+constexpr static auto WINDOW = 32;
+constexpr static auto OPENS_PER_WINDOW = 1;
+
+// ------------------------------------
+// Mock control functions
+// ------------------------------------
+
+struct Message {
+    xLinkEventHeader_t header;
+    // data of a write, the writers' buffers outlive the benchmark
+    const void* data;
+};
+
+struct Mailbox {
+    std::mutex mutex;
+    std::condition_variable cv;
+    std::deque<Message> messages;
+};
+
+// the two ends of the link and what was sent to each
+static std::atomic<void*> endpoints[2];
+static Mailbox mailboxes[2];
+static std::atomic<bool> closed{false};
+
+static int endpointIndex(void* fd) {
+    for(int i = 0; i < 2; i++) {
+        void* expected = nullptr;
+        if(endpoints[i].load() == fd || endpoints[i].compare_exchange_strong(expected, fd)) return i;
+        if(expected == fd) return i;
+    }
+    return -1;
+}
+
+static int mockEventSend(xLinkEvent_t* event) {
+    dispatcherEventPrepareSend(event);
+    int index = endpointIndex(event->deviceHandle.xLinkFD);
+    if(index < 0) return -1;
+
+    Mailbox& mailbox = mailboxes[1 - index];
+    {
+        std::lock_guard<std::mutex> lock(mailbox.mutex);
+        if(closed) return -1;
+        mailbox.messages.push_back({event->header, event->header.type == XLINK_WRITE_REQ ? event->data : nullptr});
+    }
+    mailbox.cv.notify_one();
+    return 0;
+}
+
+static int mockEventReceive(xLinkEvent_t* event) {
+    int index = endpointIndex(event->deviceHandle.xLinkFD);
+    if(index < 0) return -1;
+
+    Mailbox& mailbox = mailboxes[index];
+    Message message;
+    {
+        std::unique_lock<std::mutex> lock(mailbox.mutex);
+        mailbox.cv.wait(lock, [&] { return !mailbox.messages.empty() || closed; });
+        if(mailbox.messages.empty()) return -1;
+        message = mailbox.messages.front();
+        mailbox.messages.pop_front();
+    }
+    event->header = message.header;
+    return dispatcherEventReceiveFrom(event, message.data);
+}
+
+static void mockCloseDeviceFd(xLinkDeviceHandle_t* deviceHandle) {
+    // unblocks the readers of both ends
+    closed = true;
+    for(auto& mailbox : mailboxes) {
+        std::lock_guard<std::mutex> lock(mailbox.mutex);
+        mailbox.cv.notify_all();
+    }
+    dispatcherCloseDeviceFd(deviceHandle);
+}
+
+static DispatcherControlFunctions mockControlFunctions() {
+    DispatcherControlFunctions functions = {};
+    functions.eventSend = &mockEventSend;
+    functions.eventReceive = &mockEventReceive;
+    functions.localGetResponse = &dispatcherLocalEventGetResponse;
+    functions.remoteGetResponse = &dispatcherRemoteEventGetResponse;
+    functions.closeLink = &dispatcherCloseLink;
+    functions.closeDeviceFd = &mockCloseDeviceFd;
+    functions.flushDeferred = &dispatcherFlushDeferred;
+    functions.eventPriority = &dispatcherEventPriority;
+    return functions;
+}
+
+// ------------------------------------
+// Benchmark
+// ------------------------------------
+
+enum Op { OP_WRITE, OP_READ, OP_RELEASE, OP_OPEN, OP_CLOSE, OP_COUNT };
+static const char* opNames[] = {"write", "read", "release", "open", "close"};
+
+struct ThreadResult {
+    std::vector<double> ns[OP_COUNT];
+    bool ok = true;
+};
+
+struct Streams {
+    streamId_t host;
+    streamId_t peer;
+};
+
+template<typename F>
+static bool timed(std::vector<double>& samples, F f) {
+    auto start = std::chrono::steady_clock::now();
+    bool ok = f();
+    std::chrono::duration<double, std::nano> elapsed = std::chrono::steady_clock::now() - start;
+    samples.push_back(elapsed.count());
+    return ok;
+}
+
+static void runThread(int index, linkId_t hostLink, Streams streams, int count, ThreadResult& result) {
+    static thread_local uint8_t payload[PACKET_SIZE];
+    std::string openName = "open_" + std::to_string(index);
+    streamPacketDesc_t* p;
+
+    for(int done = 0; done < count && result.ok; done += WINDOW) {
+        for(int i = 0; i < WINDOW && result.ok; i++) {
+            result.ok = timed(result.ns[OP_WRITE], [&] {
+                return XLinkWriteData(streams.host, payload, sizeof(payload)) == X_LINK_SUCCESS;
+            });
+        }
+        for(int i = 0; i < WINDOW && result.ok; i++) {
+            result.ok = timed(result.ns[OP_READ], [&] { return XLinkReadData(streams.peer, &p) == X_LINK_SUCCESS; });
+        }
+        for(int i = 0; i < WINDOW && result.ok; i++) {
+            result.ok = timed(result.ns[OP_RELEASE], [&] { return XLinkReleaseData(streams.peer) == X_LINK_SUCCESS; });
+        }
+        for(int i = 0; i < OPENS_PER_WINDOW && result.ok; i++) {
+            streamId_t s = INVALID_STREAM_ID;
+            result.ok = timed(result.ns[OP_OPEN], [&] {
+                s = XLinkOpenStream(hostLink, openName.c_str(), PACKET_SIZE);
+                return s != INVALID_STREAM_ID && s != INVALID_STREAM_ID_OUT_OF_MEMORY;
+            });
+            result.ok = result.ok && timed(result.ns[OP_CLOSE], [&] { return XLinkCloseStream(s) == X_LINK_SUCCESS; });
+        }
+    }
+}
+
+int main(int argc, char** argv) {
+    int maxThreads = 8;
+    int count = 20000;
+    for(int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if(arg == "--threads" && i + 1 < argc) {
+            maxThreads = atoi(argv[++i]);
+        } else if(arg == "--count" && i + 1 < argc) {
+            count = atoi(argv[++i]);
+        } else {
+            printf("Usage: %s [--threads max] [--count packets per thread]\n", argv[0]);
+            return 1;
+        }
+    }
+    // each thread uses two streams of the link
+    if(maxThreads < 1 || maxThreads > XLINK_MAX_STREAMS / 2 || count < WINDOW) {
+        printf("--threads must be within 1 and %d, --count at least %d\n", XLINK_MAX_STREAMS / 2, WINDOW);
+        return 1;
+    }
+
+    // failing reads at the final reset are expected
+    mvLogDefaultLevelSet(MVLOG_FATAL);
+    XLinkGlobalHandler_t gHandler = {};
+    XLinkInitialize(&gHandler);
+
+    // replaces the control functions set by XLinkInitialize, before any link is started
+    static DispatcherControlFunctions controlFunctions = mockControlFunctions();
+    if(DispatcherInitialize(&controlFunctions) != X_LINK_SUCCESS) {
+        printf("Installing the mock control functions failed\n");
+        return -1;
+    }
+
+    XLinkHandler_t peerHandler = {};
+    peerHandler.devicePath = const_cast<char*>(LINK_NAME);
+    peerHandler.protocol = X_LINK_LOOPBACK;
+    std::thread peer([&] { XLinkServer(&peerHandler); });
+
+    XLinkHandler_t hostHandler = {};
+    hostHandler.devicePath = const_cast<char*>(LINK_NAME);
+    hostHandler.protocol = X_LINK_LOOPBACK;
+    // the peer may not be serving yet
+    bool connected = false;
+    for(int i = 0; i < 100 && !connected; i++) {
+        connected = XLinkConnect(&hostHandler) == X_LINK_SUCCESS;
+        if(!connected) std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    peer.join();
+    if(!connected || peerHandler.linkId == hostHandler.linkId) {
+        printf("Connecting failed\n");
+        return -1;
+    }
+
+    std::vector<Streams> streams(maxThreads);
+    for(int i = 0; i < maxThreads; i++) {
+        std::string name = "bench_" + std::to_string(i);
+        streams[i].host = XLinkOpenStream(hostHandler.linkId, name.c_str(), WINDOW * PACKET_SIZE);
+        streams[i].peer = XLinkOpenStream(peerHandler.linkId, name.c_str(), 0);
+        if(streams[i].host == INVALID_STREAM_ID || streams[i].peer == INVALID_STREAM_ID) {
+            printf("Open stream failed...\n");
+            return -1;
+        }
+    }
+
+    bool ok = true;
+    printf("%8s %10s %12s %12s %12s %14s\n", "threads", "op", "mean ns", "p50 ns", "p99 ns", "calls/s");
+    for(int threads = 1; threads <= maxThreads && ok; threads *= 2) {
+        std::vector<ThreadResult> results(threads);
+        std::vector<std::thread> workers;
+        auto start = std::chrono::steady_clock::now();
+        for(int i = 0; i < threads; i++) {
+            workers.emplace_back(runThread, i, (linkId_t) hostHandler.linkId, streams[i], count, std::ref(results[i]));
+        }
+        for(auto& worker : workers) {
+            worker.join();
+        }
+        std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+        for(int op = 0; op < OP_COUNT; op++) {
+            std::vector<double> all;
+            for(auto& result : results) {
+                ok = ok && result.ok;
+                all.insert(all.end(), result.ns[op].begin(), result.ns[op].end());
+            }
+            if(all.empty()) continue;
+            double sum = 0;
+            for(double ns : all) sum += ns;
+            std::sort(all.begin(), all.end());
+            printf("%8d %10s %12.0f %12.0f %12.0f %14.0f\n", threads, opNames[op], sum / all.size(),
+                   all[all.size() / 2], all[std::min(all.size() - 1, all.size() * 99 / 100)],
+                   all.size() / elapsed.count());
+        }
+    }
+
+    XLinkResetRemote(hostHandler.linkId);
+
+    printf("%s\n", ok ? "Success" : "Failed");
+    return ok ? 0 : -1;
+}
@@ -0,0 +1,184 @@
+#include <XLink/XLink.h>
+#include <XLink/XLinkLog.h>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <thread>
+#include <atomic>
+#include "test_common.hpp"
+
+// The following test needs no device: the device side of the link is served by a thread of
+// the same process. Three subscribers of one stream receive its packets through
+// XLinkFanOutSubscribe. Two of them never drop packets and must get all of them in order,
+// as the same buffers. The third reads slowly with a lag limit, it must drop packets instead
+// of holding back the others. While a lossless subscriber stops reading, the remote must be
+// held back, since packets are only released once every subscriber let go. A read waiting
+// for the next packet must fail once its subscriber is unsubscribed.
+
+constexpr static auto LINK_NAME = "fan_out_test";
+constexpr static auto STREAM_NAME = "fanned";
+constexpr static auto WINDOW = 64 * 1024;
+constexpr static auto NUM_PACKETS = 300;
+constexpr static auto MAX_LAG = 2;
+constexpr static auto STALL_MS = 200;
+constexpr static auto SLOW_READ_MS = 5;
+constexpr static TestPackets PACKETS = {NUM_PACKETS, WINDOW / 4, true};
+
+static void runPeer(std::atomic<bool>& ok, std::atomic<int>& written) {
+    XLinkHandler_t handler = {};
+    if(!serveLink(LINK_NAME, X_LINK_LOOPBACK, handler)) {
+        ok = false;
+        return;
+    }
+    auto s = XLinkOpenStream(handler.linkId, STREAM_NAME, WINDOW);
+    // the host sends a packet once it subscribed
+    if(!waitForHost(s)) {
+        ok = false;
+        return;
+    }
+    std::vector<uint8_t> payload(WINDOW);
+    for(int i = 0; i < NUM_PACKETS && ok; i++) {
+        ok = PACKETS.write(s, i, payload);
+        written++;
+    }
+    streamPacketDesc_t* p;
+    // returns an error once the host reset the link
+    XLinkReadData(s, &p);
+}
+
+// reads every packet, recording where it was received
+static bool readLossless(streamId_t subscriber, std::vector<const uint8_t*>& buffers, int stallAfter,
+                         std::atomic<int>& written, int& writtenWhileStalled) {
+    for(int i = 0; i < NUM_PACKETS; i++) {
+        streamPacketDesc_t* p;
+        uint32_t dropped = 0;
+        int index;
+        if(XLinkFanOutReadData(subscriber, &p, &dropped) != X_LINK_SUCCESS || !PACKETS.isIntact(p, index)
+           || index != i || dropped != 0) {
+            printf("Lossless subscriber: packet %d is wrong\n", i);
+            return false;
+        }
+        buffers[i] = p->data;
+        if(i == stallAfter) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(STALL_MS));
+            writtenWhileStalled = written;
+        }
+        XLinkFanOutReleaseData(subscriber);
+    }
+    return true;
+}
+
+static bool readSlowly(streamId_t subscriber, std::atomic<bool>& othersDone, int& readBeforeOthersDone) {
+    int expected = 0;
+    int index = -1;
+    int read = 0;
+    while(index != NUM_PACKETS - 1) {
+        streamPacketDesc_t* p;
+        uint32_t dropped = 0;
+        if(XLinkFanOutReadData(subscriber, &p, &dropped) != X_LINK_SUCCESS || !PACKETS.isIntact(p, index)
+           || index != expected + (int) dropped) {
+            printf("Slow subscriber: packet %d is wrong, expected %d with %u dropped\n", index, expected, dropped);
+            return false;
+        }
+        expected = index + 1;
+        if(!othersDone) read++;
+        std::this_thread::sleep_for(std::chrono::milliseconds(SLOW_READ_MS));
+        XLinkFanOutReleaseData(subscriber);
+    }
+    readBeforeOthersDone = read;
+    return true;
+}
+
+int main() {
+    // failing reads of the peer at the reset are expected
+    mvLogDefaultLevelSet(MVLOG_FATAL);
+    XLinkGlobalHandler_t gHandler = {};
+    XLinkInitialize(&gHandler);
+
+    std::atomic<bool> peerOk{true};
+    std::atomic<int> written{0};
+    std::thread peer(runPeer, std::ref(peerOk), std::ref(written));
+
+    XLinkHandler_t handler = {};
+    bool ok = connectLink(LINK_NAME, X_LINK_LOOPBACK, handler);
+
+    auto s = ok ? XLinkOpenStream(handler.linkId, STREAM_NAME, 64) : INVALID_STREAM_ID;
+    XLinkFanOutOptions_t lagged = {};
+    lagged.maxLagPackets = MAX_LAG;
+    auto first = XLinkFanOutSubscribe(s, nullptr);
+    auto second = XLinkFanOutSubscribe(s, nullptr);
+    auto slow = XLinkFanOutSubscribe(s, &lagged);
+    uint8_t go = 1;
+    if(s == INVALID_STREAM_ID || first == INVALID_STREAM_ID || second == INVALID_STREAM_ID || slow == INVALID_STREAM_ID
+       || XLinkWriteData(s, &go, 1) != X_LINK_SUCCESS) {
+        printf("Subscribing failed\n");
+        ok = false;
+    }
+
+    if(ok) {
+        std::vector<const uint8_t*> firstBuffers(NUM_PACKETS), secondBuffers(NUM_PACKETS);
+        std::atomic<bool> othersDone{false};
+        bool firstOk = false, secondOk = false, slowOk = false;
+        int writtenWhileStalled = 0, unused = 0, slowRead = 0;
+        std::thread slowThread([&] { slowOk = readSlowly(slow, othersDone, slowRead); });
+        std::thread secondThread([&] { secondOk = readLossless(second, secondBuffers, -1, written, unused); });
+        firstOk = readLossless(first, firstBuffers, NUM_PACKETS / 2, written, writtenWhileStalled);
+        secondThread.join();
+        othersDone = true;
+        slowThread.join();
+
+        ok = firstOk && secondOk && slowOk;
+        if(ok && firstBuffers != secondBuffers) {
+            printf("Subscribers got different buffers\n");
+            ok = false;
+        }
+        if(ok && writtenWhileStalled >= NUM_PACKETS) {
+            printf("Remote wasn't held back by a stalled subscriber\n");
+            ok = false;
+        }
+        if(ok && slowRead >= NUM_PACKETS / 2) {
+            printf("Slow subscriber held back the others\n");
+            ok = false;
+        }
+    }
+
+    // a read waiting for the next packet fails once its subscriber is unsubscribed meanwhile
+    if(ok) {
+        auto waiting = XLinkFanOutSubscribe(s, nullptr);
+        std::atomic<XLinkError_t> waitingRc{X_LINK_SUCCESS};
+        std::atomic<bool> waitingDone{false};
+        std::thread waitingThread([&] {
+            streamPacketDesc_t* p;
+            waitingRc = XLinkFanOutReadData(waiting, &p, nullptr);
+            waitingDone = true;
+        });
+        std::this_thread::sleep_for(std::chrono::milliseconds(STALL_MS));
+        bool blocked = !waitingDone;
+        bool unsubscribed = XLinkFanOutUnsubscribe(waiting) == X_LINK_SUCCESS;
+        waitingThread.join();
+        if(waiting == INVALID_STREAM_ID || !blocked || !unsubscribed || waitingRc != X_LINK_ERROR) {
+            printf("Read of an unsubscribed subscriber didn't fail\n");
+            ok = false;
+        }
+    }
+    if(ok && (XLinkFanOutUnsubscribe(slow) != X_LINK_SUCCESS || XLinkFanOutUnsubscribe(slow) == X_LINK_SUCCESS)) {
+        printf("Unsubscribing failed\n");
+        ok = false;
+    }
+    XLinkResetRemote(handler.linkId);
+    // the fan-out tells the remaining subscribers once the stream is gone
+    streamPacketDesc_t* p;
+    if(ok && XLinkFanOutReadData(first, &p, nullptr) != X_LINK_COMMUNICATION_NOT_OPEN) {
+        printf("Subscriber wasn't told the stream ended\n");
+        ok = false;
+    }
+    XLinkFanOutUnsubscribe(first);
+    XLinkFanOutUnsubscribe(second);
+    peer.join();
+
+    ok = ok && peerOk;
+    printf("%s\n", ok ? "Success" : "Failed");
+    return ok ? 0 : -1;
+}
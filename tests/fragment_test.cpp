@@ -0,0 +1,193 @@
+#include <XLink/XLink.h>
+#include <XLink/XLinkLog.h>
+#include <cstdio>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <thread>
+#include <atomic>
+#include "test_common.hpp"
+
+// The following test needs no device: the device side of the link is served by a thread of
+// the same process, reached over TCP loopback. Small messages on a stream of the control
+// class are written while a bulk stream sends 50MB writes in fragments. A control message
+// waits for the fragment being sent and the data queued in the socket at most, not for the
+// whole bulk write, so one written in the first half of a bulk write must complete before the
+// bulk write does. The peer checks that the packets arrive whole and in order.
+
+constexpr static auto PEER_PORT = 11630;
+constexpr static auto PEER_PATH = "127.0.0.1:11630";
+constexpr static auto BULK_STREAM_NAME = "bulk";
+constexpr static auto CONTROL_STREAM_NAME = "control";
+constexpr static auto BULK_SIZE = 50 * 1024 * 1024;
+constexpr static auto FRAGMENT_SIZE = 64 * 1024;
+constexpr static auto NUM_BULK_WRITES = 10;
+constexpr static auto MESSAGE_SIZE = 64;
+constexpr static auto MESSAGE_INTERVAL_US = 500;
+constexpr static auto MIN_MESSAGES = 100;
+// shorter than a message, ends a stream
+constexpr static uint8_t END = 0;
+
+// reads a stream until it ends, the first and last byte of a packet follow from its index
+using Clock = std::chrono::steady_clock;
+
+struct Interval {
+    Clock::time_point start, end;
+};
+
+// the control messages written in the first half of a bulk write which completed after it
+static int countOvertaken(const std::vector<Interval>& bulkWrites, const std::vector<Interval>& messages, int& checked) {
+    int overtaken = 0;
+    checked = 0;
+    for(const auto& message : messages) {
+        for(const auto& bulk : bulkWrites) {
+            if(message.start < bulk.start || message.start > bulk.start + (bulk.end - bulk.start) / 2) continue;
+            checked++;
+            if(message.end > bulk.end) overtaken++;
+        }
+    }
+    return overtaken;
+}
+
+static bool runReader(streamId_t s, uint32_t size, int& count) {
+    streamPacketDesc_t* p;
+    for(bool ok = true;;) {
+        if(XLinkReadData(s, &p) != X_LINK_SUCCESS) {
+            printf("Peer: reading failed after %d packets\n", count);
+            return false;
+        }
+        if(p->length == sizeof(END)) {
+            XLinkReleaseData(s);
+            return ok;
+        }
+        if(p->length != size || p->data[0] != TestPackets::pattern(count, 0)
+           || p->data[size - 1] != TestPackets::pattern(count, size - 1)) {
+            printf("Peer: packet %d is broken\n", count);
+            ok = false;
+        }
+        count++;
+        XLinkReleaseData(s);
+    }
+}
+
+static void runPeer(std::atomic<bool>& ok) {
+    XLinkHandler_t handler = {};
+    if(!serveLink(PEER_PATH, X_LINK_TCP_IP, handler)) {
+        ok = false;
+        return;
+    }
+    auto bulk = XLinkOpenStream(handler.linkId, BULK_STREAM_NAME, 1);
+    auto control = XLinkOpenStream(handler.linkId, CONTROL_STREAM_NAME, 1);
+    if(bulk == INVALID_STREAM_ID || control == INVALID_STREAM_ID) {
+        printf("Peer: opening the streams failed\n");
+        ok = false;
+        return;
+    }
+    int bulkCount = 0;
+    bool bulkOk = true;
+    std::thread bulkReader([&] { bulkOk = runReader(bulk, BULK_SIZE, bulkCount); });
+    int controlCount = 0;
+    bool controlOk = runReader(control, MESSAGE_SIZE, controlCount);
+    bulkReader.join();
+    if(!bulkOk || !controlOk || bulkCount != NUM_BULK_WRITES) {
+        printf("Peer: received %d bulk packets\n", bulkCount);
+        ok = false;
+    }
+
+    // the reset of the link frees packets still held, so the host waits for the streams to end.
+    // It may reset the link before the write completed here.
+    streamPacketDesc_t* p;
+    if(XLinkWriteData(control, &END, sizeof(END)) == X_LINK_SUCCESS) {
+        // returns an error once the host reset the link
+        XLinkReadData(control, &p);
+    }
+}
+
+int main() {
+    // failing reads of the peer at the reset are expected
+    mvLogDefaultLevelSet(MVLOG_FATAL);
+    XLinkGlobalHandler_t gHandler = {};
+    XLinkInitialize(&gHandler);
+
+    std::atomic<bool> peerOk{true};
+    std::thread peer(runPeer, std::ref(peerOk));
+
+    XLinkHandler_t handler = {};
+    bool ok = connectLink(PEER_PATH, X_LINK_TCP_IP, handler);
+
+    XLinkStreamOptions_t bulkOptions = {};
+    bulkOptions.fragmentSize = FRAGMENT_SIZE;
+    XLinkStreamOptions_t controlOptions = {};
+    controlOptions.priority = X_LINK_PRIORITY_CONTROL;
+    auto bulk = ok ? XLinkOpenStreamWithOptions(handler.linkId, BULK_STREAM_NAME, 64 * 1024 * 1024, &bulkOptions)
+                   : INVALID_STREAM_ID;
+    auto control = ok ? XLinkOpenStreamWithOptions(handler.linkId, CONTROL_STREAM_NAME, 1024, &controlOptions)
+                      : INVALID_STREAM_ID;
+    if(bulk == INVALID_STREAM_ID || control == INVALID_STREAM_ID) {
+        printf("Opening the streams failed\n");
+        ok = false;
+    }
+
+    std::atomic<bool> bulkRunning{ok};
+    std::atomic<bool> bulkOk{true};
+    std::vector<Interval> bulkWrites;
+    std::thread bulkWriter([&] {
+        std::vector<uint8_t> payload(BULK_SIZE);
+        for(int i = 0; i < NUM_BULK_WRITES && bulkRunning; i++) {
+            payload.front() = TestPackets::pattern(i, 0);
+            payload.back() = TestPackets::pattern(i, BULK_SIZE - 1);
+            auto start = Clock::now();
+            if(XLinkWriteData(bulk, payload.data(), BULK_SIZE) != X_LINK_SUCCESS) {
+                bulkOk = false;
+                break;
+            }
+            bulkWrites.push_back({start, Clock::now()});
+        }
+        bulkRunning = false;
+    });
+
+    std::vector<Interval> messages;
+    uint8_t message[MESSAGE_SIZE];
+    while(bulkRunning) {
+        int index = (int) messages.size();
+        message[0] = TestPackets::pattern(index, 0);
+        message[MESSAGE_SIZE - 1] = TestPackets::pattern(index, MESSAGE_SIZE - 1);
+        auto start = Clock::now();
+        if(XLinkWriteData(control, message, sizeof(message)) != X_LINK_SUCCESS) {
+            printf("Control write failed\n");
+            ok = false;
+            break;
+        }
+        messages.push_back({start, Clock::now()});
+        std::this_thread::sleep_for(std::chrono::microseconds(MESSAGE_INTERVAL_US));
+    }
+    bulkRunning = false;
+    bulkWriter.join();
+
+    if(ok && (!bulkOk || bulkWrites.size() != NUM_BULK_WRITES || messages.size() < MIN_MESSAGES)) {
+        printf("Bulk writes failed or too few control messages: %d\n", (int) messages.size());
+        ok = false;
+    }
+    if(ok) {
+        int checked = 0;
+        int overtaken = countOvertaken(bulkWrites, messages, checked);
+        if(checked == 0 || overtaken > 0) {
+            printf("%d of %d control messages waited for the bulk write in flight\n", overtaken, checked);
+            ok = false;
+        }
+    }
+
+    streamPacketDesc_t* p;
+    if(bulk == INVALID_STREAM_ID || control == INVALID_STREAM_ID || XLinkWriteData(bulk, &END, sizeof(END)) != X_LINK_SUCCESS
+       || XLinkWriteData(control, &END, sizeof(END)) != X_LINK_SUCCESS || XLinkReadData(control, &p) != X_LINK_SUCCESS) {
+        printf("Ending the streams failed\n");
+        ok = false;
+    }
+
+    XLinkResetRemote(handler.linkId);
+    peer.join();
+
+    ok = ok && peerOk;
+    printf("%s\n", ok ? "Success" : "Failed");
+    return ok ? 0 : -1;
+}
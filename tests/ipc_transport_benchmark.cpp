@@ -0,0 +1,153 @@
+#include <XLink/XLink.h>
+#include <cstdio>
+#include <chrono>
+#include <thread>
+#include <vector>
+#include <algorithm>
+
+#include <signal.h>
+#include <unistd.h>
+#include <sys/wait.h>
+
+// The following benchmark compares the X_LINK_IPC shared memory transport with TCP loopback.
+// It forks a peer process which serves both links with XLinkServer, so no device is needed.
+// Latency is the round trip of a small message, throughput is measured with 1MB writes.
+
+constexpr static auto NUM_ROUND_TRIPS = 10000;
+constexpr static auto NUM_BULK_WRITES = 1000;
+constexpr static auto MESSAGE_SIZE = 64;
+constexpr static auto BULK_SIZE = 1024 * 1024;
+
+struct Endpoint {
+    XLinkProtocol_t protocol;
+    const char* name;
+    const char* path;
+};
+
+static const Endpoint endpoints[] = {
+    {X_LINK_IPC, "ipc", "bench"},
+    {X_LINK_TCP_IP, "tcp loopback", "127.0.0.1"},
+};
+
+static int runPeer() {
+    XLinkGlobalHandler_t gHandler = {};
+    XLinkInitialize(&gHandler);
+
+    for(const auto& endpoint : endpoints) {
+        XLinkHandler_t handler = {};
+        handler.devicePath = const_cast<char*>(endpoint.path);
+        handler.protocol = endpoint.protocol;
+        if(XLinkServer(&handler) != X_LINK_SUCCESS) {
+            printf("Peer: serving %s failed\n", endpoint.name);
+            return -1;
+        }
+
+        auto data = XLinkOpenStream(handler.linkId, "bench_data", MESSAGE_SIZE);
+        auto ack = XLinkOpenStream(handler.linkId, "bench_ack", MESSAGE_SIZE);
+        if(data == INVALID_STREAM_ID || ack == INVALID_STREAM_ID) {
+            printf("Peer: open stream failed\n");
+            return -1;
+        }
+
+        uint8_t message[MESSAGE_SIZE] = {0};
+        streamPacketDesc_t* p;
+        for(int i = 0; i < NUM_ROUND_TRIPS; i++) {
+            XLinkReadData(data, &p);
+            XLinkReleaseData(data);
+            XLinkWriteData(ack, message, sizeof(message));
+        }
+        for(int i = 0; i < NUM_BULK_WRITES; i++) {
+            XLinkReadData(data, &p);
+            XLinkReleaseData(data);
+        }
+        XLinkWriteData(ack, message, sizeof(message));
+
+        // returns once the host reset the link
+        XLinkReadData(data, &p);
+    }
+    return 0;
+}
+
+static bool connectWithRetry(XLinkHandler_t& handler) {
+    // the peer may not be listening yet
+    for(int i = 0; i < 100; i++) {
+        if(XLinkConnect(&handler) == X_LINK_SUCCESS) return true;
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    }
+    return false;
+}
+
+static bool runHost(const Endpoint& endpoint) {
+    XLinkHandler_t handler = {};
+    handler.devicePath = const_cast<char*>(endpoint.path);
+    handler.protocol = endpoint.protocol;
+    if(!connectWithRetry(handler)) {
+        printf("Connecting over %s failed\n", endpoint.name);
+        return false;
+    }
+
+    auto data = XLinkOpenStream(handler.linkId, "bench_data", 8 * BULK_SIZE);
+    auto ack = XLinkOpenStream(handler.linkId, "bench_ack", MESSAGE_SIZE);
+    if(data == INVALID_STREAM_ID || ack == INVALID_STREAM_ID) {
+        printf("Open stream failed...\n");
+        return false;
+    }
+
+    uint8_t message[MESSAGE_SIZE] = {0};
+    streamPacketDesc_t* p;
+    std::vector<double> latencies;
+    for(int i = 0; i < NUM_ROUND_TRIPS; i++) {
+        auto start = std::chrono::steady_clock::now();
+        if(XLinkWriteData(data, message, sizeof(message)) != X_LINK_SUCCESS
+           || XLinkReadData(ack, &p) != X_LINK_SUCCESS) {
+            printf("Round trip failed\n");
+            return false;
+        }
+        XLinkReleaseData(ack);
+        std::chrono::duration<double, std::micro> latency = std::chrono::steady_clock::now() - start;
+        latencies.push_back(latency.count());
+    }
+
+    std::vector<uint8_t> payload(BULK_SIZE);
+    auto start = std::chrono::steady_clock::now();
+    for(int i = 0; i < NUM_BULK_WRITES; i++) {
+        if(XLinkWriteData(data, payload.data(), (int)payload.size()) != X_LINK_SUCCESS) {
+            printf("Bulk write failed\n");
+            return false;
+        }
+    }
+    XLinkReadData(ack, &p);
+    XLinkReleaseData(ack);
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+    std::sort(latencies.begin(), latencies.end());
+    printf("%s - round trip p50: %.1f us, p99: %.1f us, throughput: %.0f MB/s\n", endpoint.name,
+           latencies[latencies.size() / 2], latencies[latencies.size() * 99 / 100],
+           NUM_BULK_WRITES * (BULK_SIZE / (1024.0 * 1024.0)) / elapsed.count());
+
+    XLinkResetRemote(handler.linkId);
+    return true;
+}
+
+int main() {
+    pid_t peer = fork();
+    if(peer == 0) {
+        return runPeer();
+    }
+
+    XLinkGlobalHandler_t gHandler = {};
+    XLinkInitialize(&gHandler);
+
+    bool ok = true;
+    for(const auto& endpoint : endpoints) {
+        ok = runHost(endpoint) && ok;
+    }
+
+    if(!ok) {
+        // the peer would keep waiting for the next link
+        kill(peer, SIGKILL);
+    }
+    int status = 0;
+    waitpid(peer, &status, 0);
+    return (ok && WIFEXITED(status) && WEXITSTATUS(status) == 0) ? 0 : -1;
+}
@@ -0,0 +1,121 @@
+#include <XLink/XLink.h>
+#include <XLink/XLinkLog.h>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <thread>
+#include <atomic>
+#include "test_common.hpp"
+
+// The following test needs no device: the device side of the link is served by a thread of
+// the same process. The host keeps only the latest packets of a stream and reads slowly,
+// which mustn't hold back the remote writing many times its write window. Dropped packets
+// show up as gaps of the sequence numbers and in the drop counter, and once the remote is
+// done the last packet is at most a few reads away.
+
+constexpr static auto LINK_NAME = "keep_latest_test";
+constexpr static auto STREAM_NAME = "latest";
+constexpr static auto WINDOW = 16 * 1024;
+constexpr static auto NUM_PACKETS = 500;
+constexpr static auto KEEP_LATEST = 2;
+constexpr static auto SLOW_READ_MS = 5;
+constexpr static TestPackets PACKETS = {NUM_PACKETS, WINDOW / 4, true};
+
+static void runPeer(std::atomic<bool>& ok, std::atomic<bool>& done) {
+    XLinkHandler_t handler = {};
+    if(!serveLink(LINK_NAME, X_LINK_LOOPBACK, handler)) {
+        ok = false;
+        return;
+    }
+    auto s = XLinkOpenStream(handler.linkId, STREAM_NAME, WINDOW);
+    // the host sends a packet once it's ready to read
+    if(!waitForHost(s)) {
+        ok = false;
+        return;
+    }
+    std::vector<uint8_t> payload(WINDOW);
+    for(int i = 0; i < NUM_PACKETS && ok; i++) {
+        ok = PACKETS.write(s, i, payload);
+    }
+    done = true;
+    streamPacketDesc_t* p;
+    // returns an error once the host reset the link
+    XLinkReadData(s, &p);
+}
+
+int main() {
+    // failing reads of the peer at the reset are expected
+    mvLogDefaultLevelSet(MVLOG_FATAL);
+    XLinkGlobalHandler_t gHandler = {};
+    XLinkInitialize(&gHandler);
+
+    std::atomic<bool> peerOk{true}, peerDone{false};
+    std::thread peer(runPeer, std::ref(peerOk), std::ref(peerDone));
+
+    XLinkHandler_t handler = {};
+    bool ok = connectLink(LINK_NAME, X_LINK_LOOPBACK, handler);
+
+    XLinkStreamOptions_t options = {};
+    options.keepLatestPackets = KEEP_LATEST;
+    auto s = ok ? XLinkOpenStreamWithOptions(handler.linkId, STREAM_NAME, 64, &options) : INVALID_STREAM_ID;
+    uint8_t go = 1;
+    if(s == INVALID_STREAM_ID || XLinkWriteData(s, &go, 1) != X_LINK_SUCCESS) {
+        printf("Opening the stream failed\n");
+        ok = false;
+    }
+
+    int index = -1, read = 0, readWhileWriting = 0, readAfterDone = 0;
+    uint64_t gaps = 0;
+    uint32_t nextSequence = 0;
+    while(ok && index != NUM_PACKETS - 1) {
+        streamPacketDesc_t* p;
+        if(XLinkReadData(s, &p) != X_LINK_SUCCESS) {
+            printf("Reading failed after packet %d\n", index);
+            ok = false;
+            break;
+        }
+        int previous = index;
+        uint32_t sequence = 0;
+        if(!PACKETS.isIntact(p, index) || index <= previous || XLinkGetPacketSequence(s, p, &sequence) != X_LINK_SUCCESS
+           || sequence != (uint32_t) index) {
+            printf("Packet %d is wrong, sequence %u after %d\n", index, sequence, previous);
+            ok = false;
+        }
+        gaps += sequence - nextSequence;
+        nextSequence = sequence + 1;
+        read++;
+        if(peerDone) {
+            readAfterDone++;
+        } else {
+            readWhileWriting++;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(SLOW_READ_MS));
+        XLinkReleaseData(s);
+    }
+
+    uint64_t dropped = 0;
+    if(ok && (XLinkGetStreamDroppedPackets(s, &dropped) != X_LINK_SUCCESS || dropped != gaps
+              || dropped != (uint64_t) (NUM_PACKETS - read))) {
+        printf("Dropped %llu packets, the sequence skipped %llu of them\n", (unsigned long long) dropped,
+               (unsigned long long) gaps);
+        ok = false;
+    }
+    if(ok && readWhileWriting >= NUM_PACKETS / 2) {
+        printf("Remote was held back by the slow reader\n");
+        ok = false;
+    }
+    // one packet may be handed out already when the remote finished
+    if(ok && readAfterDone > KEEP_LATEST + 1) {
+        printf("Last packet was %d reads behind\n", readAfterDone);
+        ok = false;
+    }
+
+    XLinkResetRemote(handler.linkId);
+    peer.join();
+
+    ok = ok && peerOk;
+    printf("%s\n", ok ? "Success" : "Failed");
+    return ok ? 0 : -1;
+}
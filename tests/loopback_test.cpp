@@ -0,0 +1,151 @@
+#include <XLink/XLink.h>
+#include <cstdio>
+#include <vector>
+#include <string>
+#include <chrono>
+#include <thread>
+#include <algorithm>
+#include <atomic>
+
+// The following test needs no device: the device side of the link is served by a thread
+// of the same process over X_LINK_LOOPBACK, the host side uses the regular API.
+// It opens many streams from both sides in random order, checks the data written on them
+// and measures the round trip of small messages, which is the overhead of XLink itself.
+
+constexpr static auto LINK_NAME = "loopback_test";
+constexpr static auto NUM_STREAMS = 16;
+constexpr static auto NUM_ROUND_TRIPS = 10000;
+constexpr static auto MESSAGE_SIZE = 64;
+
+static std::atomic<bool> peerOk{true};
+
+static void runPeer() {
+    XLinkHandler_t handler = {};
+    handler.devicePath = const_cast<char*>(LINK_NAME);
+    handler.protocol = X_LINK_LOOPBACK;
+    if(XLinkServer(&handler) != X_LINK_SUCCESS) {
+        printf("Peer: serving the link failed\n");
+        peerOk = false;
+        return;
+    }
+
+    std::thread threads[NUM_STREAMS];
+    for(int i = 0; i < NUM_STREAMS; i++) {
+        threads[i] = std::thread([&, i](){
+            std::string name = "test_" + std::to_string(i);
+            auto s = XLinkOpenStream(handler.linkId, name.c_str(), 1024);
+            if(s == INVALID_STREAM_ID || XLinkWriteData(s, (uint8_t*) &s, sizeof(s)) != X_LINK_SUCCESS) {
+                peerOk = false;
+            }
+        });
+    }
+    for(auto& thread : threads) {
+        thread.join();
+    }
+
+    auto echo = XLinkOpenStream(handler.linkId, "echo", MESSAGE_SIZE);
+    if(echo == INVALID_STREAM_ID) {
+        peerOk = false;
+        return;
+    }
+    streamPacketDesc_t* p;
+    while(XLinkReadData(echo, &p) == X_LINK_SUCCESS) {
+        // returns an error once the host reset the link
+        XLinkWriteData(echo, p->data, p->length);
+        XLinkReleaseData(echo);
+    }
+}
+
+int main() {
+
+    XLinkGlobalHandler_t gHandler = {};
+    XLinkInitialize(&gHandler);
+
+    std::thread peer(runPeer);
+
+    XLinkHandler_t handler = {};
+    handler.devicePath = const_cast<char*>(LINK_NAME);
+    handler.protocol = X_LINK_LOOPBACK;
+    // the peer may not be serving yet
+    bool connected = false;
+    for(int i = 0; i < 100 && !connected; i++) {
+        connected = XLinkConnect(&handler) == X_LINK_SUCCESS;
+        if(!connected) std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    if(!connected) {
+        printf("Connecting failed\n");
+        return -1;
+    }
+
+    // loop randomly over streams
+    std::vector<int> randomized;
+    for(int i = 0; i < NUM_STREAMS; i++){
+        randomized.push_back(i);
+    }
+    std::random_shuffle(std::begin(randomized), std::end(randomized));
+
+    std::atomic<bool> ok{true};
+    std::thread threads[NUM_STREAMS];
+    for(auto i : randomized){
+        threads[i] = std::thread([&, i](){
+            std::string name = "test_" + std::to_string(i);
+            auto s = XLinkOpenStream(handler.linkId, name.c_str(), 1024);
+            streamPacketDesc_t* p;
+            if(s == INVALID_STREAM_ID || XLinkReadData(s, &p) != X_LINK_SUCCESS) {
+                printf("Open stream or read failed - name %s\n", name.c_str());
+                ok = false;
+                return;
+            }
+            // the peer writes the id it got for the stream, ids are combined with the
+            // id of the link on each side
+            constexpr streamId_t STREAM_MASK = 0x00FFFFFF;
+            if(p->length != sizeof(s) || (*(streamId_t*) p->data & STREAM_MASK) != (s & STREAM_MASK)) {
+                printf("Stream id mismatch - name %s, id: 0x%08X\n", name.c_str(), s);
+                ok = false;
+            }
+            XLinkReleaseData(s);
+        });
+    }
+    for(auto i : randomized){
+        threads[i].join();
+    }
+
+    auto echo = XLinkOpenStream(handler.linkId, "echo", MESSAGE_SIZE);
+    if(echo == INVALID_STREAM_ID) {
+        printf("Open stream failed...\n");
+        return -1;
+    }
+    uint8_t message[MESSAGE_SIZE] = {0};
+    streamPacketDesc_t* p;
+    std::vector<double> latencies;
+    for(int i = 0; i < NUM_ROUND_TRIPS && ok; i++) {
+        message[0] = (uint8_t) i;
+        auto start = std::chrono::steady_clock::now();
+        if(XLinkWriteData(echo, message, sizeof(message)) != X_LINK_SUCCESS
+           || XLinkReadData(echo, &p) != X_LINK_SUCCESS) {
+            printf("Round trip failed\n");
+            ok = false;
+            break;
+        }
+        std::chrono::duration<double, std::micro> latency = std::chrono::steady_clock::now() - start;
+        latencies.push_back(latency.count());
+        if(p->length != sizeof(message) || p->data[0] != message[0]) {
+            printf("Echo mismatch\n");
+            ok = false;
+        }
+        XLinkReleaseData(echo);
+    }
+
+    XLinkResetRemote(handler.linkId);
+    peer.join();
+
+    if(!latencies.empty()) {
+        std::sort(latencies.begin(), latencies.end());
+        printf("loopback round trip p50: %.1f us, p99: %.1f us\n",
+               latencies[latencies.size() / 2], latencies[latencies.size() * 99 / 100]);
+    }
+
+    ok = ok && peerOk;
+    printf("%s\n", ok ? "Success" : "Failed");
+    return ok ? 0 : -1;
+}
@@ -0,0 +1,128 @@
+#include <XLink/XLink.hpp>
+#include <XLink/XLinkLog.h>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+#include <set>
+#include <chrono>
+#include <thread>
+#include <atomic>
+
+// The following test needs no device: the device side of the link is served by a thread
+// of the same process over X_LINK_LOOPBACK and echoes every packet.
+// The host side uses the C++ layer of XLink.hpp. It keeps as many packets as the in-flight
+// budget allows, checks that one more read is refused, and destroys them out of order.
+// Once the first window was received, all packets must be received into recycled buffers.
+
+constexpr static auto LINK_NAME = "packet_pool_test";
+constexpr static auto STREAM_NAME = "pool";
+constexpr static auto PACKET_SIZE = 4096;
+constexpr static auto MAX_IN_FLIGHT = 4;
+constexpr static auto NUM_WINDOWS = 1000;
+
+static std::atomic<bool> peerOk{true};
+
+static void runPeer() {
+    XLinkHandler_t handler = {};
+    handler.devicePath = const_cast<char*>(LINK_NAME);
+    handler.protocol = X_LINK_LOOPBACK;
+    if(XLinkServer(&handler) != X_LINK_SUCCESS) {
+        printf("Peer: serving the link failed\n");
+        peerOk = false;
+        return;
+    }
+
+    auto s = XLinkOpenStream(handler.linkId, STREAM_NAME, MAX_IN_FLIGHT * PACKET_SIZE);
+    if(s == INVALID_STREAM_ID) {
+        peerOk = false;
+        return;
+    }
+    streamPacketDesc_t* p;
+    while(XLinkReadData(s, &p) == X_LINK_SUCCESS) {
+        // returns an error once the host closed the stream or reset the link
+        XLinkWriteData(s, p->data, p->length);
+        XLinkReleaseData(s);
+    }
+}
+
+int main() {
+    mvLogDefaultLevelSet(MVLOG_FATAL);
+    XLinkGlobalHandler_t gHandler = {};
+    XLinkInitialize(&gHandler);
+
+    std::thread peer(runPeer);
+
+    XLinkHandler_t handler = {};
+    handler.devicePath = const_cast<char*>(LINK_NAME);
+    handler.protocol = X_LINK_LOOPBACK;
+    // the peer may not be serving yet
+    bool connected = false;
+    for(int i = 0; i < 100 && !connected; i++) {
+        connected = XLinkConnect(&handler) == X_LINK_SUCCESS;
+        if(!connected) std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    if(!connected) {
+        printf("Connecting failed\n");
+        return -1;
+    }
+
+    auto stream = xlink::Stream::open(handler.linkId, STREAM_NAME, MAX_IN_FLIGHT * PACKET_SIZE, MAX_IN_FLIGHT);
+    if(!stream.valid()) {
+        printf("Open stream failed...\n");
+        return -1;
+    }
+
+    bool ok = true;
+    std::vector<uint8_t> message(PACKET_SIZE);
+    std::set<uint8_t*> buffers;
+    xlink::Packet kept;
+    for(int window = 0; window < NUM_WINDOWS && ok; window++) {
+        std::vector<xlink::Packet> packets(MAX_IN_FLIGHT);
+        for(int i = 0; i < MAX_IN_FLIGHT && ok; i++) {
+            memset(message.data(), window * MAX_IN_FLIGHT + i, message.size());
+            ok = stream.write(message.data(), (int) message.size()) == X_LINK_SUCCESS
+                 && stream.read(packets[i]) == X_LINK_SUCCESS;
+        }
+        if(!ok) {
+            printf("Round trip failed\n");
+            break;
+        }
+
+        xlink::Packet extra;
+        if(stream.read(extra) != X_LINK_OUT_OF_MEMORY || extra || stream.inFlight() != MAX_IN_FLIGHT) {
+            printf("Read over the in-flight budget wasn't refused\n");
+            ok = false;
+        }
+        for(int i = 0; i < MAX_IN_FLIGHT; i++) {
+            auto& packet = packets[i];
+            uint8_t expected = (uint8_t) (window * MAX_IN_FLIGHT + i);
+            if(packet.size() != PACKET_SIZE || packet.data()[0] != expected || packet.data()[PACKET_SIZE - 1] != expected) {
+                printf("Echo mismatch\n");
+                ok = false;
+            }
+            buffers.insert(packet.data());
+        }
+        // destroyed out of order, the last packet of the last window outlives the stream
+        packets[1].reset();
+        std::swap(packets[0], packets[2]);
+        if(window == NUM_WINDOWS - 1) kept = std::move(packets.back());
+    }
+
+    if(ok && (stream.inFlight() != 1 || !kept)) {
+        printf("Packets weren't handed back\n");
+        ok = false;
+    }
+    if(ok && buffers.size() > MAX_IN_FLIGHT) {
+        printf("Steady-state reads used %zu buffers instead of at most %d\n", buffers.size(), MAX_IN_FLIGHT);
+        ok = false;
+    }
+
+    stream.close();
+    kept.reset();
+    XLinkResetRemote(handler.linkId);
+    peer.join();
+
+    ok = ok && peerOk;
+    printf("%s\n", ok ? "Success" : "Failed");
+    return ok ? 0 : -1;
+}
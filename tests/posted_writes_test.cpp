@@ -0,0 +1,226 @@
+#include <XLink/XLink.h>
+#include <XLink/XLinkLog.h>
+extern "C" {
+#include <XLink/XLinkPrivateFields.h>
+}
+#include <cstdio>
+#include <vector>
+#include <functional>
+#include <chrono>
+#include <thread>
+#include <atomic>
+#include "test_common.hpp"
+
+// The following test needs no device: the device side of the link is served by a thread of
+// the same process. The host writes a stream with posted writes while the remote is held in
+// the stream, so it can neither receive nor read them. The writes must complete anyway, stay
+// in flight until the remote acknowledged them and closing the stream must wait for them.
+// The host then pretends the remote doesn't support posted writes, whose writes must wait
+// for the remote as acknowledged writes do.
+
+constexpr static auto LINK_NAME = "posted_writes_test";
+constexpr static auto POSTED_STREAM = "posted";
+constexpr static auto ACKNOWLEDGED_STREAM = "acknowledged";
+constexpr static auto WINDOW = 16 * 1024;
+constexpr static auto NUM_PACKETS = 8;
+constexpr static auto SETTLE_MS = 100;
+constexpr static auto WRITE_TIMEOUT_MS = 1000;
+constexpr static TestPackets PACKETS = {2 * NUM_PACKETS, 1024, true};
+
+static std::atomic<linkId_t> peerLinkId{0};
+static std::atomic<streamId_t> peerPosted{INVALID_STREAM_ID}, peerAcknowledged{INVALID_STREAM_ID};
+
+// reads until the link is reset, packets must arrive in order
+static void readPeer(streamId_t s, std::atomic<bool>& ok, std::atomic<int>& read) {
+    streamPacketDesc_t* p;
+    while(XLinkReadData(s, &p) == X_LINK_SUCCESS) {
+        int index = -1;
+        if(!PACKETS.isIntact(p, index) || index != read) {
+            printf("Peer: packet %d is wrong after %d\n", index, read.load());
+            ok = false;
+        }
+        // counted before the release, which credits the host
+        read++;
+        XLinkReleaseData(s);
+    }
+}
+
+static void runPeer(std::atomic<bool>& ok, std::atomic<int>& postedRead, std::atomic<int>& acknowledgedRead) {
+    XLinkHandler_t handler = {};
+    if(!serveLink(LINK_NAME, X_LINK_LOOPBACK, handler)) {
+        ok = false;
+        return;
+    }
+    auto posted = XLinkOpenStream(handler.linkId, POSTED_STREAM, WINDOW);
+    auto acknowledged = XLinkOpenStream(handler.linkId, ACKNOWLEDGED_STREAM, WINDOW);
+    if(posted == INVALID_STREAM_ID || acknowledged == INVALID_STREAM_ID) {
+        ok = false;
+        return;
+    }
+    peerLinkId = handler.linkId;
+    peerPosted = posted;
+    peerAcknowledged = acknowledged;
+    std::thread postedReader(readPeer, posted, std::ref(ok), std::ref(postedRead));
+    std::thread acknowledgedReader(readPeer, acknowledged, std::ref(ok), std::ref(acknowledgedRead));
+    postedReader.join();
+    acknowledgedReader.join();
+}
+
+// takes the stream as the dispatcher does, which stalls the events of the stream meanwhile
+static streamDesc_t* holdStream(linkId_t linkId, streamId_t s) {
+    xLinkDesc_t* link = getLinkById(linkId);
+    return link ? getStreamById(link->deviceHandle.xLinkFD, EXTRACT_STREAM_ID(s)) : nullptr;
+}
+
+static int postedWritesInFlight(linkId_t linkId, streamId_t s) {
+    streamDesc_t* stream = holdStream(linkId, s);
+    if(stream == nullptr) return -1;
+    int inFlight = (int) stream->postedWritesInFlight;
+    releaseStream(stream);
+    return inFlight;
+}
+
+// waits until the remote read the given number of packets and acknowledged every posted write
+static bool waitDrained(linkId_t linkId, streamId_t s, std::atomic<int>& read, int expected) {
+    for(int i = 0; i < 100; i++) {
+        if(read == expected && postedWritesInFlight(linkId, s) == 0) return true;
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    return false;
+}
+
+static bool writePackets(streamId_t s, int first, int count) {
+    std::vector<uint8_t> payload(PACKETS.size(0) + PACKETS.sizeSpread);
+    for(int i = first; i < first + count; i++) {
+        if(!PACKETS.write(s, i, payload)) return false;
+    }
+    return true;
+}
+
+// Writes while the remote is held in its stream, checks whileHeld before letting it go.
+// Returns whether the writes returned while the remote was held, within timeoutMs
+static bool writeWhileHeld(linkId_t peerLink, streamId_t peerStream, streamId_t s, int first, int count,
+                           int timeoutMs, bool& writeOk, const std::function<void()>& whileHeld) {
+    streamDesc_t* held = holdStream(peerLink, peerStream);
+    if(held == nullptr) return false;
+    std::atomic<bool> written{false};
+    std::thread writer([&] {
+        writeOk = writePackets(s, first, count);
+        written = true;
+    });
+    for(int i = 0; i < timeoutMs / 10 && !written; i++) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    bool returned = written;
+    whileHeld();
+    releaseStream(held);
+    writer.join();
+    return returned;
+}
+
+int main() {
+    // failing reads of the peer at the reset are expected
+    mvLogDefaultLevelSet(MVLOG_FATAL);
+    XLinkGlobalHandler_t gHandler = {};
+    XLinkInitialize(&gHandler);
+
+    std::atomic<bool> peerOk{true};
+    std::atomic<int> postedRead{0}, acknowledgedRead{0};
+    std::thread peer(runPeer, std::ref(peerOk), std::ref(postedRead), std::ref(acknowledgedRead));
+
+    XLinkHandler_t handler = {};
+    bool ok = connectLink(LINK_NAME, X_LINK_LOOPBACK, handler);
+    for(int i = 0; i < 100 && ok && peerOk && peerAcknowledged == INVALID_STREAM_ID; i++) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+
+    XLinkStreamOptions_t options = {};
+    options.postedWrites = 1;
+    auto s = ok ? XLinkOpenStreamWithOptions(handler.linkId, POSTED_STREAM, WINDOW, &options) : INVALID_STREAM_ID;
+    if(s == INVALID_STREAM_ID || peerPosted == INVALID_STREAM_ID) {
+        printf("Opening the stream failed\n");
+        ok = false;
+    }
+
+    // posted writes complete while the remote can't even receive them
+    bool writeOk = false;
+    int readBefore = -1, inFlight = -1;
+    if(ok && !writeWhileHeld(peerLinkId, peerPosted, s, 0, NUM_PACKETS, WRITE_TIMEOUT_MS, writeOk, [&] {
+           readBefore = postedRead;
+           inFlight = postedWritesInFlight(handler.linkId, s);
+       })) {
+        printf("Posted writes didn't return before the remote received them\n");
+        ok = false;
+    }
+    if(ok && (!writeOk || readBefore != 0 || inFlight != NUM_PACKETS)) {
+        printf("Posted writes %s, remote read %d packets, %d in flight after %d writes\n", writeOk ? "succeeded" : "failed",
+               readBefore, inFlight, NUM_PACKETS);
+        ok = false;
+    }
+    // the remote acknowledges them cumulatively once it received them
+    if(ok && !waitDrained(handler.linkId, s, postedRead, NUM_PACKETS)) {
+        printf("Remote read %d packets, %d posted writes still in flight\n", postedRead.load(),
+               postedWritesInFlight(handler.linkId, s));
+        ok = false;
+    }
+
+    // closing the stream waits for the posted writes in flight
+    std::atomic<bool> closed{false};
+    std::atomic<int> readAtClose{-1};
+    XLinkError_t closeRc = X_LINK_ERROR;
+    std::thread closer;
+    if(ok && (!writeWhileHeld(peerLinkId, peerPosted, s, NUM_PACKETS, NUM_PACKETS, WRITE_TIMEOUT_MS, writeOk, [&] {
+           closer = std::thread([&] {
+               closeRc = XLinkCloseStream(s);
+               readAtClose = postedRead.load();
+               closed = true;
+           });
+           std::this_thread::sleep_for(std::chrono::milliseconds(SETTLE_MS));
+       }) || !writeOk)) {
+        printf("Posted writes failed before the close\n");
+        ok = false;
+    }
+    if(ok && closed) {
+        printf("Stream closed with posted writes in flight\n");
+        ok = false;
+    }
+    if(closer.joinable()) closer.join();
+    if(ok && (closeRc != X_LINK_SUCCESS || readAtClose != 2 * NUM_PACKETS)) {
+        printf("Closing the stream returned %d after the remote read %d packets\n", closeRc, readAtClose.load());
+        ok = false;
+    }
+
+    // without the capability of the remote, writes wait for its response
+    xLinkDesc_t* link = getLinkById(handler.linkId);
+    if(link) link->peerCapabilities &= ~XLINK_CAPABILITY_POSTED_WRITE;
+    auto fallback = ok ? XLinkOpenStreamWithOptions(handler.linkId, ACKNOWLEDGED_STREAM, WINDOW, &options)
+                       : INVALID_STREAM_ID;
+    streamDesc_t* stream = fallback != INVALID_STREAM_ID ? holdStream(handler.linkId, fallback) : nullptr;
+    if(ok && (stream == nullptr || stream->postedWrites)) {
+        printf("Stream %s posted writes the remote doesn't support\n", stream ? "kept" : "failed opening with");
+        ok = false;
+    }
+    if(stream) releaseStream(stream);
+    inFlight = -1;
+    if(ok && writeWhileHeld(peerLinkId, peerAcknowledged, fallback, 0, 1, SETTLE_MS, writeOk, [&] {
+           inFlight = postedWritesInFlight(handler.linkId, fallback);
+       })) {
+        printf("Write completed before the remote received it\n");
+        ok = false;
+    }
+    if(ok && inFlight != 0) {
+        printf("%d posted writes in flight on a stream without them\n", inFlight);
+        ok = false;
+    }
+    if(ok && (!writeOk || !waitDrained(handler.linkId, fallback, acknowledgedRead, 1))) {
+        printf("Acknowledged write failed, remote read %d packets\n", acknowledgedRead.load());
+        ok = false;
+    }
+
+    XLinkResetRemote(handler.linkId);
+    peer.join();
+
+    ok = ok && peerOk;
+    printf("%s\n", ok ? "Success" : "Failed");
+    return ok ? 0 : -1;
+}
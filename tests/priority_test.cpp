@@ -0,0 +1,229 @@
+#include <XLink/XLink.h>
+#include <XLink/XLinkLog.h>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <thread>
+#include <atomic>
+#include <mutex>
+#include "test_common.hpp"
+
+// The following test needs no device: the device side of the link is served by a thread of
+// the same process, reached over TCP loopback through a proxy of the test. Pausing the proxy
+// stalls the dispatcher of the host in a send, so the bulk writes of many writers queue up
+// behind it. A write on a stream of the control class queued after them must be sent ahead of
+// them once the proxy resumes. The peer checks that the packets of every writer arrive whole
+// and in the order they were written.
+
+constexpr static auto PEER_PORT = 11610;
+constexpr static auto PROXY_PORT = 11611;
+constexpr static auto PROXY_PATH = "127.0.0.1:11611";
+constexpr static auto CONTROL_STREAM_NAME = "control";
+constexpr static auto NUM_BULK_STREAMS = 4;
+constexpr static auto WRITERS_PER_STREAM = 2;
+constexpr static auto NUM_WRITERS = NUM_BULK_STREAMS * WRITERS_PER_STREAM;
+// more than the socket buffers of the host take, so a send stalls while the proxy is paused
+constexpr static auto BULK_SIZE = 8 * 1024 * 1024;
+constexpr static auto BULK_WINDOW = WRITERS_PER_STREAM * BULK_SIZE;
+constexpr static auto MESSAGE_SIZE = 64;
+constexpr static auto NUM_ROUNDS = 5;
+constexpr static auto QUEUE_MS = 100;
+// bulk writes a control write may complete after: the one in flight when it was queued, and one
+// more which larger socket buffers than the usual may have taken whole
+constexpr static auto MAX_OVERTAKEN_BY = 2;
+// shorter than a header, ends a stream
+constexpr static uint8_t END = 0;
+
+static std::string bulkStreamName(int stream) {
+    return "bulk_" + std::to_string(stream);
+}
+
+// the pattern of a writer's packets, so writers only stamp the header of the next one
+static std::vector<uint8_t> makePayload(int writer, uint32_t size) {
+    std::vector<uint8_t> payload(size);
+    for(uint32_t j = 0; j < size; j++) {
+        payload[j] = TestPackets::pattern(writer, j);
+    }
+    return payload;
+}
+
+static void writeHeader(std::vector<uint8_t>& payload, int writer, int index) {
+    memcpy(payload.data(), &writer, sizeof(writer));
+    memcpy(payload.data() + sizeof(writer), &index, sizeof(index));
+}
+
+// the index of the packet, or -1 when it's broken
+static int readHeader(const streamPacketDesc_t* p, int& writer) {
+    int index;
+    if(p->length < sizeof(writer) + sizeof(index)) return -1;
+    memcpy(&writer, p->data, sizeof(writer));
+    memcpy(&index, p->data + sizeof(writer), sizeof(index));
+    for(uint32_t j = sizeof(writer) + sizeof(index); j < p->length; j++) {
+        if(p->data[j] != TestPackets::pattern(writer, j)) return -1;
+    }
+    return index;
+}
+
+// reads a stream until it ends, next holds the next index of every writer
+static bool runReader(streamId_t s, const std::string& name, std::vector<int>& next, std::mutex& nextMutex) {
+    streamPacketDesc_t* p;
+    for(bool ok = true;;) {
+        if(XLinkReadData(s, &p) != X_LINK_SUCCESS) {
+            printf("Peer: reading %s failed\n", name.c_str());
+            return false;
+        }
+        if(p->length == sizeof(END)) {
+            XLinkReleaseData(s);
+            return ok;
+        }
+        int writer = -1;
+        int index = readHeader(p, writer);
+        std::lock_guard<std::mutex> lock(nextMutex);
+        if(index < 0 || writer < 0 || writer >= (int) next.size()) {
+            printf("Peer: received a broken packet on %s\n", name.c_str());
+            ok = false;
+        } else if(index != next[writer]) {
+            printf("Peer: packet %d of writer %d on %s arrived, expected %d\n", index, writer, name.c_str(), next[writer]);
+            ok = false;
+        } else {
+            next[writer]++;
+        }
+        XLinkReleaseData(s);
+    }
+}
+
+static void runPeer(std::atomic<bool>& ok) {
+    XLinkHandler_t handler = {};
+    std::string path = "127.0.0.1:" + std::to_string(PEER_PORT);
+    if(!serveLink(path.c_str(), X_LINK_TCP_IP, handler)) {
+        ok = false;
+        return;
+    }
+    // the control stream is written by one more writer
+    std::vector<int> next(NUM_WRITERS + 1, 0);
+    std::mutex nextMutex;
+    std::vector<std::string> names;
+    for(int i = 0; i < NUM_BULK_STREAMS; i++) {
+        names.push_back(bulkStreamName(i));
+    }
+    names.push_back(CONTROL_STREAM_NAME);
+
+    std::vector<streamId_t> streams;
+    std::vector<std::thread> readers;
+    std::vector<char> readersOk(names.size(), 0);
+    for(size_t i = 0; i < names.size(); i++) {
+        streams.push_back(XLinkOpenStream(handler.linkId, names[i].c_str(), 1));
+        if(streams.back() == INVALID_STREAM_ID) {
+            printf("Peer: opening %s failed\n", names[i].c_str());
+            ok = false;
+            continue;
+        }
+        readers.emplace_back([&, i] { readersOk[i] = runReader(streams[i], names[i], next, nextMutex); });
+    }
+    for(auto& reader : readers) reader.join();
+    for(auto readerOk : readersOk) ok = ok && readerOk;
+
+    // the reset of the link frees packets still held, so the host waits for all streams to end.
+    // It may reset the link before the write completed here.
+    auto control = streams.back();
+    if(control != INVALID_STREAM_ID && XLinkWriteData(control, &END, sizeof(END)) == X_LINK_SUCCESS) {
+        streamPacketDesc_t* p;
+        // returns an error once the host reset the link
+        XLinkReadData(control, &p);
+    }
+}
+
+int main() {
+    // failing reads of the peer at the reset are expected
+    mvLogDefaultLevelSet(MVLOG_FATAL);
+    XLinkGlobalHandler_t gHandler = {};
+    XLinkInitialize(&gHandler);
+
+    TestProxy proxy(PROXY_PORT, PEER_PORT);
+    if(!proxy.listen()) {
+        printf("Proxy: listening failed\n");
+        return -1;
+    }
+    std::atomic<bool> peerOk{true}, proxyOk{true};
+    std::thread peer(runPeer, std::ref(peerOk));
+    std::thread proxyConnect([&] { proxyOk = proxy.connect(); });
+
+    XLinkHandler_t handler = {};
+    bool ok = connectLink(PROXY_PATH, X_LINK_TCP_IP, handler);
+    proxyConnect.join();
+    ok = ok && proxyOk;
+
+    std::vector<streamId_t> bulk;
+    for(int i = 0; i < NUM_BULK_STREAMS && ok; i++) {
+        bulk.push_back(XLinkOpenStream(handler.linkId, bulkStreamName(i).c_str(), BULK_WINDOW));
+        ok = bulk.back() != INVALID_STREAM_ID;
+    }
+    XLinkStreamOptions_t options = {};
+    options.priority = X_LINK_PRIORITY_CONTROL;
+    auto control = ok ? XLinkOpenStreamWithOptions(handler.linkId, CONTROL_STREAM_NAME, 1024, &options) : INVALID_STREAM_ID;
+    if(control == INVALID_STREAM_ID) {
+        printf("Opening the streams failed\n");
+        ok = false;
+    }
+
+    std::vector<std::vector<uint8_t>> payloads;
+    for(int i = 0; i < NUM_WRITERS; i++) {
+        payloads.push_back(makePayload(i, BULK_SIZE));
+    }
+    auto message = makePayload(NUM_WRITERS, MESSAGE_SIZE);
+    for(int round = 0; round < NUM_ROUNDS && ok; round++) {
+        // the first bulk write stalls the dispatcher in its send, the others queue up behind it
+        proxy.pause();
+        std::atomic<int> bulkWritten{0};
+        std::atomic<bool> bulkOk{true};
+        std::vector<std::thread> writers;
+        for(int i = 0; i < NUM_WRITERS; i++) {
+            writers.emplace_back([&, i] {
+                writeHeader(payloads[i], i, round);
+                if(XLinkWriteData(bulk[i / WRITERS_PER_STREAM], payloads[i].data(), BULK_SIZE) != X_LINK_SUCCESS) {
+                    bulkOk = false;
+                }
+                bulkWritten++;
+            });
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(QUEUE_MS));
+        int writtenBefore = -1;
+        std::thread controlWriter([&] {
+            writeHeader(message, NUM_WRITERS, round);
+            if(XLinkWriteData(control, message.data(), MESSAGE_SIZE) == X_LINK_SUCCESS) {
+                writtenBefore = bulkWritten;
+            }
+        });
+        std::this_thread::sleep_for(std::chrono::milliseconds(QUEUE_MS));
+        proxy.resume();
+        controlWriter.join();
+        for(auto& writer : writers) writer.join();
+        if(writtenBefore < 0 || !bulkOk) {
+            printf("Writes of round %d failed\n", round);
+            ok = false;
+        } else if(writtenBefore > MAX_OVERTAKEN_BY) {
+            printf("Round %d: %d queued bulk writes completed ahead of the control write\n", round, writtenBefore);
+            ok = false;
+        }
+    }
+
+    for(auto s : bulk) {
+        ok = XLinkWriteData(s, &END, sizeof(END)) == X_LINK_SUCCESS && ok;
+    }
+    streamPacketDesc_t* p;
+    if(control == INVALID_STREAM_ID || XLinkWriteData(control, &END, sizeof(END)) != X_LINK_SUCCESS
+       || XLinkReadData(control, &p) != X_LINK_SUCCESS) {
+        printf("Ending the streams failed\n");
+        ok = false;
+    }
+
+    XLinkResetRemote(handler.linkId);
+    peer.join();
+    proxy.close();
+
+    ok = ok && peerOk;
+    printf("%s\n", ok ? "Success" : "Failed");
+    return ok ? 0 : -1;
+}
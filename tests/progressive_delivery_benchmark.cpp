@@ -0,0 +1,97 @@
+#include <XLink/XLink.h>
+#include <cstdio>
+#include <chrono>
+#include <algorithm>
+
+// The following is an Server side (host) benchmark that compares how soon the first rows
+// of a large frame can be processed when the frame is delivered whole and progressively.
+
+// Use the following code on Client side (device) to test
+// ...
+//    std::vector<uint8_t> frame(FRAME_SIZE);
+//    for(auto name : {"frames_whole", "frames_progressive"}){
+//        auto s = XLinkOpenStream(0, name, 4 * FRAME_SIZE);
+//        assert(s != INVALID_STREAM_ID);
+//        for(int i = 0; i < NUM_FRAMES; i++){
+//            auto w = XLinkWriteData(s, frame.data(), (int)frame.size());
+//            assert(w == X_LINK_SUCCESS);
+//        }
+//    }
+// ...
+
+constexpr static auto NUM_FRAMES = 100;
+constexpr static auto FRAME_SIZE = 3840 * 2160 * 3 / 2;
+constexpr static auto FIRST_ROWS_SIZE = 3840 * 16;
+
+using Clock = std::chrono::steady_clock;
+
+static void readFrames(linkId_t linkId, const char* name, bool progressive) {
+    XLinkStreamOptions_t options = {};
+    options.progressiveDelivery = progressive ? 1 : 0;
+    auto s = XLinkOpenStreamWithOptions(linkId, name, 4 * FRAME_SIZE, &options);
+    if(s == INVALID_STREAM_ID) {
+        printf("Open stream %s failed...\n", name);
+        return;
+    }
+
+    // first packet only starts the clock, later ones are timed from the previous completion
+    double firstRows = 0.0, whole = 0.0;
+    auto previous = Clock::now();
+    for(int i = 0; i < NUM_FRAMES; i++) {
+        streamPacketDesc_t* p;
+        if(XLinkReadData(s, &p) != X_LINK_SUCCESS) {
+            printf("Read failed after %d frames\n", i);
+            break;
+        }
+        if(XLinkWaitPacketData(s, p, FIRST_ROWS_SIZE, nullptr) != X_LINK_SUCCESS) {
+            printf("Waiting for the first rows failed\n");
+            break;
+        }
+        auto rows = Clock::now();
+        if(XLinkWaitPacketData(s, p, p->length, nullptr) != X_LINK_SUCCESS) {
+            printf("Waiting for the frame failed\n");
+            break;
+        }
+        auto complete = Clock::now();
+        if(i > 0) {
+            firstRows += std::chrono::duration<double, std::micro>(rows - previous).count();
+            whole += std::chrono::duration<double, std::micro>(complete - previous).count();
+        }
+        previous = complete;
+        XLinkReleaseData(s);
+    }
+    XLinkCloseStream(s);
+
+    const int timed = std::max(NUM_FRAMES - 1, 1);
+    printf("%s delivery - first rows after %.0f us, whole frame after %.0f us\n",
+           progressive ? "progressive" : "whole", firstRows / timed, whole / timed);
+}
+
+int main() {
+
+    XLinkGlobalHandler_t gHandler;
+    XLinkInitialize(&gHandler);
+
+    // Search for booted device
+    deviceDesc_t deviceDesc, inDeviceDesc;
+    inDeviceDesc.protocol = X_LINK_ANY_PROTOCOL;
+    inDeviceDesc.state = X_LINK_BOOTED;
+    if(X_LINK_SUCCESS != XLinkFindFirstSuitableDevice(inDeviceDesc, &deviceDesc)){
+        printf("Didn't find a device\n");
+        return -1;
+    }
+
+    printf("Device name: %s\n", deviceDesc.name);
+
+    XLinkHandler_t handler;
+    handler.devicePath = deviceDesc.name;
+    handler.protocol = deviceDesc.protocol;
+    XLinkConnect(&handler);
+
+    readFrames(handler.linkId, "frames_whole", false);
+    readFrames(handler.linkId, "frames_progressive", true);
+
+    XLinkResetRemote(handler.linkId);
+
+    return 0;
+}
@@ -0,0 +1,191 @@
+#include <XLink/XLink.h>
+#include <XLink/XLinkLog.h>
+#include <cstdio>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <thread>
+#include <atomic>
+#include "test_common.hpp"
+
+// The following test needs no device: the device side of the link is served by a thread of
+// the same process, reached over TCP loopback through a proxy of the test. The proxy holds
+// back a large packet after its first bytes, so the peer reading it with progressive delivery
+// gets it while its data is still arriving. Waiting for the first bytes must return them
+// while the rest is missing. Waiting for a packet whose data stops arriving because the
+// connection broke off must fail and report the bytes which arrived. The same holds for packets
+// the host writes in fragments.
+
+constexpr static auto STREAM_NAME = "progressive";
+constexpr static auto PACKET_SIZE = 16 * 1024 * 1024;
+// far less than a packet, the socket buffers add some more
+constexpr static auto HELD_AFTER = 1024 * 1024;
+constexpr static auto FIRST_BYTES = 4096;
+constexpr static auto WAITING_MS = 100;
+constexpr static auto FRAGMENT_SIZE = 64 * 1024;
+
+enum Stage { STARTED, PARTIAL_READ, WAITING_FOR_BROKEN, DONE };
+
+static bool matches(const uint8_t* data, int index, uint32_t from, uint32_t to) {
+    for(uint32_t j = from; j < to; j++) {
+        if(data[j] != TestPackets::pattern(index, j)) return false;
+    }
+    return true;
+}
+
+// waits for the first bytes of the next packet, which must be all that arrived
+static bool readPartial(streamId_t s, int index, streamPacketDesc_t*& p) {
+    uint32_t available = 0;
+    if(XLinkReadData(s, &p) != X_LINK_SUCCESS || p->length != PACKET_SIZE) {
+        printf("Peer: reading packet %d failed\n", index);
+        return false;
+    }
+    if(XLinkWaitPacketData(s, p, FIRST_BYTES, &available) != X_LINK_SUCCESS || available < FIRST_BYTES
+       || available >= p->length) {
+        printf("Peer: %u bytes of packet %d available, waited for %d\n", available, index, FIRST_BYTES);
+        return false;
+    }
+    if(!matches(p->data, index, 0, FIRST_BYTES)) {
+        printf("Peer: first bytes of packet %d are wrong\n", index);
+        return false;
+    }
+    return true;
+}
+
+static void runPeer(int port, std::atomic<bool>& ok, std::atomic<int>& stage) {
+    XLinkHandler_t handler = {};
+    std::string path = "127.0.0.1:" + std::to_string(port);
+    if(!serveLink(path.c_str(), X_LINK_TCP_IP, handler)) {
+        ok = false;
+        return;
+    }
+    XLinkStreamOptions_t options = {};
+    options.progressiveDelivery = 1;
+    auto s = XLinkOpenStreamWithOptions(handler.linkId, STREAM_NAME, 1, &options);
+    streamPacketDesc_t* p;
+    if(s == INVALID_STREAM_ID || !readPartial(s, 0, p)) {
+        ok = false;
+        stage = DONE;
+        return;
+    }
+
+    // the rest arrives once the host resumed the proxy
+    stage = PARTIAL_READ;
+    uint32_t available = 0;
+    if(XLinkWaitPacketData(s, p, p->length, &available) != X_LINK_SUCCESS || available != p->length
+       || !matches(p->data, 0, 0, p->length)) {
+        printf("Peer: packet 0 is incomplete, %u bytes available\n", available);
+        ok = false;
+    }
+    XLinkReleaseData(s);
+
+    // the connection breaks off while the rest of the packet is held back. The reset of the link
+    // frees the packet, so only a copy of its descriptor is waited for
+    if(ok && readPartial(s, 1, p)) {
+        streamPacketDesc_t packet = *p;
+        stage = WAITING_FOR_BROKEN;
+        available = 0;
+        if(XLinkWaitPacketData(s, &packet, packet.length, &available) != X_LINK_COMMUNICATION_FAIL
+           || available >= packet.length) {
+            printf("Peer: waiting for broken packet 1 didn't fail, %u bytes available\n", available);
+            ok = false;
+        }
+    } else {
+        ok = false;
+    }
+    stage = DONE;
+    // the dispatcher stops once the reset fails to be sent
+    XLinkResetRemote(handler.linkId);
+}
+
+static bool waitForStage(std::atomic<int>& stage, int expected) {
+    for(int i = 0; i < 1000 && stage < expected; i++) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    return stage == expected;
+}
+
+static bool runLink(int peerPort, int proxyPort, uint32_t fragmentSize) {
+    TestProxy proxy(proxyPort, peerPort);
+    if(!proxy.listen()) {
+        printf("Proxy: listening failed\n");
+        return false;
+    }
+    std::atomic<bool> peerOk{true}, proxyOk{true};
+    std::atomic<int> stage{STARTED};
+    std::thread peer(runPeer, peerPort, std::ref(peerOk), std::ref(stage));
+    std::thread proxyConnect([&] { proxyOk = proxy.connect(); });
+
+    XLinkHandler_t handler = {};
+    std::string proxyPath = "127.0.0.1:" + std::to_string(proxyPort);
+    bool ok = connectLink(proxyPath.c_str(), X_LINK_TCP_IP, handler);
+    proxyConnect.join();
+    ok = ok && proxyOk;
+
+    XLinkStreamOptions_t options = {};
+    options.fragmentSize = fragmentSize;
+    auto s = ok ? XLinkOpenStreamWithOptions(handler.linkId, STREAM_NAME, 2 * PACKET_SIZE, &options) : INVALID_STREAM_ID;
+    if(s == INVALID_STREAM_ID) {
+        printf("Opening the stream failed\n");
+        ok = false;
+    }
+    std::vector<uint8_t> payload(PACKET_SIZE);
+    for(uint32_t j = 0; j < PACKET_SIZE; j++) {
+        payload[j] = TestPackets::pattern(0, j);
+    }
+
+    std::atomic<bool> written{false};
+    if(ok) {
+        proxy.holdAfter(HELD_AFTER);
+        std::thread writer([&] { written = XLinkWriteData(s, payload.data(), PACKET_SIZE) == X_LINK_SUCCESS; });
+        if(!waitForStage(stage, PARTIAL_READ)) {
+            printf("Peer didn't read packet 0 partially\n");
+            ok = false;
+        }
+        proxy.resume();
+        writer.join();
+        if(!written) {
+            printf("Writing packet 0 failed\n");
+            ok = false;
+        }
+    }
+
+    if(ok) {
+        for(uint32_t j = 0; j < PACKET_SIZE; j++) {
+            payload[j] = TestPackets::pattern(1, j);
+        }
+        proxy.holdAfter(HELD_AFTER);
+        // fails once the connection broke off
+        std::thread writer([&] { XLinkWriteData(s, payload.data(), PACKET_SIZE); });
+        if(!waitForStage(stage, WAITING_FOR_BROKEN)) {
+            printf("Peer didn't read packet 1 partially\n");
+            ok = false;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(WAITING_MS));
+        proxy.breakConnection();
+        writer.join();
+    }
+
+    proxy.breakConnection();
+    if(!waitForStage(stage, DONE)) {
+        printf("Peer is still waiting for packet 1\n");
+        ok = false;
+    }
+    XLinkResetRemote(handler.linkId);
+    peer.join();
+    proxy.close();
+    return ok && peerOk;
+}
+
+int main() {
+    // failing reads and writes at the broken connection are expected
+    mvLogDefaultLevelSet(MVLOG_FATAL);
+    XLinkGlobalHandler_t gHandler = {};
+    XLinkInitialize(&gHandler);
+
+    bool ok = runLink(11620, 11621, 0);
+    ok = runLink(11622, 11623, FRAGMENT_SIZE) && ok;
+
+    printf("%s\n", ok ? "Success" : "Failed");
+    return ok ? 0 : -1;
+}
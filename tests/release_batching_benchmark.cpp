@@ -0,0 +1,80 @@
+#include <XLink/XLink.h>
+#include <cstdio>
+#include <chrono>
+#include <string>
+
+// The following is an Server side (host) benchmark that compares the rate of small
+// messages read with per-packet release acknowledgements and with batched release credit.
+
+// Use the following code on Client side (device) to test
+// ...
+//    constexpr static auto NUM_MESSAGES = 100000;
+//    uint8_t message[256] = {0};
+//    for(auto name : {"bench_unbatched", "bench_batched"}){
+//        auto s = XLinkOpenStream(0, name, 64 * 1024);
+//        assert(s != INVALID_STREAM_ID);
+//        for(int i = 0; i < NUM_MESSAGES; i++){
+//            auto w = XLinkWriteData(s, message, sizeof(message));
+//            assert(w == X_LINK_SUCCESS);
+//        }
+//    }
+// ...
+
+constexpr static auto NUM_MESSAGES = 100000;
+
+static double readMessages(linkId_t linkId, const char* name, const XLinkStreamOptions_t& options) {
+    auto s = XLinkOpenStreamWithOptions(linkId, name, 64 * 1024, &options);
+    if(s == INVALID_STREAM_ID) {
+        printf("Open stream %s failed...\n", name);
+        return 0.0;
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    for(int i = 0; i < NUM_MESSAGES; i++) {
+        streamPacketDesc_t* p;
+        if(XLinkReadData(s, &p) != X_LINK_SUCCESS || XLinkReleaseData(s) != X_LINK_SUCCESS) {
+            printf("Read failed after %d messages\n", i);
+            return 0.0;
+        }
+    }
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+    XLinkCloseStream(s);
+    return NUM_MESSAGES / elapsed.count();
+}
+
+int main() {
+
+    XLinkGlobalHandler_t gHandler;
+    XLinkInitialize(&gHandler);
+
+    // Search for booted device
+    deviceDesc_t deviceDesc, inDeviceDesc;
+    inDeviceDesc.protocol = X_LINK_ANY_PROTOCOL;
+    inDeviceDesc.state = X_LINK_BOOTED;
+    if(X_LINK_SUCCESS != XLinkFindFirstSuitableDevice(inDeviceDesc, &deviceDesc)){
+        printf("Didn't find a device\n");
+        return -1;
+    }
+
+    printf("Device name: %s\n", deviceDesc.name);
+
+    XLinkHandler_t handler;
+    handler.devicePath = deviceDesc.name;
+    handler.protocol = deviceDesc.protocol;
+    XLinkConnect(&handler);
+
+    XLinkStreamOptions_t unbatched = {};
+    XLinkStreamOptions_t batched = {};
+    batched.releaseBatchPackets = 16;
+    batched.releaseBatchTimeoutUs = 1000;
+
+    double unbatchedRate = readMessages(handler.linkId, "bench_unbatched", unbatched);
+    double batchedRate = readMessages(handler.linkId, "bench_batched", batched);
+
+    printf("256B messages - unbatched: %.0f msg/s, batched: %.0f msg/s\n", unbatchedRate, batchedRate);
+
+    XLinkResetRemote(handler.linkId);
+
+    return (unbatchedRate > 0.0 && batchedRate > 0.0) ? 0 : -1;
+}
@@ -0,0 +1,153 @@
+#include <XLink/XLink.h>
+#include <XLink/XLinkLog.h>
+#include <cstdio>
+#include <vector>
+#include <chrono>
+#include <thread>
+#include <atomic>
+#include "test_common.hpp"
+
+// The following test needs no device: the device side of the link is served by a thread of
+// the same process. The host batches the releases of a stream the remote keeps full. Released
+// packets must be credited back in batches: the remote stays held back until a whole batch was
+// released and then writes exactly that many packets. Each of its writers waits for credit, a
+// batch must wake as many of them as it makes room for. A partial batch is credited back once
+// its timeout expired.
+
+constexpr static auto LINK_NAME = "release_credit_test";
+constexpr static auto STREAM_NAME = "credited";
+constexpr static auto PACKET_SIZE = 1024;
+constexpr static auto WINDOW = 16 * PACKET_SIZE;
+constexpr static auto BATCH_PACKETS = 4;
+constexpr static auto BATCH_TIMEOUT_MS = 300;
+constexpr static auto SETTLE_MS = 100;
+constexpr static auto NUM_WRITERS = BATCH_PACKETS;
+
+// packets written by each writer of the remote
+static std::atomic<int> writtenBy[NUM_WRITERS];
+
+static void runPeer(std::atomic<bool>& ok, std::atomic<int>& written) {
+    XLinkHandler_t handler = {};
+    if(!serveLink(LINK_NAME, X_LINK_LOOPBACK, handler)) {
+        ok = false;
+        return;
+    }
+    auto s = XLinkOpenStream(handler.linkId, STREAM_NAME, WINDOW);
+    // the host sends a packet once it's ready to read
+    if(!waitForHost(s)) {
+        ok = false;
+        return;
+    }
+    std::vector<std::thread> writers;
+    for(int i = 0; i < NUM_WRITERS; i++) {
+        writers.emplace_back([&, i] {
+            std::vector<uint8_t> payload(PACKET_SIZE);
+            // blocks once the window is full, until the host gave credit, and fails at the reset
+            while(XLinkWriteData(s, payload.data(), PACKET_SIZE) == X_LINK_SUCCESS) {
+                writtenBy[i]++;
+                written++;
+            }
+        });
+    }
+    for(auto& writer : writers) writer.join();
+}
+
+static bool readAndRelease(streamId_t s, int count) {
+    for(int i = 0; i < count; i++) {
+        streamPacketDesc_t* p;
+        if(XLinkReadData(s, &p) != X_LINK_SUCCESS || XLinkReleaseData(s) != X_LINK_SUCCESS) return false;
+    }
+    return true;
+}
+
+// waits until the remote wrote the given number of packets
+static bool waitWritten(std::atomic<int>& written, int expected) {
+    for(int i = 0; i < 100 && written < expected; i++) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    return written == expected;
+}
+
+int main() {
+    // failing writes of the peer at the reset are expected
+    mvLogDefaultLevelSet(MVLOG_FATAL);
+    XLinkGlobalHandler_t gHandler = {};
+    XLinkInitialize(&gHandler);
+
+    std::atomic<bool> peerOk{true};
+    std::atomic<int> written{0};
+    std::thread peer(runPeer, std::ref(peerOk), std::ref(written));
+
+    XLinkHandler_t handler = {};
+    bool ok = connectLink(LINK_NAME, X_LINK_LOOPBACK, handler);
+
+    XLinkStreamOptions_t options = {};
+    options.releaseBatchPackets = BATCH_PACKETS;
+    options.releaseBatchTimeoutUs = BATCH_TIMEOUT_MS * 1000;
+    auto s = ok ? XLinkOpenStreamWithOptions(handler.linkId, STREAM_NAME, 64, &options) : INVALID_STREAM_ID;
+    uint8_t go = 1;
+    if(s == INVALID_STREAM_ID || XLinkWriteData(s, &go, 1) != X_LINK_SUCCESS) {
+        printf("Opening the stream failed\n");
+        ok = false;
+    }
+
+    // the remote fills the window and stops
+    int filled = -1;
+    for(int i = 0; i < 100 && ok && filled != written; i++) {
+        filled = written;
+        std::this_thread::sleep_for(std::chrono::milliseconds(SETTLE_MS));
+    }
+    if(ok && filled != WINDOW / PACKET_SIZE) {
+        printf("Remote filled %d packets of a window of %d\n", filled, WINDOW / PACKET_SIZE);
+        ok = false;
+    }
+
+    // short of a batch nothing is credited
+    if(ok && readAndRelease(s, BATCH_PACKETS - 1)) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(SETTLE_MS));
+        if(written != filled) {
+            printf("Remote wrote %d packets before a batch was released\n", written - filled);
+            ok = false;
+        }
+    }
+    // the whole batch is credited at once, every blocked writer gets to write
+    std::vector<int> writtenBefore;
+    for(auto& count : writtenBy) writtenBefore.push_back(count);
+    if(ok && (!readAndRelease(s, 1) || !waitWritten(written, filled + BATCH_PACKETS))) {
+        printf("Remote wrote %d packets after a batch was released\n", written - filled);
+        ok = false;
+    }
+    for(int i = 0; i < NUM_WRITERS && ok; i++) {
+        if(writtenBy[i] != writtenBefore[i] + 1) {
+            printf("Writer %d wrote %d packets after a batch was released\n", i, writtenBy[i] - writtenBefore[i]);
+            ok = false;
+        }
+    }
+    filled += BATCH_PACKETS;
+
+    // a partial batch waits for its timeout
+    auto released = std::chrono::steady_clock::now();
+    if(ok && readAndRelease(s, 2)) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(BATCH_TIMEOUT_MS / 3));
+        if(written != filled) {
+            printf("Partial batch was credited before its timeout\n");
+            ok = false;
+        }
+    }
+    if(ok && !waitWritten(written, filled + 2)) {
+        printf("Partial batch wasn't credited after its timeout, remote wrote %d packets\n", written - filled);
+        ok = false;
+    }
+    std::chrono::duration<double, std::milli> creditedAfter = std::chrono::steady_clock::now() - released;
+    if(ok && creditedAfter.count() < BATCH_TIMEOUT_MS / 2) {
+        printf("Partial batch was credited after %.1f ms\n", creditedAfter.count());
+        ok = false;
+    }
+
+    XLinkResetRemote(handler.linkId);
+    peer.join();
+
+    ok = ok && peerOk;
+    printf("%s\n", ok ? "Success" : "Failed");
+    return ok ? 0 : -1;
+}
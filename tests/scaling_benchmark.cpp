@@ -0,0 +1,246 @@
+#include <XLink/XLink.h>
+#include <XLink/XLinkLog.h>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <chrono>
+#include <thread>
+#include <vector>
+#include <atomic>
+#include <algorithm>
+
+// The following benchmark shows where XLink stops scaling with the number of links, streams
+// and application threads. It serves up to --links links over TCP loopback from threads of
+// the same process, which echo every packet of up to --streams streams per link. For every
+// combination of powers of two up to those limits, --threads threads per stream write,
+// read and release packets in a loop for --seconds. It reports the aggregate throughput,
+// the latency of each call and the time waited for the internal locks per call.
+// Both sides of the links live in this process, so lock waits include those of the peers.
+// With --trace, the events of the last combination are written as a Chrome trace to the file.
+//
+// Usage: scaling_benchmark [--links L] [--streams S] [--threads M] [--size bytes] [--seconds T] [--trace file]
+
+constexpr static auto BASE_PORT = 11520;
+// both ends of every link take one of the links of this process
+constexpr static auto MAX_BENCH_LINKS = 32;
+
+struct Options {
+    int links = 2;
+    int streams = 4;
+    int threads = 4;
+    int size = 1024;
+    double seconds = 1;
+    std::string trace;
+};
+
+enum Op { OP_WRITE, OP_READ, OP_RELEASE, OP_COUNT };
+
+struct ThreadResult {
+    std::vector<double> us[OP_COUNT];
+    bool ok = true;
+};
+
+static std::string endpoint(int link) {
+    return "127.0.0.1:" + std::to_string(BASE_PORT + link);
+}
+
+static std::string streamName(int stream) {
+    return "scaling_" + std::to_string(stream);
+}
+
+static void echo(streamId_t s) {
+    // returns an error once the host reset the link
+    streamPacketDesc_t* p;
+    while(XLinkReadData(s, &p) == X_LINK_SUCCESS) {
+        XLinkWriteData(s, p->data, p->length);
+        XLinkReleaseData(s);
+    }
+}
+
+static void runPeer(int link, Options options) {
+    std::string path = endpoint(link);
+    XLinkHandler_t handler = {};
+    handler.devicePath = const_cast<char*>(path.c_str());
+    handler.protocol = X_LINK_TCP_IP;
+    if(XLinkServer(&handler) != X_LINK_SUCCESS) {
+        printf("Peer %d: serving the link failed\n", link);
+        return;
+    }
+
+    std::vector<std::thread> echoes;
+    for(int i = 0; i < options.streams; i++) {
+        auto s = XLinkOpenStream(handler.linkId, streamName(i).c_str(), 64 * options.size);
+        if(s == INVALID_STREAM_ID) {
+            printf("Peer %d: open stream failed\n", link);
+            continue;
+        }
+        echoes.emplace_back(echo, s);
+    }
+    for(auto& thread : echoes) {
+        thread.join();
+    }
+}
+
+template<typename F>
+static bool timed(std::vector<double>& samples, F f) {
+    auto start = std::chrono::steady_clock::now();
+    bool ok = f();
+    std::chrono::duration<double, std::micro> elapsed = std::chrono::steady_clock::now() - start;
+    samples.push_back(elapsed.count());
+    return ok;
+}
+
+static void runThread(streamId_t s, int size, const std::atomic<bool>& stop, ThreadResult& result) {
+    std::vector<uint8_t> payload(size);
+    streamPacketDesc_t* p;
+    // every thread reads as many packets as it writes, so none is left over at the end
+    while(!stop && result.ok) {
+        result.ok = timed(result.us[OP_WRITE], [&] { return XLinkWriteData(s, payload.data(), size) == X_LINK_SUCCESS; })
+                    && timed(result.us[OP_READ], [&] { return XLinkReadData(s, &p) == X_LINK_SUCCESS; })
+                    && timed(result.us[OP_RELEASE], [&] { return XLinkReleaseData(s) == X_LINK_SUCCESS; });
+    }
+}
+
+static double percentile(const std::vector<double>& sorted, double q) {
+    if(sorted.empty()) return 0;
+    return sorted[std::min(sorted.size() - 1, (size_t) (q * sorted.size()))];
+}
+
+int main(int argc, char** argv) {
+    Options options;
+    for(int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        if(arg == "--links" && hasValue) {
+            options.links = atoi(argv[++i]);
+        } else if(arg == "--streams" && hasValue) {
+            options.streams = atoi(argv[++i]);
+        } else if(arg == "--threads" && hasValue) {
+            options.threads = atoi(argv[++i]);
+        } else if(arg == "--size" && hasValue) {
+            options.size = atoi(argv[++i]);
+        } else if(arg == "--seconds" && hasValue) {
+            options.seconds = atof(argv[++i]);
+        } else if(arg == "--trace" && hasValue) {
+            options.trace = argv[++i];
+        } else {
+            printf("Usage: %s [--links L] [--streams S] [--threads M] [--size bytes] [--seconds T] [--trace file]\n",
+                   argv[0]);
+            return 1;
+        }
+    }
+    if(options.links < 1 || options.links > MAX_BENCH_LINKS || options.streams < 1 || options.streams > XLINK_MAX_STREAMS
+       || options.threads < 1 || options.size < 1 || options.seconds <= 0) {
+        printf("Invalid options, at most %d links and %d streams\n", MAX_BENCH_LINKS, XLINK_MAX_STREAMS);
+        return 1;
+    }
+
+    // failing reads of the peers at the final reset are expected
+    mvLogDefaultLevelSet(MVLOG_FATAL);
+    XLinkGlobalHandler_t gHandler = {};
+    XLinkInitialize(&gHandler);
+
+    std::vector<std::thread> peers;
+    std::vector<linkId_t> links;
+    std::vector<std::vector<streamId_t>> streams;
+    for(int l = 0; l < options.links; l++) {
+        peers.emplace_back(runPeer, l, options);
+
+        std::string path = endpoint(l);
+        XLinkHandler_t handler = {};
+        handler.devicePath = const_cast<char*>(path.c_str());
+        handler.protocol = X_LINK_TCP_IP;
+        // the peer may not be serving yet
+        bool connected = false;
+        for(int i = 0; i < 100 && !connected; i++) {
+            connected = XLinkConnect(&handler) == X_LINK_SUCCESS;
+            if(!connected) std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        }
+        if(!connected) {
+            printf("Connecting link %d failed\n", l);
+            return -1;
+        }
+        links.push_back(handler.linkId);
+
+        streams.emplace_back();
+        for(int s = 0; s < options.streams; s++) {
+            auto id = XLinkOpenStream(handler.linkId, streamName(s).c_str(), 64 * options.size);
+            if(id == INVALID_STREAM_ID) {
+                printf("Open stream failed...\n");
+                return -1;
+            }
+            streams.back().push_back(id);
+        }
+    }
+
+    bool ok = true;
+    printf("%5s %7s %7s %10s %9s  %-17s %-17s %-17s  %s\n", "links", "streams", "threads", "ops/s", "MB/s",
+           "write p50/p99 us", "read p50/p99 us", "release p50/p99",
+           "lock wait ns/call, max us: links / queue / sem refs / device fd");
+    for(int l = 1; l <= options.links && ok; l *= 2) {
+        for(int s = 1; s <= options.streams && ok; s *= 2) {
+            for(int m = 1; m <= options.threads && ok; m *= 2) {
+                std::atomic<bool> stop{false};
+                std::vector<ThreadResult> results(l * s * m);
+                std::vector<std::thread> threads;
+
+                XLinkProfStart();
+                if(!options.trace.empty()) XLinkTraceStart(0);
+                auto start = std::chrono::steady_clock::now();
+                for(int i = 0; i < (int) results.size(); i++) {
+                    streamId_t id = streams[i / (s * m)][(i / m) % s];
+                    threads.emplace_back(runThread, id, options.size, std::cref(stop), std::ref(results[i]));
+                }
+                std::this_thread::sleep_for(std::chrono::duration<double>(options.seconds));
+                stop = true;
+                for(auto& thread : threads) {
+                    thread.join();
+                }
+                std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+                XLinkProfStop();
+                if(!options.trace.empty()) XLinkTraceStop();
+
+                std::vector<double> all[OP_COUNT];
+                for(auto& result : results) {
+                    ok = ok && result.ok;
+                    for(int op = 0; op < OP_COUNT; op++) {
+                        all[op].insert(all[op].end(), result.us[op].begin(), result.us[op].end());
+                    }
+                }
+                for(auto& samples : all) {
+                    std::sort(samples.begin(), samples.end());
+                }
+
+                // every loop moves the packet there and back
+                double calls = (double) (all[OP_WRITE].size() + all[OP_READ].size() + all[OP_RELEASE].size());
+                double ops = all[OP_WRITE].size() / elapsed.count();
+                double mbps = 2.0 * ops * options.size / (1024.0 * 1024.0);
+                printf("%5d %7d %7d %10.0f %9.1f  %7.1f/%-9.1f %7.1f/%-9.1f %7.1f/%-9.1f ", l, s, m, ops, mbps,
+                       percentile(all[OP_WRITE], 0.5), percentile(all[OP_WRITE], 0.99),
+                       percentile(all[OP_READ], 0.5), percentile(all[OP_READ], 0.99),
+                       percentile(all[OP_RELEASE], 0.5), percentile(all[OP_RELEASE], 0.99));
+                for(int lock = 0; lock < X_LINK_LOCK_COUNT; lock++) {
+                    XLinkLockProf_t prof = {};
+                    XLinkGetLockProfilingData((XLinkLock_t) lock, &prof);
+                    printf(" %6.0f %-6.0f", calls > 0 ? prof.totalWaitNs / calls : 0.0, prof.maxWaitNs / 1000.0);
+                }
+                printf("\n");
+            }
+        }
+    }
+
+    if(!options.trace.empty() && XLinkTraceDump(options.trace.c_str()) != X_LINK_SUCCESS) {
+        printf("Writing the trace failed\n");
+        ok = false;
+    }
+
+    for(auto link : links) {
+        XLinkResetRemote(link);
+    }
+    for(auto& peer : peers) {
+        peer.join();
+    }
+
+    printf("%s\n", ok ? "Success" : "Failed");
+    return ok ? 0 : -1;
+}
@@ -0,0 +1,168 @@
+#include <XLink/XLink.h>
+#include <XLink/XLinkLog.h>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <random>
+#include <algorithm>
+#include <chrono>
+#include <thread>
+#include <atomic>
+#include "test_common.hpp"
+
+// The following test needs no device: the device side of the link is served by a thread of
+// the same process. Many workers read one stream opened with shared reads. Each packet must
+// be received by exactly one of them, whole, and stay intact while the workers release the
+// packets they hold in random order. One worker moves its packets out instead.
+
+constexpr static auto LINK_NAME = "shared_reads_test";
+constexpr static auto STREAM_NAME = "shared";
+constexpr static auto WINDOW = 64 * 1024;
+constexpr static auto NUM_PACKETS = 5000;
+constexpr static auto NUM_WORKERS = 8;
+constexpr static auto MAX_HELD = 4;
+constexpr static TestPackets PACKETS = {NUM_PACKETS, 1024, true};
+
+static void runPeer(std::atomic<bool>& ok) {
+    XLinkHandler_t handler = {};
+    if(!serveLink(LINK_NAME, X_LINK_LOOPBACK, handler)) {
+        ok = false;
+        return;
+    }
+    auto s = XLinkOpenStream(handler.linkId, STREAM_NAME, WINDOW);
+    // the host sends a packet once its workers run
+    if(!waitForHost(s)) {
+        ok = false;
+        return;
+    }
+    std::vector<uint8_t> payload(WINDOW);
+    for(int i = 0; i < NUM_PACKETS && ok; i++) {
+        ok = PACKETS.write(s, i, payload);
+    }
+    streamPacketDesc_t* p;
+    // returns an error once the host reset the link
+    XLinkReadData(s, &p);
+}
+
+// holds a few packets at a time and releases them in random order, until the link is reset
+static bool runWorker(streamId_t s, int worker, std::vector<std::atomic<int>>& received, std::atomic<int>& readCount) {
+    std::mt19937 random(worker);
+    std::vector<streamPacketDesc_t*> held;
+    bool ok = true;
+    for(;;) {
+        streamPacketDesc_t* p;
+        if(XLinkReadData(s, &p) != X_LINK_SUCCESS) break;
+        int index;
+        if(!PACKETS.isIntact(p->data, p->length, index)) {
+            printf("Worker %d: received a broken packet\n", worker);
+            ok = false;
+        } else {
+            received[index]++;
+        }
+        readCount++;
+        held.push_back(p);
+        if((int) held.size() < 1 + (int) (random() % MAX_HELD)) continue;
+
+        std::shuffle(held.begin(), held.end(), random);
+        for(auto packet : held) {
+            // other workers released packets meanwhile
+            if(!PACKETS.isIntact(packet->data, packet->length, index)) {
+                printf("Worker %d: held packet changed\n", worker);
+                ok = false;
+            }
+            if(XLinkReleaseSpecificData(s, packet) != X_LINK_SUCCESS) {
+                printf("Worker %d: releasing packet %d failed\n", worker, index);
+                ok = false;
+            }
+        }
+        held.clear();
+    }
+    return ok;
+}
+
+static bool runMovingWorker(streamId_t s, std::vector<std::atomic<int>>& received, std::atomic<int>& readCount) {
+    bool ok = true;
+    for(;;) {
+        streamPacketDesc_t packet;
+        if(XLinkReadMoveData(s, &packet) != X_LINK_SUCCESS) break;
+        int index;
+        if(!PACKETS.isIntact(packet.data, packet.length, index)) {
+            printf("Moving worker: received a broken packet\n");
+            ok = false;
+        } else {
+            received[index]++;
+        }
+        XLinkDeallocateMoveData(packet.data, packet.length);
+        readCount++;
+    }
+    return ok;
+}
+
+int main() {
+    // failing reads at the reset are expected
+    mvLogDefaultLevelSet(MVLOG_FATAL);
+    XLinkGlobalHandler_t gHandler = {};
+    XLinkInitialize(&gHandler);
+
+    std::atomic<bool> peerOk{true};
+    std::thread peer(runPeer, std::ref(peerOk));
+
+    XLinkHandler_t handler = {};
+    bool ok = connectLink(LINK_NAME, X_LINK_LOOPBACK, handler);
+
+    XLinkStreamOptions_t options = {};
+    options.sharedReads = 1;
+    auto s = ok ? XLinkOpenStreamWithOptions(handler.linkId, STREAM_NAME, 64, &options) : INVALID_STREAM_ID;
+    std::vector<std::atomic<int>> received(NUM_PACKETS);
+    for(auto& count : received) count = 0;
+    std::atomic<int> readCount{0};
+    std::vector<std::thread> workers;
+    std::vector<char> workersOk(NUM_WORKERS, 0);
+    if(s != INVALID_STREAM_ID) {
+        for(int i = 0; i < NUM_WORKERS; i++) {
+            workers.emplace_back([&, i] {
+                workersOk[i] = i == 0 ? runMovingWorker(s, received, readCount) : runWorker(s, i, received, readCount);
+            });
+        }
+    }
+    uint8_t go = 1;
+    if(s == INVALID_STREAM_ID || XLinkWriteData(s, &go, 1) != X_LINK_SUCCESS) {
+        printf("Opening the stream failed\n");
+        ok = false;
+    }
+
+    // workers may still hold a few packets when all were read
+    for(int i = 0; i < 1000 && ok && readCount < NUM_PACKETS; i++) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    if(ok && readCount != NUM_PACKETS) {
+        printf("Workers stalled after %d packets\n", (int) readCount);
+        ok = false;
+    }
+    if(ok) {
+        // no moved packet is left, the oldest one is held by a worker
+        streamPacketDesc_t packet{};
+        packet.data = &go;
+        packet.length = 1;
+        if(XLinkReleaseData(s) == X_LINK_SUCCESS || XLinkReleaseSpecificData(s, &packet) == X_LINK_SUCCESS) {
+            printf("Releasing a packet which isn't held wasn't refused\n");
+            ok = false;
+        }
+    }
+
+    XLinkResetRemote(handler.linkId);
+    for(auto& worker : workers) worker.join();
+    peer.join();
+
+    for(int i = 0; i < NUM_PACKETS && ok; i++) {
+        if(received[i] != 1) {
+            printf("Packet %d was received %d times\n", i, (int) received[i]);
+            ok = false;
+        }
+    }
+    ok = ok && std::all_of(workersOk.begin(), workersOk.end(), [](char workerOk) { return workerOk != 0; });
+    ok = ok && peerOk;
+    printf("%s\n", ok ? "Success" : "Failed");
+    return ok ? 0 : -1;
+}
@@ -0,0 +1,147 @@
+#include <XLink/XLink.h>
+#include <XLink/XLinkLog.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <thread>
+#include <atomic>
+#include "test_common.hpp"
+
+// The following test needs no device: the device side of each link is served by a thread of
+// the same process. The host sinks a stream into a temporary file with XLinkStreamSinkToFd,
+// framed over TCP loopback, where the payloads are spliced from the socket, and raw over
+// X_LINK_LOOPBACK. The peer writes many times its write window, which only completes if every
+// sunk payload is credited back. The file must hold all payloads in order, and once the sink
+// is removed, packets are read as usual again. Writes the peer sends in fragments are sunk whole.
+
+constexpr static auto STREAM_NAME = "sink";
+constexpr static auto WINDOW = 256 * 1024;
+constexpr static auto NUM_PACKETS = 200;
+constexpr static TestPackets PACKETS = {NUM_PACKETS, WINDOW / 2, false};
+constexpr static auto FRAGMENT_SIZE = 16 * 1024;
+
+static void runPeer(std::string path, XLinkProtocol_t protocol, uint32_t fragmentSize, std::atomic<bool>& ok) {
+    XLinkHandler_t handler = {};
+    if(!serveLink(path.c_str(), protocol, handler)) {
+        ok = false;
+        return;
+    }
+
+    XLinkStreamOptions_t options = {};
+    options.fragmentSize = fragmentSize;
+    auto s = XLinkOpenStreamWithOptions(handler.linkId, STREAM_NAME, WINDOW, &options);
+    // the host sends a packet once its sink is set, and another once it's removed
+    if(!waitForHost(s)) {
+        ok = false;
+        return;
+    }
+    std::vector<uint8_t> payload(WINDOW);
+    for(int i = 0; i < NUM_PACKETS && ok; i++) {
+        ok = PACKETS.write(s, i, payload);
+    }
+    if(!waitForHost(s) || XLinkWriteData(s, payload.data(), 100) != X_LINK_SUCCESS) {
+        ok = false;
+    }
+    streamPacketDesc_t* p;
+    // returns an error once the host reset the link
+    XLinkReadData(s, &p);
+}
+
+static bool checkFile(int fd, bool framed, size_t expected) {
+    std::vector<uint8_t> content(expected);
+    if(pread(fd, content.data(), expected, 0) != (ssize_t) expected) {
+        printf("Sink file is short\n");
+        return false;
+    }
+    size_t position = 0;
+    for(int i = 0; i < NUM_PACKETS; i++) {
+        if(framed) {
+            XLinkSinkRecord_t record;
+            memcpy(&record, content.data() + position, sizeof(record));
+            if(record.length != PACKETS.size(i) || (record.tReceived.tv_sec == 0 && record.tReceived.tv_nsec == 0)) {
+                printf("Record %d is wrong\n", i);
+                return false;
+            }
+            position += sizeof(record);
+        }
+        if(!PACKETS.matches(i, content.data() + position, PACKETS.size(i))) {
+            printf("Payload %d differs\n", i);
+            return false;
+        }
+        position += PACKETS.size(i);
+    }
+    return true;
+}
+
+static bool runLink(const std::string& path, XLinkProtocol_t protocol, bool framed, uint32_t fragmentSize = 0) {
+    std::atomic<bool> peerOk{true};
+    std::thread peer(runPeer, path, protocol, fragmentSize, std::ref(peerOk));
+
+    XLinkHandler_t handler = {};
+    if(!connectLink(path.c_str(), protocol, handler)) {
+        peer.join();
+        return false;
+    }
+
+    char fileName[] = "/tmp/xlink_stream_sink_XXXXXX";
+    int fd = mkstemp(fileName);
+    unlink(fileName);
+
+    size_t expected = 0;
+    for(int i = 0; i < NUM_PACKETS; i++) {
+        expected += PACKETS.size(i) + (framed ? sizeof(XLinkSinkRecord_t) : 0);
+    }
+
+    bool ok = fd >= 0;
+    uint8_t go = 1;
+    auto s = XLinkOpenStream(handler.linkId, STREAM_NAME, 64);
+    XLinkSinkOptions_t options = {};
+    options.framing = framed;
+    if(!ok || s == INVALID_STREAM_ID || XLinkStreamSinkToFd(s, fd, &options) != X_LINK_SUCCESS
+       || XLinkWriteData(s, &go, 1) != X_LINK_SUCCESS) {
+        printf("Setting the sink failed on %s\n", path.c_str());
+        ok = false;
+    }
+
+    // the peer's writes complete once credited, the last payload is in the file shortly after
+    struct stat fileStat = {};
+    for(int i = 0; i < 1000 && ok && (fstat(fd, &fileStat) != 0 || (size_t) fileStat.st_size < expected); i++) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    ok = ok && checkFile(fd, framed, expected);
+
+    streamPacketDesc_t* p;
+    if(ok && (XLinkStreamSinkToFd(s, -1, nullptr) != X_LINK_SUCCESS || XLinkWriteData(s, &go, 1) != X_LINK_SUCCESS
+              || XLinkReadData(s, &p) != X_LINK_SUCCESS || p->length != 100 || XLinkReleaseData(s) != X_LINK_SUCCESS)) {
+        printf("Reading after removing the sink failed\n");
+        ok = false;
+    }
+    if(ok && fstat(fd, &fileStat) == 0 && (size_t) fileStat.st_size != expected) {
+        printf("Sink file grew after removing the sink\n");
+        ok = false;
+    }
+
+    XLinkResetRemote(handler.linkId);
+    peer.join();
+    if(fd >= 0) close(fd);
+    return ok && peerOk;
+}
+
+int main() {
+    // failing reads of the peers at the reset are expected
+    mvLogDefaultLevelSet(MVLOG_FATAL);
+    XLinkGlobalHandler_t gHandler = {};
+    XLinkInitialize(&gHandler);
+
+    bool ok = runLink("127.0.0.1:11590", X_LINK_TCP_IP, true);
+    ok = runLink("stream_sink_test", X_LINK_LOOPBACK, false) && ok;
+    ok = runLink("127.0.0.1:11591", X_LINK_TCP_IP, true, FRAGMENT_SIZE) && ok;
+
+    printf("%s\n", ok ? "Success" : "Failed");
+    return ok ? 0 : -1;
+}
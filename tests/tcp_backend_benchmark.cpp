@@ -0,0 +1,190 @@
+#include <XLink/XLink.h>
+#include <XLink/XLinkLog.h>
+#include <time.h>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <chrono>
+#include <thread>
+#include <vector>
+#include <algorithm>
+
+// The following benchmark compares the TCP/IP backends selected by XLinkSetTcpBackend, and
+// the sockets backend with MSG_ZEROCOPY sends of XLinkSetTcpZeroCopyThreshold.
+// For each of them, it serves a link over TCP loopback from a thread of the same process.
+// Over one stream the peer drops every packet, the host writes --megabytes MB of --bulk byte
+// packets to it and the CPU time of the process per GB is reported. Over another stream the
+// peer echoes every packet, the host sends --messages packets of --small bytes one after the
+// other and the round trip latency is reported.
+// Both sides of the link live in this process and use the same backend, so the CPU time
+// counts both of them. Loopback copies zero-copy sends anyway, the saving shows with a peer
+// behind a NIC only.
+//
+// Usage: tcp_backend_benchmark [--megabytes MB] [--bulk bytes] [--messages N] [--small bytes]
+
+constexpr static auto BASE_PORT = 11560;
+constexpr static auto SINK_STREAM = "tcp_backend_sink";
+constexpr static auto ECHO_STREAM = "tcp_backend_echo";
+
+struct Options {
+    int megabytes = 1024;
+    int bulk = 1024 * 1024;
+    int messages = 20000;
+    int small = 64;
+};
+
+static double cpuSeconds() {
+    timespec ts = {};
+    clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static double percentile(const std::vector<double>& sorted, double q) {
+    if(sorted.empty()) return 0;
+    return sorted[std::min(sorted.size() - 1, (size_t) (q * sorted.size()))];
+}
+
+static void drain(streamId_t s) {
+    streamPacketDesc_t* p;
+    while(XLinkReadData(s, &p) == X_LINK_SUCCESS) {
+        XLinkReleaseData(s);
+    }
+}
+
+static void echo(streamId_t s) {
+    streamPacketDesc_t* p;
+    while(XLinkReadData(s, &p) == X_LINK_SUCCESS) {
+        XLinkWriteData(s, p->data, p->length);
+        XLinkReleaseData(s);
+    }
+}
+
+static void runPeer(std::string path, Options options) {
+    XLinkHandler_t handler = {};
+    handler.devicePath = const_cast<char*>(path.c_str());
+    handler.protocol = X_LINK_TCP_IP;
+    if(XLinkServer(&handler) != X_LINK_SUCCESS) {
+        printf("Peer: serving the link failed\n");
+        return;
+    }
+
+    // the sink only reads, the echo writes as much as the host
+    auto sink = XLinkOpenStream(handler.linkId, SINK_STREAM, 1);
+    auto echoed = XLinkOpenStream(handler.linkId, ECHO_STREAM, 64 * options.small);
+    if(sink == INVALID_STREAM_ID || echoed == INVALID_STREAM_ID) {
+        printf("Peer: open stream failed\n");
+        return;
+    }
+    // both return an error once the host reset the link
+    std::thread echoThread(echo, echoed);
+    drain(sink);
+    echoThread.join();
+}
+
+static bool runBackend(XLinkTcpBackend_t backend, uint32_t zeroCopyThreshold, const char* name, const Options& options) {
+    XLinkError_t rc = XLinkSetTcpBackend(backend);
+    if(rc == X_LINK_SUCCESS) rc = XLinkSetTcpZeroCopyThreshold(zeroCopyThreshold);
+    if(rc == X_LINK_NOT_IMPLEMENTED) {
+        printf("%-9s not available\n", name);
+        return true;
+    }
+    if(rc != X_LINK_SUCCESS) {
+        printf("Selecting the %s backend failed\n", name);
+        return false;
+    }
+
+    static int port = BASE_PORT;
+    std::string path = "127.0.0.1:" + std::to_string(port++);
+    std::thread peer(runPeer, path, options);
+
+    XLinkHandler_t handler = {};
+    handler.devicePath = const_cast<char*>(path.c_str());
+    handler.protocol = X_LINK_TCP_IP;
+    // the peer may not be serving yet
+    bool connected = false;
+    for(int i = 0; i < 100 && !connected; i++) {
+        connected = XLinkConnect(&handler) == X_LINK_SUCCESS;
+        if(!connected) std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    if(!connected) {
+        printf("Connecting failed\n");
+        peer.join();
+        return false;
+    }
+
+    auto sink = XLinkOpenStream(handler.linkId, SINK_STREAM, 8 * options.bulk);
+    auto echoed = XLinkOpenStream(handler.linkId, ECHO_STREAM, 64 * options.small);
+    bool ok = sink != INVALID_STREAM_ID && echoed != INVALID_STREAM_ID;
+
+    std::vector<uint8_t> payload(std::max(options.bulk, options.small));
+    long long packets = (long long) options.megabytes * 1024 * 1024 / options.bulk;
+    double cpuStart = cpuSeconds();
+    auto start = std::chrono::steady_clock::now();
+    for(long long i = 0; i < packets && ok; i++) {
+        ok = XLinkWriteData(sink, payload.data(), options.bulk) == X_LINK_SUCCESS;
+    }
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    double cpu = cpuSeconds() - cpuStart;
+    double gigabytes = (double) packets * options.bulk / (1024.0 * 1024.0 * 1024.0);
+
+    std::vector<double> us;
+    streamPacketDesc_t* p;
+    for(int i = 0; i < options.messages && ok; i++) {
+        auto sent = std::chrono::steady_clock::now();
+        ok = XLinkWriteData(echoed, payload.data(), options.small) == X_LINK_SUCCESS
+             && XLinkReadData(echoed, &p) == X_LINK_SUCCESS && XLinkReleaseData(echoed) == X_LINK_SUCCESS;
+        std::chrono::duration<double, std::micro> roundTrip = std::chrono::steady_clock::now() - sent;
+        us.push_back(roundTrip.count());
+    }
+    std::sort(us.begin(), us.end());
+
+    if(ok) {
+        printf("%-9s %10.1f %12.2f %12.1f %12.1f\n", name, gigabytes * 1024.0 / elapsed.count(),
+               gigabytes > 0 ? cpu / gigabytes : 0.0, percentile(us, 0.5), percentile(us, 0.99));
+    } else {
+        printf("%-9s transfer failed\n", name);
+    }
+
+    XLinkResetRemote(handler.linkId);
+    peer.join();
+    return ok;
+}
+
+int main(int argc, char** argv) {
+    Options options;
+    for(int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        if(arg == "--megabytes" && hasValue) {
+            options.megabytes = atoi(argv[++i]);
+        } else if(arg == "--bulk" && hasValue) {
+            options.bulk = atoi(argv[++i]);
+        } else if(arg == "--messages" && hasValue) {
+            options.messages = atoi(argv[++i]);
+        } else if(arg == "--small" && hasValue) {
+            options.small = atoi(argv[++i]);
+        } else {
+            printf("Usage: %s [--megabytes MB] [--bulk bytes] [--messages N] [--small bytes]\n", argv[0]);
+            return 1;
+        }
+    }
+    if(options.megabytes < 1 || options.bulk < 1 || options.messages < 1 || options.small < 1) {
+        printf("Invalid options\n");
+        return 1;
+    }
+
+    // failing reads of the peer at the reset are expected
+    mvLogDefaultLevelSet(MVLOG_FATAL);
+    XLinkGlobalHandler_t gHandler = {};
+    XLinkInitialize(&gHandler);
+
+    printf("%-9s %10s %12s %12s %12s\n", "backend", "MB/s", "CPU s/GB", "rtt p50 us", "rtt p99 us");
+    bool ok = runBackend(X_LINK_TCP_BACKEND_SOCKETS, 0, "sockets", options);
+    ok = runBackend(X_LINK_TCP_BACKEND_SOCKETS, XLINK_TCP_ZEROCOPY_THRESHOLD, "zerocopy", options) && ok;
+    ok = runBackend(X_LINK_TCP_BACKEND_IO_URING, 0, "io_uring", options) && ok;
+    XLinkSetTcpBackend(X_LINK_TCP_BACKEND_SOCKETS);
+    XLinkSetTcpZeroCopyThreshold(XLINK_TCP_ZEROCOPY_THRESHOLD);
+
+    printf("%s\n", ok ? "Success" : "Failed");
+    return ok ? 0 : -1;
+}
@@ -0,0 +1,224 @@
+///
+/// @file
+///
+/// @brief     Fixture of the tests which need no device: the device side of their links is
+///            served by a thread of the same process
+///
+
+#ifndef _XLINK_TEST_COMMON_HPP
+#define _XLINK_TEST_COMMON_HPP
+
+#include <XLink/XLink.h>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <chrono>
+#include <thread>
+#include <atomic>
+#include <algorithm>
+#include <vector>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+
+// Packets whose size and content follow from their index. Indexed packets start with their
+// index, so a reader which may miss packets can tell which one it got.
+struct TestPackets {
+    int count;
+    // sizes spread over this many bytes above the smallest packet
+    uint32_t sizeSpread;
+    bool indexed;
+
+    uint32_t size(int index) const {
+        return (indexed ? sizeof(uint32_t) : 1) + (uint32_t) (index * 7919) % sizeSpread;
+    }
+
+    static uint8_t pattern(int index, uint32_t position) {
+        return (uint8_t) (index * 13 + position);
+    }
+
+    // payload holds the largest packet at least
+    bool write(streamId_t s, int index, std::vector<uint8_t>& payload) const {
+        uint32_t j = 0;
+        if(indexed) {
+            memcpy(payload.data(), &index, sizeof(index));
+            j = sizeof(index);
+        }
+        for(; j < size(index); j++) {
+            payload[j] = pattern(index, j);
+        }
+        return XLinkWriteData(s, payload.data(), size(index)) == X_LINK_SUCCESS;
+    }
+
+    bool matches(int index, const uint8_t* data, uint32_t length) const {
+        if(index < 0 || index >= count || length != size(index)) return false;
+        uint32_t j = 0;
+        if(indexed) {
+            int written;
+            memcpy(&written, data, sizeof(written));
+            if(written != index) return false;
+            j = sizeof(written);
+        }
+        for(; j < length; j++) {
+            if(data[j] != pattern(index, j)) return false;
+        }
+        return true;
+    }
+
+    // of indexed packets only, index is the one the packet claims to be
+    bool isIntact(const uint8_t* data, uint32_t length, int& index) const {
+        if(length < sizeof(index)) return false;
+        memcpy(&index, data, sizeof(index));
+        return matches(index, data, length);
+    }
+
+    bool isIntact(const streamPacketDesc_t* p, int& index) const {
+        return isIntact(p->data, p->length, index);
+    }
+};
+
+inline bool serveLink(const char* path, XLinkProtocol_t protocol, XLinkHandler_t& handler) {
+    handler.devicePath = const_cast<char*>(path);
+    handler.protocol = protocol;
+    if(XLinkServer(&handler) != X_LINK_SUCCESS) {
+        printf("Peer: serving %s failed\n", path);
+        return false;
+    }
+    return true;
+}
+
+// the peer may not be serving yet
+inline bool connectLink(const char* path, XLinkProtocol_t protocol, XLinkHandler_t& handler) {
+    handler.devicePath = const_cast<char*>(path);
+    handler.protocol = protocol;
+    for(int i = 0; i < 100; i++) {
+        if(XLinkConnect(&handler) == X_LINK_SUCCESS) return true;
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    printf("Connecting %s failed\n", path);
+    return false;
+}
+
+// the host sends a packet once it's ready, so the peer doesn't write ahead of it
+inline bool waitForHost(streamId_t s) {
+    streamPacketDesc_t* p;
+    return s != INVALID_STREAM_ID && XLinkReadData(s, &p) == X_LINK_SUCCESS && XLinkReleaseData(s) == X_LINK_SUCCESS;
+}
+
+// Forwards one TCP connection from the host to a peer. Data from the host may be held back
+// after a number of bytes, which stalls the host in its sends once the socket buffers are full.
+struct TestProxy {
+    int port;
+    int peerPort;
+    int listenFd = -1;
+    int hostFd = -1;
+    int peerFd = -1;
+    std::atomic<uint64_t> forwarded{0};
+    std::atomic<uint64_t> limit{UINT64_MAX};
+    std::atomic<bool> broken{false};
+    std::thread toPeer, toHost;
+
+    TestProxy(int port, int peerPort) : port(port), peerPort(peerPort) {}
+
+    ~TestProxy() {
+        close();
+    }
+
+    // before the host connects
+    bool listen() {
+        listenFd = socket(AF_INET, SOCK_STREAM, 0);
+        int on = 1;
+        // a small receive buffer, so the sends of the host stall soon when held back
+        int bufferSize = 64 * 1024;
+        setsockopt(listenFd, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on));
+        setsockopt(listenFd, SOL_SOCKET, SO_RCVBUF, &bufferSize, sizeof(bufferSize));
+        sockaddr_in address = loopbackAddress(port);
+        return listenFd >= 0 && bind(listenFd, (sockaddr*) &address, sizeof(address)) == 0 && ::listen(listenFd, 1) == 0;
+    }
+
+    // accepts the host and connects it to the peer, which serves already
+    bool connect() {
+        hostFd = accept(listenFd, nullptr, nullptr);
+        peerFd = socket(AF_INET, SOCK_STREAM, 0);
+        sockaddr_in address = loopbackAddress(peerPort);
+        if(hostFd < 0 || peerFd < 0 || ::connect(peerFd, (sockaddr*) &address, sizeof(address)) != 0) return false;
+        toPeer = std::thread([this] { forward(hostFd, peerFd, true); });
+        toHost = std::thread([this] { forward(peerFd, hostFd, false); });
+        return true;
+    }
+
+    // forwards at most this many more bytes from the host, up to a read already underway
+    void holdAfter(uint64_t bytes) {
+        limit = forwarded + bytes;
+    }
+
+    void pause() {
+        holdAfter(0);
+    }
+
+    void resume() {
+        limit = UINT64_MAX;
+    }
+
+    // both sides see the connection break off, their sends fail as well
+    void breakConnection() {
+        broken = true;
+        if(hostFd >= 0) shutdown(hostFd, SHUT_RDWR);
+        if(peerFd >= 0) shutdown(peerFd, SHUT_RDWR);
+        if(toPeer.joinable()) toPeer.join();
+        if(toHost.joinable()) toHost.join();
+        for(int* fd : {&hostFd, &peerFd}) {
+            if(*fd < 0) continue;
+            // resets the connection instead of ending it
+            linger reset = {1, 0};
+            setsockopt(*fd, SOL_SOCKET, SO_LINGER, &reset, sizeof(reset));
+            ::close(*fd);
+            *fd = -1;
+        }
+    }
+
+    void close() {
+        breakConnection();
+        if(listenFd >= 0) ::close(listenFd);
+        listenFd = -1;
+    }
+
+    static sockaddr_in loopbackAddress(int port) {
+        sockaddr_in address = {};
+        address.sin_family = AF_INET;
+        address.sin_port = htons(port);
+        address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        return address;
+    }
+
+    // bytes from the host which may be forwarded right now
+    uint64_t allowance(uint64_t bufferSize) const {
+        uint64_t done = forwarded;
+        uint64_t until = limit;
+        return until > done ? std::min(until - done, bufferSize) : 0;
+    }
+
+    void forward(int from, int to, bool limited) {
+        std::vector<uint8_t> buffer(64 * 1024);
+        bool open = true;
+        while(open) {
+            uint64_t allowed = buffer.size();
+            while(limited && !broken && (allowed = allowance(buffer.size())) == 0) {
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            }
+            ssize_t received = broken ? -1 : read(from, buffer.data(), allowed);
+            open = received > 0;
+            for(ssize_t sent = 0; open && sent < received;) {
+                ssize_t rc = send(to, buffer.data() + sent, received - sent, MSG_NOSIGNAL);
+                open = rc > 0;
+                sent += rc;
+            }
+            if(open && limited) forwarded += received;
+        }
+        // ends the other direction as well
+        shutdown(from, SHUT_RDWR);
+        shutdown(to, SHUT_RDWR);
+    }
+};
+
+#endif  // _XLINK_TEST_COMMON_HPP
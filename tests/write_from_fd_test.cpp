@@ -0,0 +1,150 @@
+#include <XLink/XLink.h>
+#include <XLink/XLinkLog.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <thread>
+#include <atomic>
+
+// The following test needs no device: the device side of each link is served by a thread of
+// the same process. It writes part of a temporary file with XLinkWriteFromFd, over TCP loopback,
+// where the kernel sends it from the file, and over X_LINK_LOOPBACK, where it's read through a
+// buffer. The peer checks that the packets it receives add up to that part of the file.
+
+constexpr static auto STREAM_NAME = "from_fd";
+constexpr static auto FILE_SIZE = 5 * 1024 * 1024 + 123;
+constexpr static auto OFFSET = 1000;
+constexpr static auto LENGTH = FILE_SIZE - 2 * OFFSET;
+constexpr static auto WRITE_SIZE = 1024 * 1024;
+
+static uint8_t pattern(size_t position) {
+    return (uint8_t) (position * 31 + position / 4096);
+}
+
+static void runPeer(std::string path, XLinkProtocol_t protocol, std::atomic<bool>& ok, std::atomic<bool>& done) {
+    XLinkHandler_t handler = {};
+    handler.devicePath = const_cast<char*>(path.c_str());
+    handler.protocol = protocol;
+    if(XLinkServer(&handler) != X_LINK_SUCCESS) {
+        printf("Peer: serving the link failed\n");
+        ok = false;
+        done = true;
+        return;
+    }
+
+    auto s = XLinkOpenStream(handler.linkId, STREAM_NAME, 1);
+    if(s == INVALID_STREAM_ID) {
+        ok = false;
+        done = true;
+        return;
+    }
+    size_t received = 0;
+    int packets = 0;
+    streamPacketDesc_t* p;
+    while(received < (size_t) LENGTH && XLinkReadData(s, &p) == X_LINK_SUCCESS) {
+        for(uint32_t i = 0; i < p->length; i++) {
+            if(p->data[i] != pattern(OFFSET + received + i)) {
+                printf("Peer: byte %zu differs\n", received + i);
+                ok = false;
+                break;
+            }
+        }
+        received += p->length;
+        packets++;
+        XLinkReleaseData(s);
+    }
+    if(received != (size_t) LENGTH || packets < 2) {
+        printf("Peer: received %zu bytes in %d packets\n", received, packets);
+        ok = false;
+    }
+    done = true;
+    // returns an error once the host reset the link
+    XLinkReadData(s, &p);
+}
+
+static bool runLink(const std::string& path, XLinkProtocol_t protocol, int fd) {
+    std::atomic<bool> peerOk{true};
+    std::atomic<bool> peerDone{false};
+    std::thread peer(runPeer, path, protocol, std::ref(peerOk), std::ref(peerDone));
+
+    XLinkHandler_t handler = {};
+    handler.devicePath = const_cast<char*>(path.c_str());
+    handler.protocol = protocol;
+    // the peer may not be serving yet
+    bool connected = false;
+    for(int i = 0; i < 100 && !connected; i++) {
+        connected = XLinkConnect(&handler) == X_LINK_SUCCESS;
+        if(!connected) std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    if(!connected) {
+        printf("Connecting %s failed\n", path.c_str());
+        peer.join();
+        return false;
+    }
+
+    bool ok = true;
+    auto s = XLinkOpenStream(handler.linkId, STREAM_NAME, WRITE_SIZE);
+    if(s == INVALID_STREAM_ID) {
+        printf("Open stream failed...\n");
+        ok = false;
+    }
+    if(ok && XLinkWriteFromFd(s, fd, FILE_SIZE - 10, 11) == X_LINK_SUCCESS) {
+        printf("Write past the end of the file wasn't refused\n");
+        ok = false;
+    }
+    if(ok && XLinkWriteFromFd(s, fd, OFFSET, LENGTH) != X_LINK_SUCCESS) {
+        printf("Write from the file failed on %s\n", path.c_str());
+        ok = false;
+    }
+    // the file offset isn't used
+    if(ok && lseek(fd, 0, SEEK_CUR) != 0) {
+        printf("File offset was moved\n");
+        ok = false;
+    }
+
+    // the writes complete once the peer's stream holds the data, not once it read it
+    for(int i = 0; i < 1000 && ok && !peerDone; i++) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    if(!peerDone) {
+        printf("Peer didn't receive everything\n");
+        ok = false;
+    }
+    XLinkResetRemote(handler.linkId);
+    peer.join();
+    return ok && peerOk;
+}
+
+int main() {
+    // failing reads of the peers at the reset are expected
+    mvLogDefaultLevelSet(MVLOG_FATAL);
+    XLinkGlobalHandler_t gHandler = {};
+    XLinkInitialize(&gHandler);
+
+    char fileName[] = "/tmp/xlink_write_from_fd_XXXXXX";
+    int fd = mkstemp(fileName);
+    if(fd < 0) {
+        printf("Creating the file failed\n");
+        return -1;
+    }
+    unlink(fileName);
+    std::vector<uint8_t> content(FILE_SIZE);
+    for(size_t i = 0; i < content.size(); i++) {
+        content[i] = pattern(i);
+    }
+    if(write(fd, content.data(), content.size()) != (ssize_t) content.size() || lseek(fd, 0, SEEK_SET) != 0) {
+        printf("Writing the file failed\n");
+        return -1;
+    }
+
+    bool ok = runLink("127.0.0.1:11580", X_LINK_TCP_IP, fd);
+    ok = runLink("write_from_fd_test", X_LINK_LOOPBACK, fd) && ok;
+    close(fd);
+
+    printf("%s\n", ok ? "Success" : "Failed");
+    return ok ? 0 : -1;
+}
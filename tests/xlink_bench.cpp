@@ -0,0 +1,405 @@
+#include <XLink/XLink.h>
+#include <XLink/XLinkLog.h>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <chrono>
+#include <thread>
+#include <vector>
+#include <string>
+#include <algorithm>
+
+// The following benchmark sweeps packet sizes, stream counts and read modes against a peer
+// served by a thread of the same process, over TCP loopback by default. It reports MB/s,
+// messages/s and one-way and round trip latency percentiles, optionally as JSON to track
+// regressions between releases, followed by the call latencies and counters XLink recorded.
+//
+// Usage: xlink_bench [--protocol tcp|loopback] [--endpoint ip:port|name] [--max-size bytes]
+//                    [--quick] [--json file]
+
+constexpr static auto MAX_STREAMS = 4;
+constexpr static auto MIN_PACKETS = 16;
+constexpr static auto MAX_PACKETS = 20000;
+constexpr static auto ROUND_BYTES = 256 * 1024 * 1024;
+constexpr static auto ROUND_TRIPS = 2000;
+
+enum ReadMode : uint32_t { READ_RELEASE, READ_MOVE, READ_RELEASE_SPECIFIC };
+static const char* readModeNames[] = {"read_release", "read_move", "read_release_specific"};
+
+enum RoundKind : uint32_t { ROUND_THROUGHPUT, ROUND_TRIP, ROUND_STOP };
+
+// sent by the host on the control stream before each round
+struct RoundConfig {
+    uint32_t kind;
+    uint32_t readMode;
+    uint32_t size;
+    uint32_t streams;
+    uint32_t count;
+};
+
+struct Percentiles {
+    double p50 = 0, p99 = 0, p999 = 0;
+};
+
+// sent back by the peer once it read every packet of a round
+struct RoundResult {
+    Percentiles oneWay;
+};
+
+struct Options {
+    XLinkProtocol_t protocol = X_LINK_TCP_IP;
+    std::string endpoint = "127.0.0.1:11500";
+    uint32_t maxSize = 64 * 1024 * 1024;
+    bool quick = false;
+    std::string json;
+};
+
+static int64_t nowNs() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+static Percentiles percentiles(std::vector<double>& samples) {
+    Percentiles p;
+    if(samples.empty()) return p;
+    std::sort(samples.begin(), samples.end());
+    auto at = [&](double q) { return samples[std::min(samples.size() - 1, (size_t)(q * samples.size()))]; };
+    p.p50 = at(0.5);
+    p.p99 = at(0.99);
+    p.p999 = at(0.999);
+    return p;
+}
+
+// ------------------------------------
+// Peer side
+// ------------------------------------
+
+static void readPackets(streamId_t s, const RoundConfig& config, std::vector<double>& oneWay) {
+    for(uint32_t i = 0; i < config.count; i++) {
+        streamPacketDesc_t packet;
+        streamPacketDesc_t* p = &packet;
+        XLinkError_t rc = config.readMode == READ_MOVE ? XLinkReadMoveData(s, &packet) : XLinkReadData(s, &p);
+        if(rc != X_LINK_SUCCESS) return;
+
+        // the writer stamps packets with the time it started writing them
+        int64_t sent = 0;
+        if(p->length >= sizeof(sent)) {
+            memcpy(&sent, p->data, sizeof(sent));
+            oneWay.push_back((nowNs() - sent) / 1000.0);
+        }
+        if(config.kind == ROUND_TRIP) {
+            XLinkWriteData(s, p->data, p->length);
+        }
+
+        switch(config.readMode) {
+            case READ_MOVE: XLinkDeallocateMoveData(packet.data, packet.length); break;
+            case READ_RELEASE_SPECIFIC: XLinkReleaseSpecificData(s, p); break;
+            default: XLinkReleaseData(s); break;
+        }
+    }
+}
+
+static void runPeer(Options options) {
+    XLinkHandler_t handler = {};
+    handler.devicePath = const_cast<char*>(options.endpoint.c_str());
+    handler.protocol = options.protocol;
+    if(XLinkServer(&handler) != X_LINK_SUCCESS) {
+        printf("Peer: serving the link failed\n");
+        return;
+    }
+
+    auto control = XLinkOpenStream(handler.linkId, "bench_control", sizeof(RoundResult));
+    streamId_t streams[MAX_STREAMS];
+    for(int i = 0; i < MAX_STREAMS; i++) {
+        streams[i] = XLinkOpenStream(handler.linkId, ("bench_" + std::to_string(i)).c_str(), options.maxSize);
+    }
+
+    streamPacketDesc_t* p;
+    while(XLinkReadData(control, &p) == X_LINK_SUCCESS) {
+        RoundConfig config;
+        memcpy(&config, p->data, sizeof(config));
+        XLinkReleaseData(control);
+        if(config.kind == ROUND_STOP) break;
+
+        std::vector<std::vector<double>> oneWay(config.streams);
+        std::vector<std::thread> readers;
+        for(uint32_t i = 0; i < config.streams; i++) {
+            readers.emplace_back(readPackets, streams[i], std::cref(config), std::ref(oneWay[i]));
+        }
+        for(auto& reader : readers) {
+            reader.join();
+        }
+
+        std::vector<double> all;
+        for(auto& samples : oneWay) {
+            all.insert(all.end(), samples.begin(), samples.end());
+        }
+        RoundResult result;
+        result.oneWay = percentiles(all);
+        XLinkWriteData(control, (uint8_t*) &result, sizeof(result));
+    }
+
+    // returns once the host reset the link
+    XLinkReadData(control, &p);
+}
+
+// ------------------------------------
+// Host side
+// ------------------------------------
+
+struct Host {
+    streamId_t control;
+    streamId_t streams[MAX_STREAMS];
+};
+
+static bool startRound(const Host& host, const RoundConfig& config) {
+    return XLinkWriteData(host.control, (const uint8_t*) &config, sizeof(config)) == X_LINK_SUCCESS;
+}
+
+// the peer answers once it read every packet of the round
+static bool finishRound(const Host& host, RoundResult& result) {
+    streamPacketDesc_t* p;
+    if(XLinkReadData(host.control, &p) != X_LINK_SUCCESS) return false;
+    memcpy(&result, p->data, sizeof(result));
+    XLinkReleaseData(host.control);
+    return true;
+}
+
+static void writePackets(streamId_t s, const RoundConfig& config) {
+    std::vector<uint8_t> payload(config.size);
+    for(uint32_t i = 0; i < config.count; i++) {
+        int64_t sent = nowNs();
+        if(payload.size() >= sizeof(sent)) memcpy(payload.data(), &sent, sizeof(sent));
+        if(XLinkWriteData(s, payload.data(), (int) payload.size()) != X_LINK_SUCCESS) return;
+    }
+}
+
+static std::string jsonPercentiles(const Percentiles& p) {
+    char buffer[128];
+    snprintf(buffer, sizeof(buffer), "{\"p50\": %.2f, \"p99\": %.2f, \"p999\": %.2f}", p.p50, p.p99, p.p999);
+    return buffer;
+}
+
+int main(int argc, char** argv) {
+    Options options;
+    bool endpointGiven = false;
+    for(int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        if(arg == "--protocol" && hasValue) {
+            std::string protocol = argv[++i];
+            options.protocol = protocol == "loopback" ? X_LINK_LOOPBACK : X_LINK_TCP_IP;
+        } else if(arg == "--endpoint" && hasValue) {
+            options.endpoint = argv[++i];
+            endpointGiven = true;
+        } else if(arg == "--max-size" && hasValue) {
+            options.maxSize = (uint32_t) strtoul(argv[++i], nullptr, 10);
+        } else if(arg == "--quick") {
+            options.quick = true;
+        } else if(arg == "--json" && hasValue) {
+            options.json = argv[++i];
+        } else {
+            printf("Usage: %s [--protocol tcp|loopback] [--endpoint ip:port|name] [--max-size bytes] "
+                   "[--quick] [--json file]\n", argv[0]);
+            return 1;
+        }
+    }
+    if(options.protocol == X_LINK_LOOPBACK && !endpointGiven) {
+        options.endpoint = "xlink_bench";
+    }
+    if(options.quick) {
+        options.maxSize = std::min<uint32_t>(options.maxSize, 1024 * 1024);
+    }
+    if(options.maxSize < 64) {
+        printf("--max-size must be at least 64\n");
+        return 1;
+    }
+
+    // failing reads of the peer at the final reset are expected
+    mvLogDefaultLevelSet(MVLOG_FATAL);
+    XLinkGlobalHandler_t gHandler = {};
+    XLinkInitialize(&gHandler);
+
+    std::thread peer(runPeer, options);
+
+    XLinkHandler_t handler = {};
+    handler.devicePath = const_cast<char*>(options.endpoint.c_str());
+    handler.protocol = options.protocol;
+    // the peer may not be serving yet
+    bool connected = false;
+    for(int i = 0; i < 100 && !connected; i++) {
+        connected = XLinkConnect(&handler) == X_LINK_SUCCESS;
+        if(!connected) std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    if(!connected) {
+        printf("Connecting to the peer failed\n");
+        peer.detach();
+        return -1;
+    }
+
+    Host host;
+    host.control = XLinkOpenStream(handler.linkId, "bench_control", sizeof(RoundConfig));
+    bool ok = host.control != INVALID_STREAM_ID;
+    for(int i = 0; i < MAX_STREAMS; i++) {
+        // room for a second packet in flight
+        host.streams[i] = XLinkOpenStream(handler.linkId, ("bench_" + std::to_string(i)).c_str(), 2 * options.maxSize);
+        ok = ok && host.streams[i] != INVALID_STREAM_ID;
+    }
+    if(!ok) {
+        printf("Open stream failed...\n");
+        return -1;
+    }
+
+    std::vector<uint32_t> sizes;
+    for(uint32_t size = 64; size <= options.maxSize; size *= 4) {
+        sizes.push_back(size);
+    }
+    const uint32_t roundBytes = options.quick ? ROUND_BYTES / 8 : ROUND_BYTES;
+    const uint32_t maxPackets = options.quick ? MAX_PACKETS / 10 : MAX_PACKETS;
+
+    std::vector<std::string> throughputJson;
+    printf("%10s %8s %22s %12s %12s %10s %10s %10s\n", "size", "streams", "read mode", "MB/s", "msgs/s",
+           "p50 us", "p99 us", "p999 us");
+    for(uint32_t size : sizes) {
+        for(uint32_t streams : {1u, (uint32_t) MAX_STREAMS}) {
+            // keeps the memory of a round bounded
+            if((uint64_t) size * streams > options.maxSize) continue;
+            for(uint32_t mode : {READ_RELEASE, READ_MOVE, READ_RELEASE_SPECIFIC}) {
+                RoundConfig config = {ROUND_THROUGHPUT, mode, size, streams,
+                                      std::max<uint32_t>(MIN_PACKETS, std::min(maxPackets, roundBytes / size))};
+
+                RoundResult result;
+                auto start = std::chrono::steady_clock::now();
+                if(!startRound(host, config)) {
+                    printf("Round failed\n");
+                    return -1;
+                }
+                std::vector<std::thread> writers;
+                for(uint32_t i = 0; i < streams; i++) {
+                    writers.emplace_back(writePackets, host.streams[i], std::cref(config));
+                }
+                for(auto& writer : writers) {
+                    writer.join();
+                }
+                if(!finishRound(host, result)) {
+                    printf("Round failed\n");
+                    return -1;
+                }
+                std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+                double messages = (double) config.count * streams;
+                double mbps = messages * size / (1024.0 * 1024.0) / elapsed.count();
+                double mps = messages / elapsed.count();
+                printf("%10u %8u %22s %12.1f %12.0f %10.1f %10.1f %10.1f\n", size, streams, readModeNames[mode],
+                       mbps, mps, result.oneWay.p50, result.oneWay.p99, result.oneWay.p999);
+
+                char buffer[256];
+                snprintf(buffer, sizeof(buffer),
+                         "{\"size\": %u, \"streams\": %u, \"read_mode\": \"%s\", \"mb_per_s\": %.2f, "
+                         "\"msgs_per_s\": %.0f, \"one_way_us\": ",
+                         size, streams, readModeNames[mode], mbps, mps);
+                throughputJson.push_back(buffer + jsonPercentiles(result.oneWay) + "}");
+            }
+        }
+    }
+
+    std::vector<std::string> roundTripJson;
+    printf("\n%10s %14s %14s %14s %14s\n", "size", "rt p50 us", "rt p99 us", "rt p999 us", "one way p50 us");
+    for(uint32_t size : sizes) {
+        if(size > 1024 * 1024) break;
+        RoundConfig config = {ROUND_TRIP, READ_RELEASE, size, 1,
+                              (uint32_t) (options.quick ? ROUND_TRIPS / 4 : ROUND_TRIPS)};
+
+        // the peer echoes every packet
+        if(!startRound(host, config)) {
+            printf("Round failed\n");
+            return -1;
+        }
+        std::vector<uint8_t> payload(size);
+        std::vector<double> roundTrips;
+        streamPacketDesc_t* p;
+        for(uint32_t i = 0; i < config.count; i++) {
+            int64_t sent = nowNs();
+            memcpy(payload.data(), &sent, sizeof(sent));
+            if(XLinkWriteData(host.streams[0], payload.data(), (int) payload.size()) != X_LINK_SUCCESS
+               || XLinkReadData(host.streams[0], &p) != X_LINK_SUCCESS) {
+                printf("Round trip failed\n");
+                return -1;
+            }
+            roundTrips.push_back((nowNs() - sent) / 1000.0);
+            XLinkReleaseData(host.streams[0]);
+        }
+        RoundResult result;
+        if(!finishRound(host, result)) {
+            printf("Round failed\n");
+            return -1;
+        }
+
+        Percentiles rt = percentiles(roundTrips);
+        printf("%10u %14.1f %14.1f %14.1f %14.1f\n", size, rt.p50, rt.p99, rt.p999, result.oneWay.p50);
+
+        char buffer[64];
+        snprintf(buffer, sizeof(buffer), "{\"size\": %u, \"round_trip_us\": ", size);
+        roundTripJson.push_back(buffer + jsonPercentiles(rt) + ", \"one_way_us\": " + jsonPercentiles(result.oneWay) + "}");
+    }
+
+    // as measured by XLink itself, over all the rounds of the first stream
+    XLinkStreamProf_t prof = {};
+    if(XLinkGetStreamProfilingData(host.streams[0], &prof) == X_LINK_SUCCESS) {
+        const char* names[] = {"read wait", "write", "release"};
+        const XLinkLatencyProf_t* latencies[] = {&prof.readWait, &prof.writeCompletion, &prof.release};
+        printf("\n%10s %10s %10s %10s %10s %10s %10s\n", "bench_0", "calls", "p50 us", "p90 us", "p99 us",
+               "p999 us", "max us");
+        for(int i = 0; i < 3; i++) {
+            const XLinkLatencyProf_t& l = *latencies[i];
+            printf("%10s %10llu %10.1f %10.1f %10.1f %10.1f %10.1f\n", names[i], (unsigned long long) l.count,
+                   l.p50Ns / 1000.0, l.p90Ns / 1000.0, l.p99Ns / 1000.0, l.p999Ns / 1000.0, l.maxNs / 1000.0);
+        }
+    }
+
+    // and where that time went
+    XLinkStageProf_t stages = {};
+    if(XLinkGetStreamStageProfilingData(host.streams[0], &stages) == X_LINK_SUCCESS) {
+        const char* names[] = {"queue", "blocked", "transport", "response", "wakeup"};
+        printf("\n%10s %10s %10s %10s %10s\n", "stage", "events", "p50 us", "p99 us", "p999 us");
+        for(int i = 0; i < X_LINK_STAGE_COUNT; i++) {
+            const XLinkLatencyProf_t& l = stages.stages[i];
+            printf("%10s %10llu %10.1f %10.1f %10.1f\n", names[i], (unsigned long long) l.count, l.p50Ns / 1000.0,
+                   l.p99Ns / 1000.0, l.p999Ns / 1000.0);
+        }
+    }
+
+    XLinkProfCounters_t counters = {};
+    if(XLinkGetProfilingCounters(handler.linkId, &counters) == X_LINK_SUCCESS) {
+        printf("\nLink since connect: %.1f s, %llu writes of %.1f MB in %.1f s, %llu reads of %.1f MB in %.1f s\n",
+               counters.elapsedNs / 1e9, (unsigned long long) counters.writes, counters.totalWriteBytes / (1024.0 * 1024.0),
+               counters.totalWriteNs / 1e9, (unsigned long long) counters.reads, counters.totalReadBytes / (1024.0 * 1024.0),
+               counters.totalReadNs / 1e9);
+    }
+
+    RoundConfig stop = {ROUND_STOP, 0, 0, 0, 0};
+    XLinkWriteData(host.control, (const uint8_t*) &stop, sizeof(stop));
+    XLinkResetRemote(handler.linkId);
+    peer.join();
+
+    if(!options.json.empty()) {
+        FILE* file = fopen(options.json.c_str(), "w");
+        if(file == NULL) {
+            printf("Cannot write %s\n", options.json.c_str());
+            return -1;
+        }
+        fprintf(file, "{\n  \"protocol\": \"%s\",\n  \"throughput\": [\n",
+                options.protocol == X_LINK_LOOPBACK ? "loopback" : "tcp");
+        for(size_t i = 0; i < throughputJson.size(); i++) {
+            fprintf(file, "    %s%s\n", throughputJson[i].c_str(), i + 1 < throughputJson.size() ? "," : "");
+        }
+        fprintf(file, "  ],\n  \"round_trip\": [\n");
+        for(size_t i = 0; i < roundTripJson.size(); i++) {
+            fprintf(file, "    %s%s\n", roundTripJson[i].c_str(), i + 1 < roundTripJson.size() ? "," : "");
+        }
+        fprintf(file, "  ]\n}\n");
+        fclose(file);
+    }
+
+    return 0;
+}